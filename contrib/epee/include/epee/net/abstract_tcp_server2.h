@@ -54,6 +54,10 @@
 #define LOKI_DEFAULT_LOG_CATEGORY "net"
 
 #define ABSTRACT_SERVER_SEND_QUE_MAX_COUNT 1000
+// Limits on how much of the send queue is handed to the socket in one gathered (writev) write.
+// asio itself never passes more than 64 buffers to a single writev call.
+#define ABSTRACT_SERVER_SEND_GATHER_MAX_COUNT 64
+#define ABSTRACT_SERVER_SEND_GATHER_MAX_BYTES (1024 * 1024)
 
 namespace epee
 {
@@ -136,6 +140,7 @@ namespace net_utils
     virtual bool release();
     //------------------------------------------------------
     bool do_send_chunk(shared_sv chunk); ///< will send (or queue) a part of data. internal use only
+    void start_write(); ///< starts one gathered write of the front of m_send_que; m_send_que_lock must be held
 
     std::shared_ptr<connection<t_protocol_handler> > safe_shared_from_this();
     bool shutdown();
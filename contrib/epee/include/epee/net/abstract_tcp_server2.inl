@@ -556,8 +556,8 @@ PRAGMA_WARNING_DISABLE_VS(4355)
 
     m_send_que.push_back(std::move(chunk));
 
-    if(m_send_que.size() > 1)
-    { // active operation should be in progress, nothing to do, just wait last operation callback
+    if(m_send_que_inflight)
+    { // active operation should be in progress, nothing to do, just wait last operation callback (which will gather this chunk into its next write)
         auto size_now = m_send_que.back().size();
         MDEBUG("do_send_chunk() NOW just queues: packet="<<size_now<<" B, is added to queue-size="<<m_send_que.size());
         //do_send_handler_delayed( ptr , size_now ); // (((H))) // empty function
@@ -573,22 +573,11 @@ PRAGMA_WARNING_DISABLE_VS(4355)
             return false;
         }
 
-        auto size_now = m_send_que.front().size();
-        MDEBUG("do_send_chunk() NOW SENSD: packet="<<size_now<<" B");
+        MDEBUG("do_send_chunk() NOW SENSD: packet="<<m_send_que.front().size()<<" B");
         if (speed_limit_is_enabled())
 			do_send_handler_write( m_send_que.back().data(), m_send_que.back().size() ); // (((H)))
 
-        CHECK_AND_ASSERT_MES( size_now == m_send_que.front().size(), false, "Unexpected queue size");
-        reset_timer(get_default_timeout(), false);
-        using namespace boost::placeholders;
-        boost::asio::async_write(socket(), boost::asio::buffer(m_send_que.front().data(), size_now ) ,
-                                 strand_.wrap(
-                                 boost::bind(&connection<t_protocol_handler>::handle_write, self, _1, _2)
-                                 )
-                                 );
-        //MTRACE("(chunk): " << size_now);
-        //logger_handle_net_write(size_now);
-        //MINFO("[sock " << socket().native_handle() << "] Async send requested " << m_send_que.front().size());
+        start_write();
     }
     
     //do_send_handler_stop( ptr , cb ); // empty function
@@ -736,6 +725,37 @@ PRAGMA_WARNING_DISABLE_VS(4355)
   }
   //---------------------------------------------------------------------------------
   template<class t_protocol_handler>
+  void connection<t_protocol_handler>::start_write()
+  {
+    // Hand as much of the queue as the gather limits allow to a single async_write, so that a
+    // big chunked message goes out in a few writev calls rather than one syscall (and one
+    // completion handler) per chunk.  The first chunk is always taken, even if it alone is over
+    // the byte limit (e.g. an unsplit RPC response).  The speed limit throttle (see handle_write)
+    // counts the bytes of the whole gathered write, so this applies to throttled connections too.
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(std::min<size_t>(m_send_que.size(), ABSTRACT_SERVER_SEND_GATHER_MAX_COUNT));
+    size_t bytes = 0;
+    for (auto it = m_send_que.begin(); it != m_send_que.end() && buffers.size() < ABSTRACT_SERVER_SEND_GATHER_MAX_COUNT; ++it)
+    {
+      if (!buffers.empty() && bytes + it->size() > ABSTRACT_SERVER_SEND_GATHER_MAX_BYTES)
+        break;
+      buffers.emplace_back(it->data(), it->size());
+      bytes += it->size();
+    }
+    m_send_que_inflight = buffers.size();
+    m_send_que_inflight_bytes = bytes;
+    MDEBUG("start_write() gathering " << m_send_que_inflight << " of " << m_send_que.size() << " queued chunks, " << bytes << " B");
+
+    reset_timer(get_default_timeout(), false);
+    using namespace boost::placeholders;
+    boost::asio::async_write(socket(), buffers,
+        strand_.wrap(
+          boost::bind(&connection<t_protocol_handler>::handle_write, connection<t_protocol_handler>::shared_from_this(), _1, _2)
+        )
+      );
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
   void connection<t_protocol_handler>::handle_write(const boost::system::error_code& e, size_t cb)
   {
     TRY_ENTRY();
@@ -747,11 +767,11 @@ PRAGMA_WARNING_DISABLE_VS(4355)
       shutdown();
       return;
     }
-    logger_handle_net_write(cb);
 
-                // The single sleeping that is needed for correctly handling "out" speed throttling
+                // The single sleeping that is needed for correctly handling "out" speed throttling;
+                // cb is the byte total of every chunk this (gathered) write covered.
 		if (speed_limit_is_enabled()) {
-			sleep_before_packet(cb, 1, 1);
+			sleep_before_packet(cb, 1, m_send_que_inflight);
 		}
 
     bool do_shutdown = false;
@@ -762,7 +782,11 @@ PRAGMA_WARNING_DISABLE_VS(4355)
       return;
     }
 
-    m_send_que.pop_front();
+    CHECK_AND_ASSERT_MES(m_send_que_inflight > 0 && m_send_que_inflight <= m_send_que.size(), void(), "Unexpected in-flight send count " << m_send_que_inflight);
+    logger_handle_net_write(cb, m_send_que_inflight);
+    m_send_que.erase(m_send_que.begin(), m_send_que.begin() + m_send_que_inflight);
+    m_send_que_inflight = 0;
+    m_send_que_inflight_bytes = 0;
     if(m_send_que.empty())
     {
       if(m_want_close_connection)
@@ -772,19 +796,10 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     }else
     {
       //have more data to send
-		reset_timer(get_default_timeout(), false);
-		auto size_now = m_send_que.front().size();
-		MDEBUG("handle_write() NOW SENDS: packet="<<size_now<<" B" <<", from  queue size="<<m_send_que.size());
+		start_write();
+		MDEBUG("handle_write() NOW SENDS: "<<m_send_que_inflight_bytes<<" B in "<<m_send_que_inflight<<" chunks" <<", from  queue size="<<m_send_que.size());
 		if (speed_limit_is_enabled())
-			do_send_handler_write_from_queue(e, m_send_que.front().size() , m_send_que.size()); // (((H)))
-		CHECK_AND_ASSERT_MES( size_now == m_send_que.front().size(), void(), "Unexpected queue size");
-        using namespace boost::placeholders;
-        boost::asio::async_write(socket(), boost::asio::buffer(m_send_que.front().data(), size_now) , 
-           strand_.wrap(
-            boost::bind(&connection<t_protocol_handler>::handle_write, connection<t_protocol_handler>::shared_from_this(), _1, _2)
-			  )
-          );
-      //MTRACE("(normal)" << size_now);
+			do_send_handler_write_from_queue(e, m_send_que_inflight_bytes, m_send_que.size()); // (((H)))
     }
     lock.unlock();
 
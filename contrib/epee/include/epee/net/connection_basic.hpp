@@ -96,6 +96,8 @@ class connection_basic { // not-templated base class for rapid developmet of som
     std::atomic<bool> m_was_shutdown;
     std::mutex m_send_que_lock;
     std::deque<shared_sv> m_send_que;
+    size_t m_send_que_inflight = 0; // number of m_send_que entries in the current gathered write (guarded by m_send_que_lock)
+    size_t m_send_que_inflight_bytes = 0; // total size of those entries (guarded by m_send_que_lock)
     std::atomic<bool> m_is_multithreaded;
     /// Strand to ensure the connection's handlers are not called concurrently.
     boost::asio::io_service::strand strand_;
@@ -119,7 +121,7 @@ class connection_basic { // not-templated base class for rapid developmet of som
 		void do_send_handler_write(const void * ptr , size_t cb);
 		void do_send_handler_write_from_queue(const boost::system::error_code& e, size_t cb , int q_len); // from handle_write, sending next part
 
-		void logger_handle_net_write(size_t size); // network data written
+		void logger_handle_net_write(size_t size, size_t buffers); // network data written (in one gathered write of `buffers` queued chunks)
 		void logger_handle_net_read(size_t size); // network data read
 
 		// config for rate limit
@@ -137,6 +139,13 @@ class connection_basic { // not-templated base class for rapid developmet of som
 		void sleep_before_packet(size_t packet_size, int phase, int q_len); // execute a sleep ; phase is not really used now(?)
 		static void save_limit_to_file(int limit); ///< for dr-monero
 		static double get_sleep_time(size_t cb);
+
+		struct write_stats {
+			uint64_t writes; // completed gathered writes
+			uint64_t buffers; // queued chunks sent by those writes
+			uint64_t bytes; // bytes sent by those writes
+		};
+		static write_stats get_write_stats(); ///< totals across all connections, e.g. for average bytes per write
 };
 
 } // nameserver
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <cstring>
 #include <type_traits>
 #include <set>
 #include <unordered_set>
@@ -105,11 +106,16 @@ namespace epee
     static bool unserialize_t_val_as_blob(t_type& d, t_storage& stg, section* parent_section, const char* pname)
     {
       assert_blob_serializable<t_type>();
-      std::string blob;
-      if(!stg.get_value(pname, blob, parent_section))
-        return false;
-      CHECK_AND_ASSERT_MES(blob.size() == sizeof(d), false, "unserialize_t_val_as_blob: size of " << typeid(t_type).name() << " = " << sizeof(t_type) << ", but stored blod size = " << blob.size() << ", value name = " << pname);
-      d = *(const t_type*)blob.data();
+      std::string blob_copy;
+      const std::string* blob = stg.template get_value_ptr<std::string>(pname, parent_section);
+      if (!blob)
+      {
+        if(!stg.get_value(pname, blob_copy, parent_section))
+          return false;
+        blob = &blob_copy;
+      }
+      CHECK_AND_ASSERT_MES(blob->size() == sizeof(d), false, "unserialize_t_val_as_blob: size of " << typeid(t_type).name() << " = " << sizeof(t_type) << ", but stored blod size = " << blob->size() << ", value name = " << pname);
+      std::memcpy((void*) &d, blob->data(), sizeof(d));
       return true;
     } 
     //-------------------------------------------------------------------------------------------------------------------
@@ -146,6 +152,20 @@ namespace epee
     {
       using T = typename stl_container::value_type;
       container.clear();
+      if constexpr (std::is_same_v<T, std::string>)
+      {
+        if (stg.consume_on_load())
+        {
+          if (auto* arr = stg.template get_array<std::string>(pname, parent_section))
+          {
+            if constexpr (is_std_vector<stl_container>)
+              container.reserve(arr->size());
+            for (auto& str : *arr)
+              container.insert(container.end(), std::move(str));
+            return true;
+          }
+        }
+      }
       try {
         for (auto [it, end] = stg.template converting_array_range<T>(pname, parent_section); it != end; ++it)
           container.insert(container.end(), *it);
@@ -196,9 +216,15 @@ namespace epee
       assert_blob_serializable<T>();
 
       container.clear();
-      std::string buff;
-      if (!stg.get_value(pname, buff, parent_section))
-        return false;
+      std::string buff_copy;
+      const std::string* pbuff = stg.template get_value_ptr<std::string>(pname, parent_section);
+      if (!pbuff)
+      {
+        if (!stg.get_value(pname, buff_copy, parent_section))
+          return false;
+        pbuff = &buff_copy;
+      }
+      const std::string& buff = *pbuff;
 
       CHECK_AND_ASSERT_MES(buff.size() % sizeof(T) == 0,
         false, 
@@ -319,8 +345,15 @@ namespace epee
       }
       else if constexpr (!is_serialize_stl_container<T>)
       { // Non-container
-        if constexpr (is_basic_serializable<T>) // basic serializable or using portable storage:
+        if constexpr (is_basic_serializable<T>) { // basic serializable or using portable storage:
+          if constexpr (std::is_same_v<T, std::string>)
+            if (stg.consume_on_load())
+              if (auto* str = stg.template get_value_ptr<std::string>(pname, parent_section)) {
+                d = std::move(*str);
+                return true;
+              }
           return stg.get_value(pname, d, parent_section);
+        }
         else // non-basic, non-portable serializable:
           return unserialize_t_obj(d, stg, parent_section, pname);
       }
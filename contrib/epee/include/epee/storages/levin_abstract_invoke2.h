@@ -55,6 +55,7 @@ namespace epee
         return false;
       }
       serialization::portable_storage stg_ret;
+      stg_ret.set_consume_on_load(true);
       if(!stg_ret.load_from_binary(buff_to_recv))
       {
         LOG_ERROR("Failed to load_from_binary on command " << command);
@@ -99,6 +100,7 @@ namespace epee
         return false;
       }
       typename serialization::portable_storage stg_ret;
+      stg_ret.set_consume_on_load(true);
       if(!stg_ret.load_from_binary(buff_to_recv))
       {
         LOG_ERROR("Failed to load_from_binary on command " << command);
@@ -124,6 +126,7 @@ namespace epee
           return false;
         }
         serialization::portable_storage stg_ret;
+        stg_ret.set_consume_on_load(true);
         if(!stg_ret.load_from_binary(buff))
         {
           LOG_ERROR("Failed to load_from_binary on command " << command);
@@ -170,6 +173,7 @@ namespace epee
     int buff_to_t_adapter(int command, const epee::span<const uint8_t> in_buff, std::string& buff_out, callback_t cb, t_context& context )
     {
       serialization::portable_storage strg;
+      strg.set_consume_on_load(true);
       if(!strg.load_from_binary(in_buff))
       {
         LOG_ERROR("Failed to load_from_binary in command " << command);
@@ -200,6 +204,7 @@ namespace epee
     int buff_to_t_adapter(t_owner* powner, int command, const epee::span<const uint8_t> in_buff, callback_t cb, t_context& context)
     {
       serialization::portable_storage strg;
+      strg.set_consume_on_load(true);
       if(!strg.load_from_binary(in_buff))
       {
         LOG_ERROR("Failed to load_from_binary in notify " << command);
@@ -49,10 +49,14 @@ namespace epee
     public:
       portable_storage() = default;
       virtual ~portable_storage() = default;
-      section*   open_section(const std::string& section_name,  section* parent_section, bool create_if_notexist = false);
+      section*   open_section(std::string_view section_name,  section* parent_section, bool create_if_notexist = false);
       template <typename T>
-      bool       get_value(const std::string& value_name, T& val, section* parent_section);
-      bool       get_value(const std::string& value_name, storage_entry& val, section* parent_section);
+      bool       get_value(std::string_view value_name, T& val, section* parent_section);
+      bool       get_value(std::string_view value_name, storage_entry& val, section* parent_section);
+      // Returns a pointer to the stored value if it exists and holds exactly a T (i.e. without any
+      // conversion), nullptr otherwise.
+      template <typename T>
+      T*         get_value_ptr(std::string_view value_name, section* parent_section);
       template <class T>
       bool       set_value(const std::string& value_name, const T& target, section* parent_section);
 
@@ -96,12 +100,12 @@ namespace epee
       // if the member isn't an array.
       template <typename T>
       std::pair<converting_array_iterator<T>, converting_array_iterator<T>>
-      converting_array_range(const std::string& value_name, section* parent_section)
+      converting_array_range(std::string_view value_name, section* parent_section)
       {
         if (!parent_section) parent_section = &m_root;
         storage_entry* pentry = find_storage_entry(value_name, parent_section);
         if (!pentry)
-          throw std::out_of_range{value_name + " does not exist"};
+          throw std::out_of_range{std::string{value_name} + " does not exist"};
         auto& ar_entry = var::get<array_entry>(*pentry);
         return {converting_array_iterator<T>{ar_entry}, converting_array_iterator<T>{ar_entry, true}};
       }
@@ -112,7 +116,7 @@ namespace epee
       // array_range(), this does not convert (so, for example, you can't get uint64_t's if the
       // stored values are uint32_t's).
       template <typename T>
-      array_t<T>* get_array(const std::string& value_name, section* parent_section) {
+      array_t<T>* get_array(std::string_view value_name, section* parent_section) {
         if (!parent_section) parent_section = &m_root;
         if (storage_entry* pentry = find_storage_entry(value_name, parent_section))
           if (auto* ar_entry = std::get_if<array_entry>(pentry))
@@ -142,6 +146,13 @@ namespace epee
       bool dump_as_json(std::string& targetObj, size_t indent = 0, bool insert_newlines = true);
       bool load_from_json(std::string_view source);
 
+      /// When set, loading a struct from this storage moves string values (and arrays of strings)
+      /// out of the storage rather than copying them.  Only for storage that is parsed, loaded into
+      /// a single object exactly once and then discarded, such as an incoming levin message, where
+      /// this avoids a second copy of every block and transaction blob.
+      void set_consume_on_load(bool consume) { m_consume_on_load = consume; }
+      bool consume_on_load() const { return m_consume_on_load; }
+
       /// Lets you store a pointer to some arbitrary context object; typically used to pass some
       /// context to dependent child objects.
       template <typename T> void set_context(const T* obj) { context_type = &typeid(T); context = obj; }
@@ -158,7 +169,7 @@ namespace epee
     private:
       section m_root;
       section* get_root_section() {return &m_root;}
-      storage_entry* find_storage_entry(const std::string& pentry_name, section* psection);
+      storage_entry* find_storage_entry(std::string_view pentry_name, section* psection);
       template<class entry_type>
       storage_entry* insert_new_entry_get_storage_entry(const std::string& pentry_name, section* psection, const entry_type& entry);
 
@@ -166,6 +177,7 @@ namespace epee
 
       const void* context = nullptr;
       const std::type_info* context_type = nullptr;
+      bool m_consume_on_load = false;
 
 #pragma pack(push)
 #pragma pack(1)
@@ -178,7 +190,7 @@ namespace epee
 #pragma pack(pop)
     };
     template <typename T>
-    bool portable_storage::get_value(const std::string& value_name, T& val, section* parent_section)
+    bool portable_storage::get_value(std::string_view value_name, T& val, section* parent_section)
     {
       static_assert(variant_contains<T, storage_entry>);
       //TRY_ENTRY();
@@ -193,6 +205,14 @@ namespace epee
     }
     //---------------------------------------------------------------------------------------------------------------
     template <typename T>
+    T* portable_storage::get_value_ptr(std::string_view value_name, section* parent_section)
+    {
+      if(!parent_section) parent_section = &m_root;
+      storage_entry* pentry = find_storage_entry(value_name, parent_section);
+      return pentry ? std::get_if<T>(pentry) : nullptr;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template <typename T>
     bool portable_storage::set_value(const std::string& value_name, const T& v, section* parent_section)        
     {
       static_assert(variant_contains<T, storage_entry> || std::is_same_v<T, storage_entry>);
@@ -217,8 +237,7 @@ namespace epee
     {
       TRY_ENTRY();
       CHECK_AND_ASSERT(psection, nullptr);
-      auto ins_res = psection->m_entries.emplace(pentry_name, entry);
-      return &ins_res.first->second;
+      return psection->emplace(pentry_name, entry).first;
       CATCH_ENTRY("portable_storage::insert_new_entry_get_storage_entry", nullptr);
     }
     //---------------------------------------------------------------------------------------------------------------
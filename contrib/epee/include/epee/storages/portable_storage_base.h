@@ -28,8 +28,10 @@
 
 #pragma once 
 
+#include <algorithm>
 #include <variant>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <deque>
 #include <cstdint>
@@ -105,9 +107,54 @@ namespace epee
     /************************************************************************/
     struct section
     {
-      std::map<std::string, storage_entry> m_entries;
+      // Entries sorted by name.  Sections are small and, when parsed, arrive already in order, so a
+      // flat vector is much cheaper to build and search than a map with a node per entry.  Note
+      // that, unlike a map, inserting can invalidate pointers to other entries of this section.
+      std::vector<std::pair<std::string, storage_entry>> m_entries;
+
+      storage_entry* find(std::string_view name);
+      // Inserts a new entry; if `name` already exists the existing entry is left untouched and
+      // returned with false.
+      std::pair<storage_entry*, bool> emplace(std::string name, storage_entry value);
+      // Sorts entries appended directly to m_entries (e.g. while parsing, where we can't trust the
+      // input to be in order) and drops duplicate names, keeping the first.
+      void sort_entries();
     };
 
+    inline storage_entry* section::find(std::string_view name)
+    {
+      auto it = std::lower_bound(m_entries.begin(), m_entries.end(), name,
+          [](const auto& entry, std::string_view n) { return entry.first < n; });
+      if (it == m_entries.end() || it->first != name)
+        return nullptr;
+      return &it->second;
+    }
+
+    inline std::pair<storage_entry*, bool> section::emplace(std::string name, storage_entry value)
+    {
+      if (m_entries.empty() || m_entries.back().first < name)
+        return {&m_entries.emplace_back(std::move(name), std::move(value)).second, true};
+
+      auto it = std::lower_bound(m_entries.begin(), m_entries.end(), name,
+          [](const auto& entry, const std::string& n) { return entry.first < n; });
+      if (it != m_entries.end() && it->first == name)
+        return {&it->second, false};
+      return {&m_entries.emplace(it, std::move(name), std::move(value))->second, true};
+    }
+
+    inline void section::sort_entries()
+    {
+      // Already strictly increasing is the normal case
+      if (std::adjacent_find(m_entries.begin(), m_entries.end(),
+            [](const auto& a, const auto& b) { return !(a.first < b.first); }) == m_entries.end())
+        return;
+      std::stable_sort(m_entries.begin(), m_entries.end(),
+          [](const auto& a, const auto& b) { return a.first < b.first; });
+      m_entries.erase(std::unique(m_entries.begin(), m_entries.end(),
+            [](const auto& a, const auto& b) { return a.first == b.first; }),
+          m_entries.end());
+    }
+
     template <typename T> constexpr bool TYPE_IS_NOT_SERIALIZABLE = false;
 
     template <typename T>
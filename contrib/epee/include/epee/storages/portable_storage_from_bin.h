@@ -219,13 +219,18 @@ namespace epee
     {
       sec.m_entries.clear();
       size_t count = read_varint();
+      // Every entry takes at least 3 bytes (name length, name, type)
+      sec.m_entries.reserve(std::min<size_t>(count, m_count / 3));
       while(count--)
       {
         //read section name string
         std::string sec_name;
         read_sec_name(sec_name);
-        sec.m_entries.insert(std::make_pair(sec_name, load_storage_entry()));
+        // Inserting in order as we go would be quadratic for a section sent out of order, so
+        // append and sort once at the end.
+        sec.m_entries.emplace_back(std::move(sec_name), load_storage_entry());
       }
+      sec.sort_entries();
     }
     inline 
     void throwable_buffer_reader::read(std::string& str)
@@ -69,6 +69,7 @@ namespace epee
     bool load_t_from_binary(t_struct& out, const epee::span<const uint8_t> binary_buff)
     {
       portable_storage ps;
+      ps.set_consume_on_load(true);
       bool rs = ps.load_from_binary(binary_buff);
       if(!rs)
         return false;
@@ -80,6 +81,7 @@ namespace epee
     bool load_t_from_binary(t_struct& out, std::string_view binary_buff)
     {
       portable_storage ps;
+      ps.set_consume_on_load(true);
       if (!ps.load_from_binary(binary_buff))
         return false;
 
@@ -122,9 +122,8 @@ namespace epee
 
     inline void pack_entry_to_buff(std::ostream& strm, const section& sec)
     {
-      typedef std::map<std::string, storage_entry>::value_type section_pair;
       pack_varint(strm, sec.m_entries.size());
-      for(const section_pair& se: sec.m_entries)
+      for(const auto& se: sec.m_entries)
       {
         CHECK_AND_ASSERT_THROW_MES(se.first.size() < std::numeric_limits<uint8_t>::max(), "storage_entry_name is too long: " << se.first.size() << ", val: " << se.first);
         uint8_t len = static_cast<uint8_t>(se.first.size());
@@ -265,7 +265,20 @@ void connection_basic::do_send_handler_write_from_queue( const boost::system::er
 void connection_basic::logger_handle_net_read(size_t size) { // network data read
 }
 
-void connection_basic::logger_handle_net_write(size_t size) {
+namespace {
+	std::atomic<uint64_t> g_write_count{0};
+	std::atomic<uint64_t> g_write_buffers{0};
+	std::atomic<uint64_t> g_write_bytes{0};
+}
+
+void connection_basic::logger_handle_net_write(size_t size, size_t buffers) {
+	g_write_count.fetch_add(1, std::memory_order_relaxed);
+	g_write_buffers.fetch_add(buffers, std::memory_order_relaxed);
+	g_write_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+connection_basic::write_stats connection_basic::get_write_stats() {
+	return {g_write_count.load(std::memory_order_relaxed), g_write_buffers.load(std::memory_order_relaxed), g_write_bytes.load(std::memory_order_relaxed)};
 }
 
 double connection_basic::get_sleep_time(size_t cb) {
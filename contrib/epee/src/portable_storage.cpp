@@ -142,7 +142,7 @@ namespace epee {
       CATCH_ENTRY("portable_storage::load_from_binary", false);
     }
 
-    section* portable_storage::open_section(const std::string& section_name, section* parent_section, bool create_if_notexist)
+    section* portable_storage::open_section(std::string_view section_name, section* parent_section, bool create_if_notexist)
     {
       TRY_ENTRY();
       if (!parent_section) parent_section = &m_root;
@@ -152,7 +152,7 @@ namespace epee {
       {
         if(!create_if_notexist)
           return nullptr;
-        return insert_new_section(section_name, parent_section);
+        return insert_new_section(std::string{section_name}, parent_section);
       }
       CHECK_AND_ASSERT(pentry , nullptr);
       //check that section_entry we find is real "CSSection"
@@ -167,7 +167,7 @@ namespace epee {
       CATCH_ENTRY("portable_storage::open_section", nullptr);
     }
 
-    bool portable_storage::get_value(const std::string& value_name, storage_entry& val, section* parent_section)
+    bool portable_storage::get_value(std::string_view value_name, storage_entry& val, section* parent_section)
     {
       //TRY_ENTRY();
       if(!parent_section) parent_section = &m_root;
@@ -180,15 +180,11 @@ namespace epee {
       //CATCH_ENTRY("portable_storage::template<>get_value", false);
     }
 
-    storage_entry* portable_storage::find_storage_entry(const std::string& pentry_name, section* psection)
+    storage_entry* portable_storage::find_storage_entry(std::string_view pentry_name, section* psection)
     {
       TRY_ENTRY();
       CHECK_AND_ASSERT(psection, nullptr);
-      auto it = psection->m_entries.find(pentry_name);
-      if(it == psection->m_entries.end())
-        return nullptr;
-
-      return &it->second;
+      return psection->find(pentry_name);
       CATCH_ENTRY("portable_storage::find_storage_entry", nullptr);
     }
 
@@ -31,6 +31,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <exception>
 #include <boost/program_options.hpp>
 #include "common/command_line.h"
@@ -173,11 +174,29 @@ struct txpool_tx_meta_t
   uint8_t padding[76]; // till 192 bytes
 };
 
+/**
+ * @brief the kinds of per-height service node state records kept by the database
+ *
+ * short_term records form the recent state history (a full checkpoint followed by deltas),
+ * long_term records are standalone archived states and quorums records hold the quorum history
+ * kept for --store-full-quorum-history.
+ */
+enum class service_node_state_kind : uint8_t
+{
+  short_term,
+  long_term,
+  quorums,
+};
+
 #define DBF_SAFE       1
 #define DBF_FAST       2
 #define DBF_FASTEST    4
 #define DBF_RDONLY     8
 #define DBF_SALVAGE 0x10
+// Attach read-only to a database that another process (typically oxend) has open for writing:
+// implies DBF_RDONLY, never creates or resizes the environment, and shares the writer's lock file
+// so that the writer knows not to reuse pages we are still reading.
+#define DBF_ATTACH  0x20
 
 /***********************************
  * Exception Definitions
@@ -924,6 +943,20 @@ public:
    */
   virtual cryptonote::blobdata get_block_blob_from_height(uint64_t height) const = 0;
 
+  /**
+   * @brief fetch a block blob by height, without copying it
+   *
+   * Like get_block_blob_from_height, but returns a view of the blob as stored in the db.  The
+   * view is only valid for as long as the enclosing read (or write) txn is held, so the caller
+   * must already hold one, e.g. via db_rtxn_guard; the subclass should throw DB_ERROR if there
+   * is none.
+   *
+   * @param height the height to look for
+   *
+   * @return a view of the block blob
+   */
+  virtual std::string_view get_block_blob_view_from_height(uint64_t height) const = 0;
+
   /**
    * @brief fetch a block by height
    *
@@ -1298,6 +1331,36 @@ public:
    */
   virtual bool get_pruned_tx_blobs_from(const crypto::hash& h, size_t count, std::vector<cryptonote::blobdata> &bd) const = 0;
 
+  /**
+   * @brief fetches views of a number of pruned transaction blobs, without copying them
+   *
+   * Like get_pruned_tx_blobs_from, but appends views of the blobs as stored in the db.  As with
+   * get_block_blob_view_from_height, the caller must hold a read txn for as long as it uses
+   * the views.
+   *
+   * @param h the hash of the first transaction
+   * @param count the number of transactions
+   * @param views the vector to append the views to
+   *
+   * @return true iff the transactions were found
+   */
+  virtual bool get_pruned_tx_blob_views_from(const crypto::hash& h, size_t count, std::vector<std::string_view> &views) const = 0;
+
+  /**
+   * @brief fetches views of a transaction's blob, without copying it
+   *
+   * A full transaction blob is stored as two pieces: the pruned part followed by the prunable
+   * part, which may be empty if the db is pruned.  The caller must hold a read txn for as long
+   * as it uses the views (see get_block_blob_view_from_height).
+   *
+   * @param h the hash to look for
+   * @param pruned set to the pruned part of the transaction blob
+   * @param prunable set to the prunable part of the transaction blob
+   *
+   * @return true iff the transaction was found
+   */
+  virtual bool get_tx_blob_views(const crypto::hash& h, std::string_view &pruned, std::string_view &prunable) const = 0;
+
   /**
    * @brief fetches the prunable transaction blob with the given hash
    *
@@ -1752,6 +1815,48 @@ public:
   virtual bool for_all_outputs(std::function<bool(uint64_t amount, const crypto::hash &tx_hash, uint64_t height, size_t tx_idx)> f) const = 0;
   virtual bool for_all_outputs(uint64_t amount, const std::function<bool(uint64_t height)> &f) const = 0;
 
+  /**
+   * @brief runs a function over the raw blobs of a range of blocks
+   *
+   * Like for_blocks_range, but passes (block_height, block_blob) without parsing or copying the
+   * block: the view points into the database and is only valid during the call (or for as long
+   * as the caller holds an enclosing read txn, e.g. via db_rtxn_guard).
+   *
+   * @param h1 the start height
+   * @param h2 the end height (inclusive)
+   * @param std::function fn the function to run
+   *
+   * @return false if the function returns false for any block, otherwise true
+   */
+  virtual bool for_blocks_range_blobs(uint64_t h1, uint64_t h2, std::function<bool(uint64_t, std::string_view)> f) const = 0;
+
+  /**
+   * @brief runs a function over the raw blobs of all transactions stored
+   *
+   * Like for_all_transactions, but passes (transaction_hash, pruned_blob, prunable_blob) without
+   * parsing or copying; the views have the same lifetime as in for_blocks_range_blobs.  The
+   * prunable view is empty if `pruned` is true (or the transaction has been pruned).
+   *
+   * @param std::function fn the function to run
+   * @param bool pruned whether to skip looking up the prunable part
+   *
+   * @return false if the function returns false for any transaction, otherwise true
+   */
+  virtual bool for_all_transaction_blobs(std::function<bool(const crypto::hash&, std::string_view, std::string_view)> f, bool pruned) const = 0;
+
+  /**
+   * @brief runs a function over the stored data of all outputs
+   *
+   * Passes (amount, amount_index, global_output_id, output_data) for every output, in amount
+   * then amount index order, without the extra tx lookup that for_all_outputs does.  For
+   * pre-RingCT (amount != 0) outputs the commitment is left zeroed rather than computed.
+   *
+   * @param std::function f the function to run
+   *
+   * @return false if the function returns false for any output, otherwise true
+   */
+  virtual bool for_all_output_data(std::function<bool(uint64_t amount, uint64_t amount_index, uint64_t output_id, const output_data_t& data)> f) const = 0;
+
   /**
    * @brief runs a function over all alternative blocks stored
    *
@@ -1809,6 +1914,18 @@ public:
   virtual bool get_service_node_data(std::string &data, bool long_term) const = 0;
   virtual void clear_service_node_data()                                      = 0;
 
+  /// Stores (or replaces) the serialized service node state record of the given kind at `height`.
+  virtual void set_service_node_state(service_node_state_kind kind, uint64_t height, std::string_view data) = 0;
+
+  /// Calls `f(height, data)` for the stored records of the given kind, starting at the first
+  /// record at or above `from_height` and going up, or (if `reverse` is true) at the last record
+  /// at or below `from_height` and going down.  Stops early if `f` returns false.
+  virtual void for_each_service_node_state(service_node_state_kind kind, uint64_t from_height, bool reverse,
+      std::function<bool(uint64_t height, std::string_view data)> f) const = 0;
+
+  /// Removes the records of the given kind with heights in [begin, end).
+  virtual void remove_service_node_states(service_node_state_kind kind, uint64_t begin, uint64_t end) = 0;
+
   /// Updates the given proof data with the latest stored info for the given service node.  Returns
   /// true if found (and fields updated), false otherwise.
   virtual bool get_service_node_proof(const crypto::public_key &pubkey, service_nodes::proof_info &proof) const = 0;
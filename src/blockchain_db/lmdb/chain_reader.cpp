@@ -0,0 +1,101 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "chain_reader.h"
+#include "db_lmdb.h"
+
+#undef OXEN_DEFAULT_LOG_CATEGORY
+#define OXEN_DEFAULT_LOG_CATEGORY "blockchain.db.lmdb"
+
+namespace cryptonote
+{
+
+chain_reader::chain_reader(const fs::path& folder, network_type nettype)
+  : m_db{std::make_unique<BlockchainLMDB>(false /*batch_transactions*/)}
+{
+  m_db->open(folder, nettype, DBF_RDONLY | DBF_ATTACH);
+  // open() logs and leaves the db closed, rather than throwing, on a version mismatch
+  if (!m_db->is_open())
+    throw DB_ERROR("Failed to attach to " + folder.u8string() + ": database is from an incompatible version");
+  MINFO("Attached to " << folder << " at height " << m_db->height());
+}
+
+chain_reader::~chain_reader()
+{
+  if (m_db->is_open())
+    m_db->close();
+}
+
+db_rtxn_guard chain_reader::snapshot()
+{
+  return db_rtxn_guard{*m_db};
+}
+
+uint64_t chain_reader::height() const
+{
+  return m_db->height();
+}
+
+crypto::hash chain_reader::top_block_hash() const
+{
+  return m_db->top_block_hash();
+}
+
+std::string_view chain_reader::block_blob(uint64_t height) const
+{
+  return m_db->get_block_blob_view_from_height(height);
+}
+
+bool chain_reader::for_each_block(uint64_t begin, uint64_t end, std::function<bool(uint64_t height, std::string_view blob)> f) const
+{
+  if (begin >= end)
+    return true;
+  return m_db->for_blocks_range_blobs(begin, end - 1, std::move(f));
+}
+
+bool chain_reader::for_each_tx(std::function<bool(const crypto::hash& hash, std::string_view pruned, std::string_view prunable)> f, bool include_prunable) const
+{
+  return m_db->for_all_transaction_blobs(std::move(f), !include_prunable);
+}
+
+bool chain_reader::for_each_output(std::function<bool(uint64_t amount, uint64_t amount_index, uint64_t output_id, const output_data_t& data)> f) const
+{
+  return m_db->for_all_output_data(std::move(f));
+}
+
+BlockchainDB& chain_reader::db()
+{
+  return *m_db;
+}
+
+const BlockchainDB& chain_reader::db() const
+{
+  return *m_db;
+}
+
+}  // namespace cryptonote
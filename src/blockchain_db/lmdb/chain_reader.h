@@ -0,0 +1,104 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include "blockchain_db/blockchain_db.h"
+#include "common/fs.h"
+
+namespace cryptonote
+{
+
+class BlockchainLMDB;
+
+/**
+ * @brief lightweight, read-only access to the blockchain of a running daemon
+ *
+ * Attaches to an existing lmdb directory with DBF_ATTACH, so it can be used by block explorers,
+ * stats jobs and indexers while oxend keeps writing to the same database.  It doesn't construct a
+ * Blockchain (or any of the service node, ONS, or pool state that goes with one); it only exposes
+ * the raw stored data, handing out views directly into the memory map instead of copies.
+ *
+ * Every call runs in its own read txn unless a snapshot() is held, in which case they all see the
+ * same chain state and any views they hand out stay valid until the snapshot is released.  Don't
+ * hold a snapshot longer than needed: pages the daemon frees while it is held can't be reused, so
+ * the database file grows.  As with BlockchainDB, snapshots are per-thread.
+ */
+class chain_reader
+{
+public:
+  /**
+   * @brief attaches to the lmdb database directory at `folder` (e.g. ~/.oxen/lmdb)
+   *
+   * Throws DB_OPEN_FAILURE if there is no database there, and DB_ERROR if it can't be opened or
+   * was written by an incompatible version.
+   */
+  explicit chain_reader(const fs::path& folder, network_type nettype = network_type::MAINNET);
+  ~chain_reader();
+
+  chain_reader(const chain_reader&) = delete;
+  chain_reader& operator=(const chain_reader&) = delete;
+
+  /// Holds a read txn open on the calling thread for as long as it lives.
+  db_rtxn_guard snapshot();
+
+  /// Number of blocks in the chain, i.e. the top block height plus one.
+  uint64_t height() const;
+
+  crypto::hash top_block_hash() const;
+
+  /// The stored blob of the block at `height`.  Requires a snapshot(), which the view lives as
+  /// long as.  Throws BLOCK_DNE if the block doesn't exist.
+  std::string_view block_blob(uint64_t height) const;
+
+  /// Calls f(height, block_blob) for each block in [begin, end) until f returns false.  Returns
+  /// false if f did.
+  bool for_each_block(uint64_t begin, uint64_t end, std::function<bool(uint64_t height, std::string_view blob)> f) const;
+
+  /// Calls f(tx_hash, pruned_blob, prunable_blob) for every stored transaction until f returns
+  /// false.  The prunable part is only looked up if `include_prunable` is set (and is empty for
+  /// pruned txs).  Returns false if f did.
+  bool for_each_tx(std::function<bool(const crypto::hash& hash, std::string_view pruned, std::string_view prunable)> f, bool include_prunable = false) const;
+
+  /// Calls f(amount, amount_index, global_output_id, data) for every output until f returns
+  /// false.  See BlockchainDB::for_all_output_data.  Returns false if f did.
+  bool for_each_output(std::function<bool(uint64_t amount, uint64_t amount_index, uint64_t output_id, const output_data_t& data)> f) const;
+
+  /// The underlying (read-only) db, for anything not covered above.
+  BlockchainDB& db();
+  const BlockchainDB& db() const;
+
+private:
+  std::unique_ptr<BlockchainLMDB> m_db;
+};
+
+}  // namespace cryptonote
@@ -31,6 +31,7 @@
 #include <boost/format.hpp>
 #include <boost/circular_buffer.hpp>
 #include <boost/endian/conversion.hpp>
+#include <algorithm>
 #include <memory>
 #include <cstring>
 #include <type_traits>
@@ -252,10 +253,11 @@ const char* const LMDB_HF_STARTING_HEIGHTS = "hf_starting_heights";
 const char* const LMDB_HF_VERSIONS = "hf_versions";
 const char* const LMDB_SERVICE_NODE_DATA = "service_node_data";
 const char* const LMDB_SERVICE_NODE_LATEST = "service_node_proofs"; // contains the latest data sent with a proof: time, aux keys, ip, ports
+const char* const LMDB_SERVICE_NODE_STATES = "service_node_states"; // per-height service node state records, keyed by kind and height
 
 const char* const LMDB_PROPERTIES = "properties";
 
-constexpr unsigned int LMDB_DB_COUNT = 23; // Should agree with the number of db's above
+constexpr unsigned int LMDB_DB_COUNT = 24; // Should agree with the number of db's above
 
 const char zerokey[8] = {0};
 const MDB_val zerokval = { sizeof(zerokey), (void *)zerokey };
@@ -914,6 +916,8 @@ void BlockchainLMDB::add_block(const block& blk, size_t block_weight, uint64_t l
   if (result)
     throw0(DB_ERROR(lmdb_error("Failed to add block height by hash to db transaction: ", result).c_str()));
 
+  block_info_cache_added(bi);
+
   // we use weight as a proxy for size, since we don't have size but weight is >= size
   // and often actually equal
   m_cum_size += block_weight;
@@ -955,6 +959,8 @@ void BlockchainLMDB::remove_block()
 
   if ((result = mdb_cursor_del(m_cur_block_info, 0)))
       throw1(DB_ERROR(lmdb_error("Failed to add removal of block info to db transaction: ", result).c_str()));
+
+  block_info_cache_removed(m_height - 1);
 }
 
 uint64_t BlockchainLMDB::add_transaction_data(const crypto::hash& blk_hash, const std::pair<transaction, blobdata>& txp, const crypto::hash& tx_hash, const crypto::hash& tx_prunable_hash)
@@ -1409,6 +1415,10 @@ void BlockchainLMDB::open(const fs::path& filename, cryptonote::network_type net
     if (!fs::is_directory(filename))
       throw0(DB_OPEN_FAILURE("LMDB needs a directory path, but a file was passed"));
   }
+  else if (db_flags & DBF_ATTACH)
+  {
+    throw0(DB_OPEN_FAILURE("Cannot attach to " + filename.u8string() + ": no such database"));
+  }
   else
   {
     if (std::error_code ec; !fs::create_directories(filename, ec))
@@ -1450,7 +1460,9 @@ void BlockchainLMDB::open(const fs::path& filename, cryptonote::network_type net
     mdb_flags |= MDB_NOSYNC;
   if (db_flags & DBF_FASTEST)
     mdb_flags |= MDB_NOSYNC | MDB_WRITEMAP | MDB_MAPASYNC;
-  if (db_flags & DBF_RDONLY)
+  // DBF_ATTACH implies read-only.  It deliberately doesn't use MDB_NOLOCK: registering in the
+  // writer's reader table is what keeps it from recycling pages under our read txns.
+  if (db_flags & (DBF_RDONLY | DBF_ATTACH))
     mdb_flags = MDB_RDONLY;
   if (db_flags & DBF_SALVAGE)
     mdb_flags |= MDB_PREVSNAPSHOT;
@@ -1464,7 +1476,13 @@ void BlockchainLMDB::open(const fs::path& filename, cryptonote::network_type net
   mdb_env_info(m_env, &mei);
   uint64_t cur_mapsize = (uint64_t)mei.me_mapsize;
 
-  if (cur_mapsize < mapsize)
+  // When attached the writer owns the map size: we just use whatever the file currently is, and
+  // pick up the writer's resizes through lmdb_txn_begin's MDB_MAP_RESIZED handling.
+  if (db_flags & DBF_ATTACH)
+  {
+    LOG_PRINT_L1("Attached read-only to LMDB with memory map size: " << cur_mapsize);
+  }
+  else if (cur_mapsize < mapsize)
   {
     if (auto result = mdb_env_set_mapsize(m_env, mapsize))
       throw0(DB_ERROR(lmdb_error("Failed to set max memory map size: ", result).c_str()));
@@ -1473,7 +1491,7 @@ void BlockchainLMDB::open(const fs::path& filename, cryptonote::network_type net
     LOG_PRINT_L1("LMDB memory map size: " << cur_mapsize);
   }
 
-  if (need_resize())
+  if (!(db_flags & DBF_ATTACH) && need_resize())
   {
     LOG_PRINT_L0("LMDB memory map needs to be resized, doing that now.");
     do_resize();
@@ -1529,6 +1547,13 @@ void BlockchainLMDB::open(const fs::path& filename, cryptonote::network_type net
 
   lmdb_db_open(txn, LMDB_SERVICE_NODE_LATEST, MDB_CREATE, m_service_node_proofs, "Failed to open db handle for m_service_node_proofs");
 
+  // Older databases don't have this one, and we can't create it when opening read-only; in that
+  // case there are simply no records to read.
+  if (!(mdb_flags & MDB_RDONLY))
+    lmdb_db_open(txn, LMDB_SERVICE_NODE_STATES, MDB_INTEGERKEY | MDB_CREATE, m_service_node_states, "Failed to open db handle for m_service_node_states");
+  else if (mdb_dbi_open(txn, LMDB_SERVICE_NODE_STATES, MDB_INTEGERKEY, &m_service_node_states))
+    m_service_node_states = 0;
+
   lmdb_db_open(txn, LMDB_PROPERTIES, MDB_CREATE, m_properties, "Failed to open db handle for m_properties");
 
   mdb_set_dupsort(txn, m_spent_keys, compare_hash32);
@@ -1641,6 +1666,7 @@ void BlockchainLMDB::close()
   }
   this->sync();
   m_tinfo.reset();
+  block_info_cache_clear();
 
   // FIXME: not yet thread safe!!!  Use with care.
   mdb_env_close(m_env);
@@ -1682,6 +1708,7 @@ void BlockchainLMDB::reset()
     throw0(DB_ERROR(lmdb_error("Failed to drop m_blocks: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_block_info, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_block_info: ", result).c_str()));
+  block_info_cache_clear();
   if (auto result = mdb_drop(txn, m_block_heights, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_block_heights: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_block_checkpoints, 0))
@@ -1711,6 +1738,8 @@ void BlockchainLMDB::reset()
     throw0(DB_ERROR(lmdb_error("Failed to drop m_hf_versions: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_service_node_data, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_service_node_data: ", result).c_str()));
+  if (auto result = mdb_drop(txn, m_service_node_states, 0))
+    throw0(DB_ERROR(lmdb_error("Failed to drop m_service_node_states: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_properties, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_properties: ", result).c_str()));
 
@@ -2531,7 +2560,8 @@ bool BlockchainLMDB::block_exists(const crypto::hash& h, uint64_t *height) const
 template <typename T,
           std::enable_if_t<std::is_same_v<T, cryptonote::block> ||
                            std::is_same_v<T, cryptonote::block_header> ||
-                           std::is_same_v<T, cryptonote::blobdata>, int>>
+                           std::is_same_v<T, cryptonote::blobdata> ||
+                           std::is_same_v<T, std::string_view>, int>>
 T BlockchainLMDB::get_and_convert_block_blob_from_height(uint64_t height) const
 {
   // NOTE: Avoid any intermediary functions like taking a blob, then converting
@@ -2545,6 +2575,11 @@ T BlockchainLMDB::get_and_convert_block_blob_from_height(uint64_t height) const
   check_open();
 
   TXN_PREFIX_RDONLY();
+  if constexpr (std::is_same_v<T, std::string_view>)
+  {
+    if (my_rtxn) // the view would point at the txn's pages after it ends
+      throw0(DB_ERROR("Attempt to get a block blob view without an open read txn"));
+  }
   RCURSOR(blocks);
 
   MDB_val_copy<uint64_t> key(height);
@@ -2568,7 +2603,7 @@ T BlockchainLMDB::get_and_convert_block_blob_from_height(uint64_t height) const
     serialization::binary_string_unarchiver ba{blob};
     serialization::value(ba, result);
   }
-  else if constexpr (std::is_same_v<T, cryptonote::blobdata>)
+  else if constexpr (std::is_same_v<T, cryptonote::blobdata> || std::is_same_v<T, std::string_view>)
   {
     result = blob;
   }
@@ -2624,11 +2659,214 @@ cryptonote::blobdata BlockchainLMDB::get_block_blob_from_height(uint64_t height)
   return result;
 }
 
+std::string_view BlockchainLMDB::get_block_blob_view_from_height(uint64_t height) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  return get_and_convert_block_blob_from_height<std::string_view>(height);
+}
+
+void mdb_block_info_cache::push_back(const mdb_block_info& bi)
+{
+  timestamps.push_back(bi.bi_timestamp);
+  coins.push_back(bi.bi_coins);
+  weights.push_back(bi.bi_weight);
+  long_term_weights.push_back(bi.bi_long_term_block_weight);
+  cum_rct.push_back(bi.bi_cum_rct);
+  cum_diffs.push_back(bi.bi_diff);
+  hashes.push_back(bi.bi_hash);
+}
+
+void mdb_block_info_cache::truncate(uint64_t height)
+{
+  if (height <= start)
+    return clear();
+  if (height >= end())
+    return;
+  const size_t size = height - start;
+  timestamps.resize(size);
+  coins.resize(size);
+  weights.resize(size);
+  long_term_weights.resize(size);
+  cum_rct.resize(size);
+  cum_diffs.resize(size);
+  hashes.resize(size);
+}
+
+void mdb_block_info_cache::trim_front(uint64_t new_start)
+{
+  if (new_start <= start)
+    return;
+  if (new_start >= end())
+    return clear();
+  const size_t n = new_start - start;
+  timestamps.erase(timestamps.begin(), timestamps.begin() + n);
+  coins.erase(coins.begin(), coins.begin() + n);
+  weights.erase(weights.begin(), weights.begin() + n);
+  long_term_weights.erase(long_term_weights.begin(), long_term_weights.begin() + n);
+  cum_rct.erase(cum_rct.begin(), cum_rct.begin() + n);
+  cum_diffs.erase(cum_diffs.begin(), cum_diffs.begin() + n);
+  hashes.erase(hashes.begin(), hashes.begin() + n);
+  start = new_start;
+}
+
+void mdb_block_info_cache::clear()
+{
+  timestamps.clear();
+  coins.clear();
+  weights.clear();
+  long_term_weights.clear();
+  cum_rct.clear();
+  cum_diffs.clear();
+  hashes.clear();
+  start = committed_end = 0;
+}
+
+template <typename F>
+bool BlockchainLMDB::read_block_info_cache(uint64_t begin, uint64_t end, F&& f) const
+{
+  if (begin >= end)
+    return false;
+  const bool writer = m_write_txn && m_writer == boost::this_thread::get_id();
+  for (int attempt = 0; attempt < 2; ++attempt)
+  {
+    {
+      std::shared_lock lock{m_block_info_cache_mutex};
+      const auto& c = m_block_info_cache;
+      const uint64_t visible_end = writer ? c.end() : std::min(c.end(), c.committed_end);
+      if (!c.empty() && begin >= c.start && end <= visible_end)
+      {
+        f(c, begin - c.start);
+        return true;
+      }
+      // We only ever extend the cache forwards, so lookups before its start go to the db
+      if (attempt > 0 || (!c.empty() && begin < c.start))
+        return false;
+    }
+    if (!extend_block_info_cache(writer))
+      return false;
+  }
+  return false;
+}
+
+bool BlockchainLMDB::extend_block_info_cache(bool writer) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  // Another process may be writing to a read-only db, so we can't keep the cache in sync
+  if (is_read_only())
+    return false;
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(block_info);
+
+  std::unique_lock lock{m_block_info_cache_mutex};
+  auto& c = m_block_info_cache;
+  if (!writer)
+  {
+    // Only load records from a snapshot of the latest commit when there are no pending changes:
+    // anything else could put records into the cache that don't match what the writer sees.
+    if (c.dirty || (!c.empty() && c.committed_end != c.end()))
+      return false;
+    MDB_envinfo info;
+    if (mdb_env_info(m_env, &info) || mdb_txn_id(m_txn) != info.me_last_txnid)
+      return false;
+  }
+
+  MDB_stat db_stats;
+  if (int result = mdb_stat(m_txn, m_blocks, &db_stats))
+    throw0(DB_ERROR(lmdb_error("Failed to query m_blocks: ", result).c_str()));
+  const uint64_t h = db_stats.ms_entries;
+  if (c.empty())
+  {
+    c.clear();
+    c.start = c.committed_end = h > BLOCK_INFO_CACHE_BLOCKS ? h - BLOCK_INFO_CACHE_BLOCKS : 0;
+  }
+  if (c.end() >= h)
+    return false;
+
+  uint64_t height = c.end();
+  MDB_val v{sizeof(height), (void*)&height};
+  int result = mdb_cursor_get(m_cur_block_info, (MDB_val *)&zerokval, &v, MDB_GET_BOTH);
+  while (!result)
+  {
+    const auto* bi = static_cast<const mdb_block_info*>(v.mv_data);
+    for (size_t i = 0, n = v.mv_size / sizeof(mdb_block_info); i < n; ++i, ++bi)
+    {
+      // MDB_NEXT_MULTIPLE hands back the whole page of duplicates containing the next record, so
+      // the first page after the one we positioned on can start with records we already have.
+      if (bi->bi_height < c.end())
+        continue;
+      if (bi->bi_height != c.end())
+        throw0(DB_ERROR(("Unexpected block info height " + std::to_string(bi->bi_height) + ", expected " + std::to_string(c.end())).c_str()));
+      c.push_back(*bi);
+    }
+    if (c.end() >= h)
+      break;
+    MDB_val k2;
+    result = mdb_cursor_get(m_cur_block_info, &k2, &v, MDB_NEXT_MULTIPLE);
+  }
+  if (result && result != MDB_NOTFOUND)
+    throw0(DB_ERROR(lmdb_error("Error attempting to retrieve block_info from the db: ", result).c_str()));
+
+  if (!c.dirty)
+    c.committed_end = c.end();
+  return true;
+}
+
+void BlockchainLMDB::block_info_cache_added(const mdb_block_info& bi)
+{
+  std::unique_lock lock{m_block_info_cache_mutex};
+  auto& c = m_block_info_cache;
+  c.dirty = true;
+  // If this isn't the next record the cache is simply left behind; it gets extended again when
+  // needed.
+  if (c.empty() || bi.bi_height != c.end())
+    return;
+  c.push_back(bi);
+  if (c.end() - c.start >= 2 * BLOCK_INFO_CACHE_BLOCKS)
+    c.trim_front(c.end() - BLOCK_INFO_CACHE_BLOCKS);
+}
+
+void BlockchainLMDB::block_info_cache_removed(uint64_t height)
+{
+  std::unique_lock lock{m_block_info_cache_mutex};
+  auto& c = m_block_info_cache;
+  c.dirty = true;
+  c.truncate(height);
+  c.committed_end = std::min(c.committed_end, height);
+}
+
+void BlockchainLMDB::block_info_cache_committed()
+{
+  std::unique_lock lock{m_block_info_cache_mutex};
+  auto& c = m_block_info_cache;
+  c.committed_end = c.end();
+  c.dirty = false;
+}
+
+void BlockchainLMDB::block_info_cache_aborted()
+{
+  std::unique_lock lock{m_block_info_cache_mutex};
+  auto& c = m_block_info_cache;
+  if (c.dirty)
+    c.truncate(c.committed_end);
+  c.dirty = false;
+}
+
+void BlockchainLMDB::block_info_cache_clear()
+{
+  std::unique_lock lock{m_block_info_cache_mutex};
+  m_block_info_cache.clear();
+  m_block_info_cache.dirty = false;
+}
+
 uint64_t BlockchainLMDB::get_block_timestamp(const uint64_t& height) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
+  if (uint64_t ret; read_block_info_cache(height, height + 1, [&](const mdb_block_info_cache& c, size_t i) { ret = c.timestamps[i]; }))
+    return ret;
+
   TXN_PREFIX_RDONLY();
   RCURSOR(block_info);
 
@@ -2657,6 +2895,13 @@ std::vector<uint64_t> BlockchainLMDB::get_block_cumulative_rct_outputs(const std
     return {};
   res.reserve(heights.size());
 
+  const auto [min_height, max_height] = std::minmax_element(heights.begin(), heights.end());
+  if (read_block_info_cache(*min_height, *max_height + 1, [&](const mdb_block_info_cache& c, size_t i) {
+        for (uint64_t height : heights)
+          res.push_back(c.cum_rct[i + (height - *min_height)]);
+      }))
+    return res;
+
   TXN_PREFIX_RDONLY();
   RCURSOR(block_info);
 
@@ -2727,6 +2972,9 @@ size_t BlockchainLMDB::get_block_weight(const uint64_t& height) const
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
+  if (size_t ret; read_block_info_cache(height, height + 1, [&](const mdb_block_info_cache& c, size_t i) { ret = c.weights[i]; }))
+    return ret;
+
   TXN_PREFIX_RDONLY();
   RCURSOR(block_info);
 
@@ -2744,7 +2992,7 @@ size_t BlockchainLMDB::get_block_weight(const uint64_t& height) const
   return ret;
 }
 
-std::vector<uint64_t> BlockchainLMDB::get_block_info_64bit_fields(uint64_t start_height, size_t count, uint64_t (*extract)(const mdb_block_info* bi_data)) const
+std::vector<uint64_t> BlockchainLMDB::get_block_info_64bit_fields(uint64_t start_height, size_t count, uint64_t (*extract)(const mdb_block_info* bi_data), std::vector<uint64_t> mdb_block_info_cache::*cached) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
@@ -2757,6 +3005,13 @@ std::vector<uint64_t> BlockchainLMDB::get_block_info_64bit_fields(uint64_t start
     throw0(DB_ERROR(("Height " + std::to_string(start_height) + " not in blockchain").c_str()));
 
   std::vector<uint64_t> ret;
+  const uint64_t end = start_height + std::min<uint64_t>(count, h - start_height);
+  if (read_block_info_cache(start_height, end, [&](const mdb_block_info_cache& c, size_t i) {
+        const auto& col = c.*cached;
+        ret.assign(col.begin() + i, col.begin() + i + (end - start_height));
+      }))
+    return ret;
+
   ret.reserve(count);
 
   MDB_val v;
@@ -2849,13 +3104,13 @@ void BlockchainLMDB::add_max_block_size(uint64_t sz)
 std::vector<uint64_t> BlockchainLMDB::get_block_weights(uint64_t start_height, size_t count) const
 {
   return get_block_info_64bit_fields(start_height, count,
-      [](const mdb_block_info* bi) { return bi->bi_weight; });
+      [](const mdb_block_info* bi) { return bi->bi_weight; }, &mdb_block_info_cache::weights);
 }
 
 std::vector<uint64_t> BlockchainLMDB::get_long_term_block_weights(uint64_t start_height, size_t count) const
 {
   return get_block_info_64bit_fields(start_height, count,
-      [](const mdb_block_info* bi) { return bi->bi_long_term_block_weight; });
+      [](const mdb_block_info* bi) { return bi->bi_long_term_block_weight; }, &mdb_block_info_cache::long_term_weights);
 }
 
 difficulty_type BlockchainLMDB::get_block_cumulative_difficulty(const uint64_t& height) const
@@ -2863,6 +3118,9 @@ difficulty_type BlockchainLMDB::get_block_cumulative_difficulty(const uint64_t&
   LOG_PRINT_L3("BlockchainLMDB::" << __func__ << "  height: " << height);
   check_open();
 
+  if (difficulty_type ret; read_block_info_cache(height, height + 1, [&](const mdb_block_info_cache& c, size_t i) { ret = c.cum_diffs[i]; }))
+    return ret;
+
   TXN_PREFIX_RDONLY();
   RCURSOR(block_info);
 
@@ -2902,6 +3160,9 @@ uint64_t BlockchainLMDB::get_block_already_generated_coins(const uint64_t& heigh
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
+  if (uint64_t ret; read_block_info_cache(height, height + 1, [&](const mdb_block_info_cache& c, size_t i) { ret = c.coins[i]; }))
+    return ret;
+
   TXN_PREFIX_RDONLY();
   RCURSOR(block_info);
 
@@ -2924,6 +3185,9 @@ uint64_t BlockchainLMDB::get_block_long_term_weight(const uint64_t& height) cons
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
+  if (uint64_t ret; read_block_info_cache(height, height + 1, [&](const mdb_block_info_cache& c, size_t i) { ret = c.long_term_weights[i]; }))
+    return ret;
+
   TXN_PREFIX_RDONLY();
   RCURSOR(block_info);
 
@@ -2946,6 +3210,9 @@ crypto::hash BlockchainLMDB::get_block_hash_from_height(const uint64_t& height)
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
+  if (crypto::hash ret; read_block_info_cache(height, height + 1, [&](const mdb_block_info_cache& c, size_t i) { ret = c.hashes[i]; }))
+    return ret;
+
   TXN_PREFIX_RDONLY();
   RCURSOR(block_info);
 
@@ -2983,6 +3250,11 @@ std::vector<crypto::hash> BlockchainLMDB::get_hashes_range(const uint64_t& h1, c
   check_open();
   std::vector<crypto::hash> v;
 
+  if (h1 <= h2 && read_block_info_cache(h1, h2 + 1, [&](const mdb_block_info_cache& c, size_t i) {
+        v.assign(c.hashes.begin() + i, c.hashes.begin() + i + (h2 + 1 - h1));
+      }))
+    return v;
+
   for (uint64_t height = h1; height <= h2; ++height)
   {
     v.push_back(get_block_hash_from_height(height));
@@ -3145,6 +3417,26 @@ bool BlockchainLMDB::get_tx_blob(const crypto::hash& h, cryptonote::blobdata &bd
   check_open();
 
   TXN_PREFIX_RDONLY();
+
+  std::string_view pruned, prunable;
+  if (!get_tx_blob_views(h, pruned, prunable))
+    return false;
+
+  bd.reserve(pruned.size() + prunable.size());
+  bd.append(pruned);
+  bd.append(prunable);
+
+  return true;
+}
+
+bool BlockchainLMDB::get_tx_blob_views(const crypto::hash& h, std::string_view &pruned, std::string_view &prunable) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  if (my_rtxn)
+    throw0(DB_ERROR("Attempt to get tx blob views without an open read txn"));
   RCURSOR(tx_indices);
   RCURSOR(txs_pruned);
   RCURSOR(txs_prunable);
@@ -3167,9 +3459,8 @@ bool BlockchainLMDB::get_tx_blob(const crypto::hash& h, cryptonote::blobdata &bd
   else if (get_result)
     throw0(DB_ERROR(lmdb_error("DB error attempting to fetch tx from hash", get_result).c_str()));
 
-  bd.reserve(result0.mv_size + result1.mv_size);
-  bd.append(reinterpret_cast<char*>(result0.mv_data), result0.mv_size);
-  bd.append(reinterpret_cast<char*>(result1.mv_data), result1.mv_size);
+  pruned = {reinterpret_cast<const char*>(result0.mv_data), result0.mv_size};
+  prunable = {reinterpret_cast<const char*>(result1.mv_data), result1.mv_size};
 
   return true;
 }
@@ -3211,10 +3502,33 @@ bool BlockchainLMDB::get_pruned_tx_blobs_from(const crypto::hash& h, size_t coun
     return true;
 
   TXN_PREFIX_RDONLY();
+
+  std::vector<std::string_view> views;
+  if (!get_pruned_tx_blob_views_from(h, count, views))
+    return false;
+
+  bd.reserve(bd.size() + views.size());
+  for (const auto& view : views)
+    bd.emplace_back(view);
+
+  return true;
+}
+
+bool BlockchainLMDB::get_pruned_tx_blob_views_from(const crypto::hash& h, size_t count, std::vector<std::string_view> &views) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  if (!count)
+    return true;
+
+  TXN_PREFIX_RDONLY();
+  if (my_rtxn)
+    throw0(DB_ERROR("Attempt to get pruned tx blob views without an open read txn"));
   RCURSOR(tx_indices);
   RCURSOR(txs_pruned);
 
-  bd.reserve(bd.size() + count);
+  views.reserve(views.size() + count);
 
   MDB_val_set(v, h);
   MDB_val result;
@@ -3236,7 +3550,7 @@ bool BlockchainLMDB::get_pruned_tx_blobs_from(const crypto::hash& h, size_t coun
       return false;
     if (res)
       throw0(DB_ERROR(lmdb_error("DB error attempting to fetch tx blob", res).c_str()));
-    bd.emplace_back(reinterpret_cast<char*>(result.mv_data), result.mv_size);
+    views.emplace_back(reinterpret_cast<const char*>(result.mv_data), result.mv_size);
   }
 
   return true;
@@ -3710,6 +4024,138 @@ bool BlockchainLMDB::for_all_outputs(uint64_t amount, const std::function<bool(u
   return fret;
 }
 
+bool BlockchainLMDB::for_blocks_range_blobs(uint64_t h1, uint64_t h2, std::function<bool(uint64_t, std::string_view)> f) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(blocks);
+
+  MDB_val_set(k, h1);
+  MDB_val v;
+  bool fret = true;
+
+  MDB_cursor_op op = MDB_SET;
+  while (1)
+  {
+    int ret = mdb_cursor_get(m_cur_blocks, &k, &v, op);
+    op = MDB_NEXT;
+    if (ret == MDB_NOTFOUND)
+      break;
+    if (ret)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate blocks: ", ret).c_str()));
+    uint64_t height = *(const uint64_t*)k.mv_data;
+    if (height > h2)
+      break;
+    if (!f(height, {reinterpret_cast<const char*>(v.mv_data), v.mv_size})) {
+      fret = false;
+      break;
+    }
+  }
+
+  return fret;
+}
+
+bool BlockchainLMDB::for_all_transaction_blobs(std::function<bool(const crypto::hash&, std::string_view, std::string_view)> f, bool pruned) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(txs_pruned);
+  RCURSOR(txs_prunable);
+  RCURSOR(tx_indices);
+
+  MDB_val k;
+  MDB_val v;
+  bool fret = true;
+
+  MDB_cursor_op op = MDB_FIRST;
+  while (1)
+  {
+    int ret = mdb_cursor_get(m_cur_tx_indices, &k, &v, op);
+    op = MDB_NEXT;
+    if (ret == MDB_NOTFOUND)
+      break;
+    if (ret)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate transactions: ", ret).c_str()));
+
+    const txindex *ti = (const txindex *)v.mv_data;
+    const crypto::hash hash = ti->key;
+    k.mv_data = (void *)&ti->data.tx_id;
+    k.mv_size = sizeof(ti->data.tx_id);
+
+    ret = mdb_cursor_get(m_cur_txs_pruned, &k, &v, MDB_SET);
+    if (ret == MDB_NOTFOUND)
+      break;
+    if (ret)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate transactions: ", ret).c_str()));
+    std::string_view pruned_blob{reinterpret_cast<const char*>(v.mv_data), v.mv_size};
+
+    std::string_view prunable_blob;
+    if (!pruned)
+    {
+      ret = mdb_cursor_get(m_cur_txs_prunable, &k, &v, MDB_SET);
+      if (ret == 0)
+        prunable_blob = {reinterpret_cast<const char*>(v.mv_data), v.mv_size};
+      else if (ret != MDB_NOTFOUND)
+        throw0(DB_ERROR(lmdb_error("Failed to get prunable tx data the db: ", ret).c_str()));
+    }
+
+    if (!f(hash, pruned_blob, prunable_blob)) {
+      fret = false;
+      break;
+    }
+  }
+
+  return fret;
+}
+
+bool BlockchainLMDB::for_all_output_data(std::function<bool(uint64_t amount, uint64_t amount_index, uint64_t output_id, const output_data_t& data)> f) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(output_amounts);
+
+  MDB_val k;
+  MDB_val v;
+  bool fret = true;
+
+  output_data_t pre_rct_data{};
+  MDB_cursor_op op = MDB_FIRST;
+  while (1)
+  {
+    int ret = mdb_cursor_get(m_cur_output_amounts, &k, &v, op);
+    op = MDB_NEXT;
+    if (ret == MDB_NOTFOUND)
+      break;
+    if (ret)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate outputs: ", ret).c_str()));
+    uint64_t amount = *(const uint64_t*)k.mv_data;
+    bool keep_going;
+    if (amount == 0)
+    {
+      const outkey *okp = (const outkey *)v.mv_data;
+      keep_going = f(amount, okp->amount_index, okp->output_id, okp->data);
+    }
+    else
+    {
+      const pre_rct_outkey *okp = (const pre_rct_outkey *)v.mv_data;
+      memcpy(&pre_rct_data, &okp->data, sizeof(pre_rct_output_data_t));
+      keep_going = f(amount, okp->amount_index, okp->output_id, pre_rct_data);
+    }
+    if (!keep_going) {
+      fret = false;
+      break;
+    }
+  }
+
+  return fret;
+}
+
 // batch_num_blocks: (optional) Used to check if resize needed before batch transaction starts.
 bool BlockchainLMDB::batch_start(uint64_t batch_num_blocks, uint64_t batch_bytes)
 {
@@ -3773,6 +4219,7 @@ void BlockchainLMDB::batch_commit()
   m_write_txn->commit();
   TIME_MEASURE_FINISH(time1);
   time_commit1 += time1;
+  block_info_cache_committed();
   LOG_PRINT_L3("batch transaction: committed");
 
   m_write_txn = nullptr;
@@ -3810,10 +4257,12 @@ void BlockchainLMDB::batch_stop()
     m_write_txn->commit();
     TIME_MEASURE_FINISH(time1);
     time_commit1 += time1;
+    block_info_cache_committed();
     cleanup_batch();
   }
   catch (const std::exception &e)
   {
+    block_info_cache_clear();
     cleanup_batch();
     throw;
   }
@@ -3840,6 +4289,7 @@ void BlockchainLMDB::batch_abort()
   m_write_batch_txn = nullptr;
   m_batch_active = false;
   memset(&m_wcursors, 0, sizeof(m_wcursors));
+  block_info_cache_aborted();
   LOG_PRINT_L3("batch transaction: aborted");
 }
 
@@ -3953,6 +4403,7 @@ void BlockchainLMDB::block_wtxn_stop()
       m_write_txn->commit();
       TIME_MEASURE_FINISH(time1);
       time_commit1 += time1;
+      block_info_cache_committed();
 
       delete m_write_txn;
       m_write_txn = nullptr;
@@ -3974,6 +4425,7 @@ void BlockchainLMDB::block_wtxn_abort()
     delete m_write_txn;
     m_write_txn = nullptr;
     memset(&m_wcursors, 0, sizeof(m_wcursors));
+    block_info_cache_aborted();
   }
 }
 
@@ -6130,6 +6582,8 @@ void BlockchainLMDB::migrate(const uint32_t oldversion, cryptonote::network_type
   default:
     break;
   }
+  // migrations rewrite block_info directly, so don't keep anything cached while they ran
+  block_info_cache_clear();
 }
 
 uint64_t constexpr SERVICE_NODE_BLOB_SHORT_TERM_KEY = 1;
@@ -6199,10 +6653,99 @@ void BlockchainLMDB::clear_service_node_data()
     MDB_val_set(k, key);
     int result;
     if ((result = mdb_cursor_get(m_cursors->service_node_data, &k, NULL, MDB_SET)))
-        return;
+        continue;
     if ((result = mdb_cursor_del(m_cursors->service_node_data, 0)))
       throw1(DB_ERROR(lmdb_error("Failed to add removal of service node data to db transaction: ", result).c_str()));
   }
+
+  for (auto kind : {service_node_state_kind::short_term, service_node_state_kind::long_term, service_node_state_kind::quorums})
+    remove_service_node_states(kind, 0, std::numeric_limits<uint64_t>::max());
+}
+
+// Service node state records of all kinds share one table: the kind goes in the top byte of the
+// key and the height in the rest, so each kind is a contiguous, height-ordered key range.
+static constexpr uint64_t SERVICE_NODE_STATE_HEIGHT_MASK = (uint64_t{1} << 56) - 1;
+static uint64_t service_node_state_key(service_node_state_kind kind, uint64_t height)
+{
+  return (static_cast<uint64_t>(kind) << 56) | std::min(height, SERVICE_NODE_STATE_HEIGHT_MASK);
+}
+
+void BlockchainLMDB::set_service_node_state(service_node_state_kind kind, uint64_t height, std::string_view data)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  mdb_txn_cursors *m_cursors = &m_wcursors;
+  CURSOR(service_node_states);
+
+  const uint64_t key = service_node_state_key(kind, height);
+  MDB_val_set(k, key);
+  MDB_val_sized(v, data);
+  if (int result = mdb_cursor_put(m_cursors->service_node_states, &k, &v, 0))
+    throw0(DB_ERROR(lmdb_error("Failed to add service node state to db transaction: ", result).c_str()));
+}
+
+void BlockchainLMDB::for_each_service_node_state(service_node_state_kind kind, uint64_t from_height, bool reverse,
+    std::function<bool(uint64_t height, std::string_view data)> f) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+  if (!m_service_node_states)
+    return;
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(service_node_states);
+
+  const uint64_t first = service_node_state_key(kind, 0), last = service_node_state_key(kind, SERVICE_NODE_STATE_HEIGHT_MASK);
+  const uint64_t start = service_node_state_key(kind, from_height);
+  MDB_val_set(k, start);
+  MDB_val v;
+  int result = mdb_cursor_get(m_cursors->service_node_states, &k, &v, MDB_SET_RANGE);
+  if (reverse)
+  {
+    // SET_RANGE gives us the first key >= start, so unless it's an exact match step back one
+    if (result == MDB_NOTFOUND)
+      result = mdb_cursor_get(m_cursors->service_node_states, &k, &v, MDB_LAST);
+    else if (result == MDB_SUCCESS && *static_cast<const uint64_t*>(k.mv_data) != start)
+      result = mdb_cursor_get(m_cursors->service_node_states, &k, &v, MDB_PREV);
+  }
+
+  for (; result == MDB_SUCCESS; result = mdb_cursor_get(m_cursors->service_node_states, &k, &v, reverse ? MDB_PREV : MDB_NEXT))
+  {
+    const uint64_t key = *static_cast<const uint64_t*>(k.mv_data);
+    if (key < first || key > last)
+      break;
+    if (!f(key & SERVICE_NODE_STATE_HEIGHT_MASK, {static_cast<const char*>(v.mv_data), v.mv_size}))
+      break;
+  }
+  if (result != MDB_SUCCESS && result != MDB_NOTFOUND)
+    throw0(DB_ERROR(lmdb_error("Failed to enumerate service node states: ", result).c_str()));
+}
+
+void BlockchainLMDB::remove_service_node_states(service_node_state_kind kind, uint64_t begin, uint64_t end)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  mdb_txn_cursors *m_cursors = &m_wcursors;
+  CURSOR(service_node_states);
+
+  if (begin >= end)
+    return;
+  const uint64_t start = service_node_state_key(kind, begin);
+  const uint64_t stop = service_node_state_key(kind, 0) + std::min(end, SERVICE_NODE_STATE_HEIGHT_MASK + 1);
+  for (;;)
+  {
+    MDB_val_set(k, start);
+    MDB_val v;
+    int result = mdb_cursor_get(m_cursors->service_node_states, &k, &v, MDB_SET_RANGE);
+    if (result == MDB_NOTFOUND || (result == MDB_SUCCESS && *static_cast<const uint64_t*>(k.mv_data) >= stop))
+      break;
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to find service node state to remove: ", result).c_str()));
+    if ((result = mdb_cursor_del(m_cursors->service_node_states, 0)))
+      throw0(DB_ERROR(lmdb_error("Failed to add removal of service node state to db transaction: ", result).c_str()));
+  }
 }
 
 template <typename C>
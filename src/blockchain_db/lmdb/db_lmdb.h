@@ -27,6 +27,7 @@
 #pragma once
 
 #include <atomic>
+#include <shared_mutex>
 
 #include "blockchain_db/blockchain_db.h"
 #include "cryptonote_basic/blobdatatype.h" // for type blobdata
@@ -78,6 +79,7 @@ struct mdb_txn_cursors
 
   MDB_cursor *service_node_data;
   MDB_cursor *service_node_proofs;
+  MDB_cursor *service_node_states;
   MDB_cursor *output_blacklist;
   MDB_cursor *properties;
 };
@@ -106,6 +108,7 @@ struct mdb_rflags
   bool m_rf_hf_versions;
   bool m_rf_service_node_data;
   bool m_rf_service_node_proofs;
+  bool m_rf_service_node_states;
   bool m_rf_properties;
 };
 
@@ -158,6 +161,36 @@ struct mdb_txn_safe
   static std::atomic_flag creation_gate;
 };
 
+// Columnar in-memory copy of the most recent block_info records, indexed by height - start.  This
+// lets the per-height header lookups (timestamps, weights, difficulties, hashes) used by the
+// difficulty and weight median calculations and the header RPCs avoid an LMDB lookup per height.
+//
+// Records in [start, committed_end) match the last committed transaction and may be used by any
+// thread; records at or above committed_end were added by the pending write transaction and are
+// only visible to the writer thread.
+struct mdb_block_info_cache
+{
+  uint64_t start = 0;
+  uint64_t committed_end = 0;
+  bool dirty = false; // the pending write txn has added or removed block_info records
+
+  std::vector<uint64_t> timestamps;
+  std::vector<uint64_t> coins;
+  std::vector<uint64_t> weights;
+  std::vector<uint64_t> long_term_weights;
+  std::vector<uint64_t> cum_rct;
+  std::vector<cryptonote::difficulty_type> cum_diffs;
+  std::vector<crypto::hash> hashes;
+
+  bool empty() const { return timestamps.empty(); }
+  uint64_t end() const { return start + timestamps.size(); }
+
+  void push_back(const mdb_block_info& bi);
+  void truncate(uint64_t height);
+  void trim_front(uint64_t new_start);
+  void clear();
+};
+
 
 // If m_batch_active is set, a batch transaction exists beyond this class, such
 // as a batch import with verification enabled, or possibly (later) a batch
@@ -212,6 +245,8 @@ public:
 
   cryptonote::blobdata get_block_blob_from_height(uint64_t height) const override;
 
+  std::string_view get_block_blob_view_from_height(uint64_t height) const override;
+
   std::vector<uint64_t> get_block_cumulative_rct_outputs(const std::vector<uint64_t> &heights) const override;
 
   uint64_t get_block_timestamp(const uint64_t& height) const override;
@@ -252,6 +287,8 @@ public:
   bool get_tx_blob(const crypto::hash& h, cryptonote::blobdata &tx) const override;
   bool get_pruned_tx_blob(const crypto::hash& h, cryptonote::blobdata &tx) const override;
   bool get_pruned_tx_blobs_from(const crypto::hash& h, size_t count, std::vector<cryptonote::blobdata> &bd) const override;
+  bool get_pruned_tx_blob_views_from(const crypto::hash& h, size_t count, std::vector<std::string_view> &views) const override;
+  bool get_tx_blob_views(const crypto::hash& h, std::string_view &pruned, std::string_view &prunable) const override;
   bool get_prunable_tx_blob(const crypto::hash& h, cryptonote::blobdata &tx) const override;
   bool get_prunable_tx_hash(const crypto::hash& tx_hash, crypto::hash &prunable_hash) const override;
 
@@ -303,6 +340,9 @@ public:
   bool for_all_transactions(std::function<bool(const crypto::hash&, const cryptonote::transaction&)>, bool pruned) const override;
   bool for_all_outputs(std::function<bool(uint64_t amount, const crypto::hash &tx_hash, uint64_t height, size_t tx_idx)> f) const override;
   bool for_all_outputs(uint64_t amount, const std::function<bool(uint64_t height)> &f) const override;
+  bool for_blocks_range_blobs(uint64_t h1, uint64_t h2, std::function<bool(uint64_t, std::string_view)> f) const override;
+  bool for_all_transaction_blobs(std::function<bool(const crypto::hash&, std::string_view, std::string_view)> f, bool pruned) const override;
+  bool for_all_output_data(std::function<bool(uint64_t amount, uint64_t amount_index, uint64_t output_id, const output_data_t& data)> f) const override;
   bool for_all_alt_blocks(std::function<bool(const crypto::hash &blkid, const alt_block_data_t &data, const cryptonote::blobdata *block_blob, const cryptonote::blobdata *checkpoint_blob)> f, bool include_blob = false) const override;
 
   uint64_t add_block( const std::pair<block, blobdata>& blk
@@ -411,7 +451,18 @@ private:
 
   uint64_t get_database_size() const override;
 
-  std::vector<uint64_t> get_block_info_64bit_fields(uint64_t start_height, size_t count, uint64_t (*extract)(const mdb_block_info*)) const;
+  std::vector<uint64_t> get_block_info_64bit_fields(uint64_t start_height, size_t count, uint64_t (*extract)(const mdb_block_info*), std::vector<uint64_t> mdb_block_info_cache::*cached) const;
+
+  // Calls f(cache, offset of begin) with [begin, end) held in the block info cache, extending the
+  // cache first if needed; returns false (without calling f) if the range can't be served from it.
+  template <typename F>
+  bool read_block_info_cache(uint64_t begin, uint64_t end, F&& f) const;
+  bool extend_block_info_cache(bool writer) const;
+  void block_info_cache_added(const mdb_block_info& bi);
+  void block_info_cache_removed(uint64_t height);
+  void block_info_cache_committed();
+  void block_info_cache_aborted();
+  void block_info_cache_clear();
 
   uint64_t get_max_block_size() override;
   void add_max_block_size(uint64_t sz) override;
@@ -436,6 +487,10 @@ private:
   void set_service_node_data(const std::string& data, bool long_term) override;
   bool get_service_node_data(std::string& data, bool long_term) const override;
   void clear_service_node_data() override;
+  void set_service_node_state(service_node_state_kind kind, uint64_t height, std::string_view data) override;
+  void for_each_service_node_state(service_node_state_kind kind, uint64_t from_height, bool reverse,
+      std::function<bool(uint64_t height, std::string_view data)> f) const override;
+  void remove_service_node_states(service_node_state_kind kind, uint64_t begin, uint64_t end) override;
 
   bool get_service_node_proof(const crypto::public_key& pubkey, service_nodes::proof_info& proof) const override;
   void set_service_node_proof(const crypto::public_key& pubkey, const service_nodes::proof_info& proof) override;
@@ -446,7 +501,8 @@ private:
   template <typename T,
             std::enable_if_t<std::is_same_v<T, cryptonote::block> ||
                              std::is_same_v<T, cryptonote::block_header> ||
-                             std::is_same_v<T, cryptonote::blobdata>, int> = 0>
+                             std::is_same_v<T, cryptonote::blobdata> ||
+                             std::is_same_v<T, std::string_view>, int> = 0>
   T get_and_convert_block_blob_from_height(uint64_t height) const;
 
   MDB_env* m_env;
@@ -480,6 +536,7 @@ private:
 
   MDB_dbi m_service_node_data;
   MDB_dbi m_service_node_proofs;
+  MDB_dbi m_service_node_states; // 0 if opened read-only from a database that predates the table
 
   MDB_dbi m_properties;
 
@@ -510,6 +567,11 @@ private:
   // Guards LMDB resize
   std::mutex m_synchronization_lock;
 
+  mutable std::shared_mutex m_block_info_cache_mutex;
+  mutable mdb_block_info_cache m_block_info_cache;
+  // Number of recent blocks kept in m_block_info_cache: enough for the long-term weight median
+  constexpr static uint64_t BLOCK_INFO_CACHE_BLOCKS = CRYPTONOTE_LONG_TERM_BLOCK_WEIGHT_WINDOW_SIZE + 10000;
+
   constexpr static float RESIZE_PERCENT = 0.9f;
 };
 
@@ -67,11 +67,14 @@ public:
 
   virtual bool block_exists(const crypto::hash& h, uint64_t *height) const override { return false; }
   virtual cryptonote::blobdata get_block_blob_from_height(uint64_t height) const override { return cryptonote::t_serializable_object_to_blob(get_block_from_height(height)); }
+  virtual std::string_view get_block_blob_view_from_height(uint64_t height) const override { return {}; }
   virtual cryptonote::blobdata get_block_blob(const crypto::hash& h) const override { return cryptonote::blobdata(); }
   virtual cryptonote::block_header get_block_header_from_height(uint64_t height) const override { return get_block_from_height(height); }
   virtual bool get_tx_blob(const crypto::hash& h, cryptonote::blobdata &tx) const override { return false; }
   virtual bool get_pruned_tx_blob(const crypto::hash& h, cryptonote::blobdata &tx) const override { return false; }
   virtual bool get_pruned_tx_blobs_from(const crypto::hash& h, size_t count, std::vector<cryptonote::blobdata> &bd) const override { return false; }
+  virtual bool get_pruned_tx_blob_views_from(const crypto::hash& h, size_t count, std::vector<std::string_view> &views) const override { return false; }
+  virtual bool get_tx_blob_views(const crypto::hash& h, std::string_view &pruned, std::string_view &prunable) const override { return false; }
   virtual bool get_prunable_tx_blob(const crypto::hash& h, cryptonote::blobdata &tx) const override { return false; }
   virtual bool get_prunable_tx_hash(const crypto::hash& tx_hash, crypto::hash &prunable_hash) const override { return false; }
   virtual uint64_t get_block_height(const crypto::hash& h) const override { return 0; }
@@ -122,6 +125,9 @@ public:
   virtual bool for_all_transactions(std::function<bool(const crypto::hash&, const cryptonote::transaction&)>, bool pruned) const override { return true; }
   virtual bool for_all_outputs(std::function<bool(uint64_t amount, const crypto::hash &tx_hash, uint64_t height, size_t tx_idx)> f) const override { return true; }
   virtual bool for_all_outputs(uint64_t amount, const std::function<bool(uint64_t height)> &f) const override { return true; }
+  virtual bool for_blocks_range_blobs(uint64_t, uint64_t, std::function<bool(uint64_t, std::string_view)>) const override { return true; }
+  virtual bool for_all_transaction_blobs(std::function<bool(const crypto::hash&, std::string_view, std::string_view)>, bool pruned) const override { return true; }
+  virtual bool for_all_output_data(std::function<bool(uint64_t amount, uint64_t amount_index, uint64_t output_id, const output_data_t& data)> f) const override { return true; }
   virtual bool is_read_only() const override { return false; }
   virtual std::map<uint64_t, std::tuple<uint64_t, uint64_t, uint64_t>> get_output_histogram(const std::vector<uint64_t> &amounts, bool unlocked, uint64_t recent_cutoff, uint64_t min_count) const override { return std::map<uint64_t, std::tuple<uint64_t, uint64_t, uint64_t>>(); }
   virtual bool get_output_distribution(uint64_t amount, uint64_t from_height, uint64_t to_height, std::vector<uint64_t> &distribution, uint64_t &base) const override { return false; }
@@ -167,6 +173,9 @@ public:
   virtual void set_service_node_data  (const std::string& data, bool long_term)      override { }
   virtual bool get_service_node_data  (std::string& data, bool long_term)      const override { return false; }
   virtual void clear_service_node_data()                                             override { }
+  void set_service_node_state(service_node_state_kind kind, uint64_t height, std::string_view data) override { }
+  void for_each_service_node_state(service_node_state_kind kind, uint64_t from_height, bool reverse, std::function<bool(uint64_t, std::string_view)> f) const override { }
+  void remove_service_node_states(service_node_state_kind kind, uint64_t begin, uint64_t end) override { }
 
   bool get_service_node_proof(const crypto::public_key &pubkey, service_nodes::proof_info &proof) const override { return false; }
   std::unordered_map<crypto::public_key, service_nodes::proof_info> get_all_service_node_proofs() const override { return {}; }
@@ -181,4 +190,65 @@ public:
   virtual bool for_all_alt_blocks(std::function<bool(const crypto::hash &blkid, const alt_block_data_t &data, const cryptonote::blobdata *block_blob, const cryptonote::blobdata *checkpoint_blob)> f, bool include_blob = false) const override { return true; }
 };
 
+// Just enough of a chain (the block hashes) for Blockchain::init, plus an in-memory txpool table,
+// for tests and benchmarks of the tx pool.
+class TxpoolTestDB: public BaseTestDB {
+public:
+  TxpoolTestDB() { m_open = true; }
+
+  virtual void add_block( const cryptonote::block& blk
+                        , size_t block_weight
+                        , uint64_t long_term_block_weight
+                        , const cryptonote::difficulty_type& cumulative_difficulty
+                        , const uint64_t& coins_generated
+                        , uint64_t num_rct_outs
+                        , const crypto::hash& blk_hash
+                        ) override {
+    blocks.push_back(blk_hash);
+  }
+  virtual uint64_t height() const override { return blocks.size(); }
+  virtual crypto::hash get_block_hash_from_height(const uint64_t &height) const override {
+    return height < blocks.size() ? blocks[height] : crypto::null_hash;
+  }
+  virtual crypto::hash top_block_hash(uint64_t *block_height = NULL) const override {
+    if (block_height)
+      *block_height = blocks.size() - 1;
+    return blocks.empty() ? crypto::null_hash : blocks.back();
+  }
+
+  virtual void add_txpool_tx(const crypto::hash &txid, const cryptonote::blobdata &blob, const cryptonote::txpool_tx_meta_t& meta) override { txpool[txid] = {meta, blob}; }
+  virtual void update_txpool_tx(const crypto::hash &txid, const cryptonote::txpool_tx_meta_t& meta) override { txpool[txid].first = meta; }
+  virtual uint64_t get_txpool_tx_count(bool include_unrelayed_txes = true) const override { return txpool.size(); }
+  virtual bool txpool_has_tx(const crypto::hash &txid) const override { return txpool.count(txid); }
+  virtual void remove_txpool_tx(const crypto::hash& txid) override { txpool.erase(txid); }
+  virtual bool get_txpool_tx_meta(const crypto::hash& txid, cryptonote::txpool_tx_meta_t &meta) const override {
+    auto it = txpool.find(txid);
+    if (it == txpool.end())
+      return false;
+    meta = it->second.first;
+    return true;
+  }
+  virtual bool get_txpool_tx_blob(const crypto::hash& txid, cryptonote::blobdata &bd) const override {
+    auto it = txpool.find(txid);
+    if (it == txpool.end())
+      return false;
+    bd = it->second.second;
+    return true;
+  }
+  virtual cryptonote::blobdata get_txpool_tx_blob(const crypto::hash& txid) const override {
+    cryptonote::blobdata bd;
+    get_txpool_tx_blob(txid, bd);
+    return bd;
+  }
+  virtual bool for_all_txpool_txes(std::function<bool(const crypto::hash&, const cryptonote::txpool_tx_meta_t&, const cryptonote::blobdata*)> f, bool include_blob = false, bool include_unrelayed_txes = false) const override {
+    for (const auto& [txid, entry] : txpool)
+      if (!f(txid, entry.first, include_blob ? &entry.second : nullptr))
+        return false;
+    return true;
+  }
+
+  std::vector<crypto::hash> blocks;
+  std::map<crypto::hash, std::pair<cryptonote::txpool_tx_meta_t, cryptonote::blobdata>> txpool;
+};
+
 }
@@ -29,6 +29,7 @@
 
 #include "bootstrap_file.h"
 #include "blocksdat_file.h"
+#include "indexed_bootstrap_file.h"
 #include "common/command_line.h"
 #include "cryptonote_core/cryptonote_core.h"
 #include "blockchain_objects.h"
@@ -49,6 +50,7 @@ int main(int argc, char* argv[])
   uint32_t log_level = 0;
   uint64_t block_stop = 0;
   bool blocks_dat = false;
+  bool indexed = false;
 
   tools::on_startup();
 
@@ -60,6 +62,7 @@ int main(int argc, char* argv[])
   const command_line::arg_descriptor<std::string> arg_log_level  = {"log-level",  "0-4 or categories", ""};
   const command_line::arg_descriptor<uint64_t> arg_block_stop = {"block-stop", "Stop at block number", block_stop};
   const command_line::arg_descriptor<bool> arg_blocks_dat = {"blocksdat", "Output in blocks.dat format", blocks_dat};
+  const command_line::arg_descriptor<bool> arg_indexed = {"indexed", "Output in the indexed raw format, which blockchain_import can map and import in parallel", indexed};
 
 
   command_line::add_arg(desc_cmd_sett, cryptonote::arg_data_dir);
@@ -69,6 +72,7 @@ int main(int argc, char* argv[])
   command_line::add_arg(desc_cmd_sett, arg_log_level);
   command_line::add_arg(desc_cmd_sett, arg_block_stop);
   command_line::add_arg(desc_cmd_sett, arg_blocks_dat);
+  command_line::add_arg(desc_cmd_sett, arg_indexed);
 
   command_line::add_arg(desc_cmd_only, command_line::arg_help);
 
@@ -109,6 +113,12 @@ int main(int argc, char* argv[])
     return 1;
   }
   bool opt_blocks_dat = command_line::get_arg(vm, arg_blocks_dat);
+  bool opt_indexed = command_line::get_arg(vm, arg_indexed);
+  if (opt_blocks_dat && opt_indexed)
+  {
+    std::cerr << "Can't specify more than one of --blocksdat and --indexed" << std::endl;
+    return 1;
+  }
 
   auto config_folder = fs::u8path(command_line::get_arg(vm, cryptonote::arg_data_dir));
 
@@ -116,7 +126,7 @@ int main(int argc, char* argv[])
   if (command_line::has_arg(vm, arg_output_file))
     output_file_path = fs::u8path(command_line::get_arg(vm, arg_output_file));
   else
-    output_file_path = config_folder / "export" / BLOCKCHAIN_RAW;
+    output_file_path = config_folder / "export" / (opt_indexed ? BLOCKCHAIN_RAW_INDEXED : BLOCKCHAIN_RAW);
   LOG_PRINT_L0("Export output file: " << output_file_path.string());
 
   LOG_PRINT_L0("Initializing source blockchain (BlockchainDB)");
@@ -159,6 +169,11 @@ int main(int argc, char* argv[])
     BlocksdatFile blocksdat;
     r = blocksdat.store_blockchain_raw(core_storage, NULL, output_file_path, block_stop);
   }
+  else if (opt_indexed)
+  {
+    IndexedBootstrapFile indexed_file;
+    r = indexed_file.store_blockchain_raw(core_storage, NULL, output_file_path, block_stop);
+  }
   else
   {
     BootstrapFile bootstrap;
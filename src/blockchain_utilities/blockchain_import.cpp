@@ -28,15 +28,18 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <algorithm>
 #include <fstream>
+#include <iomanip>
 
 #include <boost/algorithm/string.hpp>
 #include <unistd.h>
 #include "cryptonote_protocol/quorumnet.h"
 #include "epee/misc_log_ex.h"
 #include "bootstrap_file.h"
+#include "indexed_bootstrap_file.h"
 #include "bootstrap_serialization.h"
 #include "blocks/blocks.h"
 #include "cryptonote_basic/cryptonote_format_utils.h"
@@ -44,6 +47,7 @@
 #include "cryptonote_core/uptime_proof.h"
 #include "cryptonote_core/cryptonote_core.h"
 #include "common/hex.h"
+#include "common/threadpool.h"
 
 #undef OXEN_DEFAULT_LOG_CATEGORY
 #define OXEN_DEFAULT_LOG_CATEGORY "bcutil"
@@ -136,18 +140,28 @@ int check_flush(cryptonote::core &core, std::vector<block_complete_entry> &block
   if (!force && new_height % HASH_OF_HASHES_STEP)
     return 0;
 
-  std::vector<crypto::hash> hashes;
-  for (const auto &b: blocks)
+  // Parsing and hashing is independent per block, so spread it over the threadpool
+  std::vector<crypto::hash> hashes(blocks.size());
+  std::vector<char> parsed(blocks.size(), 0);
   {
-    cryptonote::block block;
-    if (!parse_and_validate_block_from_blob(b.block, block))
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    tools::threadpool::waiter waiter;
+    tpool.submit_range(&waiter, 0, blocks.size(), [&](size_t i) {
+      cryptonote::block block;
+      if (parse_and_validate_block_from_blob(blocks[i].block, block, hashes[i]))
+        parsed[i] = 1;
+    });
+    waiter.wait(&tpool);
+  }
+  for (size_t i = 0; i < blocks.size(); ++i)
+  {
+    if (!parsed[i])
     {
       MERROR("Failed to parse block: "
-          << tools::type_to_hex(get_blob_hash(b.block)));
+          << tools::type_to_hex(get_blob_hash(blocks[i].block)));
       core.cleanup_handle_incoming_blocks();
       return 1;
     }
-    hashes.push_back(cryptonote::get_block_hash(block));
   }
   core.prevalidate_block_hashes(core.get_blockchain_storage().get_db().height(), hashes);
 
@@ -165,18 +179,20 @@ int check_flush(cryptonote::core &core, std::vector<block_complete_entry> &block
     return 1;
   }
 
-  size_t blockidx = 0;
+  auto parsed_txs = core.parse_incoming_block_txs(blocks);
+
+  size_t blockidx = 0, txidx = 0;
   for(const block_complete_entry& block_entry: blocks)
   {
     // process transactions
-    for(auto& tx_blob: block_entry.txs)
+    auto &block_txs = parsed_txs[txidx++];
+    core.handle_parsed_txs(block_txs, tx_pool_options::from_block());
+    for(const auto& info: block_txs)
     {
-      tx_verification_context tvc{};
-      core.handle_incoming_tx(tx_blob, tvc, tx_pool_options::from_block());
-      if(tvc.m_verifivation_failed)
+      if(info.tvc.m_verifivation_failed)
       {
         MERROR("transaction verification failed, tx_id = "
-            << tools::type_to_hex(get_blob_hash(tx_blob)));
+            << tools::type_to_hex(get_blob_hash(*info.blob)));
         core.cleanup_handle_incoming_blocks();
         return 1;
       }
@@ -526,6 +542,185 @@ quitting:
   return 0;
 }
 
+// Imports from an IndexedBootstrapFile.  Since the file is mapped and every height can be located
+// directly through the index, resuming is a lookup rather than a scan, and each span of
+// db_batch_size blocks is decoded on the threadpool before being handed over in one go.
+int import_from_indexed_file(cryptonote::core& core, const fs::path& import_file_path, uint64_t block_stop=0)
+{
+  core.get_blockchain_storage().get_db().reset_stats();
+
+  IndexedBootstrapFile bootstrap;
+  if (!bootstrap.open_reader(import_file_path))
+    return 2;
+
+  uint64_t start_height = 1;
+  if (opt_resume)
+    start_height = core.get_blockchain_storage().get_current_blockchain_height();
+  if (start_height < bootstrap.block_first())
+  {
+    MFATAL("bootstrap file starts at height " << bootstrap.block_first() << ", cannot import from height " << start_height);
+    return 2;
+  }
+
+  uint64_t end_height = bootstrap.block_end();
+  if (block_stop && block_stop + 1 < end_height)
+    end_height = block_stop + 1;
+  if (start_height >= end_height)
+  {
+    MINFO("Nothing to import: database height " << start_height << ", bootstrap file ends at " << end_height - 1);
+    return 0;
+  }
+
+  MINFO("start block: " << start_height << "  stop block: " << end_height - 1);
+
+  bool use_batch = opt_batch && !opt_verify;
+  auto& db = core.get_blockchain_storage().get_db();
+  tools::threadpool& tpool = tools::threadpool::getInstance();
+
+  std::vector<block_complete_entry> blocks;
+  std::vector<indexed_block_record> records;
+  std::vector<block> parsed_blocks;
+  std::vector<std::vector<std::pair<transaction, blobdata>>> parsed_txs;
+  std::atomic<uint64_t> bad_height{0};
+
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t bytes_read = 0;
+  uint64_t num_imported = 0;
+  uint64_t h = start_height;
+  int ret = 0;
+
+  while (h < end_height)
+  {
+    uint64_t span_end = h + db_batch_size;
+    // check_flush only verifies at hash-of-hashes boundaries and holds the blocks back otherwise, so
+    // end each span on one
+    if (opt_verify)
+      span_end = (span_end + HASH_OF_HASHES_STEP - 1) / HASH_OF_HASHES_STEP * HASH_OF_HASHES_STEP;
+    span_end = std::min(end_height, span_end);
+    const size_t n = span_end - h;
+    const uint64_t span_bytes = bootstrap.span_bytes(h, span_end);
+    bad_height = 0;
+
+    tools::threadpool::waiter waiter;
+    if (opt_verify)
+    {
+      // Append to whatever check_flush held back waiting for a full hash-of-hashes step
+      const size_t offset = blocks.size();
+      blocks.resize(offset + n);
+      tpool.submit_range(&waiter, 0, n, [&, offset](size_t i) {
+        indexed_block_record record;
+        if (!bootstrap.read_block(h + i, record))
+        {
+          bad_height = h + i;
+          return;
+        }
+        auto& entry = blocks[offset + i];
+        entry.block = record.block;
+        entry.txs.reserve(record.txs.size());
+        for (const auto& tx : record.txs)
+          entry.txs.emplace_back(tx);
+      });
+      waiter.wait(&tpool);
+    }
+    else
+    {
+      records.resize(n);
+      parsed_blocks.clear();
+      parsed_blocks.resize(n);
+      parsed_txs.clear();
+      parsed_txs.resize(n);
+      tpool.submit_range(&waiter, 0, n, [&](size_t i) {
+        auto& record = records[i];
+        if (!bootstrap.read_block(h + i, record) || !parse_and_validate_block_from_blob(record.block, parsed_blocks[i]))
+        {
+          bad_height = h + i;
+          return;
+        }
+        auto& txs = parsed_txs[i];
+        txs.resize(record.txs.size());
+        for (size_t t = 0; t < record.txs.size(); ++t)
+        {
+          txs[t].second = record.txs[t];
+          if (!parse_and_validate_tx_from_blob(record.txs[t], txs[t].first))
+          {
+            bad_height = h + i;
+            return;
+          }
+        }
+      });
+      waiter.wait(&tpool);
+    }
+
+    // bad_height can't legitimately be 0 since we never import the genesis block
+    if (bad_height)
+    {
+      std::cout << refresh_string;
+      MFATAL("Failed to read or parse block " << bad_height << " from bootstrap file");
+      ret = 2;
+      break;
+    }
+
+    if (opt_verify)
+    {
+      if (check_flush(core, blocks, false))
+      {
+        ret = 2;
+        break;
+      }
+    }
+    else
+    {
+      if (use_batch)
+        db.batch_start(n, span_bytes);
+      try
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          const auto& record = records[i];
+          uint64_t long_term_block_weight = core.get_blockchain_storage().get_next_long_term_block_weight(record.block_weight);
+          db.add_block(std::make_pair(parsed_blocks[i], blobdata{record.block}), record.block_weight, long_term_block_weight,
+              record.cumulative_difficulty, record.coins_generated, parsed_txs[i]);
+        }
+      }
+      catch (const std::exception& e)
+      {
+        std::cout << refresh_string;
+        MFATAL("Error adding block to blockchain: " << e.what());
+        // Leave the batch uncommitted; the destructor will abort the write txn.
+        ret = 2;
+        break;
+      }
+      if (use_batch)
+        db.batch_stop();
+    }
+
+    h = span_end;
+    num_imported += n;
+    bytes_read += span_bytes;
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << refresh_string << "block " << h - 1 << " / " << end_height - 1 << "\r" << std::flush;
+    MINFO("imported to height " << h - 1 << ": " << num_imported << " blocks, "
+        << std::fixed << std::setprecision(1) << bytes_read / 1e6 / elapsed << " MB/s, "
+        << num_imported / elapsed << " blocks/s");
+  }
+
+  if (opt_verify && ret == 0)
+    ret = check_flush(core, blocks, true);
+
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << refresh_string;
+  db.show_stats();
+  MINFO("Number of blocks imported: " << num_imported << " (" << bytes_read << " bytes) in "
+      << std::fixed << std::setprecision(1) << elapsed << "s: "
+      << bytes_read / 1e6 / elapsed << " MB/s, " << num_imported / elapsed << " blocks/s");
+  if (ret == 0)
+    MINFO("Finished at block: " << h - 1 << "  total blocks: " << h);
+
+  std::cout << "\n";
+  return ret;
+}
+
 int main(int argc, char* argv[])
 {
   TRY_ENTRY();
@@ -654,10 +849,21 @@ int main(int argc, char* argv[])
   else
     import_file_path = fs::u8path(m_config_folder) / "export" / BLOCKCHAIN_RAW;
 
+  const bool indexed = IndexedBootstrapFile::is_indexed_file(import_file_path);
+
   if (command_line::has_arg(vm, arg_count_blocks))
   {
-    BootstrapFile bootstrap;
-    bootstrap.count_blocks(import_file_path);
+    if (indexed)
+    {
+      IndexedBootstrapFile bootstrap;
+      if (bootstrap.open_reader(import_file_path))
+        MINFO("bootstrap file first block: " << bootstrap.block_first() << "  total blocks: " << bootstrap.block_count());
+    }
+    else
+    {
+      BootstrapFile bootstrap;
+      bootstrap.count_blocks(import_file_path);
+    }
     return 0;
   }
 
@@ -675,7 +881,7 @@ int main(int argc, char* argv[])
   MINFO("resume:  " << std::boolalpha << opt_resume  << std::noboolalpha);
   MINFO("nettype: " << (opt_testnet ? "testnet" : opt_devnet ? "devnet" : "mainnet"));
 
-  MINFO("bootstrap file path: " << import_file_path);
+  MINFO("bootstrap file path: " << import_file_path << (indexed ? " (indexed)" : ""));
   MINFO("database path:       " << m_config_folder);
 
   if (!opt_verify)
@@ -723,7 +929,10 @@ int main(int argc, char* argv[])
   if (command_line::get_arg(vm, arg_recalculate_difficulty))
     core.get_blockchain_storage().get_db().fixup(core.get_nettype());
 
-  import_from_file(core, import_file_path, block_stop);
+  if (indexed)
+    import_from_indexed_file(core, import_file_path, block_stop);
+  else
+    import_from_file(core, import_file_path, block_stop);
 
   // ensure db closed
   //   - transactions properly checked and handled
@@ -137,7 +137,7 @@ int main(int argc, char* argv[])
 
   try
   {
-    db->open(filename, core_storage->nettype(), DBF_RDONLY);
+    db->open(filename, core_storage->nettype(), DBF_RDONLY | DBF_ATTACH);
   }
   catch (const std::exception& e)
   {
@@ -0,0 +1,407 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "indexed_bootstrap_file.h"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "epee/int-util.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "common/hex.h"
+
+#undef OXEN_DEFAULT_LOG_CATEGORY
+#define OXEN_DEFAULT_LOG_CATEGORY "bcutil"
+
+using namespace cryptonote;
+
+namespace
+{
+  // Arbitrary; anything other than bootstrap_file.cpp's blockchain_raw_magic (0x28721586)
+  const uint32_t blockchain_raw_indexed_magic = 0x5a8b1e37;
+  const uint32_t indexed_version = 1;
+  const size_t header_size = 64;
+  // weight, cumulative difficulty, coins generated, block size, tx count
+  const size_t record_prefix_size = 3*8 + 2*4;
+
+  std::string refresh_string = "\r                                    \r";
+
+  void put_u32(std::string& out, uint32_t v)
+  {
+    v = SWAP32LE(v);
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+  }
+
+  void put_u64(std::string& out, uint64_t v)
+  {
+    v = SWAP64LE(v);
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+  }
+
+  uint32_t get_u32(const char* p)
+  {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return SWAP32LE(v);
+  }
+
+  uint64_t get_u64(const char* p)
+  {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return SWAP64LE(v);
+  }
+}
+
+IndexedBootstrapFile::~IndexedBootstrapFile()
+{
+  close_reader();
+}
+
+bool IndexedBootstrapFile::open_writer(const fs::path& file_path)
+{
+  const fs::path dir_path = file_path.parent_path();
+  if (!dir_path.empty())
+  {
+    if (fs::exists(dir_path))
+    {
+      if (!fs::is_directory(dir_path))
+      {
+        MFATAL("export directory path is a file: " << dir_path);
+        return false;
+      }
+    }
+    else
+    {
+      if (!fs::create_directory(dir_path))
+      {
+        MFATAL("Failed to create directory " << dir_path);
+        return false;
+      }
+    }
+  }
+
+  m_raw_data_file = new std::ofstream();
+
+  MINFO("creating file");
+
+  m_raw_data_file->open(file_path.string(), std::ios_base::binary | std::ios_base::out | std::ios::trunc);
+  if (m_raw_data_file->fail())
+    return false;
+
+  // Placeholder header; rewritten with the real count and index offset by close()
+  m_block_count = 0;
+  m_index_offset = 0;
+  write_header();
+  m_offset = header_size;
+  m_offsets.clear();
+
+  return true;
+}
+
+void IndexedBootstrapFile::write_header()
+{
+  std::string header;
+  header.reserve(header_size);
+  put_u32(header, blockchain_raw_indexed_magic);
+  put_u32(header, indexed_version);
+  put_u64(header, m_block_first);
+  put_u64(header, m_block_count);
+  put_u64(header, m_index_offset);
+  header.resize(header_size, 0);
+  m_raw_data_file->write(header.data(), header.size());
+}
+
+void IndexedBootstrapFile::write_block(uint64_t height)
+{
+  auto& db = m_blockchain_storage->get_db();
+  const blobdata block_blob = db.get_block_blob_from_height(height);
+  block b;
+  if (!parse_and_validate_block_from_blob(block_blob, b))
+    throw std::runtime_error("Aborting: failed to parse block at height " + std::to_string(height));
+
+  std::string record;
+  put_u64(record, db.get_block_weight(height));
+  put_u64(record, db.get_block_cumulative_difficulty(height));
+  put_u64(record, db.get_block_already_generated_coins(height));
+  put_u32(record, block_blob.size());
+  put_u32(record, b.tx_hashes.size());
+  record += block_blob;
+
+  blobdata tx_blob;
+  for (const auto& tx_id : b.tx_hashes)
+  {
+    if (tx_id == crypto::null_hash)
+      throw std::runtime_error("Aborting: tx == null_hash");
+    if (!db.get_tx_blob(tx_id, tx_blob))
+      throw std::runtime_error("Aborting: tx " + tools::type_to_hex(tx_id) + " not found");
+    put_u32(record, tx_blob.size());
+    record += tx_blob;
+  }
+
+  m_offsets.push_back(m_offset);
+  m_raw_data_file->write(record.data(), record.size());
+  m_offset += record.size();
+}
+
+bool IndexedBootstrapFile::close()
+{
+  // Pad so that the index can be read in place as aligned u64s
+  const std::string padding((8 - m_offset % 8) % 8, 0);
+  m_raw_data_file->write(padding.data(), padding.size());
+  m_index_offset = m_offset + padding.size();
+
+  std::string index;
+  index.reserve(m_offsets.size() * 8);
+  for (uint64_t offset : m_offsets)
+    put_u64(index, offset);
+  m_raw_data_file->write(index.data(), index.size());
+
+  m_block_count = m_offsets.size();
+  m_raw_data_file->seekp(0);
+  write_header();
+
+  bool ok = !m_raw_data_file->fail();
+  m_raw_data_file->flush();
+  delete m_raw_data_file;
+  m_raw_data_file = nullptr;
+  return ok;
+}
+
+bool IndexedBootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_memory_pool* _tx_pool, fs::path& output_file, uint64_t requested_block_stop)
+{
+  m_blockchain_storage = _blockchain_storage;
+  uint64_t progress_interval = 100;
+
+  uint64_t block_start = 0;
+  uint64_t block_stop = 0;
+  MINFO("source blockchain height: " <<  m_blockchain_storage->get_current_blockchain_height()-1);
+  if ((requested_block_stop > 0) && (requested_block_stop < m_blockchain_storage->get_current_blockchain_height()))
+  {
+    MINFO("Using requested block height: " << requested_block_stop);
+    block_stop = requested_block_stop;
+  }
+  else
+  {
+    block_stop = m_blockchain_storage->get_current_blockchain_height() - 1;
+    MINFO("Using block height of source blockchain: " << block_stop);
+  }
+  MINFO("Storing blocks raw data (indexed)...");
+  m_block_first = block_start;
+  if (!IndexedBootstrapFile::open_writer(output_file))
+  {
+    MFATAL("failed to open raw file for write");
+    return false;
+  }
+  for (m_cur_height = block_start; m_cur_height <= block_stop; ++m_cur_height)
+  {
+    // this method's height refers to 0-based height (genesis block = height 0)
+    write_block(m_cur_height);
+    if (m_cur_height % progress_interval == 0) {
+      std::cout << refresh_string;
+      std::cout << "block " << m_cur_height << "/" << block_stop << "\r" << std::flush;
+    }
+  }
+  // print message for last block, which may not have been printed yet due to progress_interval
+  std::cout << refresh_string;
+  std::cout << "block " << m_cur_height-1 << "/" << block_stop << "\n";
+
+  MINFO("Number of blocks exported: " << m_offsets.size());
+  MINFO("Data size: " << m_offset << " bytes");
+
+  return IndexedBootstrapFile::close();
+}
+
+bool IndexedBootstrapFile::is_indexed_file(const fs::path& file_path)
+{
+  fs::ifstream file{file_path, std::ios::binary};
+  char magic[4];
+  if (!file.read(magic, sizeof(magic)))
+    return false;
+  return get_u32(magic) == blockchain_raw_indexed_magic;
+}
+
+bool IndexedBootstrapFile::open_reader(const fs::path& file_path)
+{
+  close_reader();
+
+#ifdef _WIN32
+  {
+    fs::ifstream file{file_path, std::ios::binary};
+    if (!file)
+    {
+      MFATAL("Failed to open " << file_path);
+      return false;
+    }
+    m_contents.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    m_data = m_contents.data();
+    m_size = m_contents.size();
+  }
+#else
+  int fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    MFATAL("Failed to open " << file_path << ": " << strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t) header_size)
+  {
+    MFATAL("Failed to stat " << file_path << " or file too small");
+    ::close(fd);
+    return false;
+  }
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+  {
+    MFATAL("Failed to mmap " << file_path << ": " << strerror(errno));
+    return false;
+  }
+  // We read the records roughly in order, but from several threads at once
+  madvise(addr, st.st_size, MADV_WILLNEED);
+  m_data = static_cast<const char*>(addr);
+  m_size = st.st_size;
+#endif
+
+  if (m_size < header_size || get_u32(m_data) != blockchain_raw_indexed_magic)
+  {
+    MFATAL(file_path << " is not an indexed bootstrap file");
+    close_reader();
+    return false;
+  }
+  if (uint32_t version = get_u32(m_data + 4); version != indexed_version)
+  {
+    MFATAL("Unsupported indexed bootstrap file version " << version);
+    close_reader();
+    return false;
+  }
+  m_block_first = get_u64(m_data + 8);
+  m_block_count = get_u64(m_data + 16);
+  m_index_offset = get_u64(m_data + 24);
+
+  if (m_index_offset < header_size || m_index_offset > m_size || (m_size - m_index_offset) / 8 < m_block_count)
+  {
+    MFATAL("Indexed bootstrap file " << file_path << " is truncated or has a bad index");
+    close_reader();
+    return false;
+  }
+
+  // Offsets must be increasing and within the record area, which keeps read_block's bounds checks
+  // simple.
+  uint64_t prev = header_size;
+  for (uint64_t i = 0; i < m_block_count; ++i)
+  {
+    uint64_t offset = get_u64(m_data + m_index_offset + 8*i);
+    if (offset < prev || offset + record_prefix_size > m_index_offset)
+    {
+      MFATAL("Indexed bootstrap file " << file_path << " has a bad offset for height " << m_block_first + i);
+      close_reader();
+      return false;
+    }
+    prev = offset;
+  }
+
+  MINFO("Mapped indexed bootstrap file " << file_path << ": heights " << m_block_first << "-" << block_end() - 1
+      << ", " << m_size << " bytes");
+  return true;
+}
+
+void IndexedBootstrapFile::close_reader()
+{
+#ifdef _WIN32
+  m_contents.clear();
+  m_contents.shrink_to_fit();
+#else
+  if (m_data)
+    munmap(const_cast<char*>(m_data), m_size);
+#endif
+  m_data = nullptr;
+  m_size = 0;
+  m_block_count = 0;
+}
+
+uint64_t IndexedBootstrapFile::span_bytes(uint64_t begin, uint64_t end) const
+{
+  if (begin >= end)
+    return 0;
+  const char* index = m_data + m_index_offset;
+  uint64_t first = get_u64(index + 8*(begin - m_block_first));
+  uint64_t last = end == block_end() ? m_index_offset : get_u64(index + 8*(end - m_block_first));
+  return last - first;
+}
+
+bool IndexedBootstrapFile::read_block(uint64_t height, indexed_block_record& record) const
+{
+  const char* index = m_data + m_index_offset;
+  const uint64_t i = height - m_block_first;
+  const uint64_t begin = get_u64(index + 8*i);
+  const uint64_t end = i + 1 == m_block_count ? m_index_offset : get_u64(index + 8*(i + 1));
+
+  const char* p = m_data + begin;
+  uint64_t remaining = end - begin;
+  if (remaining < record_prefix_size)
+    return false;
+  record.block_weight = get_u64(p);
+  record.cumulative_difficulty = get_u64(p + 8);
+  record.coins_generated = get_u64(p + 16);
+  const uint32_t block_size = get_u32(p + 24);
+  const uint32_t tx_count = get_u32(p + 28);
+  p += record_prefix_size;
+  remaining -= record_prefix_size;
+
+  if (remaining < block_size)
+    return false;
+  record.block = {p, block_size};
+  p += block_size;
+  remaining -= block_size;
+
+  record.txs.clear();
+  record.txs.reserve(tx_count);
+  for (uint32_t t = 0; t < tx_count; ++t)
+  {
+    if (remaining < 4)
+      return false;
+    const uint32_t tx_size = get_u32(p);
+    p += 4;
+    remaining -= 4;
+    if (remaining < tx_size)
+      return false;
+    record.txs.emplace_back(p, tx_size);
+    p += tx_size;
+    remaining -= tx_size;
+  }
+  // Only the last record may be followed by (alignment padding before the index)
+  return remaining == 0 || (i + 1 == m_block_count && remaining < 8);
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "cryptonote_basic/cryptonote_basic.h"
+#include "cryptonote_core/blockchain.h"
+
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "common/fs.h"
+
+#include "blockchain_utilities.h"
+
+#define BLOCKCHAIN_RAW_INDEXED "blockchain.raw.idx"
+
+using namespace cryptonote;
+
+// One block as stored in an indexed bootstrap file.  The blob views point straight into the
+// mapped file, so they are only valid while the IndexedBootstrapFile they came from stays open.
+struct indexed_block_record
+{
+  std::string_view block;
+  std::vector<std::string_view> txs;
+  uint64_t block_weight;
+  difficulty_type cumulative_difficulty;
+  uint64_t coins_generated;
+};
+
+// Raw, index-addressable bootstrap format.  Unlike BootstrapFile (a stream of length-prefixed,
+// re-serialized block_packages that can only be read front to back) this stores the block and tx
+// blobs exactly as they are in the db, followed by a table of per-block offsets, so that a reader
+// can map the file and jump straight to (or hand out in parallel) any span of heights.
+//
+// Layout, all integers little-endian:
+//   header (64 bytes): magic, version (u32 each), first height, block count, index offset (u64 each)
+//   records: weight, cumulative difficulty, coins generated (u64 each), block size, tx count
+//            (u32 each), block blob, then for each tx a u32 size and the tx blob
+//   index (at the 8-byte aligned index offset): block count u64 record offsets
+class IndexedBootstrapFile
+{
+public:
+
+  IndexedBootstrapFile() = default;
+  IndexedBootstrapFile(const IndexedBootstrapFile&) = delete;
+  IndexedBootstrapFile& operator=(const IndexedBootstrapFile&) = delete;
+  ~IndexedBootstrapFile();
+
+  bool store_blockchain_raw(cryptonote::Blockchain* cs, cryptonote::tx_memory_pool* txp,
+      fs::path& output_file, uint64_t use_block_height=0);
+
+  // Returns true if the file at the given path starts with the indexed bootstrap magic.
+  static bool is_indexed_file(const fs::path& file_path);
+
+  // Maps an existing indexed file for reading.  Returns false (after logging) if the file is
+  // missing, truncated, or has an inconsistent index.
+  bool open_reader(const fs::path& file_path);
+  void close_reader();
+
+  uint64_t block_first() const { return m_block_first; }
+  uint64_t block_count() const { return m_block_count; }
+  // One past the last height in the file
+  uint64_t block_end() const { return m_block_first + m_block_count; }
+
+  // Returns the size in bytes of the records for heights [begin, end), which must be within the
+  // file.
+  uint64_t span_bytes(uint64_t begin, uint64_t end) const;
+
+  // Decodes the record at the given height, which must be within the file.  Returns false if the
+  // record is malformed.  Safe to call concurrently from multiple threads.
+  bool read_block(uint64_t height, indexed_block_record& record) const;
+
+protected:
+
+  Blockchain* m_blockchain_storage;
+
+  std::ofstream* m_raw_data_file = nullptr;
+
+  // open export file for write
+  bool open_writer(const fs::path& file_path);
+  bool close();
+  void write_block(uint64_t height);
+  void write_header();
+
+private:
+
+  uint64_t m_cur_height; // tracks current height during export
+  uint64_t m_offset; // current write position during export
+  std::vector<uint64_t> m_offsets;
+
+  uint64_t m_block_first = 0;
+  uint64_t m_block_count = 0;
+  uint64_t m_index_offset = 0;
+
+  // mapped file contents when reading
+  const char* m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  std::string m_contents;
+#endif
+};
@@ -0,0 +1,195 @@
+// Copyright (c) 2019-2020, The Loki Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "lock.h"
+
+#include <cassert>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace tools {
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    // Per-thread shared recursion depth of every recursive_shared_mutex the thread currently holds
+    // a shared lock on.  Entries are removed when the depth drops back to zero so that this stays
+    // tiny (typically zero or one entry).
+    thread_local std::unordered_map<const recursive_shared_mutex*, unsigned> shared_depths;
+
+    void add_wait(std::atomic<uint64_t>& total, clock::time_point started) {
+        total.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - started).count(),
+                std::memory_order_relaxed);
+    }
+}
+
+recursive_shared_mutex::~recursive_shared_mutex() {
+    shared_depths.erase(this);
+}
+
+unsigned& recursive_shared_mutex::shared_depth() const {
+    return shared_depths[this];
+}
+
+void recursive_shared_mutex::lock() {
+    if (owns_exclusive()) {
+        ++recursion_;
+        return;
+    }
+    if (auto it = shared_depths.find(this); it != shared_depths.end() && it->second > 0)
+        throw std::logic_error{"recursive_shared_mutex: cannot upgrade a shared lock to an exclusive lock"};
+
+    std::optional<clock::time_point> started;
+    std::unique_lock gate{turnstile_, std::try_to_lock};
+    if (!gate) {
+        started = clock::now();
+        gate.lock();
+    }
+    if (!mutex_.try_lock()) {
+        if (!started)
+            started = clock::now();
+        mutex_.lock();
+    }
+    gate.unlock();
+    if (started) {
+        exclusive_waited_.fetch_add(1, std::memory_order_relaxed);
+        add_wait(exclusive_wait_ns_, *started);
+    }
+    exclusive_acquired_.fetch_add(1, std::memory_order_relaxed);
+    owner_.store(std::this_thread::get_id(), std::memory_order_release);
+    recursion_ = 1;
+}
+
+bool recursive_shared_mutex::try_lock() {
+    if (owns_exclusive()) {
+        ++recursion_;
+        return true;
+    }
+    if (auto it = shared_depths.find(this); it != shared_depths.end() && it->second > 0)
+        return false;
+    std::unique_lock gate{turnstile_, std::try_to_lock};
+    if (!gate || !mutex_.try_lock())
+        return false;
+    exclusive_acquired_.fetch_add(1, std::memory_order_relaxed);
+    owner_.store(std::this_thread::get_id(), std::memory_order_release);
+    recursion_ = 1;
+    return true;
+}
+
+void recursive_shared_mutex::unlock() {
+    assert(owns_exclusive() && recursion_ > 0);
+    if (--recursion_ == 0) {
+        owner_.store(std::thread::id{}, std::memory_order_release);
+        mutex_.unlock();
+    }
+}
+
+void recursive_shared_mutex::lock_shared() {
+    if (owns_exclusive()) {
+        // Nests inside the exclusive lock we already hold
+        ++recursion_;
+        return;
+    }
+    auto& depth = shared_depth();
+    if (depth > 0) {
+        ++depth;
+        return;
+    }
+    std::optional<clock::time_point> started;
+    {
+        // Wait behind any writer that is already waiting
+        std::unique_lock gate{turnstile_, std::try_to_lock};
+        if (!gate) {
+            started = clock::now();
+            gate.lock();
+        }
+    }
+    if (!mutex_.try_lock_shared()) {
+        if (!started)
+            started = clock::now();
+        mutex_.lock_shared();
+    }
+    if (started) {
+        shared_waited_.fetch_add(1, std::memory_order_relaxed);
+        add_wait(shared_wait_ns_, *started);
+    }
+    shared_acquired_.fetch_add(1, std::memory_order_relaxed);
+    depth = 1;
+}
+
+bool recursive_shared_mutex::try_lock_shared() {
+    if (owns_exclusive()) {
+        ++recursion_;
+        return true;
+    }
+    auto& depth = shared_depth();
+    if (depth > 0) {
+        ++depth;
+        return true;
+    }
+    bool locked;
+    {
+        std::unique_lock gate{turnstile_, std::try_to_lock};
+        locked = gate && mutex_.try_lock_shared();
+    }
+    if (!locked) {
+        shared_depths.erase(this);
+        return false;
+    }
+    shared_acquired_.fetch_add(1, std::memory_order_relaxed);
+    depth = 1;
+    return true;
+}
+
+void recursive_shared_mutex::unlock_shared() {
+    if (owns_exclusive()) {
+        unlock();
+        return;
+    }
+    auto it = shared_depths.find(this);
+    assert(it != shared_depths.end() && it->second > 0);
+    if (--it->second == 0) {
+        shared_depths.erase(it);
+        mutex_.unlock_shared();
+    }
+}
+
+lock_contention_stats recursive_shared_mutex::contention() const {
+    lock_contention_stats s;
+    s.exclusive_acquired = exclusive_acquired_.load(std::memory_order_relaxed);
+    s.exclusive_waited = exclusive_waited_.load(std::memory_order_relaxed);
+    s.exclusive_wait_time = std::chrono::nanoseconds{exclusive_wait_ns_.load(std::memory_order_relaxed)};
+    s.shared_acquired = shared_acquired_.load(std::memory_order_relaxed);
+    s.shared_waited = shared_waited_.load(std::memory_order_relaxed);
+    s.shared_wait_time = std::chrono::nanoseconds{shared_wait_ns_.load(std::memory_order_relaxed)};
+    return s;
+}
+
+}
@@ -28,7 +28,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <tuple>
 
 namespace tools {
@@ -43,4 +48,71 @@ std::tuple<std::unique_lock<T>...> unique_locks(T& ...lockables) {
     return locks;
 }
 
+/// Snapshot of the acquisition/contention counters of a recursive_shared_mutex.  "waited" counts
+/// the acquisitions that could not be satisfied immediately and had to block; the wait times are
+/// the total time spent blocked in those acquisitions.  Recursive re-acquisitions by a thread that
+/// already holds the lock are not counted.
+struct lock_contention_stats {
+    uint64_t exclusive_acquired = 0;
+    uint64_t exclusive_waited = 0;
+    std::chrono::nanoseconds exclusive_wait_time{0};
+    uint64_t shared_acquired = 0;
+    uint64_t shared_waited = 0;
+    std::chrono::nanoseconds shared_wait_time{0};
+};
+
+/// A reader/writer mutex that, unlike std::shared_mutex, may be re-locked by the thread already
+/// holding it.  This satisfies both the Lockable and SharedLockable requirements so that it can be
+/// used with std::unique_lock and std::shared_lock.
+///
+/// Re-entrance rules:
+/// - a thread holding the exclusive lock may take further exclusive *or* shared locks (shared locks
+///   taken while holding the exclusive lock simply nest inside the exclusive lock);
+/// - a thread holding a shared lock may take further shared locks;
+/// - a thread holding only a shared lock may *not* take the exclusive lock: that would deadlock
+///   against any other shared holder, so lock() throws std::logic_error in that case instead.
+///
+/// Writers are preferred: once a thread is waiting for the exclusive lock, threads that don't
+/// already hold a shared lock wait behind it rather than joining the current readers, so that a
+/// steady stream of readers can't starve writers.  (Re-entrant shared locks by existing readers
+/// still go through, as the writer has to wait for those readers anyway.)
+///
+/// The mutex also keeps contention counters (see lock_contention_stats) that are cheap enough to
+/// leave on: the uncontended paths only touch a couple of relaxed atomics.
+class recursive_shared_mutex {
+public:
+    recursive_shared_mutex() = default;
+    recursive_shared_mutex(const recursive_shared_mutex&) = delete;
+    recursive_shared_mutex& operator=(const recursive_shared_mutex&) = delete;
+    ~recursive_shared_mutex();
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    void lock_shared();
+    bool try_lock_shared();
+    void unlock_shared();
+
+    /// Returns true if the calling thread currently holds the exclusive lock.
+    bool owns_exclusive() const { return owner_.load(std::memory_order_acquire) == std::this_thread::get_id(); }
+
+    /// Returns a snapshot of the contention counters.
+    lock_contention_stats contention() const;
+
+private:
+    // Returns a reference to the calling thread's shared recursion depth for this mutex.
+    unsigned& shared_depth() const;
+
+    std::shared_mutex mutex_;
+    // Held by a writer from before it starts waiting for mutex_ until it gets it; new readers pass
+    // through it before taking their shared lock, so they queue up behind any waiting writer.
+    std::mutex turnstile_;
+    std::atomic<std::thread::id> owner_{};
+    unsigned recursion_ = 0; // only accessed by the exclusive owner
+
+    std::atomic<uint64_t> exclusive_acquired_{0}, exclusive_waited_{0}, exclusive_wait_ns_{0};
+    std::atomic<uint64_t> shared_acquired_{0}, shared_waited_{0}, shared_wait_ns_{0};
+};
+
 }
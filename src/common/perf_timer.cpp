@@ -27,6 +27,10 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
 #include <vector>
 #include "epee/misc_os_dependent.h"
 #include "perf_timer.h"
@@ -48,6 +52,174 @@ el::Level performance_timer_log_level = el::Level::Info;
 
 static thread_local std::vector<LoggingPerformanceTimer*> *performance_timers = NULL;
 
+namespace {
+
+// Per-thread statistics are kept in lazily allocated chunks of timer slots so that threads only
+// pay for the timer ids they actually use.
+constexpr size_t TIMERS_PER_CHUNK = 64;
+constexpr size_t MAX_TIMER_CHUNKS = 64;
+constexpr size_t MAX_TIMERS = TIMERS_PER_CHUNK * MAX_TIMER_CHUNKS;
+
+// Each slot is only ever written by its owning thread, so updates are plain relaxed load+store
+// (no locked read-modify-write); readers in other threads just see slightly stale values.
+struct timer_slot
+{
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> total_ns;
+  std::atomic<uint64_t> max_ns;
+  std::array<std::atomic<uint64_t>, PERFORMANCE_TIMER_BUCKETS> histogram;
+};
+
+struct timer_chunk
+{
+  std::array<timer_slot, TIMERS_PER_CHUNK> slots;
+};
+
+struct thread_timer_stats;
+
+struct timer_registry
+{
+  std::mutex mutex;
+  std::vector<std::pair<std::string, std::string>> names; // Indexed by timer id
+  std::map<std::pair<std::string, std::string>, size_t> ids;
+  std::vector<thread_timer_stats*> threads;
+  std::vector<performance_timer_stats> exited; // Totals of threads that have exited, indexed by timer id
+};
+
+timer_registry& registry()
+{
+  static timer_registry r;
+  return r;
+}
+
+void add_slot(performance_timer_stats& to, const timer_slot& from)
+{
+  to.count += from.count.load(std::memory_order_relaxed);
+  to.total_ns += from.total_ns.load(std::memory_order_relaxed);
+  to.max_ns = std::max(to.max_ns, from.max_ns.load(std::memory_order_relaxed));
+  for (size_t i = 0; i < PERFORMANCE_TIMER_BUCKETS; i++)
+    to.histogram[i] += from.histogram[i].load(std::memory_order_relaxed);
+}
+
+struct thread_timer_stats
+{
+  std::array<std::atomic<timer_chunk*>, MAX_TIMER_CHUNKS> chunks{};
+
+  thread_timer_stats()
+  {
+    auto& reg = registry();
+    std::lock_guard lock{reg.mutex};
+    reg.threads.push_back(this);
+  }
+
+  // Folds this thread's values into the exited totals so that they aren't lost
+  ~thread_timer_stats()
+  {
+    auto& reg = registry();
+    std::lock_guard lock{reg.mutex};
+    reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), this));
+    for (size_t c = 0; c < MAX_TIMER_CHUNKS; c++)
+    {
+      timer_chunk* chunk = chunks[c].load(std::memory_order_relaxed);
+      if (!chunk)
+        continue;
+      for (size_t i = 0; i < TIMERS_PER_CHUNK; i++)
+      {
+        size_t id = c * TIMERS_PER_CHUNK + i;
+        if (id < reg.exited.size())
+          add_slot(reg.exited[id], chunk->slots[i]);
+      }
+      delete chunk;
+    }
+  }
+
+  timer_slot& slot(size_t id)
+  {
+    auto& chunk_ptr = chunks[id / TIMERS_PER_CHUNK];
+    timer_chunk* chunk = chunk_ptr.load(std::memory_order_relaxed);
+    if (!chunk)
+    {
+      chunk = new timer_chunk{};
+      chunk_ptr.store(chunk, std::memory_order_release);
+    }
+    return chunk->slots[id % TIMERS_PER_CHUNK];
+  }
+};
+
+thread_local thread_timer_stats thread_stats;
+
+void bump(std::atomic<uint64_t>& a, uint64_t v)
+{
+  a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+size_t histogram_bucket(uint64_t ns)
+{
+  uint64_t us = ns / 1000;
+  size_t bucket = 0;
+  while (us && bucket < PERFORMANCE_TIMER_BUCKETS - 1)
+  {
+    us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}
+
+size_t register_performance_timer(const char *name, const char *category)
+{
+  auto& reg = registry();
+  std::lock_guard lock{reg.mutex};
+  auto [it, inserted] = reg.ids.emplace(std::make_pair(std::string{name}, std::string{category}), reg.names.size());
+  if (inserted)
+  {
+    if (reg.names.size() >= MAX_TIMERS)
+    {
+      MWARNING("Too many performance timers, not collecting statistics for " << category << "/" << name);
+      it->second = MAX_TIMERS;
+      return it->second;
+    }
+    reg.names.push_back(it->first);
+    auto& exited = reg.exited.emplace_back();
+    exited.name = name;
+    exited.category = category;
+  }
+  return it->second;
+}
+
+void record_performance_timer(size_t id, uint64_t ns)
+{
+  if (id >= MAX_TIMERS)
+    return;
+  auto& slot = thread_stats.slot(id);
+  bump(slot.count, 1);
+  bump(slot.total_ns, ns);
+  if (ns > slot.max_ns.load(std::memory_order_relaxed))
+    slot.max_ns.store(ns, std::memory_order_relaxed);
+  bump(slot.histogram[histogram_bucket(ns)], 1);
+}
+
+std::vector<performance_timer_stats> get_performance_timer_stats()
+{
+  auto& reg = registry();
+  std::lock_guard lock{reg.mutex};
+  std::vector<performance_timer_stats> result = reg.exited;
+  for (const auto* thread : reg.threads)
+  {
+    for (size_t c = 0; c < MAX_TIMER_CHUNKS; c++)
+    {
+      const timer_chunk* chunk = thread->chunks[c].load(std::memory_order_acquire);
+      if (!chunk)
+        continue;
+      for (size_t i = 0; i < TIMERS_PER_CHUNK && c * TIMERS_PER_CHUNK + i < result.size(); i++)
+        add_slot(result[c * TIMERS_PER_CHUNK + i], chunk->slots[i]);
+    }
+  }
+  result.erase(std::remove_if(result.begin(), result.end(), [](const auto& s) { return s.count == 0; }), result.end());
+  return result;
+}
+
 void set_performance_timer_log_level(el::Level level)
 {
   if (level != el::Level::Debug && level != el::Level::Trace && level != el::Level::Info
@@ -67,13 +239,13 @@ PerformanceTimer::PerformanceTimer(bool paused): started(true), paused(paused)
     ticks = epee::misc_utils::get_ns_count();
 }
 
-LoggingPerformanceTimer::LoggingPerformanceTimer(const std::string &s, const std::string &cat, uint64_t unit, el::Level l): PerformanceTimer(), name(s), cat(cat), unit(unit), level(l)
+LoggingPerformanceTimer::LoggingPerformanceTimer(size_t stats_id, const char *s, const char *cat, uint64_t unit, el::Level l): PerformanceTimer(), stats_id(stats_id), name(s), cat(cat), unit(unit), level(l)
 {
-  const bool log = ELPP->vRegistry()->allowed(level, cat.c_str());
+  const bool log = ELPP->vRegistry()->allowed(level, cat);
   if (!performance_timers)
   {
     if (log)
-      PERF_LOG_ALWAYS(level, cat.c_str(), "PERF             ----------");
+      PERF_LOG_ALWAYS(level, cat, "PERF             ----------");
     performance_timers = new std::vector<LoggingPerformanceTimer*>();
     performance_timers->reserve(16); // how deep before realloc
   }
@@ -85,7 +257,7 @@ LoggingPerformanceTimer::LoggingPerformanceTimer(const std::string &s, const std
       if (log)
       {
         size_t size = 0; for (const auto *tmp: *performance_timers) if (!tmp->paused) ++size;
-        PERF_LOG_ALWAYS(pt->level, cat.c_str(), "PERF           " << std::string((size-1) * 2, ' ') << "  " << pt->name);
+        PERF_LOG_ALWAYS(pt->level, cat, "PERF           " << std::string((size-1) * 2, ' ') << "  " << pt->name);
       }
       pt->started = true;
     }
@@ -96,14 +268,15 @@ LoggingPerformanceTimer::LoggingPerformanceTimer(const std::string &s, const std
 LoggingPerformanceTimer::~LoggingPerformanceTimer()
 {
   pause();
+  record_performance_timer(stats_id, ticks);
   performance_timers->pop_back();
-  const bool log = ELPP->vRegistry()->allowed(level, cat.c_str());
+  const bool log = ELPP->vRegistry()->allowed(level, cat);
   if (log)
   {
     char s[12];
     snprintf(s, sizeof(s), "%8llu  ", (unsigned long long)(ticks / (1000000000 / unit)));
     size_t size = 0; for (const auto *tmp: *performance_timers) if (!tmp->paused || tmp==this) ++size;
-    PERF_LOG_ALWAYS(level, cat.c_str(), "PERF " << s << std::string(size * 2, ' ') << "  " << name);
+    PERF_LOG_ALWAYS(level, cat, "PERF " << s << std::string(size * 2, ' ') << "  " << name);
   }
   if (performance_timers->empty())
   {
@@ -29,7 +29,9 @@
 
 #pragma once
 
+#include <array>
 #include <string>
+#include <vector>
 #include <cstdio>
 #include <cstdint>
 #include "epee/misc_log_ex.h"
@@ -57,26 +59,58 @@ protected:
   bool paused;
 };
 
+// Number of latency histogram buckets kept for each timer.  Bucket 0 counts durations under 1us;
+// bucket i (for i >= 1) counts durations in [2^(i-1), 2^i) microseconds, except for the last
+// bucket which also includes everything longer.
+constexpr size_t PERFORMANCE_TIMER_BUCKETS = 32;
+
+// Aggregated statistics of a named timer, summed over all threads since startup.
+struct performance_timer_stats
+{
+  std::string name;
+  std::string category;
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  std::array<uint64_t, PERFORMANCE_TIMER_BUCKETS> histogram;
+};
+
+// Returns the id of the timer with the given name and category, registering it if needed.  Timers
+// with the same name and category (e.g. from different call sites) share statistics.  The PERF_TIMER
+// macros call this once per call site.
+size_t register_performance_timer(const char *name, const char *category);
+
+// Records one timer run into the calling thread's statistics.  This is lock-free and doesn't
+// allocate (beyond the first time a thread records a given block of timer ids), so is always on.
+void record_performance_timer(size_t id, uint64_t ns);
+
+// Returns the current statistics of every timer that has recorded at least one run.
+std::vector<performance_timer_stats> get_performance_timer_stats();
+
 class LoggingPerformanceTimer: public PerformanceTimer
 {
 public:
-  LoggingPerformanceTimer(const std::string &s, const std::string &cat, uint64_t unit, el::Level l = el::Level::Info);
+  LoggingPerformanceTimer(size_t stats_id, const char *s, const char *cat, uint64_t unit, el::Level l = el::Level::Info);
   ~LoggingPerformanceTimer();
 
 private:
-  std::string name;
-  std::string cat;
+  size_t stats_id;
+  const char *name;
+  const char *cat;
   uint64_t unit;
   el::Level level;
 };
 
 void set_performance_timer_log_level(el::Level level);
 
-#define PERF_TIMER_UNIT(name, unit) tools::LoggingPerformanceTimer pt_##name(#name, "perf." OXEN_DEFAULT_LOG_CATEGORY, unit, tools::performance_timer_log_level)
-#define PERF_TIMER_UNIT_L(name, unit, l) tools::LoggingPerformanceTimer pt_##name(#name, "perf." OXEN_DEFAULT_LOG_CATEGORY, unit, l)
+// Evaluates to the (registered once, on first use) statistics id of the timer for this call site
+#define PERF_TIMER_ID(name) [] { static const size_t id = tools::register_performance_timer(#name, "perf." OXEN_DEFAULT_LOG_CATEGORY); return id; }()
+
+#define PERF_TIMER_UNIT(name, unit) tools::LoggingPerformanceTimer pt_##name(PERF_TIMER_ID(name), #name, "perf." OXEN_DEFAULT_LOG_CATEGORY, unit, tools::performance_timer_log_level)
+#define PERF_TIMER_UNIT_L(name, unit, l) tools::LoggingPerformanceTimer pt_##name(PERF_TIMER_ID(name), #name, "perf." OXEN_DEFAULT_LOG_CATEGORY, unit, l)
 #define PERF_TIMER(name) PERF_TIMER_UNIT(name, 1000000)
 #define PERF_TIMER_L(name, l) PERF_TIMER_UNIT_L(name, 1000000, l)
-#define PERF_TIMER_START_UNIT(name, unit) std::unique_ptr<tools::LoggingPerformanceTimer> pt_##name(new tools::LoggingPerformanceTimer(#name, "perf." OXEN_DEFAULT_LOG_CATEGORY, unit, el::Level::Info))
+#define PERF_TIMER_START_UNIT(name, unit) std::unique_ptr<tools::LoggingPerformanceTimer> pt_##name(new tools::LoggingPerformanceTimer(PERF_TIMER_ID(name), #name, "perf." OXEN_DEFAULT_LOG_CATEGORY, unit, el::Level::Info))
 #define PERF_TIMER_START(name) PERF_TIMER_START_UNIT(name, 1000000)
 #define PERF_TIMER_STOP(name) do { pt_##name.reset(NULL); } while(0)
 #define PERF_TIMER_PAUSE(name) pt_##name->pause()
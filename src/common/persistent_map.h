@@ -0,0 +1,267 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace tools
+{
+
+/// Hash map with cheap, structurally shared copies.
+///
+/// Elements are spread over a fixed number of shards selected by the key hash; each shard is a
+/// small vector held through a shared_ptr.  Copying the map copies only the shard pointers, and
+/// a mutation copies just the one shard it touches (or mutates it in place when no other copy
+/// shares it), so a long history of snapshots that each differ by a few entries costs roughly
+/// one shard per change rather than one full map per snapshot.
+///
+/// The read interface mirrors std::unordered_map (find/count/at/size/iteration yielding
+/// `.first`/`.second`), but iteration is const-only: values are modified through `operator[]`,
+/// `get_mutable()`, `emplace()` and `erase()`, which are the points where copy-on-write happens.
+/// Any mutation invalidates outstanding iterators.
+///
+/// Not thread-safe for concurrent mutation; distinct copies may be used from different threads.
+template <typename Key, typename T, typename Hash = std::hash<Key>, size_t Shards = 256>
+class persistent_map
+{
+  static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "shard count must be a power of two");
+
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using size_type = size_t;
+
+private:
+  using shard_t = std::vector<value_type>;
+  std::array<std::shared_ptr<shard_t>, Shards> m_shards;
+  size_t m_size = 0;
+
+  static size_t shard_index(const Key& key) { return Hash{}(key) & (Shards - 1); }
+
+  // Returns a shard that is safe to modify, copying it first if another map still references it.
+  shard_t& writable_shard(size_t i)
+  {
+    auto& s = m_shards[i];
+    if (!s)
+      s = std::make_shared<shard_t>();
+    else if (s.use_count() > 1)
+      s = std::make_shared<shard_t>(*s);
+    return *s;
+  }
+
+  static typename shard_t::iterator find_in(shard_t& shard, const Key& key)
+  {
+    return std::find_if(shard.begin(), shard.end(), [&key](const value_type& v) { return v.first == key; });
+  }
+
+public:
+  class const_iterator
+  {
+    const persistent_map* m_map = nullptr;
+    size_t m_shard = Shards;
+    size_t m_pos = 0;
+
+    // Moves forward to the next non-empty shard if we are at the end of the current one.
+    void settle()
+    {
+      while (m_shard < Shards && (!m_map->m_shards[m_shard] || m_pos >= m_map->m_shards[m_shard]->size()))
+      {
+        ++m_shard;
+        m_pos = 0;
+      }
+    }
+
+    friend class persistent_map;
+    const_iterator(const persistent_map* map, size_t shard, size_t pos) : m_map{map}, m_shard{shard}, m_pos{pos} { settle(); }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename persistent_map::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return (*m_map->m_shards[m_shard])[m_pos]; }
+    pointer operator->() const { return &**this; }
+    const_iterator& operator++() { ++m_pos; settle(); return *this; }
+    const_iterator operator++(int) { auto copy = *this; ++*this; return copy; }
+    bool operator==(const const_iterator& o) const { return m_shard == o.m_shard && m_pos == o.m_pos; }
+    bool operator!=(const const_iterator& o) const { return !(*this == o); }
+  };
+  using iterator = const_iterator;
+
+  persistent_map() = default;
+
+  const_iterator begin() const { return {this, 0, 0}; }
+  const_iterator end() const { return {this, Shards, 0}; }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  void clear()
+  {
+    for (auto& s : m_shards)
+      s.reset();
+    m_size = 0;
+  }
+
+  const_iterator find(const Key& key) const
+  {
+    size_t i = shard_index(key);
+    if (auto& s = m_shards[i])
+      for (size_t pos = 0; pos < s->size(); pos++)
+        if ((*s)[pos].first == key)
+          return {this, i, pos};
+    return end();
+  }
+
+  size_t count(const Key& key) const { return find(key) != end(); }
+
+  const T& at(const Key& key) const
+  {
+    auto it = find(key);
+    if (it == end())
+      throw std::out_of_range{"persistent_map::at: key not found"};
+    return it->second;
+  }
+
+  /// Returns a modifiable reference to the value for an existing key, un-sharing its shard first.
+  /// Throws std::out_of_range if the key is not present.
+  T& get_mutable(const Key& key)
+  {
+    size_t i = shard_index(key);
+    if (!m_shards[i] || find_in(*m_shards[i], key) == m_shards[i]->end())
+      throw std::out_of_range{"persistent_map::get_mutable: key not found"};
+    auto& shard = writable_shard(i);
+    return find_in(shard, key)->second;
+  }
+
+  /// Returns a modifiable reference to the value for `key`, inserting a default value if needed.
+  T& operator[](const Key& key)
+  {
+    auto& shard = writable_shard(shard_index(key));
+    auto it = find_in(shard, key);
+    if (it != shard.end())
+      return it->second;
+    m_size++;
+    return shard.emplace_back(key, T{}).second;
+  }
+
+  /// Inserts `value` at `key` if the key is not already present.  Returns an iterator to the
+  /// element and whether an insertion took place (like std::unordered_map::emplace).
+  template <typename K, typename... Args>
+  std::pair<const_iterator, bool> emplace(K&& key, Args&&... args)
+  {
+    auto it = find(key);
+    if (it != end())
+      return {it, false};
+    size_t i = shard_index(key);
+    auto& shard = writable_shard(i);
+    shard.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    m_size++;
+    return {const_iterator{this, i, shard.size() - 1}, true};
+  }
+
+  size_t erase(const Key& key)
+  {
+    size_t i = shard_index(key);
+    if (!m_shards[i] || find_in(*m_shards[i], key) == m_shards[i]->end())
+      return 0;
+    auto& shard = writable_shard(i);
+    auto it = find_in(shard, key);
+    // Order within a shard is irrelevant, so swap-and-pop rather than shifting
+    if (it != std::prev(shard.end()))
+      *it = std::move(shard.back());
+    shard.pop_back();
+    if (shard.empty())
+      m_shards[i].reset();
+    m_size--;
+    return 1;
+  }
+
+  /// Erases the element at `it`; returns an iterator to the element that followed it.
+  const_iterator erase(const_iterator it)
+  {
+    size_t shard = it.m_shard, pos = it.m_pos;
+    erase(Key{it->first});
+    return {this, shard, pos};
+  }
+
+  /// Calls `changed(const value_type&)` for each element of this map that is missing from `base`
+  /// or has a different value there, and `removed(const Key&)` for each key of `base` that is not
+  /// in this map.  Shards that the two maps still share are skipped without being looked at, so
+  /// diffing a map against the copy it was derived from costs only as much as what changed.
+  template <typename Changed, typename Removed>
+  void diff(const persistent_map& base, Changed&& changed, Removed&& removed) const
+  {
+    static const shard_t empty;
+    for (size_t i = 0; i < Shards; i++)
+    {
+      if (m_shards[i] == base.m_shards[i])
+        continue;
+      const shard_t& mine = m_shards[i] ? *m_shards[i] : empty;
+      const shard_t& theirs = base.m_shards[i] ? *base.m_shards[i] : empty;
+      for (const auto& v : mine)
+      {
+        auto it = std::find_if(theirs.begin(), theirs.end(), [&v](const value_type& b) { return b.first == v.first; });
+        if (it == theirs.end() || !(it->second == v.second))
+          changed(v);
+      }
+      for (const auto& b : theirs)
+        if (std::none_of(mine.begin(), mine.end(), [&b](const value_type& v) { return v.first == b.first; }))
+          removed(b.first);
+    }
+  }
+
+  /// Returns the number of non-empty shards this map still shares with `other`; mostly useful
+  /// for tests and diagnostics of how much storage two snapshots have in common.
+  size_t shared_shards(const persistent_map& other) const
+  {
+    size_t n = 0;
+    for (size_t i = 0; i < Shards; i++)
+      if (m_shards[i] && m_shards[i] == other.m_shards[i])
+        n++;
+    return n;
+  }
+};
+
+}
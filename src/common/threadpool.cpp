@@ -33,10 +33,13 @@
 
 static thread_local int depth = 0;
 static thread_local bool is_leaf = false;
+// The pool (and queue index within it) of the current thread, if it is a pool worker
+static thread_local const tools::threadpool *worker_pool = nullptr;
+static thread_local size_t worker_index = 0;
 
 namespace tools
 {
-threadpool::threadpool(unsigned int max_threads) : running(true), active(0) {
+threadpool::threadpool(unsigned int max_threads) : running(true) {
   create(max_threads);
 }
 
@@ -74,18 +77,21 @@ void threadpool::create(unsigned int max_threads) {
   const std::unique_lock lock{mutex};
   max = max_threads ? max_threads : tools::get_max_concurrency();
   running = true;
-  for (size_t i = max ? max : 1; i > 0; i--) {
-    threads.emplace_back([this] { run(false); });
+  const size_t nthreads = max ? max : 1;
+  // Queues survive a recycle() (and keep any tasks still queued in them)
+  while (queues.size() < nthreads)
+    queues.push_back(std::make_unique<worker_queue>());
+  for (size_t i = 0; i < nthreads; i++) {
+    threads.emplace_back([this, i] { run_worker(i); });
   }
 }
 
 void threadpool::submit(waiter *obj, std::function<void()> f, bool leaf) {
   CHECK_AND_ASSERT_THROW_MES(!is_leaf, "A leaf routine is using a thread pool");
-  std::unique_lock lock{mutex};
-  if (!leaf && ((active == max && !queue.empty()) || depth > 0)) {
+  if (!leaf && ((active == max && pending > 0) || depth > 0)) {
     // if all available threads are already running
     // and there's work waiting, just run in current thread
-    lock.unlock();
+    ++n_inline;
     ++depth;
     is_leaf = leaf;
     f();
@@ -94,10 +100,22 @@ void threadpool::submit(waiter *obj, std::function<void()> f, bool leaf) {
   } else {
     if (obj)
       obj->inc();
-    if (leaf)
-      queue.push_front({obj, f, leaf});
-    else
-      queue.push_back({obj, f, leaf});
+    // Workers queue onto their own queue; everyone else spreads tasks across the workers
+    auto &q = *queues[worker_pool == this ? worker_index : next_queue++ % queues.size()];
+    {
+      std::unique_lock qlock{q.mutex};
+      // Count the task before it becomes visible: a worker can pop it (and decrement `pending`)
+      // as soon as the queue lock is released.
+      ++pending;
+      if (leaf)
+        q.tasks.push_front({obj, std::move(f), leaf});
+      else
+        q.tasks.push_back({obj, std::move(f), leaf});
+    }
+    ++n_submitted;
+    // Taking the mutex (which sleeping workers check `pending` under) ensures we can't notify
+    // between a worker's check and its wait.
+    { std::unique_lock lock{mutex}; }
     has_work.notify_one();
   }
 }
@@ -106,6 +124,16 @@ unsigned int threadpool::get_max_concurrency() const {
   return max;
 }
 
+threadpool::stats threadpool::get_stats() const {
+  stats s;
+  s.queue_depth = pending.load(std::memory_order_relaxed);
+  s.submitted = n_submitted.load(std::memory_order_relaxed);
+  s.inline_runs = n_inline.load(std::memory_order_relaxed);
+  s.steals = n_steals.load(std::memory_order_relaxed);
+  s.idle_time = std::chrono::nanoseconds{idle_ns.load(std::memory_order_relaxed)};
+  return s;
+}
+
 threadpool::waiter::~waiter()
 {
   try
@@ -145,32 +173,68 @@ void threadpool::waiter::dec() {
     cv.notify_all();
 }
 
-void threadpool::run(bool flush) {
-  std::unique_lock lock{mutex};
-  while (running) {
-    entry e;
-    while(queue.empty() && running)
-    {
-      if (flush)
-        return;
-      has_work.wait(lock);
+bool threadpool::pop_task(size_t self, entry &e) {
+  if (pending == 0)
+    return false;
+  const size_t n = queues.size();
+  for (size_t k = 0; k < n; k++) {
+    const size_t i = (self + k) % n;
+    auto &q = *queues[i];
+    std::unique_lock qlock{q.mutex};
+    if (q.tasks.empty())
+      continue;
+    if (k == 0) {
+      e = std::move(q.tasks.front());
+      q.tasks.pop_front();
+    } else {
+      e = std::move(q.tasks.back());
+      q.tasks.pop_back();
+      ++n_steals;
     }
-    if (!running) break;
+    --pending;
+    return true;
+  }
+  return false;
+}
 
-    active++;
-    e = std::move(queue.front());
-    queue.pop_front();
-    lock.unlock();
-    ++depth;
-    is_leaf = e.leaf;
-    e.f();
-    --depth;
-    is_leaf = false;
+void threadpool::execute(entry &e) {
+  active++;
+  ++depth;
+  is_leaf = e.leaf;
+  e.f();
+  --depth;
+  is_leaf = false;
+
+  if (e.wo)
+    e.wo->dec();
+  active--;
+}
+
+// Called by a waiter to help run queued tasks until there are none left
+void threadpool::run(bool /*flush*/) {
+  const size_t self = worker_pool == this ? worker_index : 0;
+  entry e;
+  while (running && pop_task(self, e))
+    execute(e);
+}
 
-    if (e.wo)
-      e.wo->dec();
-    lock.lock();
-    active--;
+void threadpool::run_worker(size_t index) {
+  worker_pool = this;
+  worker_index = index;
+  while (true) {
+    entry e;
+    if (pop_task(index, e)) {
+      execute(e);
+      continue;
+    }
+    std::unique_lock lock{mutex};
+    if (running && pending == 0) {
+      const auto started = std::chrono::steady_clock::now();
+      has_work.wait(lock, [this] { return !running || pending > 0; });
+      idle_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+    }
+    if (!running) break;
   }
+  worker_pool = nullptr;
 }
 }
@@ -27,8 +27,13 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <deque>
@@ -40,6 +45,10 @@
 namespace tools
 {
 //! A global thread pool
+//!
+//! Each worker thread has its own task queue: tasks submitted from outside the pool are spread
+//! across the worker queues round-robin, each worker takes tasks from the front of its own queue
+//! and, once that is empty, steals from the back of the other workers' queues.
 class threadpool
 {
 public:
@@ -70,11 +79,40 @@ public:
   // task to finish.
   void submit(waiter *waiter, std::function<void()> f, bool leaf = false);
 
+  // Submits f(i) for every i in [begin, end), split into contiguous chunks of `chunk_size`
+  // indices (by default, enough chunks to give each thread a few) so that there is one queued
+  // task (and one std::function) per chunk rather than per item.  f is shared by all the chunks
+  // and must be safe to call concurrently.
+  template <typename F>
+  void submit_range(waiter *waiter, size_t begin, size_t end, F f, size_t chunk_size = 0) {
+    if (begin >= end)
+      return;
+    if (chunk_size == 0)
+      chunk_size = std::max<size_t>(1, (end - begin) / (4 * std::max(max, 1u)));
+    auto shared_f = std::make_shared<F>(std::move(f));
+    for (size_t i = begin; i < end; i += std::min(chunk_size, end - i)) {
+      const size_t last = i + std::min(chunk_size, end - i);
+      submit(waiter, [shared_f, i, last] {
+        for (size_t j = i; j < last; ++j)
+          (*shared_f)(j);
+      });
+    }
+  }
+
   // destroy and recreate threads
   void recycle();
 
   unsigned int get_max_concurrency() const;
 
+  struct stats {
+    size_t queue_depth; //!< tasks currently queued, across all workers
+    uint64_t submitted; //!< tasks queued (i.e. not run inline by the submitter)
+    uint64_t inline_runs; //!< tasks run inline by the submitting thread
+    uint64_t steals; //!< tasks a worker took from another worker's queue
+    std::chrono::nanoseconds idle_time; //!< total time workers spent waiting for work
+  };
+  stats get_stats() const;
+
   ~threadpool();
   void stop();
   void start(unsigned int max_threads = 0);
@@ -88,14 +126,26 @@ public:
       std::function<void()> f;
       bool leaf;
     } entry;
-    std::deque<entry> queue;
+    struct worker_queue {
+      std::mutex mutex;
+      std::deque<entry> tasks;
+    };
+    // Takes a task from queue `self` (from the front), or else steals one from the back of
+    // another queue.  Returns false if all queues are empty.
+    bool pop_task(size_t self, entry &e);
+    void execute(entry &e);
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::atomic<size_t> pending{0};
+    std::atomic<unsigned int> next_queue{0};
     std::condition_variable has_work;
     std::mutex mutex;
     std::vector<std::thread> threads;
-    unsigned int active;
+    std::atomic<unsigned int> active{0};
     unsigned int max;
-    bool running;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> n_submitted{0}, n_inline{0}, n_steals{0}, idle_ns{0};
     void run(bool flush = false);
+    void run_worker(size_t index);
 };
 
 }
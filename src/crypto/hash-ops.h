@@ -62,6 +62,7 @@ enum
 
 #define CN_TURTLE_PAGE_SIZE 262144
 void cn_fast_hash(const void *data, size_t length, char *hash);
+void cn_fast_hash_many(const void *const *data, const size_t *length, char (*hashes)[HASH_SIZE], size_t count);
 void cn_turtle_hash(const void *data, size_t length, char *hash, int light, int variant, int prehashed, uint32_t scratchpad, uint32_t iterations);
 #ifdef ENABLE_MONERO_SLOW_HASH
 void cn_monero_hash(const void *data, size_t length, char *hash, int variant, int prehashed);
@@ -69,6 +69,12 @@ namespace crypto {
     return h;
   }
 
+  // Hashes `count` independent buffers (data[i] of length[i] bytes, into hashes[i]) at once; this
+  // is considerably faster than separate cn_fast_hash calls on CPUs with AVX2/AVX-512.
+  inline void cn_fast_hash_many(const void *const *data, const std::size_t *length, hash *hashes, std::size_t count) {
+    cn_fast_hash_many(data, length, reinterpret_cast<char (*)[HASH_SIZE]>(hashes), count);
+  }
+
   enum struct cn_slow_hash_type
   {
 #ifdef ENABLE_MONERO_SLOW_HASH
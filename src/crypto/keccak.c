@@ -144,6 +144,112 @@ void keccak1600(const uint8_t *in, size_t inlen, uint8_t *md)
     keccak(in, inlen, md, sizeof(state_t));
 }
 
+#if defined(HAVE_KECCAK_AVX2) || defined(HAVE_KECCAK_AVX512)
+
+#define KECCAK_MAX_LANES 8
+
+// keccak-avx2.c / keccak-avx512.c
+void keccakf_x4_avx2(uint64_t *lanes, int rounds);
+void keccakf_x8_avx512(uint64_t *lanes, int rounds);
+
+// Hashes the messages through `nlanes` lane-parallel states.  Each lane works through one message
+// at a time, a block per permutation; as soon as a lane has absorbed its padded last block it
+// outputs the digest and picks up the next waiting message, so messages of different lengths
+// still keep every lane busy until the queue runs dry.
+static void keccak_lanes(const uint8_t *const *in, const size_t *inlen, uint8_t *md, size_t count, int mdlen,
+    size_t nlanes, void (*permute)(uint64_t *, int))
+{
+    uint64_t st[25 * KECCAK_MAX_LANES];
+    uint8_t temp[144];
+    const uint8_t *pos[KECCAK_MAX_LANES];
+    size_t left[KECCAK_MAX_LANES], msg[KECCAK_MAX_LANES];
+    bool last[KECCAK_MAX_LANES];
+    size_t next = 0, active = 0, i, l;
+    const size_t rsiz = 200 - 2 * mdlen, rsizw = rsiz / 8;
+
+    for (l = 0; l < nlanes; l++)
+        msg[l] = SIZE_MAX;
+
+    while (next < count || active > 0) {
+        for (l = 0; l < nlanes; l++) {
+            if (msg[l] == SIZE_MAX) {
+                if (next == count)
+                    continue;
+                msg[l] = next;
+                pos[l] = in[next];
+                left[l] = inlen[next];
+                next++;
+                active++;
+                for (i = 0; i < 25; i++)
+                    st[i * nlanes + l] = 0;
+            }
+
+            const uint8_t *block = pos[l];
+            last[l] = left[l] < rsiz;
+            if (last[l]) {
+                // last block and padding
+                if (left[l] > 0)
+                    memcpy(temp, pos[l], left[l]);
+                temp[left[l]] = 1;
+                memset(temp + left[l] + 1, 0, rsiz - left[l] - 1);
+                temp[rsiz - 1] |= 0x80;
+                block = temp;
+            } else {
+                pos[l] += rsiz;
+                left[l] -= rsiz;
+            }
+            for (i = 0; i < rsizw; i++) {
+                uint64_t ina;
+                memcpy(&ina, block + i * 8, 8);
+                st[i * nlanes + l] ^= swap64le(ina);
+            }
+        }
+
+        permute(st, KECCAK_ROUNDS);
+
+        for (l = 0; l < nlanes; l++) {
+            if (msg[l] == SIZE_MAX || !last[l])
+                continue;
+            for (i = 0; i < (size_t)mdlen / 8; i++) {
+                uint64_t out = swap64le(st[i * nlanes + l]);
+                memcpy(md + msg[l] * mdlen + i * 8, &out, 8);
+            }
+            msg[l] = SIZE_MAX;
+            active--;
+        }
+    }
+}
+
+#endif
+
+void keccak_many(const uint8_t *const *in, const size_t *inlen, uint8_t *md, size_t count, int mdlen)
+{
+    size_t i;
+
+    if (mdlen <= 0 || mdlen > 100 || mdlen % 8 != 0)
+    {
+      local_abort("Bad keccak use");
+    }
+
+#ifdef HAVE_KECCAK_AVX512
+    if (count > 4 && __builtin_cpu_supports("avx512f"))
+    {
+      keccak_lanes(in, inlen, md, count, mdlen, 8, keccakf_x8_avx512);
+      return;
+    }
+#endif
+#ifdef HAVE_KECCAK_AVX2
+    if (count > 1 && __builtin_cpu_supports("avx2"))
+    {
+      keccak_lanes(in, inlen, md, count, mdlen, 4, keccakf_x4_avx2);
+      return;
+    }
+#endif
+
+    for (i = 0; i < count; i++)
+      keccak(in[i], inlen[i], md + i * mdlen, mdlen);
+}
+
 #define KECCAK_FINALIZED 0x80000000
 #define KECCAK_BLOCKLEN 136
 #define KECCAK_WORDS 17
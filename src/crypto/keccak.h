@@ -34,6 +34,11 @@ void keccakf(uint64_t st[25], int norounds);
 
 void keccak1600(const uint8_t *in, size_t inlen, uint8_t *md);
 
+// compute keccak hashes of `count` independent messages: message i is in[i] (of inlen[i] bytes)
+// and its mdlen-byte hash is written to md + i * mdlen.  Runs several messages through SIMD
+// lane-parallel permutations when the CPU supports it.
+void keccak_many(const uint8_t *const *in, const size_t *inlen, uint8_t *md, size_t count, int mdlen);
+
 void keccak_init(KECCAK_CTX * ctx);
 void keccak_update(KECCAK_CTX * ctx, const uint8_t *in, size_t inlen);
 void keccak_finish(KECCAK_CTX * ctx, uint8_t *md);
@@ -86,21 +86,37 @@ void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
     char *ints = calloc(cnt, HASH_SIZE);  // zero out as extra protection for using uninitialized mem
     assert(ints);
 
+    // The pairs on each level are independent, so each level is hashed as one cn_fast_hash_many
+    // batch (into `level`, then copied back) rather than pair by pair.
+    char (*level)[HASH_SIZE] = calloc(cnt, HASH_SIZE);
+    const void **data = malloc(cnt * sizeof(*data));
+    size_t *lengths = malloc(cnt * sizeof(*lengths));
+    assert(level && data && lengths);
+    for (j = 0; j < cnt; ++j)
+      lengths[j] = 64;
+
     memcpy(ints, hashes, (2 * cnt - count) * HASH_SIZE);
 
-    for (i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
-      cn_fast_hash(hashes[i], 64, ints + j * HASH_SIZE);
+    for (i = 2 * cnt - count, j = 0; i < count; i += 2, ++j) {
+      data[j] = hashes[i];
     }
-    assert(i == count);
+    cn_fast_hash_many(data, lengths, level, j);
+    memcpy(ints + (2 * cnt - count) * HASH_SIZE, level, j * HASH_SIZE);
+    assert(2 * cnt - count + j == cnt);
 
     while (cnt > 2) {
       cnt >>= 1;
       for (i = 0, j = 0; j < cnt; i += 2, ++j) {
-        cn_fast_hash(ints + i * HASH_SIZE, 64, ints + j * HASH_SIZE);
+        data[j] = ints + i * HASH_SIZE;
       }
+      cn_fast_hash_many(data, lengths, level, cnt);
+      memcpy(ints, level, cnt * HASH_SIZE);
     }
 
     cn_fast_hash(ints, 64, root_hash);
+    free(lengths);
+    free(data);
+    free(level);
     free(ints);
   }
 }
@@ -343,8 +343,14 @@ namespace cryptonote
     template<class Archive>
     void serialize_base(Archive& ar)
     {
+      constexpr bool Binary = serialization::is_binary<Archive>;
+      const unsigned int start_pos = Binary ? ar.streampos() : 0;
+
       serialization::value(ar, static_cast<transaction_prefix&>(*this));
 
+      if (Binary)
+        prefix_size = ar.streampos() - start_pos;
+
       if (version != txversion::v1)
       {
         if (!vin.empty())
@@ -29,6 +29,7 @@
 // 
 // Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
 
+#include <array>
 #include <atomic>
 #include <boost/algorithm/string.hpp>
 #include <limits>
@@ -1271,9 +1272,6 @@ namespace cryptonote
     // v2 transactions hash different parts together, than hash the set of those hashes
     crypto::hash hashes[3];
 
-    // prefix
-    get_transaction_prefix_hash(t, hashes[0]);
-
     const blobdata blob = tx_to_blob(t);
     CHECK_AND_ASSERT_MES(!blob.empty(), false, "Failed to convert tx to blob");
 
@@ -1285,13 +1283,22 @@ namespace cryptonote
       const unsigned int unprunable_size = t.unprunable_size;
       const unsigned int prefix_size = t.prefix_size;
 
-      // base rct
       CHECK_AND_ASSERT_MES(prefix_size <= unprunable_size && unprunable_size <= blob.size(), false,
               "Inconsistent transaction prefix (" << prefix_size << "), unprunable (" << unprunable_size << ") and blob (" << blob.size() << ") sizes in: " << __func__);
-      cryptonote::get_blob_hash(std::string_view{blob}.substr(prefix_size, unprunable_size - prefix_size), hashes[1]);
+
+      // prefix, base rct and prunable rct are consecutive pieces of the blob, so hash them together
+      const void *parts[3] = {blob.data(), blob.data() + prefix_size, blob.data() + unprunable_size};
+      const size_t sizes[3] = {prefix_size, unprunable_size - prefix_size, blob.size() - unprunable_size};
+      const bool has_prunable = t.rct_signatures.type != rct::RCTType::Null;
+      crypto::cn_fast_hash_many(parts, sizes, hashes, has_prunable ? 3 : 2);
+      if (!has_prunable)
+        hashes[2] = crypto::null_hash;
     }
     else
     {
+      // prefix
+      get_transaction_prefix_hash(t, hashes[0]);
+
       transaction &tt = const_cast<transaction&>(t);
       serialization::binary_string_archiver ba;
       try {
@@ -1301,17 +1308,17 @@ namespace cryptonote
         return false;
       }
       cryptonote::get_blob_hash(ba.str(), hashes[1]);
-    }
 
-    // prunable rct
-    if (t.rct_signatures.type == rct::RCTType::Null)
-    {
-      hashes[2] = crypto::null_hash;
-    }
-    else if (!calculate_transaction_prunable_hash(t, &blob, hashes[2]))
-    {
-      LOG_ERROR("Failed to get tx prunable hash");
-      return false;
+      // prunable rct
+      if (t.rct_signatures.type == rct::RCTType::Null)
+      {
+        hashes[2] = crypto::null_hash;
+      }
+      else if (!calculate_transaction_prunable_hash(t, &blob, hashes[2]))
+      {
+        LOG_ERROR("Failed to get tx prunable hash");
+        return false;
+      }
     }
 
     // the tx hash is the hash of the 3 hashes
@@ -1399,6 +1406,91 @@ namespace cryptonote
     return get_transaction_hash(t, res, &blob_size);
   }
   //---------------------------------------------------------------
+  bool get_transaction_hashes(const std::vector<const transaction*>& txs, const std::vector<std::string_view>& blobs, std::vector<crypto::hash>& hashes)
+  {
+    CHECK_AND_ASSERT_MES(txs.size() == blobs.size(), false, "Mismatched txes and blobs");
+    hashes.resize(txs.size());
+
+    // Every piece of every tx first (a v1 tx hashes its entire blob), then each v2+ tx's 3 piece
+    // hashes.
+    std::vector<const void*> data;
+    std::vector<size_t> sizes;
+    std::vector<crypto::hash*> outputs;
+    std::vector<std::array<crypto::hash, 3>> pieces(txs.size());
+    std::vector<size_t> combine;
+    auto add = [&](const void *d, size_t size, crypto::hash *out) {
+      data.push_back(d);
+      sizes.push_back(size);
+      outputs.push_back(out);
+    };
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+      const transaction &t = *txs[i];
+      const std::string_view blob = blobs[i];
+      if (t.is_hash_valid())
+        hashes[i] = t.hash;
+      else if (t.version == txversion::v1)
+        add(blob.data(), blob.size(), &hashes[i]);
+      else if (t.is_transfer())
+      {
+        const size_t prefix_size = t.prefix_size, unprunable_size = t.unprunable_size;
+        CHECK_AND_ASSERT_MES(prefix_size <= unprunable_size && unprunable_size <= blob.size(), false,
+            "Inconsistent transaction prefix (" << prefix_size << "), unprunable (" << unprunable_size << ") and blob (" << blob.size() << ") sizes in: " << __func__);
+        add(blob.data(), prefix_size, &pieces[i][0]);
+        add(blob.data() + prefix_size, unprunable_size - prefix_size, &pieces[i][1]);
+        if (t.rct_signatures.type != rct::RCTType::Null)
+          add(blob.data() + unprunable_size, blob.size() - unprunable_size, &pieces[i][2]);
+        else
+          pieces[i][2] = crypto::null_hash;
+        combine.push_back(i);
+      }
+      else if (!get_transaction_hash(t, hashes[i]))
+        return false;
+    }
+
+    std::vector<crypto::hash> results(data.size());
+    crypto::cn_fast_hash_many(data.data(), sizes.data(), results.data(), data.size());
+    for (size_t j = 0; j < results.size(); ++j)
+      *outputs[j] = results[j];
+
+    data.clear();
+    sizes.clear();
+    for (size_t i : combine)
+    {
+      data.push_back(pieces[i].data());
+      sizes.push_back(sizeof(pieces[i]));
+    }
+    results.resize(combine.size());
+    crypto::cn_fast_hash_many(data.data(), sizes.data(), results.data(), data.size());
+    for (size_t j = 0; j < combine.size(); ++j)
+      hashes[combine[j]] = results[j];
+
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+      if (txs[i]->is_hash_valid())
+        continue;
+      ++tx_hashes_calculated_count;
+      txs[i]->hash = hashes[i];
+      txs[i]->set_hash_valid(true);
+    }
+    return true;
+  }
+  //---------------------------------------------------------------
+  void get_transaction_prefix_hashes(const std::vector<const transaction*>& txs, const std::vector<std::string_view>& blobs, std::vector<crypto::hash>& hashes)
+  {
+    CHECK_AND_ASSERT_THROW_MES(txs.size() == blobs.size(), "Mismatched txes and blobs");
+    std::vector<const void*> data(txs.size());
+    std::vector<size_t> sizes(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+      sizes[i] = txs[i]->prefix_size;
+      CHECK_AND_ASSERT_THROW_MES(sizes[i] <= blobs[i].size(), "Inconsistent transaction prefix and blob sizes");
+      data[i] = blobs[i].data();
+    }
+    hashes.resize(txs.size());
+    crypto::cn_fast_hash_many(data.data(), sizes.data(), hashes.data(), txs.size());
+  }
+  //---------------------------------------------------------------
   blobdata get_block_hashing_blob(const block& b)
   {
     blobdata blob = t_serializable_object_to_blob(static_cast<block_header>(b));
@@ -1438,6 +1530,68 @@ namespace cryptonote
     return p;
   }
   //---------------------------------------------------------------
+  bool get_block_hashes(const std::vector<block>& blocks, std::vector<crypto::hash>& hashes)
+  {
+    std::vector<const transaction*> miner_txs;
+    std::vector<blobdata> miner_tx_blobs;
+    for (const auto &b : blocks)
+    {
+      if (b.is_hash_valid() || b.miner_tx.is_hash_valid())
+        continue;
+      miner_txs.push_back(&b.miner_tx);
+      miner_tx_blobs.push_back(tx_to_blob(b.miner_tx));
+    }
+    const std::vector<std::string_view> miner_tx_blob_views(miner_tx_blobs.begin(), miner_tx_blobs.end());
+    std::vector<crypto::hash> miner_tx_hashes;
+    if (!get_transaction_hashes(miner_txs, miner_tx_blob_views, miner_tx_hashes))
+      return false;
+
+    hashes.resize(blocks.size());
+    std::vector<blobdata> hashing_blobs;
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      if (blocks[i].is_hash_valid())
+      {
+        hashes[i] = blocks[i].hash;
+        ++block_hashes_cached_count;
+        continue;
+      }
+      // calculate_block_hash hashes the serialized (i.e. length-prefixed) hashing blob
+      hashing_blobs.push_back(t_serializable_object_to_blob(get_block_hashing_blob(blocks[i])));
+      indices.push_back(i);
+    }
+    std::vector<const void*> data;
+    std::vector<size_t> sizes;
+    for (const auto &blob : hashing_blobs)
+    {
+      data.push_back(blob.data());
+      sizes.push_back(blob.size());
+    }
+    std::vector<crypto::hash> results(hashing_blobs.size());
+    crypto::cn_fast_hash_many(data.data(), sizes.data(), results.data(), data.size());
+    for (size_t j = 0; j < indices.size(); ++j)
+    {
+      const block &b = blocks[indices[j]];
+      ++block_hashes_calculated_count;
+      b.hash = hashes[indices[j]] = results[j];
+      b.set_hash_valid(true);
+    }
+    return true;
+  }
+  //---------------------------------------------------------------
+  uint64_t get_short_tx_id(const crypto::hash& salt, const crypto::hash& txid)
+  {
+    char buf[sizeof(salt) + sizeof(txid)];
+    std::memcpy(buf, salt.data, sizeof(salt));
+    std::memcpy(buf + sizeof(salt), txid.data, sizeof(txid));
+    crypto::hash h;
+    crypto::cn_fast_hash(buf, sizeof(buf), h);
+    uint64_t id;
+    std::memcpy(&id, h.data, sizeof(id));
+    return SWAP64LE(id);
+  }
+  //---------------------------------------------------------------
   std::vector<uint64_t> relative_output_offsets_to_absolute(const std::vector<uint64_t>& off)
   {
     std::vector<uint64_t> res = off;
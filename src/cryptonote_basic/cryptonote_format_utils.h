@@ -190,11 +190,26 @@ namespace cryptonote
   crypto::hash get_transaction_prunable_hash(const transaction& t, const cryptonote::blobdata *blob = NULL);
   bool calculate_transaction_hash(const transaction& t, crypto::hash& res, size_t* blob_size);
   crypto::hash get_pruned_transaction_hash(const transaction& t, const crypto::hash &pruned_data_hash);
+  // Batched get_transaction_hash and get_transaction_prefix_hash for txes just parsed from `blobs`
+  // (so that each tx's prefix and unprunable sizes locate its hashed pieces in its blob): the
+  // pieces of all the txes go through cn_fast_hash_many together.  Tx hashes get cached in the txes.
+  bool get_transaction_hashes(const std::vector<const transaction*>& txs, const std::vector<std::string_view>& blobs, std::vector<crypto::hash>& hashes);
+  void get_transaction_prefix_hashes(const std::vector<const transaction*>& txs, const std::vector<std::string_view>& blobs, std::vector<crypto::hash>& hashes);
+
+  // Salted short transaction id used by compact block relay: the first 8 bytes (little-endian) of
+  // H(salt || txid).  The salt is the hash of the relayed block's previous block, which only keeps
+  // the ids from being computed before that block exists; since it is public, anyone can still
+  // grind txids with colliding short ids for the next block.  Receivers therefore treat ambiguous
+  // ids as unknown and verify the reconstructed block hash, falling back to the full tx hashes.
+  uint64_t get_short_tx_id(const crypto::hash& salt, const crypto::hash& txid);
 
   blobdata get_block_hashing_blob(const block& b);
   bool calculate_block_hash(const block& b, crypto::hash& res);
   bool get_block_hash(const block& b, crypto::hash& res);
   crypto::hash get_block_hash(const block& b);
+  // Batched get_block_hash: the miner txes, then the hashing blobs, of all the blocks go through
+  // cn_fast_hash_many together.  Block hashes get cached in the blocks.
+  bool get_block_hashes(const std::vector<block>& blocks, std::vector<crypto::hash>& hashes);
   bool parse_and_validate_block_from_blob(const std::string_view b_blob, block& b, crypto::hash *block_hash);
   bool parse_and_validate_block_from_blob(const std::string_view b_blob, block& b);
   bool parse_and_validate_block_from_blob(const std::string_view b_blob, block& b, crypto::hash &block_hash);
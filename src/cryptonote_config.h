@@ -155,7 +155,9 @@ constexpr uint64_t BLOCKS_EXPECTED_IN_YEARS(int years) { return BLOCKS_EXPECTED_
 // able to sync non-fluffy blocks, keep here so we can still accept blocks
 // pre-hardfork
 #define P2P_SUPPORT_FLAG_FLUFFY_BLOCKS                  0x01
-#define P2P_SUPPORT_FLAGS                               P2P_SUPPORT_FLAG_FLUFFY_BLOCKS
+#define P2P_SUPPORT_FLAG_COMPACT_BLOCKS                 0x02
+#define P2P_SUPPORT_FLAGS                               (P2P_SUPPORT_FLAG_FLUFFY_BLOCKS | P2P_SUPPORT_FLAG_COMPACT_BLOCKS)
+#define COMPACT_BLOCK_MIN_TX_WEIGHT                     64     // no tx is lighter; bounds the tx count a compact block may claim
 
 #define CRYPTONOTE_NAME                         "oxen"
 #define CRYPTONOTE_POOLDATA_FILENAME            "poolstate.bin"
@@ -32,6 +32,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <numeric>
 #include <boost/endian/conversion.hpp>
 
 #include "common/rules.h"
@@ -77,6 +78,11 @@ extern "C" {
 
 #define FIND_BLOCKCHAIN_SUPPLEMENT_MAX_SIZE (100*1024*1024) // 100 MB
 
+// Maximum number of distinct amounts we keep output distribution prefix sums for; amount 0 (all
+// rct outputs) is always cached, requests for other amounts beyond this limit are served straight
+// from the db.
+#define OUTPUT_DISTRIBUTION_CACHE_MAX_AMOUNTS 8
+
 using namespace crypto;
 
 //#include "serialization/json_archive.h"
@@ -112,7 +118,7 @@ Blockchain::block_extended_info::block_extended_info(const alt_block_data_t &src
 //------------------------------------------------------------------
 Blockchain::Blockchain(tx_memory_pool& tx_pool, service_nodes::service_node_list& service_node_list):
   m_db(), m_tx_pool(tx_pool), m_current_block_cumul_weight_limit(0), m_current_block_cumul_weight_median(0),
-  m_max_prepare_blocks_threads(4), m_db_sync_on_blocks(true), m_db_sync_threshold(1), m_db_sync_mode(db_async), m_db_default_sync(false), m_fast_sync(true), m_show_time_stats(false), m_sync_counter(0), m_bytes_to_sync(0), m_cancel(false),
+  m_max_prepare_blocks_threads(0), m_db_sync_on_blocks(true), m_db_sync_threshold(1), m_db_sync_mode(db_async), m_db_default_sync(false), m_fast_sync(true), m_show_time_stats(false), m_sync_counter(0), m_bytes_to_sync(0), m_cancel(false),
   m_long_term_block_weights_window(CRYPTONOTE_LONG_TERM_BLOCK_WEIGHT_WINDOW_SIZE),
   m_long_term_effective_median_block_weight(0),
   m_long_term_block_weights_cache_tip_hash(crypto::null_hash),
@@ -293,11 +299,25 @@ uint64_t Blockchain::get_current_blockchain_height(bool lock) const
   // m_db functions which do not depend on one another (ie, no getheight + gethash(height-1), as
   // well as not accessing class members, even read only (ie, m_invalid_blocks). The caller must
   // lock if it is otherwise needed or set lock to true.
-  std::unique_lock lock_{*this, std::defer_lock};
+  std::shared_lock lock_{*this, std::defer_lock};
   if (lock) lock_.lock();
   return m_db->height();
 }
 //------------------------------------------------------------------
+namespace {
+  // One step of blocks for load_missing_blocks_into_oxen_subsystems.  The blobs are read from the
+  // db by the calling thread, then the transactions are parsed and the block/tx hashes computed on
+  // the threadpool while the previous step is being applied to the subsystems.
+  struct oxen_subsystems_step
+  {
+    std::vector<cryptonote::block> blocks;
+    std::vector<std::vector<cryptonote::blobdata>> tx_blobs;
+    std::vector<std::vector<cryptonote::transaction>> txs;
+    std::atomic<bool> failed{false};
+    tools::threadpool::waiter waiter;
+  };
+}
+
 bool Blockchain::load_missing_blocks_into_oxen_subsystems()
 {
   uint64_t const snl_height   = std::max(hard_fork_begins(m_nettype, network_version_9_service_nodes).value_or(0), m_service_node_list.height() + 1);
@@ -317,9 +337,64 @@ bool Blockchain::load_missing_blocks_into_oxen_subsystems()
   auto scan_start               = work_start;
   work_time ons_duration{}, snl_duration{}, ons_iteration_duration{}, snl_iteration_duration{};
 
-  std::vector<cryptonote::block> blocks;
-  std::vector<cryptonote::transaction> txs;
-  std::vector<crypto::hash> missed_txs;
+  // Reads the blocks and tx blobs for [height, height + BLOCK_COUNT) and queues parsing them; the
+  // step's waiter must be waited on before using its txs.  Only this thread touches the db because
+  // we may be inside a write txn (e.g. from pop_blocks) that other threads can't see.
+  tools::threadpool& tpool = tools::threadpool::getInstance();
+  auto load_step = [&](uint64_t height, oxen_subsystems_step& step) {
+    size_t const count = std::min<uint64_t>(BLOCK_COUNT, end_height - height);
+    step.blocks.clear();
+    step.tx_blobs.clear();
+    step.txs.clear();
+    step.failed = false;
+    step.blocks.resize(count);
+    step.tx_blobs.resize(count);
+    step.txs.resize(count);
+    try
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        if (!parse_and_validate_block_from_blob(m_db->get_block_blob_from_height(height + i), step.blocks[i]))
+        {
+          LOG_ERROR("Invalid block at height " << height + i);
+          return false;
+        }
+        auto& blobs = step.tx_blobs[i];
+        blobs.reserve(step.blocks[i].tx_hashes.size());
+        for (const auto& tx_hash : step.blocks[i].tx_hashes)
+          if (cryptonote::blobdata blob; m_db->get_tx_blob(tx_hash, blob))
+            blobs.push_back(std::move(blob));
+      }
+    }
+    catch (const std::exception& e)
+    {
+      LOG_ERROR("Unable to get checkpointed historical blocks for updating oxen subsystems: " << e.what());
+      return false;
+    }
+
+    tpool.submit_range(&step.waiter, 0, count, [&step](size_t i) {
+      cryptonote::get_block_hash(step.blocks[i]);
+      auto& blobs = step.tx_blobs[i];
+      auto& txs = step.txs[i];
+      txs.resize(blobs.size());
+      for (size_t j = 0; j < blobs.size(); j++)
+      {
+        if (!parse_and_validate_tx_from_blob(blobs[j], txs[j]))
+        {
+          step.failed = true;
+          return;
+        }
+        cryptonote::get_transaction_hash(txs[j]);
+      }
+      blobs = {};
+    });
+    return true;
+  };
+
+  auto current = std::make_unique<oxen_subsystems_step>();
+  auto next = std::make_unique<oxen_subsystems_step>();
+  if (!load_step(start_height, *current))
+    return false;
 
   for (int64_t block_count = total_blocks,
                index       = 0;
@@ -330,7 +405,7 @@ bool Blockchain::load_missing_blocks_into_oxen_subsystems()
     {
       m_service_node_list.store();
       auto duration = work_time{clock::now() - work_start};
-      MGINFO("... scanning height " << start_height + (index * BLOCK_COUNT) << " (" << duration.count() << "s) (snl: " << snl_iteration_duration.count() << "s; ons: " << ons_iteration_duration.count() << "s)");
+      MGINFO("... scanning height " << start_height + (index * BLOCK_COUNT) << " (" << duration.count() << "s, " << (10 * BLOCK_COUNT) / duration.count() << " blocks/s) (snl: " << snl_iteration_duration.count() << "s; ons: " << ons_iteration_duration.count() << "s)");
 #ifdef ENABLE_SYSTEMD
       // Tell systemd that we're doing something so that it should let us continue starting up
       // (giving us 120s until we have to send the next notification):
@@ -343,25 +418,28 @@ bool Blockchain::load_missing_blocks_into_oxen_subsystems()
       ons_iteration_duration = snl_iteration_duration = {};
     }
 
-    blocks.clear();
-    uint64_t height = start_height + (index * BLOCK_COUNT);
-    if (!get_blocks_only(height, static_cast<uint64_t>(BLOCK_COUNT), blocks))
+    current->waiter.wait(&tpool);
+    if (current->failed)
     {
-      LOG_ERROR("Unable to get checkpointed historical blocks for updating oxen subsystems");
+      LOG_ERROR("Invalid transaction in historical blocks for updating oxen subsystems");
       return false;
     }
 
-    for (cryptonote::block const &blk : blocks)
+    // Start on the next step while the subsystems work through this one
+    if (block_count > BLOCK_COUNT && !load_step(start_height + (index + 1) * BLOCK_COUNT, *next))
     {
-      uint64_t block_height = get_block_height(blk);
+      next->waiter.wait(&tpool);
+      return false;
+    }
 
-      txs.clear();
-      missed_txs.clear();
-      if (!get_transactions(blk.tx_hashes, txs, missed_txs))
-      {
-        MERROR("Unable to get transactions for block for updating ONS DB: " << cryptonote::get_block_hash(blk));
-        return false;
-      }
+    bool ok = true;
+    if (m_ons_db.db)
+      m_ons_db.batch_start();
+    for (size_t i = 0; ok && i < current->blocks.size(); i++)
+    {
+      cryptonote::block const &blk = current->blocks[i];
+      auto const &txs = current->txs[i];
+      uint64_t block_height = get_block_height(blk);
 
       if (block_height >= snl_height)
       {
@@ -375,28 +453,41 @@ bool Blockchain::load_missing_blocks_into_oxen_subsystems()
         if (!m_service_node_list.block_added(blk, txs, checkpoint_ptr))
         {
           MFATAL("Unable to process block for updating service node list: " << cryptonote::get_block_hash(blk));
-          return false;
+          ok = false;
         }
         snl_iteration_duration += clock::now() - snl_start;
       }
 
-      if (m_ons_db.db && (block_height >= ons_height))
+      if (ok && m_ons_db.db && (block_height >= ons_height))
       {
         auto ons_start = clock::now();
         if (!m_ons_db.add_block(blk, txs))
         {
           MFATAL("Unable to process block for updating ONS DB: " << cryptonote::get_block_hash(blk));
-          return false;
+          ok = false;
         }
         ons_iteration_duration += clock::now() - ons_start;
       }
     }
+    if (m_ons_db.db)
+    {
+      auto ons_start = clock::now();
+      m_ons_db.batch_stop(ok);
+      ons_iteration_duration += clock::now() - ons_start;
+    }
+
+    if (!ok)
+    {
+      next->waiter.wait(&tpool);
+      return false;
+    }
+    std::swap(current, next);
   }
 
   if (total_blocks > 1)
   {
     auto duration = work_time{clock::now() - scan_start};
-    MGINFO("Done recalculating oxen subsystems (" << duration.count() << "s) (snl: " << snl_duration.count() << "s; ons: " << ons_duration.count() << "s)");
+    MGINFO("Done recalculating oxen subsystems (" << duration.count() << "s, " << total_blocks / duration.count() << " blocks/s) (snl: " << snl_duration.count() << "s; ons: " << ons_duration.count() << "s)");
   }
 
   if (total_blocks > 0)
@@ -720,6 +811,7 @@ block Blockchain::pop_block_from_blockchain()
   }
 
   m_ons_db.block_detach(*this, m_db->height());
+  output_distribution_detached();
 
   // return transactions from popped block to the tx_pool
   size_t pruned = 0;
@@ -2128,7 +2220,7 @@ bool Blockchain::handle_alternative_block(const block& b, const crypto::hash& id
 bool Blockchain::get_blocks_only(uint64_t start_offset, size_t count, std::vector<block>& blocks, std::vector<cryptonote::blobdata>* txs) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
   const uint64_t height = m_db->height();
   if(start_offset >= height)
     return false;
@@ -2164,7 +2256,7 @@ bool Blockchain::get_blocks_only(uint64_t start_offset, size_t count, std::vecto
 bool Blockchain::get_blocks(uint64_t start_offset, size_t count, std::vector<std::pair<cryptonote::blobdata,block>>& blocks, std::vector<cryptonote::blobdata>& txs) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
   if(start_offset >= m_db->height())
     return false;
 
@@ -2186,7 +2278,7 @@ bool Blockchain::get_blocks(uint64_t start_offset, size_t count, std::vector<std
 bool Blockchain::get_blocks(uint64_t start_offset, size_t count, std::vector<std::pair<cryptonote::blobdata,block>>& blocks) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
   const uint64_t height = m_db->height();
   if(start_offset >= height)
     return false;
@@ -2349,7 +2441,7 @@ bool Blockchain::get_alternative_blocks(std::vector<block>& blocks) const
 size_t Blockchain::get_alternative_blocks_count() const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
   return m_db->get_alt_block_count();
 }
 //------------------------------------------------------------------
@@ -2383,7 +2475,7 @@ crypto::public_key Blockchain::get_output_key(uint64_t amount, uint64_t global_i
 bool Blockchain::get_outs(const rpc::GET_OUTPUTS_BIN::request& req, rpc::GET_OUTPUTS_BIN::response& res) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   res.outs.clear();
   res.outs.reserve(req.outputs.size());
@@ -2445,31 +2537,150 @@ bool Blockchain::get_output_distribution(uint64_t amount, uint64_t from_height,
     start_height = from_height;
 
   distribution.clear();
+  std::shared_lock lock{*this};
   uint64_t db_height = m_db->height();
   if (db_height == 0)
     return false;
   if (start_height >= db_height || to_height >= db_height)
     return false;
 
+  auto copy_out = [&](const std::vector<uint64_t> &cumulative) {
+    if (amount == 0)
+    {
+      distribution.assign(cumulative.begin() + start_height, cumulative.begin() + std::max(start_height, to_height + 1));
+      if (start_height > 0)
+        base = cumulative[start_height - 1];
+    }
+    else
+    {
+      // Matches BlockchainDB::get_output_distribution: the counts run to the top of the chain and
+      // include all earlier outputs (i.e. base is folded into the first element).
+      distribution.assign(cumulative.begin() + start_height, cumulative.end());
+    }
+  };
+
+  // Bring the slot up to the current height: it may be behind if it is new or if a db batch abort
+  // restored popped blocks, and ahead if a batch abort rolled back blocks it had been extended with.
+  // The db is read without holding m_output_dist_mutex so that a slow build of one slot doesn't
+  // hold up requests served from the others; the chain can't change under us while we hold the
+  // blockchain lock, so the only thing that can race with us is another request extending the same
+  // slot.
+  uint64_t first = 0;
+  {
+    std::lock_guard dist_lock{m_output_dist_mutex};
+    auto it = m_output_dist_cache.find(amount);
+    if (it == m_output_dist_cache.end())
+    {
+      if (amount != 0 && m_output_dist_cache.size() >= OUTPUT_DISTRIBUTION_CACHE_MAX_AMOUNTS)
+        return m_db->get_output_distribution(amount, start_height, to_height, distribution, base);
+    }
+    else
+    {
+      auto &cumulative = it->second;
+      if (cumulative.size() > db_height)
+        cumulative.resize(db_height);
+      if (cumulative.size() == db_height)
+      {
+        copy_out(cumulative);
+        return true;
+      }
+      first = cumulative.size();
+    }
+  }
+
+  std::vector<uint64_t> extra;
   if (amount == 0)
   {
-    std::vector<uint64_t> heights;
-    heights.reserve(to_height + 1 - start_height);
-    const uint64_t real_start_height = start_height > 0 ? start_height-1 : start_height;
-    for (uint64_t h = real_start_height; h <= to_height; ++h)
-      heights.push_back(h);
-    distribution = m_db->get_block_cumulative_rct_outputs(heights);
-    if (start_height > 0)
+    std::vector<uint64_t> heights(db_height - first);
+    std::iota(heights.begin(), heights.end(), first);
+    extra = m_db->get_block_cumulative_rct_outputs(heights);
+  }
+  else
+  {
+    uint64_t extra_base;
+    if (!m_db->get_output_distribution(amount, first, 0, extra, extra_base))
+      return false;
+    extra.resize(std::min<uint64_t>(extra.size(), db_height - first));
+  }
+  if (extra.size() != db_height - first)
+    return false;
+
+  std::lock_guard dist_lock{m_output_dist_mutex};
+  auto it = m_output_dist_cache.find(amount);
+  if (it == m_output_dist_cache.end())
+  {
+    // Dropped while we were reading, so we only have the tail: go to the db
+    if (first != 0)
+      return m_db->get_output_distribution(amount, start_height, to_height, distribution, base);
+    // Crowded out by other amounts while we were reading: serve it without caching it
+    if (amount != 0 && m_output_dist_cache.size() >= OUTPUT_DISTRIBUTION_CACHE_MAX_AMOUNTS)
     {
-      base = distribution[0];
-      distribution.erase(distribution.begin());
+      copy_out(extra);
+      return true;
     }
-    return true;
+    it = m_output_dist_cache.emplace(amount, std::move(extra)).first;
   }
   else
   {
-    return m_db->get_output_distribution(amount, start_height, to_height, distribution, base);
+    auto &cumulative = it->second;
+    if (cumulative.size() > db_height)
+      cumulative.resize(db_height);
+    if (cumulative.size() == first)
+      cumulative.insert(cumulative.end(), extra.begin(), extra.end());
+    else if (cumulative.size() != db_height)
+    {
+      if (first != 0)
+      {
+        m_output_dist_cache.erase(it);
+        return m_db->get_output_distribution(amount, start_height, to_height, distribution, base);
+      }
+      cumulative = std::move(extra);
+    }
+    // else another request finished extending it first
   }
+  copy_out(it->second);
+  return true;
+}
+//------------------------------------------------------------------
+void Blockchain::output_distribution_block_added(uint64_t height, const block &bl, const std::vector<std::pair<transaction, blobdata>> &txs)
+{
+  std::lock_guard dist_lock{m_output_dist_mutex};
+  for (auto it = m_output_dist_cache.begin(); it != m_output_dist_cache.end(); )
+  {
+    auto &[amount, cumulative] = *it;
+    if (cumulative.size() > height)
+      cumulative.resize(height);
+    if (cumulative.size() < height)
+    {
+      // Fell behind somehow; drop it and let the next request rebuild it from the db
+      it = m_output_dist_cache.erase(it);
+      continue;
+    }
+
+    // Count outputs the same way BlockchainDB::add_block indexes them: v2+ miner tx outputs are
+    // stored as rct (amount 0) outputs.
+    uint64_t count = 0;
+    if (bl.miner_tx.version >= txversion::v2_ringct)
+      count += amount == 0 ? bl.miner_tx.vout.size() : 0;
+    else if (amount != 0)
+      for (const auto &vout : bl.miner_tx.vout)
+        count += vout.amount == amount;
+    for (const auto &tx : txs)
+      for (const auto &vout : tx.first.vout)
+        count += vout.amount == amount;
+
+    cumulative.push_back((cumulative.empty() ? 0 : cumulative.back()) + count);
+    ++it;
+  }
+}
+//------------------------------------------------------------------
+void Blockchain::output_distribution_detached()
+{
+  const uint64_t height = m_db->height();
+  std::lock_guard dist_lock{m_output_dist_mutex};
+  for (auto &[amount, cumulative] : m_output_dist_cache)
+    if (cumulative.size() > height)
+      cumulative.resize(height);
 }
 //------------------------------------------------------------------
 void Blockchain::get_output_blacklist(std::vector<uint64_t> &blacklist) const
@@ -2483,7 +2694,7 @@ void Blockchain::get_output_blacklist(std::vector<uint64_t> &blacklist) const
 bool Blockchain::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, uint64_t& starter_offset) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   // make sure the request includes at least the genesis block, otherwise
   // how can we expect to sync from the client that the block list came from?
@@ -2557,7 +2768,8 @@ uint64_t Blockchain::block_difficulty(uint64_t i) const
 bool Blockchain::get_blocks(const std::vector<crypto::hash>& block_ids, std::vector<std::pair<cryptonote::blobdata,block>>& blocks, std::vector<crypto::hash>& missed_bs) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
+  db_rtxn_guard rtxn_guard(m_db);
 
   blocks.reserve(block_ids.size());
   for (const auto& block_hash : block_ids)
@@ -2567,11 +2779,13 @@ bool Blockchain::get_blocks(const std::vector<crypto::hash>& block_ids, std::vec
       uint64_t height = 0;
       if (m_db->block_exists(block_hash, &height))
       {
-        blocks.push_back(std::make_pair(m_db->get_block_blob_from_height(height), block()));
-        if (!parse_and_validate_block_from_blob(blocks.back().first, blocks.back().second))
+        const std::string_view blob = m_db->get_block_blob_view_from_height(height);
+        block b;
+        if (parse_and_validate_block_from_blob(blob, b))
+          blocks.emplace_back(blob, std::move(b));
+        else
         {
           LOG_ERROR("Invalid block: " << block_hash);
-          blocks.pop_back();
           missed_bs.push_back(block_hash);
         }
       }
@@ -2591,7 +2805,7 @@ bool Blockchain::get_blocks(const std::vector<crypto::hash>& block_ids, std::vec
 bool Blockchain::get_transactions_blobs(const std::vector<crypto::hash>& txs_ids, std::vector<cryptonote::blobdata>& txs, std::vector<crypto::hash>& missed_txs, bool pruned) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   txs.reserve(txs_ids.size());
   for (const auto& tx_hash : txs_ids)
@@ -2617,7 +2831,7 @@ bool Blockchain::get_transactions_blobs(const std::vector<crypto::hash>& txs_ids
 std::vector<uint64_t> Blockchain::get_transactions_heights(const std::vector<crypto::hash>& txs_ids) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   auto heights = m_db->get_tx_block_heights(txs_ids);
   for (auto &h : heights)
@@ -2641,7 +2855,7 @@ size_t get_transaction_version(const cryptonote::blobdata &bd)
 bool Blockchain::get_split_transactions_blobs(const std::vector<crypto::hash>& txs_ids, std::vector<std::tuple<crypto::hash, cryptonote::blobdata, crypto::hash, cryptonote::blobdata>>& txs, std::vector<crypto::hash>& missed_txs) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   txs.reserve(txs_ids.size());
   for (const auto& tx_hash : txs_ids)
@@ -2674,7 +2888,7 @@ bool Blockchain::get_split_transactions_blobs(const std::vector<crypto::hash>& t
 bool Blockchain::get_transactions(const std::vector<crypto::hash>& txs_ids, std::vector<transaction>& txs, std::vector<crypto::hash>& missed_txs) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   txs.reserve(txs_ids.size());
   cryptonote::blobdata tx;
@@ -2709,7 +2923,7 @@ bool Blockchain::get_transactions(const std::vector<crypto::hash>& txs_ids, std:
 bool Blockchain::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::vector<crypto::hash>& hashes, uint64_t& start_height, uint64_t& current_height, bool clip_pruned) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   // if we can't find the split point, return false
   if(!find_blockchain_supplement(qblock_ids, start_height))
@@ -2739,7 +2953,7 @@ bool Blockchain::find_blockchain_supplement(const std::list<crypto::hash>& qbloc
 bool Blockchain::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, NOTIFY_RESPONSE_CHAIN_ENTRY::request& resp) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   bool result = find_blockchain_supplement(qblock_ids, resp.m_block_ids, resp.start_height, resp.total_height, true);
   if (result)
@@ -2755,7 +2969,7 @@ bool Blockchain::find_blockchain_supplement(const std::list<crypto::hash>& qbloc
 bool Blockchain::find_blockchain_supplement(const uint64_t req_start_block, const std::list<crypto::hash>& qblock_ids, std::vector<std::pair<std::pair<cryptonote::blobdata, crypto::hash>, std::vector<std::pair<crypto::hash, cryptonote::blobdata> > > >& blocks, uint64_t& total_height, uint64_t& start_height, bool pruned, bool get_miner_tx_hash, size_t max_count) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  std::unique_lock lock{*this};
+  std::shared_lock lock{*this};
 
   // if a specific start height has been requested
   if(req_start_block > 0)
@@ -2779,34 +2993,43 @@ bool Blockchain::find_blockchain_supplement(const uint64_t req_start_block, cons
   total_height = get_current_blockchain_height();
   size_t count = 0, size = 0;
   blocks.reserve(std::min(std::min(max_count, (size_t)10000), (size_t)(total_height - start_height)));
+  // The blobs are read as views into the db (valid while rtxn_guard is held) so that each one
+  // gets copied exactly once: straight into the returned vector.
+  std::vector<std::string_view> txs;
   for(uint64_t i = start_height; i < total_height && count < max_count && (size < FIND_BLOCKCHAIN_SUPPLEMENT_MAX_SIZE || count < 3); i++, count++)
   {
-    blocks.resize(blocks.size()+1);
-    blocks.back().first.first = m_db->get_block_blob_from_height(i);
+    const std::string_view block_blob = m_db->get_block_blob_view_from_height(i);
     block b;
-    CHECK_AND_ASSERT_MES(parse_and_validate_block_from_blob(blocks.back().first.first, b), false, "internal error, invalid block");
+    CHECK_AND_ASSERT_MES(parse_and_validate_block_from_blob(block_blob, b), false, "internal error, invalid block");
+    blocks.resize(blocks.size()+1);
+    blocks.back().first.first = block_blob;
     blocks.back().first.second = get_miner_tx_hash ? cryptonote::get_transaction_hash(b.miner_tx) : crypto::null_hash;
-    std::vector<cryptonote::blobdata> txs;
+    size += block_blob.size();
+
+    auto &block_txs = blocks.back().second;
+    block_txs.reserve(b.tx_hashes.size());
     if (pruned)
     {
-      CHECK_AND_ASSERT_MES(m_db->get_pruned_tx_blobs_from(b.tx_hashes.front(), b.tx_hashes.size(), txs), false, "Failed to retrieve all transactions needed");
+      txs.clear();
+      CHECK_AND_ASSERT_MES(b.tx_hashes.empty() || m_db->get_pruned_tx_blob_views_from(b.tx_hashes.front(), b.tx_hashes.size(), txs), false, "Failed to retrieve all transactions needed");
+      CHECK_AND_ASSERT_MES(txs.size() == b.tx_hashes.size(), false, "mismatched sizes of b.tx_hashes and txs");
+      for (size_t i = 0; i < txs.size(); ++i)
+        block_txs.emplace_back(b.tx_hashes[i], txs[i]);
     }
     else
     {
-      std::vector<crypto::hash> mis;
-      get_transactions_blobs(b.tx_hashes, txs, mis, pruned);
-      CHECK_AND_ASSERT_MES(!mis.size(), false, "internal error, transaction from block not found");
-    }
-    size += blocks.back().first.first.size();
-    for (const auto &t: txs)
-      size += t.size();
-
-    CHECK_AND_ASSERT_MES(txs.size() == b.tx_hashes.size(), false, "mismatched sizes of b.tx_hashes and txs");
-    blocks.back().second.reserve(txs.size());
-    for (size_t i = 0; i < txs.size(); ++i)
-    {
-      blocks.back().second.push_back(std::make_pair(b.tx_hashes[i], std::move(txs[i])));
+      for (const auto &tx_hash : b.tx_hashes)
+      {
+        std::string_view tx_pruned, tx_prunable;
+        CHECK_AND_ASSERT_MES(m_db->get_tx_blob_views(tx_hash, tx_pruned, tx_prunable), false, "internal error, transaction from block not found");
+        auto &blob = block_txs.emplace_back(tx_hash, cryptonote::blobdata{}).second;
+        blob.reserve(tx_pruned.size() + tx_prunable.size());
+        blob.append(tx_pruned);
+        blob.append(tx_prunable);
+      }
     }
+    for (const auto &tx : block_txs)
+      size += tx.second.size();
   }
   return true;
 }
@@ -4362,6 +4585,7 @@ bool Blockchain::handle_block_to_main_chain(const block& bl, const crypto::hash&
       uint64_t long_term_block_weight = get_next_long_term_block_weight(block_weight);
       cryptonote::blobdata bd = cryptonote::block_to_blob(bl);
       new_height = m_db->add_block(std::make_pair(std::move(bl), std::move(bd)), block_weight, long_term_block_weight, cumulative_difficulty, already_generated_coins, txs);
+      output_distribution_block_added(new_height - 1, bl, txs);
     }
     catch (const KEY_IMAGE_EXISTS& e)
     {
@@ -4735,20 +4959,55 @@ bool Blockchain::get_checkpoint(uint64_t height, checkpoint_t &checkpoint) const
   return m_checkpoints.get_checkpoint(height, checkpoint);
 }
 //------------------------------------------------------------------
-void Blockchain::block_longhash_worker(uint64_t height, const epee::span<const block> &blocks, std::unordered_map<crypto::hash, crypto::hash> &map) const
+void Blockchain::precompute_block_pow(uint64_t height, const std::vector<block> &blocks)
 {
   TIME_MEASURE_START(t);
 
-  for (const auto & block : blocks)
+  // Only hash the blocks that verify_block_pow() will actually want a PoW hash for
+  std::vector<size_t> todo;
+  todo.reserve(blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i)
   {
-    if (m_cancel)
-      break;
-    crypto::hash id = get_block_hash(block);
-    crypto::hash pow = get_block_longhash_w_blockchain(m_nettype, this, block, height++, 0);
-    map.emplace(id, pow);
+    if (cryptonote::block_has_pulse_components(blocks[i]))
+      continue;
+#if defined(PER_BLOCK_CHECKPOINT)
+    if (height + i < m_blocks_hash_check.size() && m_blocks_hash_check[height + i] != crypto::null_hash)
+      continue;
+#endif
+    todo.push_back(i);
   }
+  if (todo.empty())
+    return;
+
+  tools::threadpool& tpool = tools::threadpool::getInstance();
+  size_t threads = tpool.get_max_concurrency();
+  if (m_max_prepare_blocks_threads > 0 && threads > m_max_prepare_blocks_threads)
+    threads = m_max_prepare_blocks_threads;
+  threads = std::min(threads, todo.size());
+
+  // Every worker keeps pulling the next unhashed block (rather than taking a fixed slice) so that
+  // one slow worker doesn't hold up the whole span.  The RandomX cache for each seed is shared
+  // read-only between the workers' VMs (see rx_slow_hash).
+  std::vector<crypto::hash> pow(todo.size());
+  std::atomic<size_t> next{0};
+  tools::threadpool::waiter waiter;
+  for (size_t i = 0; i < threads; i++)
+  {
+    tpool.submit(&waiter, [&] {
+      for (size_t j = next++; j < todo.size() && !m_cancel; j = next++)
+        pow[j] = get_block_longhash_w_blockchain(m_nettype, this, blocks[todo[j]], height + todo[j], 0);
+    }, true);
+  }
+  waiter.wait(&tpool);
+
+  if (m_cancel)
+    return;
+
+  for (size_t j = 0; j < todo.size(); ++j)
+    m_blocks_longhash_table.emplace(get_block_hash(blocks[todo[j]]), pow[j]);
 
   TIME_MEASURE_FINISH(t);
+  MDEBUG("Precomputed PoW of " << todo.size() << "/" << blocks.size() << " blocks using " << threads << " threads in " << t << " ms");
 }
 
 //------------------------------------------------------------------
@@ -4772,6 +5031,19 @@ bool Blockchain::cleanup_handle_incoming_blocks(bool force_sync)
     MERROR("Exception in cleanup_handle_incoming_blocks: " << e.what());
   }
 
+  // Keep the ONS DB in step with the blockchain batch: if the blocks didn't make it into the
+  // blockchain then they shouldn't stay in ONS either.
+  m_ons_db.batch_stop(success && m_batch_success);
+  if (m_show_time_stats)
+  {
+    ons::ingest_stats ons_stats = m_ons_db.take_ingest_stats();
+    using ms = std::chrono::duration<double, std::milli>;
+    if (ons_stats.blocks > 0)
+      MINFO("ONS: " << ons_stats.blocks << " blocks, " << ons_stats.txs << " txs in " << ms{ons_stats.total}.count()
+          << "ms (validate/write/commit: " << ms{ons_stats.validate}.count() << "/" << ms{ons_stats.write}.count()
+          << "/" << ms{ons_stats.commit}.count() << "ms)");
+  }
+
   if (success && m_sync_counter > 0)
   {
     if (force_sync)
@@ -4891,7 +5163,19 @@ uint64_t Blockchain::prevalidate_block_hashes(uint64_t height, const std::vector
       data.push_back(h);
   }
 
-  // hash and check
+  // hash all the fully filled steps we have precomputed hashes for in one batch
+  std::vector<const void*> step_data;
+  for (size_t n = first_index; n <= last_index && n < m_blocks_hash_of_hashes.size(); ++n)
+  {
+    if (data.size() < (n - first_index) * HASH_OF_HASHES_STEP + HASH_OF_HASHES_STEP)
+      break;
+    step_data.push_back(data.data() + (n - first_index) * HASH_OF_HASHES_STEP);
+  }
+  std::vector<size_t> step_sizes(step_data.size(), HASH_OF_HASHES_STEP * sizeof(crypto::hash));
+  std::vector<crypto::hash> step_hashes(step_data.size());
+  crypto::cn_fast_hash_many(step_data.data(), step_sizes.data(), step_hashes.data(), step_data.size());
+
+  // check
   uint64_t usable = first_index * HASH_OF_HASHES_STEP - height; // may start negative, but unsigned under/overflow is not UB
   for (size_t n = first_index; n <= last_index; ++n)
   {
@@ -4901,9 +5185,7 @@ uint64_t Blockchain::prevalidate_block_hashes(uint64_t height, const std::vector
       if (data.size() < (n - first_index) * HASH_OF_HASHES_STEP + HASH_OF_HASHES_STEP)
         break;
 
-      crypto::hash hash;
-      cn_fast_hash(data.data() + (n - first_index) * HASH_OF_HASHES_STEP, HASH_OF_HASHES_STEP * sizeof(crypto::hash), hash);
-      bool valid = hash == m_blocks_hash_of_hashes[n];
+      bool valid = step_hashes[n - first_index] == m_blocks_hash_of_hashes[n];
 
       // add to the known hashes array
       if (!valid)
@@ -4991,7 +5273,7 @@ bool Blockchain::calc_batched_governance_reward(uint64_t height, uint64_t &rewar
 
 //------------------------------------------------------------------
 // ND: Speedups:
-// 1. Thread long_hash computations if possible (m_max_prepare_blocks_threads = nthreads, default = 4)
+// 1. Thread long_hash computations if possible (m_max_prepare_blocks_threads = nthreads, default = all)
 // 2. Group all amounts (from txs) and related absolute offsets and form a table of tx_prefix_hash
 //    vs [k_image, output_keys] (m_scan_table). This is faster because it takes advantage of bulk queries
 //    and is threaded if possible. The table (m_scan_table) will be used later when querying output
@@ -5041,6 +5323,8 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::vector<block_complete
     std::lock(m_tx_pool, *this);
   }
   m_batch_success = true;
+  if (m_ons_db.db)
+    m_ons_db.batch_start();
 
   const uint64_t height = m_db->height();
   if ((height + blocks_entry.size()) < m_blocks_hash_check.size())
@@ -5052,87 +5336,46 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::vector<block_complete
   blocks.resize(blocks_entry.size());
 
   {
-    // limit threads, default limit = 4
-    if(threads > m_max_prepare_blocks_threads)
-      threads = m_max_prepare_blocks_threads;
-
-    unsigned int batches = blocks_entry.size() / threads;
-    unsigned int extra = blocks_entry.size() % threads;
-    MDEBUG("block_batches: " << batches);
-    std::vector<std::unordered_map<crypto::hash, crypto::hash>> maps(threads);
-    auto it = blocks_entry.begin();
-    unsigned blockidx = 0;
-
     const crypto::hash tophash = m_db->top_block_hash();
-    for (unsigned i = 0; i < threads; i++)
+    auto it = blocks_entry.begin();
+    for (size_t blockidx = 0; blockidx < blocks.size(); ++blockidx, ++it)
     {
-      for (unsigned int j = 0; j < batches; j++, ++blockidx)
-      {
-        block &block = blocks[blockidx];
-        crypto::hash block_hash;
+      block &block = blocks[blockidx];
 
-        if (!parse_and_validate_block_from_blob(it->block, block, block_hash))
-          return false;
+      if (!parse_and_validate_block_from_blob(it->block, block))
+        return false;
 
-        // check first block and skip all blocks if its not chained properly
-        if (blockidx == 0)
+      // check first block and skip all blocks if its not chained properly
+      if (blockidx == 0)
+      {
+        if (block.prev_id != tophash)
         {
-          if (block.prev_id != tophash)
-          {
-            MDEBUG("Skipping prepare blocks. New blocks don't belong to chain.");
-            blocks.clear();
-            return true;
-          }
+          MDEBUG("Skipping prepare blocks. New blocks don't belong to chain.");
+          blocks.clear();
+          return true;
         }
-        if (have_block(block_hash))
-          blocks_exist = true;
-
-        std::advance(it, 1);
       }
     }
 
-    for (unsigned i = 0; i < extra && !blocks_exist; i++, blockidx++)
-    {
-      block &block = blocks[blockidx];
-      crypto::hash block_hash;
-
-      if (!parse_and_validate_block_from_blob(it->block, block, block_hash))
-        return false;
-
+    // hash the whole span in one batch
+    std::vector<crypto::hash> block_hashes;
+    if (!get_block_hashes(blocks, block_hashes))
+      return false;
+    for (const auto &block_hash : block_hashes)
       if (have_block(block_hash))
         blocks_exist = true;
 
-      std::advance(it, 1);
-    }
-
     if (!blocks_exist)
     {
       m_blocks_longhash_table.clear();
-      uint64_t thread_height = height;
-      tools::threadpool::waiter waiter;
       m_prepare_height = height;
       m_prepare_nblocks = blocks_entry.size();
       m_prepare_blocks = &blocks;
-      for (unsigned int i = 0; i < threads; i++)
-      {
-        unsigned nblocks = batches;
-        if (i < extra)
-          ++nblocks;
-        tpool.submit(&waiter, [this, thread_height, blocks=epee::span<const block>(&blocks[thread_height - height], nblocks), &map=maps[i]]
-            { block_longhash_worker(thread_height, blocks, map); }, true);
-        thread_height += nblocks;
-      }
-
-      waiter.wait(&tpool);
+      precompute_block_pow(height, blocks);
       m_prepare_height = 0;
 
       if (m_cancel)
          return false;
-
-      for (const auto & map : maps)
-      {
-        m_blocks_longhash_table.insert(map.begin(), map.end());
-      }
     }
   }
 
@@ -5173,8 +5416,32 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::vector<block_complete
     return false; \
   } while(0); \
 
-  // generate sorted tables for all amounts and absolute offsets
+  // parse all the txes first, so that their prefix hashes can be calculated in one batch
   size_t tx_index = 0, block_index = 0;
+  {
+    std::vector<const transaction*> tx_ptrs;
+    std::vector<std::string_view> tx_blobs;
+    for (const auto &entry : blocks_entry)
+    {
+      for (const auto &tx_blob : entry.txs)
+      {
+        if (tx_index >= txes.size())
+          SCAN_TABLE_QUIT("tx_index is out of sync");
+        transaction &tx = txes[tx_index++].first;
+        if (!parse_and_validate_tx_base_from_blob(tx_blob, tx))
+          SCAN_TABLE_QUIT("Could not parse tx from incoming blocks.");
+        tx_ptrs.push_back(&tx);
+        tx_blobs.push_back(tx_blob);
+      }
+    }
+    std::vector<crypto::hash> prefix_hashes;
+    get_transaction_prefix_hashes(tx_ptrs, tx_blobs, prefix_hashes);
+    for (size_t i = 0; i < prefix_hashes.size(); ++i)
+      txes[i].second = prefix_hashes[i];
+  }
+
+  // generate sorted tables for all amounts and absolute offsets
+  tx_index = 0;
   for (const auto &entry : blocks_entry)
   {
     if (m_cancel)
@@ -5184,14 +5451,10 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::vector<block_complete
     {
       if (tx_index >= txes.size())
         SCAN_TABLE_QUIT("tx_index is out of sync");
-      transaction &tx = txes[tx_index].first;
-      crypto::hash &tx_prefix_hash = txes[tx_index].second;
+      const transaction &tx = txes[tx_index].first;
+      const crypto::hash &tx_prefix_hash = txes[tx_index].second;
       ++tx_index;
 
-      if (!parse_and_validate_tx_base_from_blob(tx_blob, tx))
-        SCAN_TABLE_QUIT("Could not parse tx from incoming blocks.");
-      cryptonote::get_transaction_prefix_hash(tx, tx_prefix_hash);
-
       auto its = m_scan_table.find(tx_prefix_hash);
       if (its != m_scan_table.end())
         SCAN_TABLE_QUIT("Duplicate tx found from incoming blocks.");
@@ -54,6 +54,7 @@
 #include "epee/rolling_median.h"
 #include "cryptonote_basic/cryptonote_basic.h"
 #include "common/util.h"
+#include "common/lock.h"
 #include "cryptonote_protocol/cryptonote_protocol_defs.h"
 #include "rpc/core_rpc_server_commands_defs.h"
 #include "cryptonote_basic/difficulty.h"
@@ -767,7 +768,7 @@ namespace cryptonote
     /**
      * @brief sets various performance options
      *
-     * @param maxthreads max number of threads when preparing blocks for addition
+     * @param maxthreads max number of threads when preparing blocks for addition (0 = no limit)
      * @param sync_on_blocks whether to sync based on blocks or bytes
      * @param sync_threshold number of blocks/bytes to cache before syncing to database
      * @param sync_mode the ::blockchain_db_sync_mode to use
@@ -925,14 +926,16 @@ namespace cryptonote
         std::vector<output_data_t> &outputs) const;
 
     /**
-     * @brief computes the "short" and "long" hashes for a set of blocks
+     * @brief computes the PoW hashes for a span of blocks ahead of adding them
+     *
+     * Skips blocks whose PoW won't be checked (Pulse blocks and blocks covered by the
+     * precomputed hashes of hashes), spreads the rest over up to m_max_prepare_blocks_threads
+     * threadpool workers and stores the results in m_blocks_longhash_table for verify_block_pow.
      *
      * @param height the height of the first block
      * @param blocks the blocks to be hashed
-     * @param map return-by-reference the hashes for each block
      */
-    void block_longhash_worker(uint64_t height, const epee::span<const block> &blocks,
-        std::unordered_map<crypto::hash, crypto::hash> &map) const;
+    void precompute_block_pow(uint64_t height, const std::vector<block> &blocks);
 
     /**
      * @brief returns a set of known alternate chains
@@ -966,6 +969,18 @@ namespace cryptonote
     void unlock() const { m_blockchain_lock.unlock(); }
     bool try_lock() const { return m_blockchain_lock.try_lock(); }
 
+    // Shared (read-only) locking: any number of threads may hold a shared lock at once; shared
+    // locks only wait for (and block) exclusive lock holders such as block processing.  A thread
+    // holding only a shared lock must not try to take the exclusive lock (this throws).
+    void lock_shared() const { m_blockchain_lock.lock_shared(); }
+    void unlock_shared() const { m_blockchain_lock.unlock_shared(); }
+    bool try_lock_shared() const { return m_blockchain_lock.try_lock_shared(); }
+
+    /**
+     * @brief returns the acquisition and contention counters of the blockchain lock
+     */
+    tools::lock_contention_stats get_lock_contention_stats() const { return m_blockchain_lock.contention(); }
+
     void cancel();
 
     /**
@@ -1056,7 +1071,7 @@ namespace cryptonote
     service_nodes::service_node_list& m_service_node_list;
     ons::name_system_db               m_ons_db;
 
-    mutable std::recursive_mutex m_blockchain_lock; // TODO: add here reader/writer lock
+    mutable tools::recursive_shared_mutex m_blockchain_lock;
 
     // main chain
     size_t m_current_block_cumul_weight_limit;
@@ -1107,6 +1122,13 @@ namespace cryptonote
       difficulty_type m_difficulty_for_next_miner_block{1};
     } m_cache;
 
+    // Output distribution prefix sums, one slot per amount: slot[h] is the number of outputs of
+    // that amount in blocks 0 through h.  Slots are built on first request and then kept in step
+    // with the chain as blocks are added and popped, so that any [from, to] distribution query is
+    // a copy out of the slot rather than a walk over the db.
+    mutable std::mutex m_output_dist_mutex;
+    mutable std::unordered_map<uint64_t, std::vector<uint64_t>> m_output_dist_cache;
+
     boost::asio::io_service m_async_service;
     std::thread m_async_thread;
     std::unique_ptr<boost::asio::io_service::work> m_async_work_idle;
@@ -1493,6 +1515,20 @@ namespace cryptonote
      */
     bool expand_transaction_2(transaction &tx, const crypto::hash &tx_prefix_hash, const std::vector<std::vector<rct::ctkey>> &pubkeys) const;
 
+    /**
+     * @brief extends the cached output distribution slots with a newly added block
+     *
+     * @param height the height of the block just added to the db
+     * @param bl the block
+     * @param txs the block's transactions
+     */
+    void output_distribution_block_added(uint64_t height, const block &bl, const std::vector<std::pair<transaction, blobdata>> &txs);
+
+    /**
+     * @brief truncates the cached output distribution slots to the current db height
+     */
+    void output_distribution_detached();
+
     /**
      * @brief invalidates any cached block template
      */
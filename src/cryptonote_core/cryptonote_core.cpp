@@ -84,6 +84,9 @@ DISABLE_VS_WARNINGS(4355)
 
 #define BAD_SEMANTICS_TXES_MAX_SIZE 100
 
+// smallest number of rct sigs worth giving their own batch verification task
+#define MIN_BATCH_VERIFY_CHUNK 16
+
 // basically at least how many bytes the block itself serializes to without the miner tx
 #define BLOCK_SIZE_SANITY_LEEWAY 100
 
@@ -158,8 +161,8 @@ namespace cryptonote
   };
   static const command_line::arg_descriptor<uint64_t> arg_prep_blocks_threads = {
     "prep-blocks-threads"
-  , "Max number of threads to use when preparing block hashes in groups."
-  , 4
+  , "Max number of threads to use when verifying the proof-of-work of groups of synced blocks (0 = all available threads)."
+  , 0
   };
   static const command_line::arg_descriptor<uint64_t> arg_show_time_stats  = {
     "show-time-stats"
@@ -1158,26 +1161,57 @@ namespace cryptonote
       return;
     }
 
-    tx_info.parsed = parse_and_validate_tx_from_blob(*tx_info.blob, tx_info.tx, tx_info.tx_hash);
+    // The hash is calculated afterwards, for all the parsed txes at once (see parse_incoming_txs)
+    tx_info.parsed = parse_and_validate_tx_from_blob(*tx_info.blob, tx_info.tx);
     if(!tx_info.parsed)
     {
       LOG_PRINT_L1("WRONG TRANSACTION BLOB, Failed to parse, rejected");
       tx_info.tvc.m_verifivation_failed = true;
       return;
     }
-    //std::cout << "!"<< tx.vin.size() << std::endl;
+  }
+  //-----------------------------------------------------------------------------------------------
+  void core::parse_incoming_tx_hashes(std::vector<tx_verification_batch_info> &tx_info)
+  {
+    // Hashing every parsed tx (or block span's worth of txes) in one batch lets cn_fast_hash_many
+    // interleave their keccak permutations.
+    std::vector<tx_verification_batch_info*> parsed;
+    std::vector<const transaction*> txs;
+    std::vector<std::string_view> blobs;
+    for (auto &info : tx_info)
+    {
+      if (!info.parsed)
+        continue;
+      parsed.push_back(&info);
+      txs.push_back(&info.tx);
+      blobs.push_back(*info.blob);
+    }
+    std::vector<crypto::hash> hashes;
+    const bool batched = get_transaction_hashes(txs, blobs, hashes);
 
     std::lock_guard lock{bad_semantics_txes_lock};
-    for (int idx = 0; idx < 2; ++idx)
+    for (size_t i = 0; i < parsed.size(); ++i)
     {
-      if (bad_semantics_txes[idx].find(tx_info.tx_hash) != bad_semantics_txes[idx].end())
+      auto &info = *parsed[i];
+      if (batched)
+        info.tx_hash = hashes[i];
+      // one bad tx fails the whole batch: hash the rest one at a time
+      else if (!get_transaction_hash(info.tx, info.tx_hash))
+      {
+        LOG_PRINT_L1("WRONG TRANSACTION BLOB, Failed to hash, rejected");
+        info.parsed = false;
+        info.tvc.m_verifivation_failed = true;
+        continue;
+      }
+
+      if (bad_semantics_txes[0].count(info.tx_hash) || bad_semantics_txes[1].count(info.tx_hash))
       {
         LOG_PRINT_L1("Transaction already seen with bad semantics, rejected");
-        tx_info.tvc.m_verifivation_failed = true;
-        return;
+        info.tvc.m_verifivation_failed = true;
+        continue;
       }
+      info.result = true;
     }
-    tx_info.result = true;
   }
   //-----------------------------------------------------------------------------------------------
   void core::set_semantics_failed(const crypto::hash &tx_hash)
@@ -1203,15 +1237,17 @@ namespace cryptonote
     return true;
   }
   //-----------------------------------------------------------------------------------------------
-  void core::parse_incoming_tx_accumulated_batch(std::vector<tx_verification_batch_info> &tx_info, bool kept_by_block)
+  void core::parse_incoming_tx_accumulated_batch(std::vector<tx_verification_batch_info> &tx_info, bool kept_by_block, size_t num_blocks)
   {
-    if (kept_by_block && get_blockchain_storage().is_within_compiled_block_hash_area())
+    if (kept_by_block && num_blocks > 0 &&
+        get_blockchain_storage().is_within_compiled_block_hash_area(get_current_blockchain_height() + num_blocks - 1))
     {
       MTRACE("Skipping semantics check for txs kept by block in embedded hash area");
       return;
     }
 
     std::vector<const rct::rctSig*> rvv;
+    std::vector<size_t> rvv_idx; // tx_info index of each rvv element
     for (size_t n = 0; n < tx_info.size(); ++n)
     {
       if (!tx_info[n].result || tx_info[n].already_have)
@@ -1268,6 +1304,7 @@ namespace cryptonote
             break;
           }
           rvv.push_back(&rv); // delayed batch verification
+          rvv_idx.push_back(n);
           break;
         default:
           MERROR_VER("Unknown rct type: " << (int)rv.type);
@@ -1277,50 +1314,63 @@ namespace cryptonote
           break;
       }
     }
-    if (!rvv.empty() && !rct::verRctSemanticsSimple(rvv))
+    if (rvv.empty())
+      return;
+
+    // Bulletproofs are verified in batches (one multiexp per batch rather than one per proof).  A
+    // big batch, such as all the txes of a sync span, is split into one chunk per pool thread so
+    // that the batches get verified in parallel.
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    const size_t chunk_size = std::max<size_t>(MIN_BATCH_VERIFY_CHUNK, (rvv.size() + tpool.get_max_concurrency() - 1) / tpool.get_max_concurrency());
+    const size_t num_chunks = (rvv.size() + chunk_size - 1) / chunk_size;
+    std::vector<char> chunk_ok(num_chunks, false);
+    tools::threadpool::waiter waiter;
+    tpool.submit_range(&waiter, 0, num_chunks, [&](size_t c) {
+      const auto begin = rvv.begin() + c * chunk_size, end = rvv.begin() + std::min((c + 1) * chunk_size, rvv.size());
+      chunk_ok[c] = rct::verRctSemanticsSimple(std::vector<const rct::rctSig*>{begin, end});
+    }, 1);
+    waiter.wait(&tpool);
+
+    for (size_t c = 0; c < num_chunks; ++c)
     {
+      if (chunk_ok[c])
+        continue;
       LOG_PRINT_L1("One transaction among this group has bad semantics, verifying one at a time");
-      const bool assumed_bad = rvv.size() == 1; // if there's only one tx, it must be the bad one
-      for (size_t n = 0; n < tx_info.size(); ++n)
+      const size_t begin = c * chunk_size, end = std::min((c + 1) * chunk_size, rvv.size());
+      const bool assumed_bad = end - begin == 1; // if there's only one tx, it must be the bad one
+      for (size_t i = begin; i < end; ++i)
       {
-        if (!tx_info[n].result || tx_info[n].already_have)
-          continue;
-        if (!rct::is_rct_bulletproof(tx_info[n].tx.rct_signatures.type))
-          continue;
-        if (assumed_bad || !rct::verRctSemanticsSimple(tx_info[n].tx.rct_signatures))
+        auto &info = tx_info[rvv_idx[i]];
+        if (assumed_bad || !rct::verRctSemanticsSimple(*rvv[i]))
         {
-          set_semantics_failed(tx_info[n].tx_hash);
-          tx_info[n].tvc.m_verifivation_failed = true;
-          tx_info[n].result = false;
+          set_semantics_failed(info.tx_hash);
+          info.tvc.m_verifivation_failed = true;
+          info.result = false;
         }
       }
     }
   }
   //-----------------------------------------------------------------------------------------------
-  std::vector<core::tx_verification_batch_info> core::parse_incoming_txs(const std::vector<blobdata>& tx_blobs, const tx_pool_options &opts)
+  void core::parse_incoming_txs(std::vector<tx_verification_batch_info> &tx_info, bool kept_by_block, size_t num_blocks)
   {
-    // Caller needs to do this around both this *and* handle_parsed_txs
-    //auto lock = incoming_tx_lock();
-    std::vector<tx_verification_batch_info> tx_info(tx_blobs.size());
-
     tools::threadpool& tpool = tools::threadpool::getInstance();
     tools::threadpool::waiter waiter;
-    for (size_t i = 0; i < tx_blobs.size(); i++) {
-      tx_info[i].blob = &tx_blobs[i];
-      tpool.submit(&waiter, [this, &info = tx_info[i]] {
-        try
-        {
-          parse_incoming_tx_pre(info);
-        }
-        catch (const std::exception &e)
-        {
-          MERROR_VER("Exception in handle_incoming_tx_pre: " << e.what());
-          info.tvc.m_verifivation_failed = true;
-        }
-      });
-    }
+    tpool.submit_range(&waiter, 0, tx_info.size(), [this, &tx_info](size_t i) {
+      auto &info = tx_info[i];
+      try
+      {
+        parse_incoming_tx_pre(info);
+      }
+      catch (const std::exception &e)
+      {
+        MERROR_VER("Exception in handle_incoming_tx_pre: " << e.what());
+        info.tvc.m_verifivation_failed = true;
+      }
+    }, 1);
     waiter.wait(&tpool);
 
+    parse_incoming_tx_hashes(tx_info);
+
     for (auto &info : tx_info) {
       if (!info.result)
         continue;
@@ -1337,11 +1387,48 @@ namespace cryptonote
       }
     }
 
+    parse_incoming_tx_accumulated_batch(tx_info, kept_by_block, num_blocks);
+  }
+  //-----------------------------------------------------------------------------------------------
+  std::vector<core::tx_verification_batch_info> core::parse_incoming_txs(const std::vector<blobdata>& tx_blobs, const tx_pool_options &opts)
+  {
+    // Caller needs to do this around both this *and* handle_parsed_txs
+    //auto lock = incoming_tx_lock();
+    std::vector<tx_verification_batch_info> tx_info(tx_blobs.size());
+    for (size_t i = 0; i < tx_blobs.size(); i++)
+      tx_info[i].blob = &tx_blobs[i];
 
-    parse_incoming_tx_accumulated_batch(tx_info, opts.kept_by_block);
+    parse_incoming_txs(tx_info, opts.kept_by_block, 1);
 
     return tx_info;
   }
+  //-----------------------------------------------------------------------------------------------
+  std::vector<std::vector<core::tx_verification_batch_info>> core::parse_incoming_block_txs(const std::vector<block_complete_entry>& blocks)
+  {
+    // Caller needs to hold the incoming tx lock (e.g. via prepare_handle_incoming_blocks) around
+    // both this and the handle_parsed_txs calls.
+    std::vector<tx_verification_batch_info> tx_info;
+    size_t num_txs = 0;
+    for (const auto &entry : blocks)
+      num_txs += entry.txs.size();
+    tx_info.resize(num_txs);
+    size_t i = 0;
+    for (const auto &entry : blocks)
+      for (const auto &blob : entry.txs)
+        tx_info[i++].blob = &blob;
+
+    parse_incoming_txs(tx_info, true /*kept_by_block*/, blocks.size());
+
+    std::vector<std::vector<tx_verification_batch_info>> result(blocks.size());
+    auto it = std::make_move_iterator(tx_info.begin());
+    for (size_t b = 0; b < blocks.size(); ++b)
+    {
+      const auto end = it + blocks[b].txs.size();
+      result[b].assign(it, end);
+      it = end;
+    }
+    return result;
+  }
 
   bool core::handle_parsed_txs(std::vector<tx_verification_batch_info> &parsed_txs, const tx_pool_options &opts,
       uint64_t *blink_rollback_height)
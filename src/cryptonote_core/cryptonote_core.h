@@ -220,6 +220,23 @@ namespace cryptonote
       */
      std::vector<tx_verification_batch_info> parse_incoming_txs(const std::vector<blobdata>& tx_blobs, const tx_pool_options &opts);
 
+     /**
+      * @brief parses the transactions of a span of incoming blocks
+      *
+      * Like parse_incoming_txs (with tx_pool_options::from_block()), but parses and checks the
+      * transactions of all the given blocks at once so that their proofs are batch verified
+      * together rather than one block at a time.  Each element of the returned value can then be
+      * passed to handle_parsed_txs() just before the corresponding block is added.
+      *
+      * m_incoming_tx_lock must already be held, e.g. by prepare_handle_incoming_blocks().  The
+      * returned values point into `blocks`, which must be kept alive until they have been handled.
+      *
+      * @param blocks the incoming blocks
+      *
+      * @return one vector of tx_verification_batch_info per block, in the same order as `blocks`.
+      */
+     std::vector<std::vector<tx_verification_batch_info>> parse_incoming_block_txs(const std::vector<block_complete_entry>& blocks);
+
      /**
       * @brief handles parsed incoming transactions
       *
@@ -1041,7 +1058,9 @@ namespace cryptonote
      void set_semantics_failed(const crypto::hash &tx_hash);
 
      void parse_incoming_tx_pre(tx_verification_batch_info &tx_info);
-     void parse_incoming_tx_accumulated_batch(std::vector<tx_verification_batch_info> &tx_info, bool kept_by_block);
+     void parse_incoming_tx_hashes(std::vector<tx_verification_batch_info> &tx_info);
+     void parse_incoming_txs(std::vector<tx_verification_batch_info> &tx_info, bool kept_by_block, size_t num_blocks);
+     void parse_incoming_tx_accumulated_batch(std::vector<tx_verification_batch_info> &tx_info, bool kept_by_block, size_t num_blocks);
 
      /**
       * @brief act on a set of command line options given
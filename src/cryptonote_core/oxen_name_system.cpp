@@ -1676,11 +1676,26 @@ struct scoped_db_transaction
   name_system_db &ons_db;
   bool commit      = false; // If true, on destruction- END the transaction otherwise ROLLBACK all SQLite events prior for the ons_db
   bool initialised = false;
+  bool savepoint   = false; // True if we are nested inside a batch, and so only use a savepoint
 };
 
 scoped_db_transaction::scoped_db_transaction(name_system_db &ons_db)
 : ons_db(ons_db)
 {
+  if (ons_db.batch_active())
+  {
+    char *sql_err = nullptr;
+    if (sqlite3_exec(ons_db.db, "SAVEPOINT ons_block;", nullptr, nullptr, &sql_err) != SQLITE_OK)
+    {
+      MERROR("Failed to create savepoint, reason=" << (sql_err ? sql_err : "??"));
+      sqlite3_free(sql_err);
+      return;
+    }
+    initialised = true;
+    savepoint   = true;
+    return;
+  }
+
   if (ons_db.transaction_begun)
   {
     MERROR("Failed to begin transaction, transaction exists previously that was not closed properly");
@@ -1702,6 +1717,17 @@ scoped_db_transaction::scoped_db_transaction(name_system_db &ons_db)
 scoped_db_transaction::~scoped_db_transaction()
 {
   if (!initialised) return;
+  if (savepoint)
+  {
+    char *sql_err = nullptr;
+    if (sqlite3_exec(ons_db.db, commit ? "RELEASE ons_block;" : "ROLLBACK TO ons_block; RELEASE ons_block;", NULL, NULL, &sql_err) != SQLITE_OK)
+    {
+      MERROR("Failed to " << (commit ? "release" : "roll back to") << " savepoint in ONS DB, reason=" << (sql_err ? sql_err : "??"));
+      sqlite3_free(sql_err);
+    }
+    return;
+  }
+
   if (!ons_db.transaction_begun)
   {
     MERROR("Trying to apply non-existent transaction (no prior history of a db transaction beginning) to the ONS DB");
@@ -1725,6 +1751,34 @@ auto constexpr DB_VERSION = db_version::v2_full_rows;
 
 constexpr auto EXPIRATION = " (expiration_height IS NULL OR expiration_height >= ?) "sv;
 
+// Maximum number of name hashes we look up in a single query
+constexpr size_t MAX_NAME_HASHES_PER_QUERY = 256;
+
+// Appends a comma-separated list of `count` placeholders, rounded up to the next power of 2, and
+// returns the number appended.  The rounding keeps the number of distinct query shapes small so
+// that their compiled statements can be cached; callers bind the extra placeholders by repeating
+// the last value.
+size_t append_padded_placeholders(std::string& sql, size_t count)
+{
+  size_t padded = 1;
+  while (padded < count)
+    padded <<= 1;
+  sql.reserve(sql.size() + 3 * padded);
+  for (size_t i = 0; i < padded; i++)
+    sql += i > 0 ? ", ?" : "?";
+  return padded;
+}
+
+std::string resolve_cache_key(mapping_type type, std::string_view name_hash_b64, uint64_t blockchain_height)
+{
+  std::string key;
+  key.reserve(1 + name_hash_b64.size() + sizeof(blockchain_height));
+  key += static_cast<char>(db_mapping_type(type));
+  key += name_hash_b64;
+  key.append(reinterpret_cast<const char*>(&blockchain_height), sizeof(blockchain_height));
+  return key;
+}
+
 } // anon. namespace
 
 bool name_system_db::init(cryptonote::Blockchain const *blockchain, cryptonote::network_type nettype, sqlite3 *db)
@@ -1924,6 +1978,9 @@ name_system_db::~name_system_db()
 {
   if (!db) return;
 
+  if (batch_active())
+    batch_stop(true);
+
   {
     scoped_db_transaction db_transaction(*this);
     save_settings(last_processed_height, last_processed_hash, static_cast<int>(DB_VERSION));
@@ -2077,18 +2134,18 @@ bool add_ons_entry(ons::name_system_db &ons_db, uint64_t height, cryptonote::tx_
     if (sql.empty())
       return false; // already MERROR'd
 
-    // Compile sql statement
-    sql_compiled_statement statement{ons_db};
-    if (!statement.compile(sql, false /*optimise_for_multiple_usage*/))
+    // Compile sql statement (there are only a few possible variations, so we keep them around)
+    auto [statement, statement_lock] = ons_db.cached_statement(sql);
+    if (!statement)
     {
       MERROR("Failed to compile SQL statement for updating ONS record=" << sql);
       return false;
     }
 
     // Bind statement parameters
-    bind_container(statement, bind);
+    bind_container(*statement, bind);
 
-    if (!sql_run_statement(ons_sql_type::save_mapping, statement, nullptr))
+    if (!sql_run_statement(ons_sql_type::save_mapping, *statement, nullptr))
       return false;
   }
 
@@ -2103,6 +2160,12 @@ bool name_system_db::add_block(const cryptonote::block &block, const std::vector
   if (last_processed_height >= height)
       return true;
 
+  using clock = std::chrono::steady_clock;
+  auto const start = clock::now();
+  auto add_time = oxen::defer([&] { stats.total += clock::now() - start; });
+  stats.blocks++;
+
+  clear_resolve_cache();
   scoped_db_transaction db_transaction(*this);
   if (!db_transaction)
    return false;
@@ -2115,6 +2178,7 @@ bool name_system_db::add_block(const cryptonote::block &block, const std::vector
       if (tx.type != cryptonote::txtype::oxen_name_system)
         continue;
 
+      auto const validate_start = clock::now();
       cryptonote::tx_extra_oxen_name_system entry = {};
       std::string fail_reason;
       if (!validate_ons_tx(block.major_version, height, tx, entry, &fail_reason))
@@ -2124,10 +2188,15 @@ bool name_system_db::add_block(const cryptonote::block &block, const std::vector
         return false;
       }
 
+      auto const write_start = clock::now();
+      stats.validate += write_start - validate_start;
       crypto::hash const &tx_hash = cryptonote::get_transaction_hash(tx);
-      if (!add_ons_entry(*this, height, entry, tx_hash))
+      bool const added = add_ons_entry(*this, height, entry, tx_hash);
+      stats.write += clock::now() - write_start;
+      if (!added)
         return false;
 
+      stats.txs++;
       ons_parsed_from_block = true;
     }
   }
@@ -2136,12 +2205,78 @@ bool name_system_db::add_block(const cryptonote::block &block, const std::vector
   last_processed_hash   = cryptonote::get_block_hash(block);
   if (ons_parsed_from_block)
   {
-    save_settings(last_processed_height, last_processed_hash, static_cast<int>(DB_VERSION));
+    // When batching, the settings get saved once when the batch is committed
+    if (batch_active())
+      batch_dirty = true;
+    else
+      save_settings(last_processed_height, last_processed_hash, static_cast<int>(DB_VERSION));
     db_transaction.commit = ons_parsed_from_block;
   }
   return true;
 }
 
+bool name_system_db::batch_start()
+{
+  if (batch_active() || transaction_begun)
+  {
+    MERROR("Failed to start ONS batch: a transaction is already in progress");
+    return false;
+  }
+
+  char *sql_err = nullptr;
+  if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, &sql_err) != SQLITE_OK)
+  {
+    MERROR("Failed to start ONS batch, reason=" << (sql_err ? sql_err : "??"));
+    sqlite3_free(sql_err);
+    return false;
+  }
+
+  transaction_begun  = true;
+  batch_start_height = last_processed_height;
+  batch_start_hash   = last_processed_hash;
+  batch_dirty        = false;
+  return true;
+}
+
+void name_system_db::batch_stop(bool commit)
+{
+  if (!batch_active())
+    return;
+
+  auto const start = std::chrono::steady_clock::now();
+  if (commit && batch_dirty)
+    save_settings(last_processed_height, last_processed_hash, static_cast<int>(DB_VERSION));
+
+  char *sql_err = nullptr;
+  if (sqlite3_exec(db, commit ? "END;" : "ROLLBACK;", nullptr, nullptr, &sql_err) != SQLITE_OK)
+  {
+    MERROR("Failed to " << (commit ? "commit" : "roll back") << " ONS batch, reason=" << (sql_err ? sql_err : "??"));
+    sqlite3_free(sql_err);
+    if (commit)
+    {
+      sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+      commit = false;
+    }
+  }
+
+  if (!commit)
+  {
+    last_processed_height = *batch_start_height;
+    last_processed_hash   = batch_start_hash;
+    clear_resolve_cache();
+  }
+
+  transaction_begun = false;
+  batch_start_height.reset();
+  batch_dirty = false;
+  stats.commit += std::chrono::steady_clock::now() - start;
+}
+
+ingest_stats name_system_db::take_ingest_stats()
+{
+  return std::exchange(stats, {});
+}
+
 struct ons_update_history
 {
   uint64_t value_last_update_height        = static_cast<uint64_t>(-1);
@@ -2179,9 +2314,32 @@ struct replay_ons_tx
 
 void name_system_db::block_detach(cryptonote::Blockchain const &blockchain, uint64_t new_blockchain_height)
 {
+  clear_resolve_cache();
   prune_db(new_blockchain_height);
 }
 
+std::pair<sql_compiled_statement*, std::unique_lock<std::mutex>> name_system_db::cached_statement(std::string const &query)
+{
+  std::unique_lock lock{statement_cache_mutex};
+  if (auto it = statement_cache.find(query); it != statement_cache.end())
+    return {&it->second, std::move(lock)};
+
+  sql_compiled_statement statement{*this};
+  if (!statement.compile(query))
+    return {nullptr, std::move(lock)};
+
+  if (statement_cache.size() >= STATEMENT_CACHE_SIZE)
+    statement_cache.clear();
+  return {&statement_cache.emplace(query, std::move(statement)).first->second, std::move(lock)};
+}
+
+void name_system_db::clear_resolve_cache()
+{
+  std::lock_guard lock{resolve_cache_mutex};
+  resolve_cache_index.clear();
+  resolve_cache.clear();
+}
+
 bool name_system_db::save_owner(ons::generic_owner const &owner, int64_t *row_id)
 {
   bool result = bind_and_run(ons_sql_type::save_owner, save_owner_sql, nullptr,
@@ -2279,6 +2437,16 @@ mapping_record name_system_db::get_mapping(mapping_type type, std::string_view n
 std::optional<mapping_value> name_system_db::resolve(mapping_type type, std::string_view name_hash_b64, uint64_t blockchain_height)
 {
   assert(name_hash_b64.size() == 44 && name_hash_b64.back() == '=' && oxenmq::is_base64(name_hash_b64));
+  std::string key = resolve_cache_key(type, name_hash_b64, blockchain_height);
+  {
+    std::lock_guard lock{resolve_cache_mutex};
+    if (auto it = resolve_cache_index.find(key); it != resolve_cache_index.end())
+    {
+      resolve_cache.splice(resolve_cache.begin(), resolve_cache, it->second);
+      return it->second->second;
+    }
+  }
+
   std::optional<mapping_value> result;
   bind_all(resolve_sql, db_mapping_type(type), name_hash_b64, blockchain_height);
   if (step(resolve_sql) == SQLITE_ROW)
@@ -2294,54 +2462,80 @@ std::optional<mapping_value> name_system_db::resolve(mapping_type type, std::str
   }
   reset(resolve_sql);
   clear_bindings(resolve_sql);
+
+  std::lock_guard lock{resolve_cache_mutex};
+  if (!resolve_cache_index.count(key))
+  {
+    auto& [cached_key, value] = resolve_cache.emplace_front(std::move(key), result);
+    resolve_cache_index.emplace(cached_key, resolve_cache.begin());
+    if (resolve_cache.size() > RESOLVE_CACHE_SIZE)
+    {
+      resolve_cache_index.erase(resolve_cache.back().first);
+      resolve_cache.pop_back();
+    }
+  }
   return result;
 }
 
 std::vector<mapping_record> name_system_db::get_mappings(std::vector<mapping_type> const &types, std::string_view name_base64_hash, std::optional<uint64_t> blockchain_height)
 {
-  assert(name_base64_hash.size() == 44 && name_base64_hash.back() == '=' && oxenmq::is_base64(name_base64_hash));
+  return get_mappings_by_name_hashes(types, {name_base64_hash}, blockchain_height);
+}
+
+std::vector<mapping_record> name_system_db::get_mappings_by_name_hashes(std::vector<mapping_type> const &types, std::vector<std::string_view> const &name_base64_hashes, std::optional<uint64_t> blockchain_height)
+{
   std::vector<mapping_record> result;
-  if (types.empty())
+  if (types.empty() || name_base64_hashes.empty())
     return result;
 
+  std::vector<uint16_t> db_types;
+  db_types.reserve(types.size());
+  for (auto type : types)
+    db_types.push_back(db_mapping_type(type));
+  std::sort(db_types.begin(), db_types.end());
+  db_types.erase(std::unique(db_types.begin(), db_types.end()), db_types.end());
+
   std::string sql_statement;
   std::vector<std::variant<uint16_t, uint64_t, std::string_view>> bind;
-  sql_statement.reserve(sql_select_mappings_and_owners_prefix.size() + EXPIRATION.size() + 70
-      + sql_select_mappings_and_owners_suffix.size());
-  sql_statement += sql_select_mappings_and_owners_prefix;
-  sql_statement += "WHERE name_hash = ?";
-  bind.emplace_back(name_base64_hash);
-
-  // Generate string statement
-  if (types.size())
+  for (size_t start = 0; start < name_base64_hashes.size(); start += MAX_NAME_HASHES_PER_QUERY)
   {
-    sql_statement += " AND type IN (";
+    size_t const count = std::min(name_base64_hashes.size() - start, MAX_NAME_HASHES_PER_QUERY);
 
-    for (size_t i = 0; i < types.size(); i++)
+    // Generate string statement
+    sql_statement.clear();
+    bind.clear();
+    sql_statement += sql_select_mappings_and_owners_prefix;
+    sql_statement += "WHERE name_hash IN (";
+    size_t padded = append_padded_placeholders(sql_statement, count);
+    for (size_t i = 0; i < padded; i++)
     {
-      sql_statement += i > 0 ? ", ?" : "?";
-      bind.emplace_back(db_mapping_type(types[i]));
+      std::string_view name_base64_hash = name_base64_hashes[start + std::min(i, count - 1)];
+      assert(name_base64_hash.size() == 44 && name_base64_hash.back() == '=' && oxenmq::is_base64(name_base64_hash));
+      bind.emplace_back(name_base64_hash);
     }
+
+    sql_statement += ") AND type IN (";
+    padded = append_padded_placeholders(sql_statement, db_types.size());
+    for (size_t i = 0; i < padded; i++)
+      bind.emplace_back(db_types[std::min(i, db_types.size() - 1)]);
     sql_statement += ")";
-  }
 
-  if (blockchain_height)
-  {
-    sql_statement += " AND ";
-    sql_statement += EXPIRATION;
-    bind.emplace_back(*blockchain_height);
-  }
+    if (blockchain_height)
+    {
+      sql_statement += " AND ";
+      sql_statement += EXPIRATION;
+      bind.emplace_back(*blockchain_height);
+    }
 
-  sql_statement += sql_select_mappings_and_owners_suffix;
+    sql_statement += sql_select_mappings_and_owners_suffix;
 
-  // Compile Statement
-  sql_compiled_statement statement{*this};
-  if (!statement.compile(sql_statement, false /*optimise_for_multiple_usage*/)
-      || !bind_container(statement, bind))
-    return result;
+    // Compile (or reuse) and execute
+    auto [statement, statement_lock] = cached_statement(sql_statement);
+    if (!statement || !bind_container(*statement, bind))
+      return result;
 
-  // Execute
-  sql_run_statement(ons_sql_type::get_mappings, statement, &result);
+    sql_run_statement(ons_sql_type::get_mappings, *statement, &result);
+  }
 
   return result;
 }
@@ -2357,11 +2551,7 @@ std::vector<mapping_record> name_system_db::get_mappings_by_owners(std::vector<g
     constexpr auto SQL_SUFFIX  = "))"sv;
 
     std::string placeholders;
-    placeholders.reserve(3*owners.size());
-    for (size_t i = 0; i < owners.size(); i++)
-      placeholders += "?, ";
-    if (owners.size() > 0)
-      placeholders.resize(placeholders.size() - 2);
+    size_t padded = owners.empty() ? 0 : append_padded_placeholders(placeholders, owners.size());
 
     sql_statement.reserve(sql_select_mappings_and_owners_prefix.size() + SQL_WHERE_OWNER.size() + SQL_OR_BACKUP_OWNER.size()
         + SQL_SUFFIX.size() + 2*placeholders.size() + 5 + EXPIRATION.size() + sql_select_mappings_and_owners_suffix.size());
@@ -2373,8 +2563,8 @@ std::vector<mapping_record> name_system_db::get_mappings_by_owners(std::vector<g
     sql_statement += SQL_SUFFIX;
 
     for (int i : {0, 1})
-      for (auto const &owner : owners)
-        bind.emplace_back(blob_view{reinterpret_cast<const char*>(&owner), sizeof(owner)});
+      for (size_t j = 0; j < padded; j++)
+        bind.emplace_back(blob_view{reinterpret_cast<const char*>(&owners[std::min(j, owners.size() - 1)]), sizeof(generic_owner)});
   }
 
   if (blockchain_height)
@@ -2388,13 +2578,12 @@ std::vector<mapping_record> name_system_db::get_mappings_by_owners(std::vector<g
 
   // Compile Statement
   std::vector<mapping_record> result;
-  sql_compiled_statement statement{*this};
-  if (!statement.compile(sql_statement, false /*optimise_for_multiple_usage*/)
-      || !bind_container(statement, bind))
+  auto [statement, statement_lock] = cached_statement(sql_statement);
+  if (!statement || !bind_container(*statement, bind))
     return result;
 
   // Execute
-  sql_run_statement(ons_sql_type::get_mappings_by_owners, statement, &result);
+  sql_run_statement(ons_sql_type::get_mappings_by_owners, *statement, &result);
   return result;
 }
 
@@ -9,7 +9,11 @@
 #include <oxenmq/hex.h>
 
 #include <cassert>
+#include <chrono>
+#include <list>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 struct sqlite3;
 struct sqlite3_stmt;
@@ -238,6 +242,18 @@ struct mapping_record
   generic_owner backup_owner;
 };
 
+// Time spent by name_system_db::add_block, accumulated until retrieved with take_ingest_stats()
+struct ingest_stats
+{
+  using duration = std::chrono::steady_clock::duration;
+  size_t   blocks = 0;
+  size_t   txs    = 0;
+  duration total{};    // All of add_block, including the below
+  duration validate{}; // Validating ONS txs against the current DB state
+  duration write{};    // Writing owners and mappings
+  duration commit{};   // Committing batches (see name_system_db::batch_start)
+};
+
 struct name_system_db;
 class sql_compiled_statement final
 {
@@ -283,6 +299,17 @@ struct name_system_db
   cryptonote::network_type    network_type() const { return nettype; }
   uint64_t                    height      () const { return last_processed_height; }
 
+  // Bulk ingest: between batch_start() and batch_stop() every add_block() (and block_detach()) runs
+  // inside one DB transaction, with each block in its own savepoint so that a failed block is still
+  // rolled back on its own.  batch_stop(false) rolls back everything since batch_start().  Intended
+  // to be used alongside the blockchain's own batch when syncing or rescanning many blocks.
+  bool                        batch_start    ();
+  void                        batch_stop     (bool commit = true);
+  bool                        batch_active   () const { return batch_start_height.has_value(); }
+
+  // Returns the timing breakdown of add_block calls since the last call, and resets it.
+  ingest_stats                take_ingest_stats();
+
   // Signifies the blockchain has reorganized commences the rollback and pruning procedures.
   void                        block_detach   (cryptonote::Blockchain const &blockchain, uint64_t new_blockchain_height);
   bool                        save_owner     (generic_owner const &owner, int64_t *row_id);
@@ -301,6 +328,10 @@ struct name_system_db
   // you will get the latest mappingsvalues regardless of whether expired or not they are expired.
   mapping_record              get_mapping           (mapping_type type, std::string_view name_base64_hash, std::optional<uint64_t> blockchain_height = std::nullopt);
   std::vector<mapping_record> get_mappings          (std::vector<mapping_type> const &types, std::string_view name_base64_hash, std::optional<uint64_t> blockchain_height = std::nullopt);
+  // Batched get_mappings: looks up every (name hash, type) combination of the given name hashes and
+  // types in as few queries as possible.  Records come back grouped by name hash; use the record's
+  // name_hash and type to match them back up with the request.
+  std::vector<mapping_record> get_mappings_by_name_hashes(std::vector<mapping_type> const &types, std::vector<std::string_view> const &name_base64_hashes, std::optional<uint64_t> blockchain_height = std::nullopt);
   std::vector<mapping_record> get_mappings_by_owner (generic_owner const &key, std::optional<uint64_t> blockchain_height = std::nullopt);
   std::vector<mapping_record> get_mappings_by_owners(std::vector<generic_owner> const &keys, std::optional<uint64_t> blockchain_height = std::nullopt);
   settings_record             get_settings          ();
@@ -309,7 +340,8 @@ struct name_system_db
   std::map<mapping_type, int> get_mapping_counts(uint64_t blockchain_height);
 
   // Resolves a mapping of the given type and name hash. Returns a null optional if the value was
-  // not found or expired, otherwise returns the encrypted value.
+  // not found or expired, otherwise returns the encrypted value.  Recent results are kept in a
+  // small cache which is dropped whenever a block is added or detached.
   std::optional<mapping_value> resolve(mapping_type type, std::string_view name_hash_b64, uint64_t blockchain_height);
 
   // Validates an ONS transaction.  If the function returns true then entry will be populated with
@@ -321,10 +353,23 @@ struct name_system_db
 
   sqlite3 *db               = nullptr;
   bool    transaction_begun = false;
+  // Returns a persistent compiled statement for the given query, compiling it the first time the
+  // query is seen.  This is for queries built at runtime (which callers should keep to a handful of
+  // distinct shapes, e.g. by padding placeholder counts); returns nullptr if compilation fails.
+  // The cache is shared between threads, so the returned lock must be held for as long as the
+  // statement is in use (i.e. through binding, running and resetting it).
+  std::pair<sql_compiled_statement*, std::unique_lock<std::mutex>> cached_statement(std::string const &query);
+
 private:
+  void clear_resolve_cache();
+
   cryptonote::network_type nettype;
   uint64_t last_processed_height = 0;
   crypto::hash last_processed_hash = crypto::null_hash;
+  std::optional<uint64_t> batch_start_height; // Set while a batch is active
+  crypto::hash batch_start_hash = crypto::null_hash;
+  bool batch_dirty = false; // True if a batch has written ONS records
+  ingest_stats stats;
   sql_compiled_statement save_owner_sql{*this};
   sql_compiled_statement save_mapping_sql{*this};
   sql_compiled_statement save_settings_sql{*this};
@@ -338,6 +383,16 @@ private:
   sql_compiled_statement get_mappings_by_owner_sql{*this};
   sql_compiled_statement get_mapping_counts_sql{*this};
   sql_compiled_statement get_mappings_on_height_and_newer_sql{*this};
+
+  static constexpr size_t STATEMENT_CACHE_SIZE = 64;
+  std::mutex statement_cache_mutex;
+  std::unordered_map<std::string, sql_compiled_statement> statement_cache;
+
+  static constexpr size_t RESOLVE_CACHE_SIZE = 1024;
+  std::mutex resolve_cache_mutex;
+  // Most recently used first; the index keys point into the strings stored in the list.
+  std::list<std::pair<std::string, std::optional<mapping_value>>> resolve_cache;
+  std::unordered_map<std::string_view, decltype(resolve_cache)::iterator> resolve_cache_index;
 };
 
 }; // namespace service_nodes
@@ -68,6 +68,9 @@ extern "C" {
 namespace service_nodes
 {
   size_t constexpr STORE_LONG_TERM_STATE_INTERVAL = 10000;
+  // Short term states are stored as deltas against the previous block's state; every this many
+  // blocks we store a full copy instead so that loading never has to replay a long chain.
+  size_t constexpr STORE_SHORT_TERM_CHECKPOINT_INTERVAL = 200;
 
   constexpr auto X25519_MAP_PRUNING_INTERVAL = 5min;
   constexpr auto X25519_MAP_PRUNING_LAG = 24h;
@@ -660,7 +663,7 @@ namespace service_nodes
     }
 
     uint64_t block_height = cryptonote::get_block_height(block);
-    auto &info = duplicate_info(iter->second);
+    auto &info = duplicate_info(service_nodes_infos.get_mutable(key));
     bool is_me = my_keys && my_keys->pub == key;
 
     switch (state_change.state) {
@@ -685,7 +688,7 @@ namespace service_nodes
           }
         }
 
-        service_nodes_infos.erase(iter);
+        service_nodes_infos.erase(key);
         return true;
 
       case new_state::decommission:
@@ -842,7 +845,7 @@ namespace service_nodes
         if (crypto::check_signature(service_nodes::generate_request_stake_unlock_hash(unlock.nonce),
                     cit->key_image_pub_key, unlock.signature))
         {
-          duplicate_info(it->second).requested_unlock_height = unlock_height;
+          duplicate_info(service_nodes_infos.get_mutable(snode_key)).requested_unlock_height = unlock_height;
           return true;
         }
         else
@@ -1202,7 +1205,7 @@ namespace service_nodes
     // Successfully Validated
     //
 
-    auto &info = duplicate_info(iter->second);
+    auto &info = duplicate_info(service_nodes_infos.get_mutable(stake.service_node_pubkey));
     if (new_contributor)
     {
       contributor_position = info.contributors.size();
@@ -2057,7 +2060,7 @@ namespace service_nodes
       if (it != service_nodes_infos.end())
       {
         // set the winner as though it was re-registering at transaction index=UINT32_MAX for this block
-        auto &info = duplicate_info(it->second);
+        auto &info = duplicate_info(service_nodes_infos.get_mutable(winner_pubkey));
         info.last_reward_block_height = block_height;
         info.last_reward_transaction_index = UINT32_MAX;
       }
@@ -2105,9 +2108,8 @@ namespace service_nodes
       /// Apply changes
       for (const auto& [swarm_id, snodes] : existing_swarms) {
         for (const auto& snode : snodes) {
-          auto& sn_info_ptr = service_nodes_infos.at(snode);
-          if (sn_info_ptr->swarm_id == swarm_id) continue; /// nothing changed for this snode
-          duplicate_info(sn_info_ptr).swarm_id = swarm_id;
+          if (service_nodes_infos.at(snode)->swarm_id == swarm_id) continue; /// nothing changed for this snode
+          duplicate_info(service_nodes_infos.get_mutable(snode)).swarm_id = swarm_id;
         }
       }
     }
@@ -2137,7 +2139,6 @@ namespace service_nodes
         bool need_quorum_for_future_states    = (dist_to_next_long_term_state <= VOTE_LIFETIME + VOTE_OR_TX_VERIFY_HEIGHT_BUFFER);
         if ((it->height % STORE_LONG_TERM_STATE_INTERVAL) == 0 || need_quorum_for_future_states)
         {
-          m_transient.state_added_to_archive = true;
           if (need_quorum_for_future_states) // Preserve just quorum
           {
             state_t &state            = const_cast<state_t &>(*it); // safe: set order only depends on state_t.height
@@ -2208,6 +2209,25 @@ namespace service_nodes
     auto it = std::prev(history.end());
     m_state = std::move(*it);
     history.erase(it);
+
+    if (using_archive)
+    {
+      // The archived state we reverted to has no short term record for later deltas to build on:
+      // have the next store() rewrite everything, starting with a checkpoint of it.
+      m_transient.stored_short_term_top.reset();
+      m_transient.stored_long_term_top.reset();
+      m_transient.stored_quorums_top.reset();
+      return;
+    }
+
+    // Stored records above what we kept belong to the detached blocks: make sure the next store()
+    // overwrites them rather than assuming they're already written.
+    auto &short_term_top = m_transient.stored_short_term_top;
+    if (short_term_top && *short_term_top > m_state.height)
+      short_term_top = m_state.height;
+    auto &long_term_top = m_transient.stored_long_term_top;
+    if (long_term_top && (m_transient.state_archive.empty() || *long_term_top > m_transient.state_archive.rbegin()->height))
+      long_term_top = m_transient.state_archive.empty() ? std::nullopt : std::make_optional(m_transient.state_archive.rbegin()->height);
   }
 
   std::vector<crypto::public_key> service_node_list::state_t::get_expired_nodes(cryptonote::BlockchainDB const &db,
@@ -2661,6 +2681,42 @@ namespace service_nodes
     return result;
   }
 
+  template <typename T>
+  static std::string serialize_to_string(T &value)
+  {
+    serialization::binary_string_archiver ba;
+    serialization::serialize(ba, value);
+    return ba.str();
+  }
+
+  // Serializes `state` as a short term record: in full if `base` is null, otherwise just the nodes
+  // that changed since `base`.
+  static std::string serialize_state_delta(uint8_t hf_version, service_node_list::state_t const &state, service_node_list::state_t const *base)
+  {
+    service_node_list::state_delta_serialized result = {};
+    result.version             = service_node_list::state_delta_serialized::get_version(hf_version);
+    result.height              = state.height;
+    result.base_height         = base ? base->height : state.height;
+    result.block_hash          = state.block_hash;
+    result.key_image_blacklist = state.key_image_blacklist;
+    result.quorums             = serialize_quorum_state(hf_version, state.height, state.quorums);
+    result.only_stored_quorums = state.only_loaded_quorums;
+
+    if (base)
+    {
+      state.service_nodes_infos.diff(base->service_nodes_infos,
+          [&result](pubkey_and_sninfo const &kv_pair) { result.infos.emplace_back(kv_pair); },
+          [&result](crypto::public_key const &pubkey) { result.removed.push_back(pubkey); });
+    }
+    else
+    {
+      result.infos.reserve(state.service_nodes_infos.size());
+      for (const auto &kv_pair : state.service_nodes_infos)
+        result.infos.emplace_back(kv_pair);
+    }
+    return serialize_to_string(result);
+  }
+
   bool service_node_list::store()
   {
     if (!m_blockchain.has_db())
@@ -2670,80 +2726,102 @@ namespace service_nodes
     if (hf_version < cryptonote::network_version_9_service_nodes)
       return true;
 
-    data_for_serialization *data[] = {&m_transient.cache_long_term_data, &m_transient.cache_short_term_data};
-    auto const serialize_version   = data_for_serialization::get_version(hf_version);
+    using kind = cryptonote::service_node_state_kind;
     std::lock_guard lock(m_sn_mutex);
-
-    for (data_for_serialization *serialize_entry : data)
-    {
-      if (serialize_entry->version != serialize_version) m_transient.state_added_to_archive = true;
-      serialize_entry->version = serialize_version;
-      serialize_entry->clear();
-    }
-
-    m_transient.cache_short_term_data.quorum_states.reserve(m_transient.old_quorum_states.size());
-    for (const quorums_by_height &entry : m_transient.old_quorum_states)
-      m_transient.cache_short_term_data.quorum_states.push_back(serialize_quorum_state(hf_version, entry.height, entry.quorums));
-
-
-    if (m_transient.state_added_to_archive)
+    auto &db = m_blockchain.get_db();
+    cryptonote::db_wtxn_guard txn_guard{db};
+    try
     {
-      for (auto const &it : m_transient.state_archive)
-        m_transient.cache_long_term_data.states.push_back(serialize_service_node_state_object(hf_version, it));
-    }
+      // NOTE: After a reset, or after loading the old whole-history blobs, start over with an
+      // empty table (which also drops those blobs).
+      auto &checkpoints = m_transient.stored_checkpoints;
+      auto &short_term_top = m_transient.stored_short_term_top;
+      if (!short_term_top)
+      {
+        db.clear_service_node_data();
+        checkpoints.clear();
+      }
 
-    // NOTE: A state_t may reference quorums up to (VOTE_LIFETIME
-    // + VOTE_OR_TX_VERIFY_HEIGHT_BUFFER) blocks back. So in the
-    // (MAX_SHORT_TERM_STATE_HISTORY | 2nd oldest checkpoint) window of states we store, the
-    // first (VOTE_LIFETIME + VOTE_OR_TX_VERIFY_HEIGHT_BUFFER) states we only
-    // store their quorums, such that the following states have quorum
-    // information preceeding it.
+      // NOTE: Short term history.  Only states added since the last store get written: each one as
+      // a delta against the state before it, except every STORE_SHORT_TERM_CHECKPOINT_INTERVAL
+      // blocks (or when that state is gone) where we write a full checkpoint instead.  Records
+      // above m_state were orphaned by a reorg.
+      db.remove_service_node_states(kind::short_term, m_state.height + 1, UINT64_MAX);
+      while (short_term_top && !checkpoints.empty() && checkpoints.back() > *short_term_top)
+        checkpoints.pop_back();
 
-    uint64_t const max_short_term_height = short_term_state_cull_height(hf_version, (m_state.height - 1)) + VOTE_LIFETIME + VOTE_OR_TX_VERIFY_HEIGHT_BUFFER;
-    for (auto it = m_transient.state_history.begin();
-         it != m_transient.state_history.end() && it->height <= max_short_term_height;
-         it++)
-    {
-      // TODO(oxen): There are 2 places where we convert a state_t to be a serialized state_t without quorums. We should only do this in one location for clarity.
-      m_transient.cache_short_term_data.states.push_back(serialize_service_node_state_object(hf_version, *it, it->height < max_short_term_height /*only_serialize_quorums*/));
-    }
-
-    m_transient.cache_data_blob.clear();
-    if (m_transient.state_added_to_archive)
-    {
-      serialization::binary_string_archiver ba;
-      try {
-        serialization::serialize(ba, m_transient.cache_long_term_data);
-      } catch (const std::exception& e) {
-        LOG_ERROR("Failed to store service node info: failed to serialize long term data: " << e.what());
-        return false;
+      state_t const *prev = nullptr;
+      if (short_term_top)
+      {
+        auto it = m_transient.state_history.find(*short_term_top);
+        if (it != m_transient.state_history.end())
+          prev = &*it;
       }
-      m_transient.cache_data_blob.append(ba.str());
+
+      auto write_short_term = [&](state_t const &state) {
+        bool const checkpoint = !prev || prev->height + 1 != state.height || prev->only_loaded_quorums || state.only_loaded_quorums ||
+                                state.height % STORE_SHORT_TERM_CHECKPOINT_INTERVAL == 0;
+        db.set_service_node_state(kind::short_term, state.height, serialize_state_delta(hf_version, state, checkpoint ? nullptr : prev));
+        if (checkpoint)
+          checkpoints.push_back(state.height);
+        prev = &state;
+      };
+
+      for (auto it = short_term_top ? m_transient.state_history.upper_bound(*short_term_top) : m_transient.state_history.begin();
+           it != m_transient.state_history.end();
+           it++)
+        write_short_term(*it);
+      if (!short_term_top || *short_term_top < m_state.height)
+        write_short_term(m_state);
+      short_term_top = m_state.height;
+
+      // Drop everything below the last checkpoint we still need to rebuild the oldest kept state
+      uint64_t const oldest = m_transient.state_history.empty() ? m_state.height : m_transient.state_history.begin()->height;
+      auto needed = std::upper_bound(checkpoints.begin(), checkpoints.end(), oldest);
+      if (needed != checkpoints.begin())
       {
-        auto &db = m_blockchain.get_db();
-        cryptonote::db_wtxn_guard txn_guard{db};
-        db.set_service_node_data(m_transient.cache_data_blob, true /*long_term*/);
+        --needed;
+        db.remove_service_node_states(kind::short_term, 0, *needed);
+        checkpoints.erase(checkpoints.begin(), needed);
       }
-    }
 
-    m_transient.cache_data_blob.clear();
-    {
-      serialization::binary_string_archiver ba;
-      try {
-        serialization::serialize(ba, m_transient.cache_short_term_data);
-      } catch (const std::exception& e) {
-        LOG_ERROR("Failed to store service node info: failed to serialize short term data: " << e.what());
-        return false;
+      // NOTE: Long term archive: standalone states that, once written, never change.
+      auto &archive = m_transient.state_archive;
+      auto &long_term_top = m_transient.stored_long_term_top;
+      db.remove_service_node_states(kind::long_term, archive.empty() ? 0 : archive.rbegin()->height + 1, UINT64_MAX);
+      for (auto it = long_term_top ? archive.upper_bound(*long_term_top) : archive.begin(); it != archive.end(); it++)
+      {
+        state_serialized serialized = serialize_service_node_state_object(hf_version, *it);
+        db.set_service_node_state(kind::long_term, it->height, serialize_to_string(serialized));
       }
-      m_transient.cache_data_blob.append(ba.str());
+      long_term_top = archive.empty() ? std::nullopt : std::make_optional(archive.rbegin()->height);
+
+      // NOTE: Quorum history, if enabled with --store-full-quorum-history
+      auto const &old_quorums = m_transient.old_quorum_states;
+      auto &quorums_top = m_transient.stored_quorums_top;
+      db.remove_service_node_states(kind::quorums, 0, old_quorums.empty() ? UINT64_MAX : old_quorums.front().height);
+      if (!old_quorums.empty())
+        db.remove_service_node_states(kind::quorums, old_quorums.back().height + 1, UINT64_MAX);
+      auto quorum_it = !quorums_top ? old_quorums.begin()
+        : std::upper_bound(old_quorums.begin(), old_quorums.end(), *quorums_top,
+            [](uint64_t height, quorums_by_height const &entry) { return height < entry.height; });
+      for (; quorum_it != old_quorums.end(); quorum_it++)
       {
-        auto &db = m_blockchain.get_db();
-        cryptonote::db_wtxn_guard txn_guard{db};
-        db.set_service_node_data(m_transient.cache_data_blob, false /*long_term*/);
+        quorum_for_serialization serialized = serialize_quorum_state(hf_version, quorum_it->height, quorum_it->quorums);
+        db.set_service_node_state(kind::quorums, quorum_it->height, serialize_to_string(serialized));
       }
+      quorums_top = old_quorums.empty() ? std::nullopt : std::make_optional(old_quorums.back().height);
+    }
+    catch (const std::exception& e)
+    {
+      LOG_ERROR("Failed to store service node info: " << e.what());
+      txn_guard.abort();
+      // We don't know what made it into the db, so rewrite everything next time
+      m_transient.stored_short_term_top.reset();
+      m_transient.stored_long_term_top.reset();
+      m_transient.stored_quorums_top.reset();
+      return false;
     }
-
-    m_transient.state_added_to_archive = false;
     return true;
   }
 
@@ -2978,6 +3056,7 @@ namespace service_nodes
     auto old_x25519 = iproof.pubkey_x25519;
     if (iproof.update(std::chrono::system_clock::to_time_t(now), proof.public_ip, proof.storage_https_port, proof.storage_omq_port, proof.qnet_port, proof.snode_version, proof.pubkey_ed25519, derived_x25519_pubkey))
       iproof.store(proof.pubkey, m_blockchain);
+    m_proof_generation++;
 
     if (now - x25519_map_last_pruned >= X25519_MAP_PRUNING_INTERVAL)
     {
@@ -3078,6 +3157,7 @@ namespace service_nodes
     {
       iproof.store(iproof.proof->pubkey, m_blockchain);
     }
+    m_proof_generation++;
 
     if (now - x25519_map_last_pruned >= X25519_MAP_PRUNING_INTERVAL)
     {
@@ -3199,6 +3279,7 @@ namespace service_nodes
 
     auto &info = proofs[pubkey];
     info.checkpoint_participation.add(entry);
+    m_proof_generation++;
   }
 
   void service_node_list::record_pulse_participation(crypto::public_key const &pubkey, uint64_t height, uint8_t round, bool participated)
@@ -3215,6 +3296,7 @@ namespace service_nodes
 
     auto &info = proofs[pubkey];
     info.pulse_participation.add(entry);
+    m_proof_generation++;
   }
 
   void service_node_list::record_timestamp_participation(crypto::public_key const &pubkey, bool participated)
@@ -3228,6 +3310,7 @@ namespace service_nodes
 
     auto &info = proofs[pubkey];
     info.timestamp_participation.add(entry);
+    m_proof_generation++;
   }
 
   void service_node_list::record_timesync_status(crypto::public_key const &pubkey, bool synced)
@@ -3241,6 +3324,7 @@ namespace service_nodes
 
     auto &info = proofs[pubkey];
     info.timesync_status.add(entry);
+    m_proof_generation++;
   }
 
   std::optional<bool> proof_info::reachable_stats::reachable(const std::chrono::steady_clock::time_point& now) const {
@@ -3287,6 +3371,7 @@ namespace service_nodes
       if (reach.first_unreachable == NEVER)
         reach.first_unreachable = now;
     }
+    m_proof_generation++;
 
     return true;
 
@@ -3326,63 +3411,80 @@ namespace service_nodes
       block_hash = sn_list->m_blockchain.get_block_id_by_height(height);
 
     for (auto &pubkey_info : state.infos)
-    {
-      using version_t = service_node_info::version_t;
-      auto &info = const_cast<service_node_info &>(*pubkey_info.info);
-      if (info.version < version_t::v1_add_registration_hf_version)
-      {
-        info.version = version_t::v1_add_registration_hf_version;
-        info.registration_hf_version = sn_list->m_blockchain.get_network_version(pubkey_info.info->registration_height);
-      }
-      if (info.version < version_t::v4_noproofs)
-      {
-        // Nothing to do here (the missing data will be generated in the new proofs db via uptime proofs).
-        info.version = version_t::v4_noproofs;
-      }
-      if (info.version < version_t::v5_pulse_recomm_credit)
-      {
-        // If it's an old record then assume it's from before oxen 8, in which case there were only
-        // two valid values here: initial for a node that has never been recommissioned, or 0 for a recommission.
+      add_loaded_info(std::move(pubkey_info));
+    quorums = quorum_for_serialization_to_quorum_manager(state.quorums);
+  }
 
-        auto was = info.recommission_credit;
-        if (info.decommission_count <= info.is_decommissioned()) // Has never been decommissioned (or is currently in the first decommission), so add initial starting credit
-          info.recommission_credit = DECOMMISSION_INITIAL_CREDIT;
-        else
-          info.recommission_credit = 0;
+  service_node_list::state_t::state_t(service_node_list* snl, state_delta_serialized &&delta, state_t const *base)
+  : height{delta.height}
+  , key_image_blacklist{std::move(delta.key_image_blacklist)}
+  , only_loaded_quorums{delta.only_stored_quorums}
+  , block_hash{delta.block_hash}
+  , sn_list{snl}
+  {
+    if (!sn_list)
+      throw std::logic_error("Cannot deserialize a state_t without a service_node_list");
 
-        info.pulse_sorter.last_height_validating_in_quorum = info.last_reward_block_height;
-        info.version = version_t::v5_pulse_recomm_credit;
-      }
-      if (info.version < version_t::v6_reassign_sort_keys)
-      {
-        info.pulse_sorter = {};
-        info.version      = version_t::v6_reassign_sort_keys;
-      }
-      if (info.version < version_t::v7_decommission_reason)
-      {
-        // Nothing to do here (leave consensus reasons as 0s)
-        info.version = version_t::v7_decommission_reason;
-      }
-      // Make sure we handled any future state version upgrades:
-      assert(info.version == tools::enum_top<decltype(info.version)>);
-      service_nodes_infos.emplace(std::move(pubkey_info.pubkey), std::move(pubkey_info.info));
+    if (!delta.is_checkpoint())
+    {
+      if (!base || base->height != delta.base_height)
+        throw std::logic_error("Service node state delta for height " + std::to_string(delta.height) + " is missing its base state");
+      service_nodes_infos = base->service_nodes_infos;
+      for (auto const &pubkey : delta.removed)
+        service_nodes_infos.erase(pubkey);
     }
-    quorums = quorum_for_serialization_to_quorum_manager(state.quorums);
+
+    for (auto &pubkey_info : delta.infos)
+      add_loaded_info(std::move(pubkey_info));
+    quorums = quorum_for_serialization_to_quorum_manager(delta.quorums);
   }
 
-  bool service_node_list::load(const uint64_t current_height)
+  void service_node_list::state_t::add_loaded_info(service_node_pubkey_info &&pubkey_info)
   {
-    LOG_PRINT_L1("service_node_list::load()");
-    reset(false);
-    if (!m_blockchain.has_db())
+    using version_t = service_node_info::version_t;
+    auto &info = const_cast<service_node_info &>(*pubkey_info.info);
+    if (info.version < version_t::v1_add_registration_hf_version)
     {
-      return false;
+      info.version = version_t::v1_add_registration_hf_version;
+      info.registration_hf_version = sn_list->m_blockchain.get_network_version(pubkey_info.info->registration_height);
     }
+    if (info.version < version_t::v4_noproofs)
+    {
+      // Nothing to do here (the missing data will be generated in the new proofs db via uptime proofs).
+      info.version = version_t::v4_noproofs;
+    }
+    if (info.version < version_t::v5_pulse_recomm_credit)
+    {
+      // If it's an old record then assume it's from before oxen 8, in which case there were only
+      // two valid values here: initial for a node that has never been recommissioned, or 0 for a recommission.
+
+      auto was = info.recommission_credit;
+      if (info.decommission_count <= info.is_decommissioned()) // Has never been decommissioned (or is currently in the first decommission), so add initial starting credit
+        info.recommission_credit = DECOMMISSION_INITIAL_CREDIT;
+      else
+        info.recommission_credit = 0;
 
+      info.pulse_sorter.last_height_validating_in_quorum = info.last_reward_block_height;
+      info.version = version_t::v5_pulse_recomm_credit;
+    }
+    if (info.version < version_t::v6_reassign_sort_keys)
+    {
+      info.pulse_sorter = {};
+      info.version      = version_t::v6_reassign_sort_keys;
+    }
+    if (info.version < version_t::v7_decommission_reason)
+    {
+      // Nothing to do here (leave consensus reasons as 0s)
+      info.version = version_t::v7_decommission_reason;
+    }
+    // Make sure we handled any future state version upgrades:
+    assert(info.version == tools::enum_top<decltype(info.version)>);
+    service_nodes_infos[pubkey_info.pubkey] = std::move(pubkey_info.info);
+  }
+
+  bool service_node_list::load_legacy_data(cryptonote::BlockchainDB &db, uint64_t current_height, uint64_t &bytes_loaded)
+  {
     // NOTE: Deserialize long term state history
-    uint64_t bytes_loaded = 0;
-    auto &db = m_blockchain.get_db();
-    cryptonote::db_rtxn_guard txn_guard{db};
     std::string blob;
     if (db.get_service_node_data(blob, true /*long_term*/))
     {
@@ -3528,6 +3630,128 @@ namespace service_nodes
         m_state = {this, std::move(data_in.states[last_index])};
       }
     }
+    return true;
+  }
+
+  bool service_node_list::load_state_records(cryptonote::BlockchainDB &db, uint64_t current_height, uint64_t &bytes_loaded)
+  {
+    using kind = cryptonote::service_node_state_kind;
+    try
+    {
+      // NOTE: Walk down from the newest short term record until we reach the checkpoint that the
+      // oldest state we keep in memory (i.e. the oldest one process_block would not have culled
+      // yet) can be rebuilt from; older records are not even parsed.
+      std::vector<state_delta_serialized> records;
+      uint64_t keep_from = 0;
+      db.for_each_service_node_state(kind::short_term, UINT64_MAX, true /*reverse*/, [&](uint64_t height, std::string_view blob) {
+        bytes_loaded += blob.size();
+        auto &record = records.emplace_back();
+        serialization::parse_binary(blob, record);
+        if (records.size() == 1) // After processing block H, process_block has culled everything up to cull_height(H)
+          keep_from = short_term_state_cull_height(m_blockchain.get_network_version(), record.height) + 1;
+        return !(record.is_checkpoint() && record.height <= keep_from);
+      });
+
+      if (records.empty() || !records.back().is_checkpoint())
+      {
+        LOG_PRINT_L0("Stored service node states have no checkpoint to rebuild from, regenerating state");
+        return false;
+      }
+      if (records.front().only_stored_quorums)
+      {
+        LOG_PRINT_L0("Unexpected last serialized state only has quorums loaded");
+        return false;
+      }
+
+      // NOTE: Replay upwards from the checkpoint.  Each state starts as a copy of the one before
+      // it, so the rebuilt history shares all unchanged nodes just as if we had processed the blocks.
+      m_transient.stored_checkpoints.clear();
+      state_t state{this};
+      for (auto it = records.rbegin(); it != records.rend(); it++)
+      {
+        if (it->is_checkpoint())
+          m_transient.stored_checkpoints.push_back(it->height);
+        state = state_t{this, std::move(*it), &state};
+        if (state.height >= keep_from && std::next(it) != records.rend())
+          m_transient.state_history.emplace_hint(m_transient.state_history.end(), state);
+      }
+      m_state = std::move(state);
+
+      // NOTE: Drop states for blocks that are no longer in the chain (e.g. popped while we were not
+      // running, or a reorg since the last store); the rescan will regenerate them.
+      while (m_state.height >= current_height || m_state.block_hash != db.get_block_hash_from_height(m_state.height))
+      {
+        if (m_transient.state_history.empty())
+        {
+          LOG_PRINT_L0("No stored service node state matches the current chain, regenerating state");
+          return false;
+        }
+        auto last = std::prev(m_transient.state_history.end());
+        m_state = *last;
+        m_transient.state_history.erase(last);
+      }
+      m_transient.stored_short_term_top = m_state.height;
+
+      // NOTE: Long term state archive
+      db.for_each_service_node_state(kind::long_term, 0, false /*reverse*/, [&](uint64_t height, std::string_view blob) {
+        if (height > m_state.height)
+          return false;
+        bytes_loaded += blob.size();
+        state_serialized entry = {};
+        serialization::parse_binary(blob, entry);
+        m_transient.state_archive.emplace_hint(m_transient.state_archive.end(), this, std::move(entry));
+        return true;
+      });
+      if (!m_transient.state_archive.empty())
+        m_transient.stored_long_term_top = m_transient.state_archive.rbegin()->height;
+
+      // NOTE: Quorum history
+      if (m_store_quorum_history)
+      {
+        uint64_t const hist_state_from_height = current_height > m_store_quorum_history ? current_height - m_store_quorum_history : 0;
+        db.for_each_service_node_state(kind::quorums, hist_state_from_height, false /*reverse*/, [&](uint64_t height, std::string_view blob) {
+          bytes_loaded += blob.size();
+          quorum_for_serialization entry = {};
+          serialization::parse_binary(blob, entry);
+          m_transient.old_quorum_states.emplace_back(height, quorum_for_serialization_to_quorum_manager(entry));
+          return true;
+        });
+        if (!m_transient.old_quorum_states.empty())
+          m_transient.stored_quorums_top = m_transient.old_quorum_states.back().height;
+      }
+    }
+    catch (const std::exception& e)
+    {
+      LOG_ERROR("Failed to load service node states: " << e.what());
+      return false;
+    }
+    return true;
+  }
+
+  bool service_node_list::load(const uint64_t current_height)
+  {
+    LOG_PRINT_L1("service_node_list::load()");
+    reset(false);
+    if (!m_blockchain.has_db())
+    {
+      return false;
+    }
+
+    uint64_t bytes_loaded = 0;
+    auto &db = m_blockchain.get_db();
+    cryptonote::db_rtxn_guard txn_guard{db};
+
+    // NOTE: Databases written by older versions only have the two whole-history blobs; the first
+    // store() after loading those converts them to per-height records.
+    bool have_state_records = false;
+    db.for_each_service_node_state(cryptonote::service_node_state_kind::short_term, 0, false /*reverse*/, [&have_state_records](uint64_t, std::string_view) {
+      have_state_records = true;
+      return false;
+    });
+
+    if (have_state_records ? !load_state_records(db, current_height, bytes_loaded)
+                           : !load_legacy_data(db, current_height, bytes_loaded))
+      return false;
 
     // NOTE: Load uptime proof data
     proofs = db.get_all_service_node_proofs();
@@ -28,8 +28,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
 #include <string_view>
 #include "serialization/serialization.h"
@@ -38,6 +40,7 @@
 #include "cryptonote_core/service_node_voting.h"
 #include "cryptonote_core/service_node_quorum_cop.h"
 #include "common/util.h"
+#include "common/persistent_map.h"
 
 namespace cryptonote
 {
@@ -367,7 +370,9 @@ namespace service_nodes
   };
 
   using pubkey_and_sninfo     =          std::pair<crypto::public_key, std::shared_ptr<const service_node_info>>;
-  using service_nodes_infos_t = std::unordered_map<crypto::public_key, std::shared_ptr<const service_node_info>>;
+  // Copy-on-write map: every state_t in the history holds its own copy, but copies share all the
+  // shards that were not modified between them.
+  using service_nodes_infos_t = tools::persistent_map<crypto::public_key, std::shared_ptr<const service_node_info>>;
 
   struct service_node_pubkey_info
   {
@@ -492,6 +497,11 @@ namespace service_nodes
         f(it->second);
     }
 
+    /// Returns a counter that is incremented whenever any proof-derived value (uptime proofs,
+    /// reachability reports, participation records) changes; used by callers that cache values
+    /// extracted via access_proof() to tell whether they are out of date.
+    uint64_t proof_generation() const { return m_proof_generation; }
+
     /// Returns the (monero curve) pubkey associated with a x25519 pubkey.  Returns a null public
     /// key if not found.  (Note: this is just looking up the association, not derivation).
     crypto::public_key get_pubkey_from_x25519(const crypto::x25519_public_key &x25519) const;
@@ -672,6 +682,39 @@ namespace service_nodes
       END_SERIALIZE()
     };
 
+    // One short term state_t as stored in the per-height state table: either a full checkpoint
+    // (base_height == height) or just the nodes added, changed and removed since the state at
+    // base_height, which is always the preceding short term record.
+    struct state_delta_serialized
+    {
+      enum struct version_t : uint8_t { version_0, count, };
+      static version_t get_version(uint8_t /*hf_version*/) { return version_t::version_0; }
+
+      version_t                              version;
+      uint64_t                               height;
+      uint64_t                               base_height;
+      crypto::hash                           block_hash;
+      std::vector<service_node_pubkey_info>  infos;
+      std::vector<crypto::public_key>        removed;
+      std::vector<key_image_blacklist_entry> key_image_blacklist;
+      quorum_for_serialization               quorums;
+      bool                                   only_stored_quorums;
+
+      bool is_checkpoint() const { return base_height == height; }
+
+      BEGIN_SERIALIZE()
+        ENUM_FIELD(version, version < version_t::count)
+        VARINT_FIELD(height)
+        VARINT_FIELD(base_height)
+        FIELD(block_hash)
+        FIELD(infos)
+        FIELD(removed)
+        FIELD(key_image_blacklist)
+        FIELD(quorums)
+        FIELD(only_stored_quorums)
+      END_SERIALIZE()
+    };
+
     struct state_t;
     using state_set = std::set<state_t, std::less<>>;
     using block_height = uint64_t;
@@ -687,6 +730,9 @@ namespace service_nodes
 
       state_t(service_node_list* snl) : sn_list{snl} {}
       state_t(service_node_list* snl, state_serialized &&state);
+      // Rebuilds a state from a short term record; `base` must be the state at delta.base_height
+      // (and is ignored if the record is a checkpoint).
+      state_t(service_node_list* snl, state_delta_serialized &&delta, state_t const *base);
 
       friend bool operator<(const state_t &a, const state_t &b) { return a.height < b.height; }
       friend bool operator<(const state_t &s, block_height h)   { return s.height < h; }
@@ -721,6 +767,10 @@ namespace service_nodes
       bool process_key_image_unlock_tx(cryptonote::network_type nettype, uint64_t block_height, const cryptonote::transaction &tx);
       payout get_block_leader() const;
       payout get_block_producer(uint8_t pulse_round) const;
+
+    private:
+      // Upgrades a deserialized node to the current service_node_info version and inserts it
+      void add_loaded_info(service_node_pubkey_info &&pubkey_info);
     };
 
     // Can be set to true (via --dev-allow-local-ips) for debugging a new testnet on a local private network.
@@ -728,7 +778,9 @@ namespace service_nodes
     void record_timestamp_participation(crypto::public_key const &pubkey, bool participated);
     void record_timesync_status(crypto::public_key const &pubkey, bool synced);
 
+#ifndef IN_UNIT_TESTS
   private:
+#endif
     // Note(maxim): private methods don't have to be protected the mutex
     bool m_rescanning = false; /* set to true when doing a rescan so we know not to reset proofs */
     void process_block(const cryptonote::block& block, const std::vector<cryptonote::transaction>& txs);
@@ -739,6 +791,8 @@ namespace service_nodes
 
     void reset(bool delete_db_entry = false);
     bool load(uint64_t current_height);
+    bool load_state_records(cryptonote::BlockchainDB &db, uint64_t current_height, uint64_t &bytes_loaded);
+    bool load_legacy_data(cryptonote::BlockchainDB &db, uint64_t current_height, uint64_t &bytes_loaded);
 
     mutable std::recursive_mutex  m_sn_mutex;
     cryptonote::Blockchain&       m_blockchain;
@@ -750,6 +804,7 @@ namespace service_nodes
     std::unordered_map<crypto::x25519_public_key, std::pair<crypto::public_key, time_t>> x25519_to_pub;
     std::chrono::system_clock::time_point x25519_map_last_pruned = std::chrono::system_clock::from_time_t(0);
     std::unordered_map<crypto::public_key, proof_info> proofs;
+    std::atomic<uint64_t> m_proof_generation{0};
 
     struct quorums_by_height
     {
@@ -765,10 +820,10 @@ namespace service_nodes
       state_set                                 state_history; // Store state_t's from MIN(2nd oldest checkpoint | height - DEFAULT_SHORT_TERM_STATE_HISTORY) up to the block height
       state_set                                 state_archive; // Store state_t's where ((height < m_state_history.first()) && (height % STORE_LONG_TERM_STATE_INTERVAL))
       std::unordered_map<crypto::hash, state_t> alt_state;
-      bool                                      state_added_to_archive;
-      data_for_serialization                    cache_long_term_data;
-      data_for_serialization                    cache_short_term_data;
-      std::string                               cache_data_blob;
+      std::optional<uint64_t>                   stored_short_term_top; // Highest state/archive/quorum heights already written to the db; unset
+      std::optional<uint64_t>                   stored_long_term_top;  // until the first store() after a reset or a load from the old blobs
+      std::optional<uint64_t>                   stored_quorums_top;
+      std::vector<uint64_t>                     stored_checkpoints;    // Heights of the full short term records in the db, ascending
     } m_transient = {};
 
     state_t m_state; // NOTE: Not in m_transient due to the non-trivial constructor. We can't blanket initialise using = {}; needs to be reset in ::reset(...) manually
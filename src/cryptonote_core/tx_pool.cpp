@@ -30,6 +30,7 @@
 // Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
 
 #include <algorithm>
+#include <optional>
 #include <unordered_set>
 #include <vector>
 
@@ -69,6 +70,7 @@ namespace cryptonote
     time_t const MIN_RELAY_TIME = (60 * 5); // only start re-relaying transactions after that many seconds
     time_t const MAX_RELAY_TIME = (60 * 60 * 4); // at most that many seconds between resends
     float const ACCEPT_THRESHOLD = 1.0f;
+    size_t const MAX_PARSED_TX_CACHE_SIZE = 5000; // max number of parsed pool txes kept in memory
 
     // a kind of increasing backoff within min/max bounds
     uint64_t get_relay_delay(time_t now, time_t received)
@@ -388,13 +390,14 @@ namespace cryptonote
         memset(meta.padding, 0, sizeof(meta.padding));
         try
         {
-          m_parsed_tx_cache.insert(std::make_pair(id, tx));
+          if (m_parsed_tx_cache.size() < MAX_PARSED_TX_CACHE_SIZE)
+            m_parsed_tx_cache.insert(std::make_pair(id, tx));
           std::unique_lock b_lock{m_blockchain};
           LockedTXN lock(m_blockchain);
           m_blockchain.add_txpool_tx(id, blob, meta);
           if (!insert_key_images(tx, id, opts.kept_by_block))
             return false;
-          m_txs_by_fee_and_receive_time.emplace(std::tuple<bool, double, std::time_t>(non_standard_tx, fee / (double)(tx_weight ? tx_weight : 1), receive_time), id);
+          add_to_sorted_container(non_standard_tx, id, meta);
           lock.commit();
         }
         catch (const std::exception &e)
@@ -432,7 +435,7 @@ namespace cryptonote
 
       try
       {
-        if (opts.kept_by_block)
+        if (opts.kept_by_block && m_parsed_tx_cache.size() < MAX_PARSED_TX_CACHE_SIZE)
           m_parsed_tx_cache.insert(std::make_pair(id, tx));
         std::unique_lock b_lock{m_blockchain};
         LockedTXN lock(m_blockchain);
@@ -440,7 +443,7 @@ namespace cryptonote
         m_blockchain.add_txpool_tx(id, blob, meta);
         if (!insert_key_images(tx, id, opts.kept_by_block))
           return false;
-        m_txs_by_fee_and_receive_time.emplace(std::tuple<bool, double, std::time_t>(non_standard_tx, fee / (double)(tx_weight ? tx_weight : 1), receive_time), id);
+        add_to_sorted_container(non_standard_tx, id, meta);
         lock.commit();
       }
       catch (const std::exception &e)
@@ -732,7 +735,7 @@ namespace cryptonote
     txpool_tx_meta_t lookup_meta;
     if (!meta)
     {
-      if (m_blockchain.get_txpool_tx_meta(txid, lookup_meta))
+      if (get_tx_meta(txid, lookup_meta))
         meta = &lookup_meta;
       else
       {
@@ -747,7 +750,7 @@ namespace cryptonote
     m_blockchain.remove_txpool_tx(txid);
     m_txpool_weight -= meta->weight;
     remove_transaction_keyimages(tx, txid);
-    m_txs_by_fee_and_receive_time.erase(it);
+    remove_from_sorted_container(it);
 
     return true;
   }
@@ -768,7 +771,7 @@ namespace cryptonote
       {
         const crypto::hash &txid = it->second;
         txpool_tx_meta_t meta;
-        if (!m_blockchain.get_txpool_tx_meta(txid, meta))
+        if (!get_tx_meta(txid, meta))
         {
           MERROR("Failed to find tx in txpool");
           return false;
@@ -883,7 +886,7 @@ namespace cryptonote
     {
       LockedTXN lock(m_blockchain);
       txpool_tx_meta_t meta;
-      if (!m_blockchain.get_txpool_tx_meta(id, meta))
+      if (!get_tx_meta(id, meta))
       {
         MERROR("Failed to find tx in txpool");
         return false;
@@ -922,7 +925,7 @@ namespace cryptonote
     }
 
     if (sorted_it != m_txs_by_fee_and_receive_time.end())
-      m_txs_by_fee_and_receive_time.erase(sorted_it);
+      remove_from_sorted_container(sorted_it);
     ++m_cookie;
     return true;
   }
@@ -941,11 +944,83 @@ namespace cryptonote
   //---------------------------------------------------------------------------------
   sorted_tx_container::iterator tx_memory_pool::find_tx_in_sorted_container(const crypto::hash& id) const
   {
-    return std::find_if( m_txs_by_fee_and_receive_time.begin(), m_txs_by_fee_and_receive_time.end()
-                       , [&](const sorted_tx_container::value_type& a){
-                         return a.second == id;
-                       }
-    );
+    auto it = m_pool_tx_info.find(id);
+    if (it == m_pool_tx_info.end())
+      return m_txs_by_fee_and_receive_time.end();
+    return it->second.sorted_it;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::add_to_sorted_container(bool non_standard, const crypto::hash& id, const txpool_tx_meta_t& meta)
+  {
+    const double fee_per_weight = meta.fee / (double)(meta.weight ? meta.weight : 1);
+    auto sorted_it = m_txs_by_fee_and_receive_time.emplace(std::tuple<bool, double, std::time_t>(non_standard, fee_per_weight, meta.receive_time), id).first;
+    auto [info_it, inserted] = m_pool_tx_info.emplace(id, pool_tx_info{sorted_it, meta});
+    if (m_block_template.valid)
+      m_block_template.added.push_back(id);
+    if (inserted && m_short_tx_id_salt)
+      m_short_tx_ids.emplace(get_short_tx_id(m_short_tx_id_salt, id), id);
+    if (!inserted)
+    {
+      if (meta.double_spend_seen && m_block_template.valid && m_block_template.selected.count(id))
+        m_block_template.valid = false;
+      // Replacing an existing entry (e.g. a tx re-added with updated metadata)
+      if (info_it->second.sorted_it != sorted_it)
+        m_txs_by_fee_and_receive_time.erase(info_it->second.sorted_it);
+      info_it->second = {sorted_it, meta};
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::remove_from_sorted_container(sorted_tx_container::iterator it)
+  {
+    if (m_block_template.valid && m_block_template.selected.count(it->second))
+      m_block_template.valid = false;
+    if (m_short_tx_id_salt)
+    {
+      auto range = m_short_tx_ids.equal_range(get_short_tx_id(m_short_tx_id_salt, it->second));
+      for (auto sit = range.first; sit != range.second; ++sit)
+      {
+        if (sit->second == it->second)
+        {
+          m_short_tx_ids.erase(sit);
+          break;
+        }
+      }
+    }
+    m_pool_tx_info.erase(it->second);
+    m_parsed_tx_cache.erase(it->second);
+    m_txs_by_fee_and_receive_time.erase(it);
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::set_short_tx_id_salt(const crypto::hash& salt)
+  {
+    if (salt == m_short_tx_id_salt)
+      return;
+    m_short_tx_id_salt = salt;
+    m_short_tx_ids.clear();
+    m_short_tx_ids.reserve(m_pool_tx_info.size());
+    for (const auto& [txid, info] : m_pool_tx_info)
+      m_short_tx_ids.emplace(get_short_tx_id(salt, txid), txid);
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::get_tx_meta(const crypto::hash& txid, txpool_tx_meta_t& meta) const
+  {
+    if (auto it = m_pool_tx_info.find(txid); it != m_pool_tx_info.end())
+    {
+      meta = it->second.meta;
+      return true;
+    }
+    return m_blockchain.get_txpool_tx_meta(txid, meta);
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::update_tx_meta(const crypto::hash& txid, const txpool_tx_meta_t& meta)
+  {
+    m_blockchain.update_txpool_tx(txid, meta);
+    if (auto it = m_pool_tx_info.find(txid); it != m_pool_tx_info.end())
+      it->second.meta = meta;
+    // A template tx that now conflicts with something else could be the invalid spend: have the
+    // next refresh recheck every tx from scratch rather than keep it.
+    if (meta.double_spend_seen && m_block_template.valid && m_block_template.selected.count(txid))
+      m_block_template.valid = false;
   }
   //---------------------------------------------------------------------------------
   //TODO: investigate whether boolean return is appropriate
@@ -968,7 +1043,7 @@ namespace cryptonote
         }
         else
         {
-          m_txs_by_fee_and_receive_time.erase(sorted_it);
+          remove_from_sorted_container(sorted_it);
         }
         m_timed_out_transactions.insert(txid);
         remove.push_back(std::make_pair(txid, meta.weight));
@@ -1074,10 +1149,10 @@ namespace cryptonote
     {
       try {
         txpool_tx_meta_t meta;
-        if (m_blockchain.get_txpool_tx_meta(tx, meta) && meta.do_not_relay)
+        if (get_tx_meta(tx, meta) && meta.do_not_relay)
         {
           meta.do_not_relay = false;
-          m_blockchain.update_txpool_tx(tx, meta);
+          update_tx_meta(tx, meta);
           ++updated;
         }
       } catch (const std::exception &e) {
@@ -1100,11 +1175,11 @@ namespace cryptonote
       try
       {
         txpool_tx_meta_t meta;
-        if (m_blockchain.get_txpool_tx_meta(tx.first, meta))
+        if (get_tx_meta(tx.first, meta))
         {
           meta.relayed = true;
           meta.last_relayed_time = now;
-          m_blockchain.update_txpool_tx(tx.first, meta);
+          update_tx_meta(tx.first, meta);
         }
       }
       catch (const std::exception &e)
@@ -1308,7 +1383,7 @@ namespace cryptonote
         {
           try
           {
-            if (!m_blockchain.get_txpool_tx_meta(tx_id_hash, meta))
+            if (!get_tx_meta(tx_id_hash, meta))
             {
               MERROR("Failed to get tx meta from txpool");
               return false;
@@ -1383,6 +1458,10 @@ namespace cryptonote
     std::unique_lock lock{m_transactions_lock};
     m_input_cache.clear();
     m_parsed_tx_cache.clear();
+    m_block_template = {};
+    // Compact blocks on top of this one will be salted with its hash, so get the index ready now
+    // rather than when the next block arrives.
+    set_short_tx_id_salt(get_block_hash(blk));
 
     std::vector<transaction> pool_txs;
     get_transactions(pool_txs);
@@ -1430,7 +1509,7 @@ namespace cryptonote
           }
 
           txpool_tx_meta_t meta;
-          if (!m_blockchain.get_txpool_tx_meta(tx_hash, meta))
+          if (!get_tx_meta(tx_hash, meta))
           {
             MERROR("Failed to get tx meta from txpool to check if we can prune a state change");
             continue;
@@ -1462,6 +1541,8 @@ namespace cryptonote
     std::unique_lock lock{m_transactions_lock};
     m_input_cache.clear();
     m_parsed_tx_cache.clear();
+    m_block_template = {};
+    set_short_tx_id_salt(m_blockchain.get_tail_id());
     return true;
   }
   //------------------------------------------------------------------
@@ -1477,6 +1558,21 @@ namespace cryptonote
     return result;
   }
   //---------------------------------------------------------------------------------
+  std::vector<crypto::hash> tx_memory_pool::find_short_tx_ids(const crypto::hash &salt, const std::vector<uint64_t> &short_ids) const
+  {
+    std::vector<crypto::hash> result(short_ids.size(), crypto::null_hash);
+    std::unique_lock lock{m_transactions_lock};
+    if (salt != m_short_tx_id_salt)
+      return result;
+    for (size_t i = 0; i < short_ids.size(); i++)
+    {
+      auto range = m_short_tx_ids.equal_range(short_ids[i]);
+      if (range.first != range.second && std::next(range.first) == range.second)
+        result[i] = range.first->second;
+    }
+    return result;
+  }
+  //---------------------------------------------------------------------------------
   bool tx_memory_pool::have_tx(const crypto::hash &id) const
   {
     return have_txs({{id}})[0];
@@ -1609,11 +1705,11 @@ end:
     return ret;
   }
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::is_transaction_ready_to_go(txpool_tx_meta_t& txd, const crypto::hash &txid, const cryptonote::blobdata &txblob, transaction &tx) const
+  bool tx_memory_pool::is_transaction_ready_to_go(txpool_tx_meta_t& txd, const crypto::hash &txid, const cryptonote::blobdata &txblob, transaction &tx, bool tx_parsed) const
   {
     struct transction_parser
     {
-      transction_parser(const cryptonote::blobdata &txblob, const crypto::hash &txid, transaction &tx): txblob(txblob), txid(txid), tx(tx), parsed(false) {}
+      transction_parser(const cryptonote::blobdata &txblob, const crypto::hash &txid, transaction &tx, bool parsed): txblob(txblob), txid(txid), tx(tx), parsed(parsed) {}
       cryptonote::transaction &operator()()
       {
         if (!parsed)
@@ -1629,7 +1725,7 @@ end:
       const crypto::hash &txid;
       transaction &tx;
       bool parsed;
-    } lazy_tx(txblob, txid, tx);
+    } lazy_tx(txblob, txid, tx, tx_parsed);
 
     //not the best implementation at this time, sorry :(
     //check is ring_signature already checked ?
@@ -1730,7 +1826,7 @@ end:
         for (const crypto::hash &txid: it->second)
         {
           txpool_tx_meta_t meta;
-          if (!m_blockchain.get_txpool_tx_meta(txid, meta))
+          if (!get_tx_meta(txid, meta))
           {
             MERROR("Failed to find tx meta in txpool");
             // continue, not fatal
@@ -1743,7 +1839,7 @@ end:
             changed = true;
             try
             {
-              m_blockchain.update_txpool_tx(txid, meta);
+              update_tx_meta(txid, meta);
             }
             catch (const std::exception &e)
             {
@@ -1764,66 +1860,80 @@ end:
   {
     auto locks = tools::unique_locks(m_transactions_lock, m_blockchain);
 
-    total_weight         = 0;
-    raw_fee              = 0;
-    uint64_t best_reward = 0;
+    size_t const max_total_weight = 2 * median_weight - CRYPTONOTE_COINBASE_BLOB_RESERVED_SIZE;
+    auto &tmpl = m_block_template;
+
+    // If the last template was built on the same chain tip with the same parameters we only need
+    // to consider the txes that arrived since then, as long as the template never got into the
+    // large block penalty zone: in that case the greedy selection below takes every ready,
+    // non-conflicting tx and the order they arrive in doesn't matter.
+    const bool incremental = tmpl.valid && !tmpl.saturated
+      && tmpl.prev_id == bl.prev_id && tmpl.height == height && tmpl.median_weight == median_weight
+      && tmpl.already_generated_coins == already_generated_coins && tmpl.version == version;
+
+    if (!incremental)
     {
+      tmpl = {};
+      tmpl.prev_id = bl.prev_id;
+      tmpl.height = height;
+      tmpl.median_weight = median_weight;
+      tmpl.already_generated_coins = already_generated_coins;
+      tmpl.version = version;
+
       // NOTE: Calculate base line empty block reward
       oxen_block_reward_context block_reward_context = {};
       block_reward_context.height                    = height;
 
       block_reward_parts reward_parts = {};
-      if (!get_oxen_block_reward(median_weight, total_weight, already_generated_coins, version, reward_parts, block_reward_context))
+      if (!get_oxen_block_reward(median_weight, 0, already_generated_coins, version, reward_parts, block_reward_context))
       {
         MERROR("Failed to get block reward for empty block");
         return false;
       }
 
-      best_reward = version >= cryptonote::network_version_16_pulse ? 0 /*Empty block, starts with 0 fee*/ : reward_parts.base_miner;
+      tmpl.best_reward = version >= cryptonote::network_version_16_pulse ? 0 /*Empty block, starts with 0 fee*/ : reward_parts.base_miner;
     }
 
-    size_t const max_total_weight = 2 * median_weight - CRYPTONOTE_COINBASE_BLOB_RESERVED_SIZE;
-    std::unordered_set<crypto::key_image> k_images;
-
-    LOG_PRINT_L2("Filling block template, median weight " << median_weight << ", " << m_txs_by_fee_and_receive_time.size() << " txes in the pool");
-
-    LockedTXN lock(m_blockchain);
-
-    uint64_t next_reward = 0;
-    uint64_t net_fee     = 0;
+    // Only opened if we actually need to write back updated metadata; everything else here comes
+    // from the in-memory metadata mirror and parsed tx cache.
+    std::optional<LockedTXN> lock;
 
-    for (auto sorted_it : m_txs_by_fee_and_receive_time)
-    {
-      txpool_tx_meta_t meta;
-      if (!m_blockchain.get_txpool_tx_meta(sorted_it.second, meta))
+    // Considers adding a tx to the template.  Returns false if the tx can't be added because of
+    // block weight limits or a key image conflict with an already selected tx (i.e. a case where a
+    // full rebuild could select differently).
+    auto consider = [&](const crypto::hash &txid) -> bool {
+      auto info_it = m_pool_tx_info.find(txid);
+      if (info_it == m_pool_tx_info.end())
       {
         MERROR("  failed to find tx meta");
-        continue;
+        return true;
       }
-      LOG_PRINT_L2("Considering " << sorted_it.second << ", weight " << meta.weight << ", current block weight " << total_weight << "/" << max_total_weight << ", current reward " << print_money(best_reward));
+      txpool_tx_meta_t meta = info_it->second.meta;
+      LOG_PRINT_L2("Considering " << txid << ", weight " << meta.weight << ", current block weight " << tmpl.total_weight << "/" << max_total_weight << ", current reward " << print_money(tmpl.best_reward));
 
       // Can not exceed maximum block weight
-      if (max_total_weight < total_weight + meta.weight)
+      if (max_total_weight < tmpl.total_weight + meta.weight)
       {
         LOG_PRINT_L2("  would exceed maximum block weight");
-        continue;
+        return false;
       }
 
       // NOTE: Calculate the next block reward for the block producer
       oxen_block_reward_context next_block_reward_context = {};
       next_block_reward_context.height                    = height;
-      next_block_reward_context.fee                       = raw_fee + meta.fee;
+      next_block_reward_context.fee                       = tmpl.raw_fee + meta.fee;
 
       block_reward_parts next_reward_parts           = {};
-      if(!get_oxen_block_reward(median_weight, total_weight + meta.weight, already_generated_coins, version, next_reward_parts, next_block_reward_context))
+      if(!get_oxen_block_reward(median_weight, tmpl.total_weight + meta.weight, already_generated_coins, version, next_reward_parts, next_block_reward_context))
       {
         LOG_PRINT_L2("Block reward calculation bug");
-        return false;
+        throw std::runtime_error{"block reward calculation failed"};
       }
 
       // NOTE: Use the net fee for comparison (after penalty is applied).
       // After HF16, penalty is applied on the miner fee. Before, penalty is
       // applied on the base reward.
+      uint64_t next_reward;
       if (version >= cryptonote::network_version_16_pulse)
       {
         next_reward = next_reward_parts.miner_fee;
@@ -1831,18 +1941,23 @@ end:
       else
       {
         next_reward = next_reward_parts.base_miner + next_reward_parts.miner_fee;
-        assert(next_reward_parts.miner_fee == raw_fee + meta.fee);
+        assert(next_reward_parts.miner_fee == tmpl.raw_fee + meta.fee);
       }
 
       // If we're getting lower reward tx, don't include this TX
-      if (next_reward < best_reward)
+      if (next_reward < tmpl.best_reward)
       {
         LOG_PRINT_L2("  would decrease reward to " << print_money(next_reward));
-        continue;
+        return false;
       }
 
-      cryptonote::blobdata txblob = m_blockchain.get_txpool_tx_blob(sorted_it.second);
-      cryptonote::transaction tx;
+      cryptonote::blobdata txblob;
+      cryptonote::transaction parsed_tx;
+      auto cached = m_parsed_tx_cache.find(txid);
+      const bool tx_parsed = cached != m_parsed_tx_cache.end();
+      cryptonote::transaction &tx = tx_parsed ? cached->second : parsed_tx;
+      if (!tx_parsed)
+        txblob = m_blockchain.get_txpool_tx_blob(txid);
 
       // Skip transactions that are not ready to be
       // included into the blockchain or that are
@@ -1851,7 +1966,7 @@ end:
       bool ready = false;
       try
       {
-        ready = is_transaction_ready_to_go(meta, sorted_it.second, txblob, tx);
+        ready = is_transaction_ready_to_go(meta, txid, txblob, tx, tx_parsed);
       }
       catch (const std::exception &e)
       {
@@ -1862,7 +1977,9 @@ end:
       {
         try
         {
-          m_blockchain.update_txpool_tx(sorted_it.second, meta);
+          if (!lock)
+            lock.emplace(m_blockchain);
+          update_tx_meta(txid, meta);
         }
         catch (const std::exception &e)
         {
@@ -1873,28 +1990,90 @@ end:
       if (!ready)
       {
         LOG_PRINT_L2("  not ready to go");
-        continue;
+        return true;
       }
-      if (have_key_images(k_images, tx))
+      if (have_key_images(tmpl.key_images, tx))
       {
         LOG_PRINT_L2("  key images already seen");
-        continue;
+        return false;
       }
 
-      bl.tx_hashes.push_back(sorted_it.second);
-      total_weight += meta.weight;
-      raw_fee      += meta.fee;
-      net_fee       = next_reward_parts.miner_fee;
-      best_reward   = next_reward;
-      append_key_images(k_images, tx);
-      LOG_PRINT_L2("  added, new block weight " << total_weight << "/" << max_total_weight << ", reward " << print_money(best_reward));
-    }
-    lock.commit();
+      tmpl.tx_hashes.push_back(txid);
+      tmpl.selected.insert(txid);
+      tmpl.total_weight += meta.weight;
+      tmpl.raw_fee      += meta.fee;
+      tmpl.net_fee       = next_reward_parts.miner_fee;
+      tmpl.best_reward   = next_reward;
+      append_key_images(tmpl.key_images, tx);
+      LOG_PRINT_L2("  added, new block weight " << tmpl.total_weight << "/" << max_total_weight << ", reward " << print_money(tmpl.best_reward));
 
-    expected_reward = best_reward;
+      // A ready tx has been fully parsed, so keep it around for the next template refresh
+      if (!tx_parsed && m_parsed_tx_cache.size() < MAX_PARSED_TX_CACHE_SIZE)
+        m_parsed_tx_cache.emplace(txid, std::move(parsed_tx));
+      return true;
+    };
+
+    try
+    {
+      if (incremental)
+      {
+        LOG_PRINT_L2("Updating block template with " << tmpl.added.size() << " new txes, median weight " << median_weight);
+        auto added = std::move(tmpl.added);
+        tmpl.added.clear();
+        for (const auto &txid : added)
+        {
+          if (tmpl.selected.count(txid))
+            continue;
+          // Txes that arrived and then left the pool again (mined, pruned, ...) since the last
+          // refresh are still listed here; there's nothing to consider for those.
+          auto info_it = m_pool_tx_info.find(txid);
+          if (info_it == m_pool_tx_info.end())
+            continue;
+          // Anything that would push us into the penalty zone (or conflicts) needs a full,
+          // fee-ordered rebuild instead.
+          if (tmpl.total_weight + info_it->second.meta.weight > median_weight || !consider(txid))
+          {
+            MDEBUG("Incremental block template update not possible, rebuilding");
+            tmpl.valid = false;
+            if (lock)
+              lock->commit();
+            lock.reset();
+            return fill_block_template(bl, median_weight, already_generated_coins, total_weight, raw_fee, expected_reward, version, height);
+          }
+        }
+      }
+      else
+      {
+        LOG_PRINT_L2("Filling block template, median weight " << median_weight << ", " << m_txs_by_fee_and_receive_time.size() << " txes in the pool");
+        for (auto const &sorted_it : m_txs_by_fee_and_receive_time)
+        {
+          if (!consider(sorted_it.second))
+            tmpl.saturated = true;
+        }
+      }
+    }
+    catch (const std::exception &e)
+    {
+      MERROR("Failed to fill block template: " << e.what());
+      tmpl.valid = false;
+      return false;
+    }
+    if (lock)
+      lock->commit();
+
+    // Anything beyond the median means there's a penalty in play, so the selection depends on the
+    // order txes are considered in and we can't update incrementally.
+    if (tmpl.total_weight > median_weight)
+      tmpl.saturated = true;
+    tmpl.valid = true;
+
+    bl.tx_hashes = tmpl.tx_hashes;
+    total_weight = tmpl.total_weight;
+    raw_fee = tmpl.raw_fee;
+    expected_reward = tmpl.best_reward;
     LOG_PRINT_L2("Block template filled with " << bl.tx_hashes.size() << " txes, weight "
-        << total_weight << "/" << max_total_weight << ", reward " << print_money(best_reward)
-        << " (including " << print_money(net_fee) << " in fees)");
+        << total_weight << "/" << max_total_weight << ", reward " << print_money(expected_reward)
+        << " (including " << print_money(tmpl.net_fee) << " in fees)");
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -1945,7 +2124,7 @@ end:
           }
           else
           {
-            m_txs_by_fee_and_receive_time.erase(sorted_it);
+            remove_from_sorted_container(sorted_it);
           }
           ++n_removed;
         }
@@ -1968,6 +2147,10 @@ end:
 
     m_txpool_max_weight = max_txpool_weight ? max_txpool_weight : DEFAULT_TXPOOL_MAX_WEIGHT;
     m_txs_by_fee_and_receive_time.clear();
+    m_pool_tx_info.clear();
+    m_short_tx_ids.clear();
+    m_short_tx_id_salt = crypto::null_hash;
+    m_block_template = {};
     m_spent_key_images.clear();
     m_txpool_weight = 0;
     std::vector<crypto::hash> remove;
@@ -1994,7 +2177,7 @@ end:
         }
 
         const bool non_standard_tx = !tx.is_transfer();
-        m_txs_by_fee_and_receive_time.emplace(std::tuple<bool, double, time_t>(non_standard_tx, meta.fee / (double)meta.weight, meta.receive_time), txid);
+        add_to_sorted_container(non_standard_tx, txid, meta);
         m_txpool_weight += meta.weight;
         return true;
       }, true);
@@ -2019,6 +2202,7 @@ end:
       lock.commit();
     }
 
+    set_short_tx_id_salt(m_blockchain.get_tail_id());
     m_cookie = 0;
 
     // Ignore deserialization error
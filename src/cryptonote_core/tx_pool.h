@@ -290,6 +290,21 @@ namespace cryptonote
      */
     std::vector<uint8_t> have_txs(const std::vector<crypto::hash> &hashes) const;
 
+    /**
+     * @brief resolves compact block short tx ids (see get_short_tx_id) against the pool
+     *
+     * The index is only kept for the current chain tip, so nothing resolves for any other salt; in
+     * particular a peer-chosen salt never causes the index to be rebuilt.
+     *
+     * @param salt the short id salt, i.e. the hash of the compact block's previous block
+     * @param short_ids the short ids to look up
+     *
+     * @return vector of the same size as `short_ids` containing the txid of the pool tx with each
+     * short id, or null_hash if there is no such tx, if more than one pool tx has that short id, or
+     * if `salt` isn't the current chain tip.
+     */
+    std::vector<crypto::hash> find_short_tx_ids(const crypto::hash &salt, const std::vector<uint64_t> &short_ids) const;
+
     /**
      * @brief action to take when notified of a block added to the blockchain
      *
@@ -388,6 +403,10 @@ namespace cryptonote
      * @param expected_reward return-by-reference the total reward awarded to the block producer finding this block, including transaction fees and, if applicable, a large block reward penalty.
      * @param version hard fork version to use for consensus rules
      *
+     * The selection is cached: if called again for the same chain tip and parameters, only the
+     * txes added to the pool since the last call are considered (unless the cached template was
+     * limited by block weight, in which case it is rebuilt from scratch).
+     *
      * @return true
      */
     bool fill_block_template(block &bl, size_t median_weight, uint64_t already_generated_coins, size_t &total_weight, uint64_t &raw_fee, uint64_t &expected_reward, uint8_t version, uint64_t height);
@@ -546,7 +565,9 @@ namespace cryptonote
      */
     void set_txpool_max_weight(size_t bytes);
 
+#ifndef IN_UNIT_TESTS
   private:
+#endif
 
     /**
      * @brief insert key images into m_spent_key_images
@@ -617,12 +638,13 @@ namespace cryptonote
      *
      * @param txd the transaction to check (and info about it)
      * @param txid the txid of the transaction to check
-     * @param txblob the transaction blob to check
+     * @param txblob the transaction blob to check; unused if tx_parsed is true
      * @param tx the parsed transaction, if successful
+     * @param tx_parsed true if tx already contains the parsed transaction
      *
      * @return true if the transaction is good to go, otherwise false
      */
-    bool is_transaction_ready_to_go(txpool_tx_meta_t& txd, const crypto::hash &txid, const cryptonote::blobdata &txblob, transaction&tx) const;
+    bool is_transaction_ready_to_go(txpool_tx_meta_t& txd, const crypto::hash &txid, const cryptonote::blobdata &txblob, transaction&tx, bool tx_parsed = false) const;
 
     /**
      * @brief mark all transactions double spending the one passed
@@ -706,6 +728,27 @@ namespace cryptonote
     //!< container for transactions organized by fee per size and receive time
     sorted_tx_container m_txs_by_fee_and_receive_time;
 
+    //! in-memory state of a pool transaction
+    struct pool_tx_info
+    {
+      sorted_tx_container::iterator sorted_it; //!< the tx's entry in m_txs_by_fee_and_receive_time
+      txpool_tx_meta_t meta; //!< mirror of the tx's metadata; the database copy is only used for persistence
+    };
+
+    //! txid -> in-memory tx state, kept in sync by add_to_sorted_container() and
+    //! remove_from_sorted_container() so that lookups by txid don't need a linear scan (or, for
+    //! metadata, a database read).
+    std::unordered_map<crypto::hash, pool_tx_info> m_pool_tx_info;
+
+    //! short tx id -> txid of every pool tx, using m_short_tx_id_salt (the chain tip hash) as the
+    //! salt; rebuilt by set_short_tx_id_salt() when the chain tip changes, and kept in sync by
+    //! add_to_sorted_container() and remove_from_sorted_container() in between.
+    std::unordered_multimap<uint64_t, crypto::hash> m_short_tx_ids;
+    crypto::hash m_short_tx_id_salt = crypto::null_hash;
+
+    //! rebuilds m_short_tx_ids for the given salt, if not already using it
+    void set_short_tx_id_salt(const crypto::hash& salt);
+
     std::atomic<uint64_t> m_cookie; //!< incremented at each change
 
     /// Callbacks for new tx notifications
@@ -720,6 +763,37 @@ namespace cryptonote
      */
     sorted_tx_container::iterator find_tx_in_sorted_container(const crypto::hash& id) const;
 
+    /**
+     * @brief adds a transaction to the sorted container (and its txid index and metadata mirror),
+     * replacing any existing entry for the same txid.
+     *
+     * @param non_standard whether the tx is a non-standard (i.e. state change, etc.) tx
+     * @param id the tx hash
+     * @param meta the tx metadata; the fee, weight and receive time determine the sort position
+     */
+    void add_to_sorted_container(bool non_standard, const crypto::hash& id, const txpool_tx_meta_t& meta);
+
+    /**
+     * @brief removes an entry from the sorted container (and its txid index, metadata mirror and
+     * parsed tx cache)
+     *
+     * @param it an iterator to the entry to remove; must not be the end iterator
+     */
+    void remove_from_sorted_container(sorted_tx_container::iterator it);
+
+    /**
+     * @brief gets the metadata of a pool transaction, from the in-memory mirror if possible,
+     * falling back to the database otherwise.
+     *
+     * @return true if the tx was found
+     */
+    bool get_tx_meta(const crypto::hash& txid, txpool_tx_meta_t& meta) const;
+
+    /**
+     * @brief updates the metadata of a pool transaction in the database and the in-memory mirror
+     */
+    void update_tx_meta(const crypto::hash& txid, const txpool_tx_meta_t& meta);
+
     //! cache/call Blockchain::check_tx_inputs results
     bool check_tx_inputs(const std::function<cryptonote::transaction&()> &get_tx, const crypto::hash &txid, uint64_t &max_used_block_height, crypto::hash &max_used_block_id, tx_verification_context &tvc, bool kept_by_block = false, uint64_t* blink_rollback_height = nullptr) const;
 
@@ -736,6 +810,30 @@ namespace cryptonote
 
     mutable std::unordered_map<crypto::hash, std::tuple<bool, tx_verification_context, uint64_t, crypto::hash>> m_input_cache;
 
+    //! the last block template built by fill_block_template, kept so that subsequent calls on the
+    //! same chain tip only need to consider txes added since then.
+    struct block_template_state
+    {
+      bool valid = false; //!< false if the next fill_block_template needs a full rebuild
+      bool saturated = false; //!< true if weight limits/penalties/conflicts excluded some txes, so only a full rebuild is exact
+      crypto::hash prev_id = crypto::null_hash;
+      uint64_t height = 0;
+      size_t median_weight = 0;
+      uint64_t already_generated_coins = 0;
+      uint8_t version = 0;
+      std::vector<crypto::hash> tx_hashes; //!< selected txes, in selection order
+      std::unordered_set<crypto::hash> selected; //!< same as tx_hashes, for lookups
+      std::unordered_set<crypto::key_image> key_images; //!< key images spent by the selected txes
+      size_t total_weight = 0;
+      uint64_t raw_fee = 0;
+      uint64_t net_fee = 0;
+      uint64_t best_reward = 0;
+      std::vector<crypto::hash> added; //!< txes added to the pool since the template was built
+    };
+    block_template_state m_block_template;
+
+    //! parsed pool transactions, to avoid re-fetching and re-parsing them; cleared on every chain
+    //! change and bounded to MAX_PARSED_TX_CACHE_SIZE entries.
     std::unordered_map<crypto::hash, transaction> m_parsed_tx_cache;
 
     mutable std::shared_mutex m_blinks_mutex;
@@ -104,6 +104,15 @@ KV_SERIALIZE_MAP_CODE_BEGIN(NOTIFY_REQUEST_FLUFFY_MISSING_TX::request)
   KV_SERIALIZE_CONTAINER_POD_AS_BLOB(missing_tx_indices)
 KV_SERIALIZE_MAP_CODE_END()
 
+KV_SERIALIZE_MAP_CODE_BEGIN(NOTIFY_NEW_COMPACT_BLOCK::request)
+  KV_SERIALIZE_VAL_POD_AS_BLOB(block_hash)
+  KV_SERIALIZE(block)
+  KV_SERIALIZE_CONTAINER_POD_AS_BLOB(short_tx_ids)
+  KV_SERIALIZE_CONTAINER_POD_AS_BLOB(prefilled_indices)
+  KV_SERIALIZE(prefilled_txs)
+  KV_SERIALIZE(current_blockchain_height)
+KV_SERIALIZE_MAP_CODE_END()
+
 KV_SERIALIZE_MAP_CODE_BEGIN(NOTIFY_UPTIME_PROOF::request)
   KV_SERIALIZE_N(snode_version[0], "snode_version_major")
   KV_SERIALIZE_N(snode_version[1], "snode_version_minor")
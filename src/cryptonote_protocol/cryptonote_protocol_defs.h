@@ -242,6 +242,32 @@ namespace cryptonote
     };
   }; 
 
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // Compact version of NOTIFY_NEW_FLUFFY_BLOCK, only sent to peers with
+  // P2P_SUPPORT_FLAG_COMPACT_BLOCKS: instead of the full 32-byte hash of each of the block's txes
+  // it carries salted 8-byte short ids (see get_short_tx_id) that the receiver resolves from its
+  // mempool.  Txes the sender expects the receiver not to have are included directly.  Anything
+  // that can't be resolved is fetched with NOTIFY_REQUEST_FLUFFY_MISSING_TX, to which the reply is
+  // an ordinary NOTIFY_NEW_FLUFFY_BLOCK.
+  struct NOTIFY_NEW_COMPACT_BLOCK
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 17;
+
+    struct request
+    {
+      crypto::hash block_hash;
+      blobdata block;                          // The block, serialized with an empty tx_hashes
+      std::vector<uint64_t> short_tx_ids;      // Short id of each of the block's txes, in block order
+      std::vector<uint64_t> prefilled_indices; // Indices (into short_tx_ids) of the txes in prefilled_txs, ascending
+      std::vector<blobdata> prefilled_txs;
+      uint64_t current_blockchain_height;
+
+      KV_MAP_SERIALIZABLE
+    };
+  };
+
   /************************************************************************/
   /*                                                                      */
   /************************************************************************/
@@ -571,6 +571,19 @@ namespace cryptonote
     transaction miner_tx;
     if(parse_and_validate_block_from_blob(arg.b.block, new_block))
     {
+      // A request we made for another block's txes that was never answered doesn't apply to this one
+      if(!context.m_requested_objects.empty())
+      {
+        size_t requested_in_block = 0;
+        for (const auto& h : new_block.tx_hashes)
+          requested_in_block += context.m_requested_objects.count(h);
+        if (requested_in_block != context.m_requested_objects.size())
+        {
+          MDEBUG(context << " NOTIFY_NEW_FLUFFY_BLOCK for a block we didn't request txes for, dropping the stale request");
+          context.m_requested_objects.clear();
+        }
+      }
+
       // This is a second notification, we must have asked for some missing tx
       if(!context.m_requested_objects.empty())
       {
@@ -601,6 +614,10 @@ namespace cryptonote
       // Also, remember to pepper some whitespace changes around to bother
       // moneromooo ... only because I <3 him. 
       std::vector<uint64_t> need_tx_indices;
+
+      // Txes that we only got because the peer sent them to us; when relaying the block to compact
+      // block peers we include these in full as they likely don't have them either.
+      std::unordered_set<crypto::hash> new_txs;
         
       transaction tx;
       crypto::hash tx_hash;
@@ -678,6 +695,7 @@ namespace cryptonote
               m_core.resume_mine();
               return 1;
             }
+            new_txs.insert(tx_hash);
             
             //
             // future todo: 
@@ -763,7 +781,10 @@ namespace cryptonote
         // request non-mempool txs
         MDEBUG("We are missing " << need_tx_indices.size() << " txes for this fluffy block");
         for (auto txidx: need_tx_indices)
+        {
           MDEBUG("  tx " << new_block.tx_hashes[txidx]);
+          context.m_requested_objects.insert(new_block.tx_hashes[txidx]);
+        }
         NOTIFY_REQUEST_FLUFFY_MISSING_TX::request missing_tx_req;
         missing_tx_req.block_hash = get_block_hash(new_block);
         missing_tx_req.current_blockchain_height = arg.current_blockchain_height;
@@ -779,54 +800,8 @@ namespace cryptonote
 
         block_complete_entry b = {};
         b.block                = arg.b.block;
-        b.txs                  = have_tx;
-
-        std::vector<block_complete_entry> blocks;
-        blocks.push_back(b);
-
-
-        std::vector<block> pblocks;
-        if (!m_core.prepare_handle_incoming_blocks(blocks, pblocks))
-        {
-          LOG_PRINT_CCONTEXT_L0("Failure in prepare_handle_incoming_blocks");
-          m_core.resume_mine();
-          return 1;
-        }
-
-        block_verification_context bvc{};
-        m_core.handle_incoming_block(arg.b.block, pblocks.empty() ? NULL : &pblocks[0], bvc, nullptr /*checkpoint*/); // got block from handle_notify_new_block
-        if (!m_core.cleanup_handle_incoming_blocks(true))
-        {
-          LOG_PRINT_CCONTEXT_L0("Failure in cleanup_handle_incoming_blocks");
-          m_core.resume_mine();
-          return 1;
-        }
-        m_core.resume_mine();
-
-        if( bvc.m_verifivation_failed )
-        {
-          LOG_PRINT_CCONTEXT_L0("Block verification failed, dropping connection");
-          drop_connection(context, true, false);
-          return 1;
-        }
-        if( bvc.m_added_to_main_chain )
-        {
-          //TODO: Add here announce protocol usage
-          NOTIFY_NEW_FLUFFY_BLOCK::request reg_arg{};
-          reg_arg.current_blockchain_height = arg.current_blockchain_height;
-          reg_arg.b = b;
-          relay_block(reg_arg, context);
-        }
-        else if( bvc.m_marked_as_orphaned )
-        {
-          context.m_needed_objects.clear();
-          context.m_state = cryptonote_connection_context::state_synchronizing;
-          NOTIFY_REQUEST_CHAIN::request r{};
-          m_core.get_blockchain_storage().get_short_chain_history(r.block_ids);
-          MLOG_P2P_MESSAGE("-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size() );
-          post_notify<NOTIFY_REQUEST_CHAIN>(r, context);
-          MLOG_PEER_STATE("requesting chain");
-        }            
+        b.txs                  = std::move(have_tx);
+        return handle_complete_new_block(std::move(b), arg.current_blockchain_height, new_txs, context);
       }
     } 
     else
@@ -846,6 +821,57 @@ namespace cryptonote
         
     return 1;
   }  
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_complete_new_block(block_complete_entry&& b, uint64_t current_blockchain_height, const std::unordered_set<crypto::hash>& prefill, cryptonote_connection_context& context)
+  {
+    std::vector<block_complete_entry> blocks;
+    blocks.push_back(b);
+
+    std::vector<block> pblocks;
+    if (!m_core.prepare_handle_incoming_blocks(blocks, pblocks))
+    {
+      LOG_PRINT_CCONTEXT_L0("Failure in prepare_handle_incoming_blocks");
+      m_core.resume_mine();
+      return 1;
+    }
+
+    block_verification_context bvc{};
+    m_core.handle_incoming_block(b.block, pblocks.empty() ? NULL : &pblocks[0], bvc, nullptr /*checkpoint*/); // got block from handle_notify_new_block
+    if (!m_core.cleanup_handle_incoming_blocks(true))
+    {
+      LOG_PRINT_CCONTEXT_L0("Failure in cleanup_handle_incoming_blocks");
+      m_core.resume_mine();
+      return 1;
+    }
+    m_core.resume_mine();
+
+    if( bvc.m_verifivation_failed )
+    {
+      LOG_PRINT_CCONTEXT_L0("Block verification failed, dropping connection");
+      drop_connection(context, true, false);
+      return 1;
+    }
+    if( bvc.m_added_to_main_chain )
+    {
+      //TODO: Add here announce protocol usage
+      NOTIFY_NEW_FLUFFY_BLOCK::request reg_arg{};
+      reg_arg.current_blockchain_height = current_blockchain_height;
+      reg_arg.b = std::move(b);
+      relay_block(reg_arg, context, prefill);
+    }
+    else if( bvc.m_marked_as_orphaned )
+    {
+      context.m_needed_objects.clear();
+      context.m_state = cryptonote_connection_context::state_synchronizing;
+      NOTIFY_REQUEST_CHAIN::request r{};
+      m_core.get_blockchain_storage().get_short_chain_history(r.block_ids);
+      MLOG_P2P_MESSAGE("-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size() );
+      post_notify<NOTIFY_REQUEST_CHAIN>(r, context);
+      MLOG_PEER_STATE("requesting chain");
+    }
+    return 1;
+  }
   //------------------------------------------------------------------------------------------------------------------------  
   template<class t_core>
   int t_cryptonote_protocol_handler<t_core>::handle_uptime_proof(int command, NOTIFY_UPTIME_PROOF::request& arg, cryptonote_connection_context& context)
@@ -1056,6 +1082,147 @@ namespace cryptonote
     post_notify<NOTIFY_NEW_FLUFFY_BLOCK>(fluffy_response, context);    
     return 1;        
   }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, cryptonote_connection_context& context)
+  {
+    MLOG_P2P_MESSAGE("Received NOTIFY_NEW_COMPACT_BLOCK " << arg.block_hash << " (height " << arg.current_blockchain_height << ", " << arg.short_tx_ids.size() << " txes, " << arg.prefilled_txs.size() << " prefilled)");
+    if(context.m_state != cryptonote_connection_context::state_normal)
+      return 1;
+    if(!is_synchronized() || m_no_sync)
+    {
+      LOG_DEBUG_CC(context, "Received new compact block while syncing, ignored");
+      return 1;
+    }
+
+    // Checked before we allocate anything per tx: the block couldn't hold more txes than this
+    const uint64_t max_txes = m_core.get_blockchain_storage().get_current_cumulative_block_weight_limit() / COMPACT_BLOCK_MIN_TX_WEIGHT;
+    if (arg.short_tx_ids.size() > max_txes)
+    {
+      LOG_ERROR_CCONTEXT("NOTIFY_NEW_COMPACT_BLOCK: claims " << arg.short_tx_ids.size() << " txes (more than the " << max_txes << " that fit in a block), dropping connection");
+      drop_connection(context, false, false);
+      return 1;
+    }
+
+    bool prefilled_ok = arg.prefilled_indices.size() == arg.prefilled_txs.size();
+    for (size_t i = 0; prefilled_ok && i < arg.prefilled_indices.size(); i++)
+      prefilled_ok = arg.prefilled_indices[i] < arg.short_tx_ids.size() && (i == 0 || arg.prefilled_indices[i] > arg.prefilled_indices[i - 1]);
+    if (!prefilled_ok)
+    {
+      LOG_ERROR_CCONTEXT("NOTIFY_NEW_COMPACT_BLOCK: invalid prefilled tx indices, dropping connection");
+      drop_connection(context, false, false);
+      return 1;
+    }
+
+    m_core.pause_mine();
+
+    block new_block;
+    if (!parse_and_validate_block_from_blob(arg.block, new_block) || !new_block.tx_hashes.empty())
+    {
+      LOG_ERROR_CCONTEXT
+      (
+        "sent wrong compact block: failed to parse and validate block: "
+        << oxenmq::to_hex(arg.block)
+        << ", dropping connection"
+      );
+      m_core.resume_mine();
+      drop_connection(context, false, false);
+      return 1;
+    }
+
+    // The reply to this is a NOTIFY_NEW_FLUFFY_BLOCK with the full block and the requested txes
+    // (just the block if we don't ask for any), which completes the block via the fluffy path.
+    auto request_fluffy = [&](std::vector<uint64_t> missing_tx_indices) {
+      NOTIFY_REQUEST_FLUFFY_MISSING_TX::request missing_tx_req;
+      missing_tx_req.block_hash = arg.block_hash;
+      missing_tx_req.current_blockchain_height = arg.current_blockchain_height;
+      missing_tx_req.missing_tx_indices = std::move(missing_tx_indices);
+
+      m_core.resume_mine();
+      MLOG_P2P_MESSAGE("-->>NOTIFY_REQUEST_FLUFFY_MISSING_TX: missing_tx_indices.size()=" << missing_tx_req.missing_tx_indices.size() );
+      post_notify<NOTIFY_REQUEST_FLUFFY_MISSING_TX>(missing_tx_req, context);
+      return 1;
+    };
+
+    // Our short id index is only kept for our current chain tip; blocks on any other parent (alt
+    // blocks, or ones we are behind on) go through the fluffy path.
+    if (new_block.prev_id != m_core.get_blockchain_storage().get_tail_id())
+    {
+      MDEBUG("Compact block " << arg.block_hash << " isn't on our chain tip, requesting fluffy block");
+      context.m_requested_objects.clear();
+      return request_fluffy({});
+    }
+
+    // Short ids are salted with the previous block's hash; resolve them against the pool first and
+    // then let the prefilled txes override whatever they matched.
+    auto& pool = m_core.get_pool();
+    const crypto::hash& salt = new_block.prev_id;
+    std::vector<crypto::hash> tx_hashes = pool.find_short_tx_ids(salt, arg.short_tx_ids);
+    std::vector<blobdata> txs(tx_hashes.size());
+    std::unordered_set<crypto::hash> new_txs;
+
+    for (size_t i = 0; i < arg.prefilled_txs.size(); i++)
+    {
+      const uint64_t tx_idx = arg.prefilled_indices[i];
+      auto& tx_blob = arg.prefilled_txs[i];
+      transaction tx;
+      crypto::hash tx_hash;
+      if (!parse_and_validate_tx_from_blob(tx_blob, tx, tx_hash) || get_short_tx_id(salt, tx_hash) != arg.short_tx_ids[tx_idx])
+      {
+        LOG_ERROR_CCONTEXT("NOTIFY_NEW_COMPACT_BLOCK: sent invalid prefilled tx at index " << tx_idx << ", dropping connection");
+        m_core.resume_mine();
+        drop_connection(context, false, false);
+        return 1;
+      }
+
+      if (!pool.have_tx(tx_hash))
+      {
+        MDEBUG("Incoming tx " << tx_hash << " not in pool, adding");
+        cryptonote::tx_verification_context tvc{};
+        if (!m_core.handle_incoming_tx(tx_blob, tvc, tx_pool_options::from_block()) || tvc.m_verifivation_failed)
+        {
+          LOG_PRINT_CCONTEXT_L1("Block verification failed: transaction verification failed, dropping connection");
+          drop_connection(context, false, false);
+          m_core.resume_mine();
+          return 1;
+        }
+        new_txs.insert(tx_hash);
+      }
+
+      tx_hashes[tx_idx] = tx_hash;
+      txs[tx_idx] = std::move(tx_blob);
+    }
+
+    std::vector<uint64_t> need_tx_indices;
+    for (size_t i = 0; i < txs.size(); i++)
+      if (txs[i].empty() && !(tx_hashes[i] && pool.get_transaction(tx_hashes[i], txs[i])))
+        need_tx_indices.push_back(i);
+
+    context.m_requested_objects.clear();
+    if (need_tx_indices.empty())
+    {
+      new_block.tx_hashes = std::move(tx_hashes);
+      new_block.invalidate_hashes();
+      if (get_block_hash(new_block) == arg.block_hash)
+      {
+        MDEBUG("We have all needed txes for this compact block");
+        block_complete_entry b = {};
+        b.block = t_serializable_object_to_blob(new_block);
+        b.txs   = std::move(txs);
+        return handle_complete_new_block(std::move(b), arg.current_blockchain_height, new_txs, context);
+      }
+
+      // A short id matched the wrong pool tx; this can happen (though rarely) by chance, so don't
+      // penalize the peer but fall back to getting the block with full tx hashes.
+      MDEBUG("Compact block " << arg.block_hash << " reconstruction failed (short tx id collision), requesting fluffy block");
+      return request_fluffy({});
+    }
+
+    // Ask for the missing txes (whether or not we could resolve their short ids) by index right
+    // away: the reply carries the block's tx hashes, so the fluffy path can check what it got.
+    MDEBUG("We are missing " << need_tx_indices.size() << " txes for this compact block");
+    return request_fluffy(std::move(need_tx_indices));
+  }
   //------------------------------------------------------------------------------------------------------------------------  
   template<class t_core>
   int t_cryptonote_protocol_handler<t_core>::handle_notify_new_transactions(int command, NOTIFY_NEW_TRANSACTIONS::request& arg, cryptonote_connection_context& context)
@@ -1528,6 +1695,14 @@ namespace cryptonote
 
             uint64_t block_process_time_full = 0, transactions_process_time_full = 0;
             size_t num_txs = 0, blockidx = 0;
+
+            // Parse and verify the proofs of every tx in the span up front, in large batches,
+            // then hand them to the pool one block at a time as the blocks get added.
+            TIME_MEASURE_START(transactions_parse_time);
+            auto span_parsed_txs = m_core.parse_incoming_block_txs(blocks);
+            TIME_MEASURE_FINISH(transactions_parse_time);
+            transactions_process_time_full += transactions_parse_time;
+
             for(const block_complete_entry& block_entry: blocks)
             {
               if (m_stopping)
@@ -1536,7 +1711,8 @@ namespace cryptonote
               // process transactions
               TIME_MEASURE_START(transactions_process_time);
               num_txs += block_entry.txs.size();
-              auto parsed_txs = m_core.handle_incoming_txs(block_entry.txs, tx_pool_options::from_block());
+              auto &parsed_txs = span_parsed_txs[blockidx];
+              m_core.handle_parsed_txs(parsed_txs, tx_pool_options::from_block());
 
               for (size_t i = 0; i < parsed_txs.size(); ++i)
               {
@@ -2518,18 +2694,68 @@ skip:
   template<class t_core>
   bool t_cryptonote_protocol_handler<t_core>::relay_block(NOTIFY_NEW_FLUFFY_BLOCK::request& arg, cryptonote_connection_context& exclude_context)
   {
-    // sort peers between fluffy ones and others
-    std::vector<std::pair<epee::net_utils::zone, boost::uuids::uuid>> fluffyConnections;
-    m_p2p->for_each_connection([&exclude_context, &fluffyConnections](connection_context& context, nodetool::peerid_type peer_id, uint32_t support_flags)
+    return relay_block(arg, exclude_context, {});
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  bool t_cryptonote_protocol_handler<t_core>::relay_block(NOTIFY_NEW_FLUFFY_BLOCK::request& arg, cryptonote_connection_context& exclude_context, const std::unordered_set<crypto::hash>& prefill)
+  {
+    // sort peers between compact ones and others
+    std::vector<std::pair<epee::net_utils::zone, boost::uuids::uuid>> fluffyConnections, compactConnections;
+    m_p2p->for_each_connection([&exclude_context, &fluffyConnections, &compactConnections](connection_context& context, nodetool::peerid_type peer_id, uint32_t support_flags)
     {
       if (peer_id && exclude_context.m_connection_id != context.m_connection_id && context.m_remote_address.get_zone() == epee::net_utils::zone::public_)
       {
-        LOG_DEBUG_CC(context, "PEER FLUFFY BLOCKS - RELAYING THIN/COMPACT WHATEVER BLOCK");
-        fluffyConnections.push_back({context.m_remote_address.get_zone(), context.m_connection_id});
+        if (support_flags & P2P_SUPPORT_FLAG_COMPACT_BLOCKS)
+        {
+          LOG_DEBUG_CC(context, "PEER COMPACT BLOCKS - RELAYING COMPACT BLOCK");
+          compactConnections.push_back({context.m_remote_address.get_zone(), context.m_connection_id});
+        }
+        else
+        {
+          LOG_DEBUG_CC(context, "PEER FLUFFY BLOCKS - RELAYING THIN/COMPACT WHATEVER BLOCK");
+          fluffyConnections.push_back({context.m_remote_address.get_zone(), context.m_connection_id});
+        }
       }
       return true;
     });
 
+    if (!compactConnections.empty())
+    {
+      NOTIFY_NEW_COMPACT_BLOCK::request compact{};
+      block b;
+      if (parse_and_validate_block_from_blob(arg.b.block, b, &compact.block_hash))
+      {
+        // We can only prefill txes if we were given all the blobs (in which case they are in block order)
+        const bool have_tx_blobs = arg.b.txs.size() == b.tx_hashes.size();
+        compact.current_blockchain_height = arg.current_blockchain_height;
+        compact.short_tx_ids.reserve(b.tx_hashes.size());
+        for (size_t i = 0; i < b.tx_hashes.size(); i++)
+        {
+          compact.short_tx_ids.push_back(get_short_tx_id(b.prev_id, b.tx_hashes[i]));
+          if (have_tx_blobs && prefill.count(b.tx_hashes[i]))
+          {
+            compact.prefilled_indices.push_back(i);
+            compact.prefilled_txs.push_back(arg.b.txs[i]);
+          }
+        }
+        b.tx_hashes.clear();
+        compact.block = t_serializable_object_to_blob(b);
+
+        std::string compactBlob;
+        epee::serialization::store_t_to_binary(compact, compactBlob);
+        m_p2p->relay_notify_to_list(NOTIFY_NEW_COMPACT_BLOCK::ID, epee::strspan<uint8_t>(compactBlob), std::move(compactConnections));
+      }
+      else
+      {
+        LOG_PRINT_L1("relay_block failed to parse block for compact relay, relaying fluffy block instead");
+        fluffyConnections.insert(fluffyConnections.end(), compactConnections.begin(), compactConnections.end());
+      }
+    }
+
+    if (fluffyConnections.empty())
+      return true;
+
     std::string fluffyBlob;
     if (arg.b.txs.size())
     {
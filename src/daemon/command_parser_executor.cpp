@@ -224,6 +224,13 @@ bool command_parser_executor::print_net_stats(const std::vector<std::string>& ar
   return m_executor.print_net_stats();
 }
 
+bool command_parser_executor::print_perf(const std::vector<std::string>& args)
+{
+  if (args.size() > 1) return false;
+
+  return m_executor.print_perf(args.empty() ? "" : args[0]);
+}
+
 bool command_parser_executor::print_blockchain_info(const std::vector<std::string>& args)
 {
   if(!args.size())
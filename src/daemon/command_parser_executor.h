@@ -150,6 +150,8 @@ public:
 
   bool print_net_stats(const std::vector<std::string>& args);
 
+  bool print_perf(const std::vector<std::string>& args);
+
   bool print_sn_state_changes(const std::vector<std::string> &args);
 
   bool set_bootstrap_daemon(const std::vector<std::string>& args);
@@ -90,6 +90,12 @@ void command_server::init_commands(cryptonote::rpc::core_rpc_server* rpc_server)
     , [this](const auto &x) { return m_parser.print_net_stats(x); }
     , "Print network statistics."
     );
+  m_command_lookup.set_handler(
+      "print_perf"
+    , [this](const auto &x) { return m_parser.print_perf(x); }
+    , "print_perf [<category>]"
+    , "Print internal performance timer statistics (since startup), optionally only for timers whose category starts with <category>, e.g. perf.blockchain."
+    );
   m_command_lookup.set_handler(
       "print_bc"
     , [this](const auto &x) { return m_parser.print_blockchain_info(x); }
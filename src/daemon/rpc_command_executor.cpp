@@ -49,6 +49,8 @@
 #include <ctime>
 #include <string>
 #include <numeric>
+#include <algorithm>
+#include <cmath>
 #include <stack>
 
 #undef OXEN_DEFAULT_LOG_CATEGORY
@@ -710,6 +712,69 @@ bool rpc_command_executor::print_net_stats()
     % percent
     % tools::get_human_readable_bytes(limit);
 
+  if (net_stats_res.total_writes_out > 0)
+    tools::success_msg_writer() << boost::format("Sent %s in %u socket writes, average %s per write")
+      % tools::get_human_readable_bytes(net_stats_res.total_write_bytes_out)
+      % net_stats_res.total_writes_out
+      % tools::get_human_readable_bytes(net_stats_res.total_write_bytes_out / net_stats_res.total_writes_out);
+
+  return true;
+}
+
+// Returns the upper bound, in microseconds, of the histogram bucket containing the given quantile
+static uint64_t perf_histogram_quantile_us(const std::vector<uint64_t>& histogram, uint64_t count, double q)
+{
+  uint64_t target = std::max<uint64_t>(1, std::ceil(count * q)), seen = 0;
+  for (size_t i = 0; i < histogram.size(); i++)
+  {
+    seen += histogram[i];
+    if (seen >= target)
+      return uint64_t{1} << i;
+  }
+  return uint64_t{1} << histogram.size();
+}
+
+bool rpc_command_executor::print_perf(const std::string &category)
+{
+  GET_PERF_STATS::request req{};
+  GET_PERF_STATS::response res{};
+  req.category = category;
+
+  if (!invoke<GET_PERF_STATS>(std::move(req), res, "Failed to retrieve performance timer statistics"))
+    return false;
+
+  const auto& lock = res.blockchain_lock;
+  tools::msg_writer() << "Blockchain lock: " << lock.exclusive_acquired << " exclusive (" << lock.exclusive_waited << " waited, "
+      << lock.exclusive_wait_ns / 1000000 << " ms), " << lock.shared_acquired << " shared (" << lock.shared_waited << " waited, "
+      << lock.shared_wait_ns / 1000000 << " ms)";
+
+  if (res.timers.empty())
+  {
+    tools::msg_writer() << "No performance timers have run" << (category.empty() ? "" : " in category " + category);
+    return true;
+  }
+
+  std::sort(res.timers.begin(), res.timers.end(), [](const auto& a, const auto& b) { return a.total_ns > b.total_ns; });
+
+  // Quantiles are only known to histogram bucket resolution, so are shown as upper bounds
+  tools::msg_writer() << std::setw(12) << std::right << "Total (ms)"
+      << std::setw(12) << "Count"
+      << std::setw(12) << "Avg (us)"
+      << std::setw(12) << "p50 (us)"
+      << std::setw(12) << "p99 (us)"
+      << std::setw(12) << "Max (us)"
+      << "  " << std::left << "Timer";
+  for (const auto& t : res.timers)
+  {
+    tools::msg_writer() << std::setw(12) << std::right << t.total_ns / 1000000
+        << std::setw(12) << t.count
+        << std::setw(12) << t.total_ns / t.count / 1000
+        << std::setw(12) << ("<" + std::to_string(perf_histogram_quantile_us(t.histogram, t.count, 0.5)))
+        << std::setw(12) << ("<" + std::to_string(perf_histogram_quantile_us(t.histogram, t.count, 0.99)))
+        << std::setw(12) << t.max_ns / 1000
+        << "  " << std::left << t.category << "/" << t.name;
+  }
+
   return true;
 }
 
@@ -195,6 +195,8 @@ public:
 
   bool print_net_stats();
 
+  bool print_perf(const std::string &category);
+
   bool set_bootstrap_daemon(
     const std::string &address,
     const std::string &username,
@@ -73,6 +73,7 @@ static rct::key Hi[maxN*maxM], Gi[maxN*maxM];
 static ge_p3 Hi_p3[maxN*maxM], Gi_p3[maxN*maxM];
 static std::shared_ptr<straus_cached_data> straus_HiGi_cache;
 static std::shared_ptr<pippenger_cached_data> pippenger_HiGi_cache;
+static std::shared_ptr<pippenger_fixed_cached_data> pippenger_fixed_HiGi_cache;
 static const rct::key TWO = { {0x02, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00  } };
 static const rct::key MINUS_ONE = { { 0xec, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 } };
 static const rct::key MINUS_INV_EIGHT = { { 0x74, 0xa4, 0x19, 0x7a, 0xf0, 0x7d, 0x0b, 0xf7, 0x05, 0xc2, 0xda, 0x25, 0x2b, 0x5c, 0x0b, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a } };
@@ -141,6 +142,31 @@ static void init_exponents()
   init_done = true;
 }
 
+// The fixed base tables are only needed for verification, and are large, so we only build
+// them when first verifying rather than in init_exponents
+static void init_fixed_exponents()
+{
+  init_exponents();
+
+  std::lock_guard lock{init_mutex};
+
+  static bool init_done = false;
+  if (init_done)
+    return;
+  std::vector<MultiexpData> data;
+  data.reserve(maxN*maxM*2);
+  for (size_t i = 0; i < maxN*maxM; ++i)
+  {
+    data.push_back({rct::zero(), Gi_p3[i]});
+    data.push_back({rct::zero(), Hi_p3[i]});
+  }
+
+  pippenger_fixed_HiGi_cache = pippenger_fixed_init_cache(data);
+
+  MINFO("Fixed base Pippenger cache size: " << pippenger_fixed_get_cache_size(pippenger_fixed_HiGi_cache)/1024 << " kB");
+  init_done = true;
+}
+
 /* Given two scalar arrays, construct a vector commitment */
 static rct::key vector_exponent(const rct::keyV &a, const rct::keyV &b)
 {
@@ -811,7 +837,7 @@ struct proof_data_t
  */
 bool bulletproof_VERIFY(const std::vector<const Bulletproof*> &proofs)
 {
-  init_exponents();
+  init_fixed_exponents();
 
   PERF_TIMER_START_BP(VERIFY);
 
@@ -1068,7 +1094,7 @@ bool bulletproof_VERIFY(const std::vector<const Bulletproof*> &proofs)
     multiexp_data[i * 2] = {m_z4[i], Gi_p3[i]};
     multiexp_data[i * 2 + 1] = {m_z5[i], Hi_p3[i]};
   }
-  if (!(multiexp(multiexp_data, 2 * maxMN) == rct::identity()))
+  if (!(pippenger_fixed(multiexp_data, pippenger_fixed_HiGi_cache, 2 * maxMN) == rct::identity()))
   {
     PERF_TIMER_STOP_BP(VERIFY_step2_check);
     MERROR("Verification failure");
@@ -707,4 +707,136 @@ rct::key pippenger(const std::vector<MultiexpData> &data, const std::shared_ptr<
   return res;
 }
 
+// Fixed base variant of Pippenger: since the points are known in advance, we can store
+// 2^(8k) * P for each byte k of the scalar. Every byte of every scalar then goes into a
+// single set of buckets, so the buckets are summed once and no doublings are needed, at
+// the cost of storing 32 cached points per base point.
+#define PIPPENGER_FIXED_C 8
+#define PIPPENGER_FIXED_WINDOWS (256 / PIPPENGER_FIXED_C)
+
+struct pippenger_fixed_cached_data
+{
+  size_t size;
+  ge_cached *cached;
+  pippenger_fixed_cached_data(): size(0), cached(NULL) {}
+  ~pippenger_fixed_cached_data() { aligned_free(cached); }
+};
+
+std::shared_ptr<pippenger_fixed_cached_data> pippenger_fixed_init_cache(const std::vector<MultiexpData> &data, size_t N)
+{
+  MULTIEXP_PERF(PERF_TIMER_START_UNIT(pippenger_fixed_init_cache, 1000000));
+  if (N == 0)
+    N = data.size();
+  CHECK_AND_ASSERT_THROW_MES(N <= data.size(), "Bad cache base data");
+  std::shared_ptr<pippenger_fixed_cached_data> cache(new pippenger_fixed_cached_data());
+
+  cache->size = N;
+  cache->cached = (ge_cached*)aligned_realloc(cache->cached, N * PIPPENGER_FIXED_WINDOWS * sizeof(ge_cached), 4096);
+  CHECK_AND_ASSERT_THROW_MES(cache->cached, "Out of memory");
+  for (size_t i = 0; i < N; ++i)
+  {
+    ge_cached *table = &cache->cached[i * PIPPENGER_FIXED_WINDOWS];
+    ge_p3 p3 = data[i].point;
+    ge_p3_to_cached(&table[0], &p3);
+    for (size_t k = 1; k < PIPPENGER_FIXED_WINDOWS; ++k)
+    {
+      ge_p2 p2;
+      ge_p1p1 p1;
+      ge_p3_to_p2(&p2, &p3);
+      for (size_t j = 0; j < PIPPENGER_FIXED_C; ++j)
+      {
+        ge_p2_dbl(&p1, &p2);
+        if (j == PIPPENGER_FIXED_C - 1)
+          ge_p1p1_to_p3(&p3, &p1);
+        else
+          ge_p1p1_to_p2(&p2, &p1);
+      }
+      ge_p3_to_cached(&table[k], &p3);
+    }
+  }
+
+  MULTIEXP_PERF(PERF_TIMER_STOP(pippenger_fixed_init_cache));
+  return cache;
+}
+
+size_t pippenger_fixed_get_cache_size(const std::shared_ptr<pippenger_fixed_cached_data> &cache)
+{
+  return cache->size * PIPPENGER_FIXED_WINDOWS * sizeof(*cache->cached);
+}
+
+rct::key pippenger_fixed(const std::vector<MultiexpData> &data, const std::shared_ptr<pippenger_fixed_cached_data> &cache, size_t cache_size)
+{
+  CHECK_AND_ASSERT_THROW_MES(cache != NULL, "No cache");
+  if (cache_size == 0)
+    cache_size = std::min(cache->size, data.size());
+  CHECK_AND_ASSERT_THROW_MES(cache_size <= cache->size, "Cache is too small");
+  CHECK_AND_ASSERT_THROW_MES(cache_size <= data.size(), "Bad cache size");
+  MULTIEXP_PERF(PERF_TIMER_UNIT(pippenger_fixed, 1000000));
+
+  ge_p3 result = ge_p3_identity;
+  bool result_init = false;
+  std::unique_ptr<ge_p3[]> buckets{new ge_p3[1<<PIPPENGER_FIXED_C]};
+  bool buckets_init[1<<PIPPENGER_FIXED_C] = {};
+
+  // partition the bytes of all scalars into a single set of buckets
+  for (size_t i = 0; i < cache_size; ++i)
+  {
+    const ge_cached *table = &cache->cached[i * PIPPENGER_FIXED_WINDOWS];
+    const unsigned char *bytes = data[i].scalar.bytes;
+    for (size_t k = 0; k < PIPPENGER_FIXED_WINDOWS; ++k)
+    {
+      const unsigned int bucket = bytes[k];
+      if (bucket == 0)
+        continue;
+      if (!buckets_init[bucket])
+      {
+        buckets[bucket] = ge_p3_identity;
+        buckets_init[bucket] = true;
+      }
+      add(buckets[bucket], table[k]);
+    }
+  }
+
+  // sum the buckets
+  ge_p3 pail;
+  bool pail_init = false;
+  for (size_t i = (1<<PIPPENGER_FIXED_C)-1; i > 0; --i)
+  {
+    if (buckets_init[i])
+    {
+      if (pail_init)
+        add(pail, buckets[i]);
+      else
+      {
+        pail = buckets[i];
+        pail_init = true;
+      }
+    }
+    if (pail_init)
+    {
+      if (result_init)
+        add(result, pail);
+      else
+      {
+        result = pail;
+        result_init = true;
+      }
+    }
+  }
+
+  // any points past the cached ones are not fixed, do them the usual way
+  if (data.size() > cache_size)
+  {
+    const std::vector<MultiexpData> rest(data.begin() + cache_size, data.end());
+    const rct::key r = rest.size() <= 95 ? straus(rest) : pippenger(rest, NULL, 0, get_pippenger_c(rest.size()));
+    ge_p3 r_p3;
+    CHECK_AND_ASSERT_THROW_MES(ge_frombytes_vartime(&r_p3, r.bytes) == 0, "ge_frombytes_vartime failed");
+    add(result, r_p3);
+  }
+
+  rct::key res;
+  ge_p3_tobytes(res.bytes, &result);
+  return res;
+}
+
 }
@@ -55,6 +55,7 @@ struct MultiexpData {
 
 struct straus_cached_data;
 struct pippenger_cached_data;
+struct pippenger_fixed_cached_data;
 
 rct::key bos_coster_heap_conv(std::vector<MultiexpData> data);
 rct::key bos_coster_heap_conv_robust(std::vector<MultiexpData> data);
@@ -65,6 +66,9 @@ std::shared_ptr<pippenger_cached_data> pippenger_init_cache(const std::vector<Mu
 size_t pippenger_get_cache_size(const std::shared_ptr<pippenger_cached_data> &cache);
 size_t get_pippenger_c(size_t N);
 rct::key pippenger(const std::vector<MultiexpData> &data, const std::shared_ptr<pippenger_cached_data> &cache = NULL, size_t cache_size = 0, size_t c = 0);
+std::shared_ptr<pippenger_fixed_cached_data> pippenger_fixed_init_cache(const std::vector<MultiexpData> &data, size_t N = 0);
+size_t pippenger_fixed_get_cache_size(const std::shared_ptr<pippenger_fixed_cached_data> &cache);
+rct::key pippenger_fixed(const std::vector<MultiexpData> &data, const std::shared_ptr<pippenger_fixed_cached_data> &cache, size_t cache_size = 0);
 
 }
 
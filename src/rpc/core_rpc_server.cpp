@@ -50,6 +50,7 @@
 #include "common/command_line.h"
 #include "common/oxen.h"
 #include "common/sha256sum.h"
+#include "common/string_util.h"
 #include "common/perf_timer.h"
 #include "common/random.h"
 #include "common/hex.h"
@@ -166,8 +167,13 @@ namespace cryptonote { namespace rpc {
       cmd->is_legacy = std::is_base_of_v<LEGACY, RPC>;
       cmd->invoke = [](rpc_request&& request, core_rpc_server& server) {
         reg_helper<RPC> helper;
-        Response res = server.invoke(helper.load(request), std::move(request.context));
-        return helper.serialize(std::move(res));
+        if constexpr (std::is_same_v<RPC, GET_SERVICE_NODES>)
+          // Polled constantly by SS/lokinet/clients, so goes through the pre-serialized cache
+          return server.invoke_cached(helper.load(request), std::move(request.context));
+        else {
+          Response res = server.invoke(helper.load(request), std::move(request.context));
+          return helper.serialize(std::move(res));
+        }
       };
 
       for (const auto& name : RPC::names())
@@ -468,6 +474,9 @@ namespace cryptonote { namespace rpc {
       std::lock_guard lock{epee::net_utils::network_throttle_manager::m_lock_get_global_throttle_out};
       epee::net_utils::network_throttle_manager::get_global_throttle_out().get_stats(res.total_packets_out, res.total_bytes_out);
     }
+    auto writes = epee::net_utils::connection_basic::get_write_stats();
+    res.total_writes_out = writes.writes;
+    res.total_write_bytes_out = writes.bytes;
     res.status = STATUS_OK;
     return res;
   }
@@ -505,8 +514,8 @@ namespace cryptonote { namespace rpc {
     for(auto& bd: bs)
     {
       res.blocks.resize(res.blocks.size()+1);
-      res.blocks.back().block = bd.first.first;
       size += bd.first.first.size();
+      res.blocks.back().block = std::move(bd.first.first);
       res.output_indices.push_back(GET_BLOCKS_FAST::block_output_indices());
       ntxes += bd.second.size();
       res.output_indices.back().indices.reserve(1 + bd.second.size());
@@ -1830,7 +1839,6 @@ namespace cryptonote { namespace rpc {
     response.hash = tools::type_to_hex(hash);
     response.difficulty = m_core.get_blockchain_storage().block_difficulty(height);
     response.cumulative_difficulty = m_core.get_blockchain_storage().get_db().get_block_cumulative_difficulty(height);
-    response.block_weight = m_core.get_blockchain_storage().get_db().get_block_weight(height);
     response.reward = get_block_reward(blk);
     response.miner_reward = blk.miner_tx.vout[0].amount;
     response.block_size = response.block_weight = m_core.get_blockchain_storage().get_db().get_block_weight(height);
@@ -2005,7 +2013,7 @@ namespace cryptonote { namespace rpc {
       if (block_height != h)
         throw rpc_error{ERROR_INTERNAL, "Internal error: coinbase transaction in the block has the wrong height"};
       res.headers.push_back(block_header_response());
-      fill_block_header_response(blk, false, block_height, get_block_hash(blk), res.headers.back(), req.fill_pow_hash && context.admin, req.get_tx_hashes);
+      fill_block_header_response(blk, false, block_height, m_core.get_block_id_by_height(h), res.headers.back(), req.fill_pow_hash && context.admin, req.get_tx_hashes);
     }
     res.status = STATUS_OK;
     return res;
@@ -2606,15 +2614,6 @@ namespace cryptonote { namespace rpc {
 
       return {std::move(distribution), start_height, base};
     }
-
-    static struct {
-      std::mutex mutex;
-      std::vector<std::uint64_t> cached_distribution;
-      std::uint64_t cached_from = 0, cached_to = 0, cached_start_height = 0, cached_base = 0;
-      crypto::hash cached_m10_hash = crypto::null_hash;
-      crypto::hash cached_top_hash = crypto::null_hash;
-      bool cached = false;
-    } output_dist_cache;
   }
 
   namespace detail {
@@ -2623,60 +2622,14 @@ namespace cryptonote { namespace rpc {
         uint64_t amount,
         uint64_t from_height,
         uint64_t to_height,
-        const std::function<crypto::hash(uint64_t)>& get_hash,
-        bool cumulative,
-        uint64_t blockchain_height)
+        bool cumulative)
     {
-      auto& d = output_dist_cache;
-      const std::unique_lock lock{d.mutex};
-
-      crypto::hash top_hash = crypto::null_hash;
-      if (d.cached_to < blockchain_height)
-        top_hash = get_hash(d.cached_to);
-      if (d.cached && amount == 0 && d.cached_from == from_height && d.cached_to == to_height && d.cached_top_hash == top_hash)
-        return process_distribution(cumulative, d.cached_start_height, d.cached_distribution, d.cached_base);
-
+      // No caching here: Blockchain keeps per-amount prefix sums of the distribution up to date as
+      // blocks are added and removed, so any range is cheap to get.
       std::vector<std::uint64_t> distribution;
       std::uint64_t start_height, base;
-
-      // see if we can extend the cache - a common case
-      bool can_extend = d.cached && amount == 0 && d.cached_from == from_height && to_height > d.cached_to && top_hash == d.cached_top_hash;
-      if (!can_extend)
-      {
-        // we kept track of the hash 10 blocks below, if it exists, so if it matches,
-        // we can still pop the last 10 cached slots and try again
-        if (d.cached && amount == 0 && d.cached_from == from_height && d.cached_to - d.cached_from >= 10 && to_height > d.cached_to - 10)
-        {
-          crypto::hash hash10 = get_hash(d.cached_to - 10);
-          if (hash10 == d.cached_m10_hash)
-          {
-            d.cached_to -= 10;
-            d.cached_top_hash = hash10;
-            d.cached_m10_hash = crypto::null_hash;
-            CHECK_AND_ASSERT_MES(d.cached_distribution.size() >= 10, std::nullopt, "Cached distribution size does not match cached bounds");
-            for (int p = 0; p < 10; ++p)
-              d.cached_distribution.pop_back();
-            can_extend = true;
-          }
-        }
-      }
-      if (can_extend)
-      {
-        std::vector<std::uint64_t> new_distribution;
-        if (!f(amount, d.cached_to + 1, to_height, start_height, new_distribution, base))
-          return std::nullopt;
-        distribution = d.cached_distribution;
-        distribution.reserve(distribution.size() + new_distribution.size());
-        for (const auto &e: new_distribution)
-          distribution.push_back(e);
-        start_height = d.cached_start_height;
-        base = d.cached_base;
-      }
-      else
-      {
-        if (!f(amount, from_height, to_height, start_height, distribution, base))
-          return std::nullopt;
-      }
+      if (!f(amount, from_height, to_height, start_height, distribution, base))
+        return std::nullopt;
 
       if (to_height > 0 && to_height >= from_height)
       {
@@ -2685,18 +2638,6 @@ namespace cryptonote { namespace rpc {
           distribution.resize(to_height - offset + 1);
       }
 
-      if (amount == 0)
-      {
-        d.cached_from = from_height;
-        d.cached_to = to_height;
-        d.cached_top_hash = get_hash(d.cached_to);
-        d.cached_m10_hash = d.cached_to >= 10 ? get_hash(d.cached_to - 10) : crypto::null_hash;
-        d.cached_distribution = distribution;
-        d.cached_start_height = start_height;
-        d.cached_base = base;
-        d.cached = true;
-      }
-
       return process_distribution(cumulative, start_height, std::move(distribution), base);
     }
   }
@@ -2721,9 +2662,7 @@ namespace cryptonote { namespace rpc {
             amount,
             req.from_height,
             req_to_height,
-            [this](uint64_t height) { return m_core.get_blockchain_storage().get_db().get_block_hash_from_height(height); },
-            req.cumulative,
-            m_core.get_current_blockchain_height());
+            req.cumulative);
         if (!data)
           throw rpc_error{ERROR_INTERNAL, "Failed to get output distribution"};
 
@@ -2937,6 +2876,32 @@ namespace cryptonote { namespace rpc {
     return res;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  GET_PERF_STATS::response core_rpc_server::invoke(GET_PERF_STATS::request&& req, rpc_context context)
+  {
+    GET_PERF_STATS::response res{};
+    for (auto& stats : tools::get_performance_timer_stats())
+    {
+      if (!tools::starts_with(stats.category, req.category))
+        continue;
+      auto& t = res.timers.emplace_back();
+      t.name = std::move(stats.name);
+      t.category = std::move(stats.category);
+      t.count = stats.count;
+      t.total_ns = stats.total_ns;
+      t.max_ns = stats.max_ns;
+      t.histogram.assign(stats.histogram.begin(), stats.histogram.end());
+    }
+    auto lock = m_core.get_blockchain_storage().get_lock_contention_stats();
+    res.blockchain_lock.exclusive_acquired = lock.exclusive_acquired;
+    res.blockchain_lock.exclusive_waited = lock.exclusive_waited;
+    res.blockchain_lock.exclusive_wait_ns = lock.exclusive_wait_time.count();
+    res.blockchain_lock.shared_acquired = lock.shared_acquired;
+    res.blockchain_lock.shared_waited = lock.shared_waited;
+    res.blockchain_lock.shared_wait_ns = lock.shared_wait_time.count();
+    res.status = STATUS_OK;
+    return res;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   GET_SERVICE_NODE_REGISTRATION_CMD_RAW::response core_rpc_server::invoke(GET_SERVICE_NODE_REGISTRATION_CMD_RAW::request&& req, rpc_context context)
   {
     GET_SERVICE_NODE_REGISTRATION_CMD_RAW::response res{};
@@ -3223,6 +3188,173 @@ namespace cryptonote { namespace rpc {
     return res;
   }
 
+  namespace {
+    // A proof-derived entry that is younger than this is served even if proofs have changed since
+    // it was built: with thousands of nodes some proof or reachability report arrives nearly every
+    // second, and rebuilding on each one would make the cache useless for proof fields.
+    constexpr auto SN_RESPONSE_CACHE_PROOF_MIN_AGE = 2s;
+    // Proof-derived entries are always rebuilt after this long, even without proof changes,
+    // because reachability is also a function of the current time.
+    constexpr auto SN_RESPONSE_CACHE_PROOF_MAX_AGE = 30s;
+
+    bool requests_proof_fields(const GET_SERVICE_NODES::requested_fields_t& f) {
+      return f.all || f.service_node_version || f.lokinet_version || f.storage_server_version ||
+        f.public_ip || f.storage_port || f.storage_lmq_port || f.quorumnet_port ||
+        f.pubkey_ed25519 || f.pubkey_x25519 || f.last_uptime_proof ||
+        f.storage_server_reachable || f.storage_server_first_unreachable ||
+        f.storage_server_last_unreachable || f.storage_server_last_reachable ||
+        f.lokinet_reachable || f.lokinet_first_unreachable || f.lokinet_last_unreachable ||
+        f.lokinet_last_reachable || f.checkpoint_participation || f.pulse_participation ||
+        f.timestamp_participation || f.timesync_status;
+    }
+
+    // Cache key: the raw requested field flags, plus the other request values that affect a
+    // whole-list response.
+    std::string sn_response_cache_key(const GET_SERVICE_NODES::request& req) {
+      static_assert(std::is_trivially_copyable_v<GET_SERVICE_NODES::requested_fields_t>);
+      const auto& fields = *req.fields;
+      std::string key(reinterpret_cast<const char*>(&fields), sizeof(fields));
+      key += static_cast<char>(req.active_only);
+      key += static_cast<char>(!req.poll_block_hash.empty());
+      return key;
+    }
+  }
+
+  std::string detail::sn_response_cache::get(std::string key, GET_SERVICE_NODES::request req, const fresh_fn& fresh, const build_fn& build)
+  {
+    std::shared_ptr<slot> s;
+    {
+      std::lock_guard lock{m_mutex};
+      auto [it, inserted] = m_slots.try_emplace(std::move(key));
+      if (inserted)
+      {
+        if (m_slots.size() > m_max_entries)
+        {
+          auto lru = m_slots.end();
+          for (auto i = m_slots.begin(); i != m_slots.end(); ++i)
+            if (i != it && (lru == m_slots.end() || i->second->last_used < lru->second->last_used))
+              lru = i;
+          m_slots.erase(lru); // Anyone still using it keeps their own reference
+        }
+        it->second = std::make_shared<slot>();
+        it->second->entry.req = std::move(req);
+      }
+      it->second->requested = true;
+      it->second->last_used = ++m_use_counter;
+      s = it->second;
+    }
+
+    std::lock_guard lock{s->mutex};
+    if (!fresh(s->entry))
+      build(s->entry);
+    return s->entry.body;
+  }
+
+  void detail::sn_response_cache::refresh(const fresh_fn& fresh, const build_fn& build)
+  {
+    std::vector<std::shared_ptr<slot>> requested;
+    {
+      std::lock_guard lock{m_mutex};
+      for (auto it = m_slots.begin(); it != m_slots.end(); )
+      {
+        if (!it->second->requested)
+        {
+          // Nobody asked for this one since the last refresh, so drop it rather than keep rebuilding it
+          it = m_slots.erase(it);
+          continue;
+        }
+        it->second->requested = false;
+        requested.push_back(it->second);
+        ++it;
+      }
+    }
+
+    for (auto& s : requested)
+    {
+      std::lock_guard lock{s->mutex};
+      if (!fresh(s->entry))
+        build(s->entry);
+    }
+  }
+
+  size_t detail::sn_response_cache::size() const
+  {
+    std::lock_guard lock{m_mutex};
+    return m_slots.size();
+  }
+
+  bool core_rpc_server::sn_response_cache_fresh(const detail::sn_response_cache_entry& entry, const std::string& top_hash) const
+  {
+    if (entry.body.empty() || entry.block_hash != top_hash || entry.target_height != m_core.get_target_blockchain_height())
+      return false;
+    if (!entry.proof_fields)
+      return true;
+    auto age = std::chrono::steady_clock::now() - entry.built;
+    return age < SN_RESPONSE_CACHE_PROOF_MIN_AGE || (age < SN_RESPONSE_CACHE_PROOF_MAX_AGE &&
+        entry.proof_generation == m_core.get_service_node_list().proof_generation());
+  }
+
+  void core_rpc_server::build_sn_response_cache_entry(detail::sn_response_cache_entry& entry)
+  {
+    entry.proof_fields = requests_proof_fields(*entry.req.fields);
+    entry.proof_generation = m_core.get_service_node_list().proof_generation();
+    entry.built = std::chrono::steady_clock::now();
+
+    auto req = entry.req;
+    bool polling = !req.poll_block_hash.empty();
+    // The cached body is never an "unchanged" reply (those are handled before we get here), so
+    // build the full response and just flag it as a polling reply for serialization.
+    req.poll_block_hash.clear();
+    auto res = invoke(std::move(req), rpc_context{});
+    res.polling_mode = polling;
+
+    entry.block_hash = res.block_hash;
+    entry.target_height = res.target_height;
+    entry.body = reg_helper<GET_SERVICE_NODES>{}.serialize(std::move(res));
+  }
+
+  std::string core_rpc_server::invoke_cached(GET_SERVICE_NODES::request&& req, rpc_context context)
+  {
+    PERF_TIMER(invoke_cached_get_service_nodes);
+    reg_helper<GET_SERVICE_NODES> helper;
+
+    // Only whole-list responses are cached; specific pubkeys, random samples, and the as_json dump
+    // are built on demand.
+    if (!req.service_node_pubkeys.empty() || req.limit != 0 || req.include_json)
+      return helper.serialize(invoke(std::move(req), std::move(context)));
+
+    auto top_hash = tools::type_to_hex(m_core.get_block_id_by_height(m_core.get_current_blockchain_height() - 1));
+    // Unchanged poll replies are tiny and need no caching
+    if (!req.poll_block_hash.empty() && req.poll_block_hash == top_hash)
+      return helper.serialize(invoke(std::move(req), std::move(context)));
+
+    if (!req.fields || req.fields->all)
+      req.fields = all_fields;
+    auto key = sn_response_cache_key(req);
+
+    return m_sn_response_cache.get(std::move(key), std::move(req),
+        [this, &top_hash](const auto& entry) { return sn_response_cache_fresh(entry, top_hash); },
+        [this](auto& entry) { build_sn_response_cache_entry(entry); });
+  }
+
+  void core_rpc_server::queue_service_nodes_cache_rebuild()
+  {
+    if (!m_sn_response_cache_rebuild_pending.exchange(true))
+      m_core.get_omq().job([this] { rebuild_service_nodes_cache(); });
+  }
+
+  void core_rpc_server::rebuild_service_nodes_cache()
+  {
+    m_sn_response_cache_rebuild_pending = false;
+    if (m_core.get_current_blockchain_height() < m_core.get_target_blockchain_height())
+      return; // Still syncing: don't rebuild on every block, the next request will do it.
+
+    auto top_hash = tools::type_to_hex(m_core.get_block_id_by_height(m_core.get_current_blockchain_height() - 1));
+    m_sn_response_cache.refresh(
+        [this, &top_hash](const auto& entry) { return sn_response_cache_fresh(entry, top_hash); },
+        [this](auto& entry) { build_sn_response_cache_entry(entry); });
+  }
+
   namespace {
     struct version_printer { const std::array<uint16_t, 3> &v; };
     std::ostream &operator<<(std::ostream &o, const version_printer &vp) { return o << vp.v[0] << '.' << vp.v[1] << '.' << vp.v[2]; }
@@ -3494,23 +3626,25 @@ namespace cryptonote { namespace rpc {
     uint8_t hf_version = get_network_version(nettype(), *height);
     if (req.include_expired) height = std::nullopt;
 
-    std::vector<ons::mapping_type> types;
-
-    ons::name_system_db &db = m_core.get_blockchain_storage().name_system_db();
+    // Validate everything first, then look up all the requested names in one batch
+    std::vector<std::vector<ons::mapping_type>> entry_types(req.entries.size());
+    std::vector<std::string> name_hashes(req.entries.size());
+    std::vector<ons::mapping_type> all_types;
     for (size_t request_index = 0; request_index < req.entries.size(); request_index++)
     {
       ONS_NAMES_TO_OWNERS::request_entry const &request = req.entries[request_index];
       if (!context.admin)
         check_quantity_limit(request.types.size(), ONS_NAMES_TO_OWNERS::MAX_TYPE_REQUEST_ENTRIES, "types");
 
-      types.clear();
-      if (types.capacity() < request.types.size())
-        types.reserve(request.types.size());
+      auto& types = entry_types[request_index];
+      types.reserve(request.types.size());
       for (auto type : request.types)
       {
         types.push_back(static_cast<ons::mapping_type>(type));
         if (!ons::mapping_type_allowed(hf_version, types.back()))
           throw rpc_error{ERROR_WRONG_PARAM, "Invalid lokinet type '" + std::to_string(type) + "'"};
+        if (std::find(all_types.begin(), all_types.end(), types.back()) == all_types.end())
+          all_types.push_back(types.back());
       }
 
       // This also takes 32 raw bytes, but that is undocumented (because it is painful to pass
@@ -3518,20 +3652,52 @@ namespace cryptonote { namespace rpc {
       auto name_hash = ons::name_hash_input_to_base64(request.name_hash);
       if (!name_hash)
         throw rpc_error{ERROR_WRONG_PARAM, "Invalid name_hash: expected hash as 64 hex digits or 43/44 base64 characters"};
+      name_hashes[request_index] = std::move(*name_hash);
+    }
 
-      std::vector<ons::mapping_record> records = db.get_mappings(types, *name_hash, height);
-      for (auto const &record : records)
+    std::unordered_multimap<std::string_view, size_t> name_hash_to_request_index;
+    std::vector<std::string_view> lookup_hashes;
+    lookup_hashes.reserve(name_hashes.size());
+    for (size_t request_index = 0; request_index < name_hashes.size(); request_index++)
+    {
+      if (entry_types[request_index].empty())
+        continue;
+      std::string_view name_hash = name_hashes[request_index];
+      if (!name_hash_to_request_index.count(name_hash))
+        lookup_hashes.push_back(name_hash);
+      name_hash_to_request_index.emplace(name_hash, request_index);
+    }
+
+    ons::name_system_db &db = m_core.get_blockchain_storage().name_system_db();
+    std::vector<ons::mapping_record> records = db.get_mappings_by_name_hashes(all_types, lookup_hashes, height);
+
+    // Regroup the records by request so that the response is ordered the same way as the request
+    std::vector<std::vector<ons::mapping_record const *>> entry_records(req.entries.size());
+    for (auto const &record : records)
+    {
+      auto [begin, end] = name_hash_to_request_index.equal_range(record.name_hash);
+      for (auto it = begin; it != end; ++it)
+      {
+        auto const &types = entry_types[it->second];
+        if (std::find(types.begin(), types.end(), record.type) != types.end())
+          entry_records[it->second].push_back(&record);
+      }
+    }
+
+    for (size_t request_index = 0; request_index < entry_records.size(); request_index++)
+    {
+      for (auto const *record : entry_records[request_index])
       {
         auto& entry = res.entries.emplace_back();
         entry.entry_index                                      = request_index;
-        entry.type                                             = record.type;
-        entry.name_hash                                        = record.name_hash;
-        entry.owner                                            = record.owner.to_string(nettype());
-        if (record.backup_owner) entry.backup_owner            = record.backup_owner.to_string(nettype());
-        entry.encrypted_value                                  = oxenmq::to_hex(record.encrypted_value.to_view());
-        entry.expiration_height                                = record.expiration_height;
-        entry.update_height                                    = record.update_height;
-        entry.txid                                             = tools::type_to_hex(record.txid);
+        entry.type                                             = record->type;
+        entry.name_hash                                        = record->name_hash;
+        entry.owner                                            = record->owner.to_string(nettype());
+        if (record->backup_owner) entry.backup_owner           = record->backup_owner.to_string(nettype());
+        entry.encrypted_value                                  = oxenmq::to_hex(record->encrypted_value.to_view());
+        entry.expiration_height                                = record->expiration_height;
+        entry.update_height                                    = record->update_height;
+        entry.txid                                             = tools::type_to_hex(record->txid);
       }
     }
 
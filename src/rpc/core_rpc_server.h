@@ -31,8 +31,12 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <variant>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
@@ -149,7 +153,55 @@ namespace cryptonote::rpc {
   // Function used for getting an output distribution; this is non-static because we need to get at
   // it from the test suite, but should be considered internal.
   namespace detail {
-    std::optional<output_distribution_data> get_output_distribution(const std::function<bool(uint64_t, uint64_t, uint64_t, uint64_t&, std::vector<uint64_t>&, uint64_t&)>& f, uint64_t amount, uint64_t from_height, uint64_t to_height, const std::function<crypto::hash(uint64_t)>& get_hash, bool cumulative, uint64_t blockchain_height);
+    std::optional<output_distribution_data> get_output_distribution(const std::function<bool(uint64_t, uint64_t, uint64_t, uint64_t&, std::vector<uint64_t>&, uint64_t&)>& f, uint64_t amount, uint64_t from_height, uint64_t to_height, bool cumulative);
+
+    struct sn_response_cache_entry {
+      GET_SERVICE_NODES::request req; // Normalized request this body was built from
+      std::string block_hash;         // Hex block hash the body was built at
+      uint64_t target_height;
+      uint64_t proof_generation;      // service_node_list::proof_generation() when built
+      bool proof_fields;              // True if the body includes proof-derived fields
+      std::chrono::steady_clock::time_point built;
+      std::string body;
+    };
+
+    // The key is client controlled (it is derived from the requested fields), so only this many of
+    // the most recently used response shapes are kept.
+    constexpr size_t SN_RESPONSE_CACHE_MAX_ENTRIES = 16;
+
+    // Pre-serialized GET_SERVICE_NODES responses, one per request shape.  Each entry has its own
+    // lock, held while it is built, so that concurrent requests for a stale entry wait for a single
+    // rebuild without holding up requests for the other entries.
+    class sn_response_cache {
+    public:
+      using fresh_fn = std::function<bool(const sn_response_cache_entry&)>;
+      using build_fn = std::function<void(sn_response_cache_entry&)>;
+
+      explicit sn_response_cache(size_t max_entries = SN_RESPONSE_CACHE_MAX_ENTRIES) : m_max_entries{max_entries} {}
+
+      // Returns the body for the given key, first (re)building it from `req` with `build` if it is
+      // new or `fresh` says it is stale.  Adding an entry beyond the limit evicts the least
+      // recently used one.
+      std::string get(std::string key, GET_SERVICE_NODES::request req, const fresh_fn& fresh, const build_fn& build);
+
+      // Rebuilds the stale entries that were requested since the last refresh, and drops the ones
+      // that weren't.
+      void refresh(const fresh_fn& fresh, const build_fn& build);
+
+      size_t size() const;
+
+    private:
+      struct slot {
+        std::mutex mutex;
+        sn_response_cache_entry entry;
+        bool requested = false; // Served since the last refresh
+        uint64_t last_used = 0;
+      };
+      mutable std::mutex m_mutex;
+      std::unordered_map<std::string, std::shared_ptr<slot>> m_slots;
+      uint64_t m_use_counter = 0;
+      const size_t m_max_entries;
+    };
   }
 
   /**
@@ -271,6 +323,19 @@ namespace cryptonote::rpc {
     ONS_OWNERS_TO_NAMES::response                       invoke(ONS_OWNERS_TO_NAMES::request&& req, rpc_context context);
     ONS_RESOLVE::response                               invoke(ONS_RESOLVE::request&& req, rpc_context context);
     FLUSH_CACHE::response                               invoke(FLUSH_CACHE::request&& req, rpc_context);
+    GET_PERF_STATS::response                            invoke(GET_PERF_STATS::request&& req, rpc_context context);
+
+    /// GET_SERVICE_NODES entry point used by the RPC command registration (and thus by both the
+    /// HTTP and OMQ RPC servers): returns the serialized response, served from a per-block cache of
+    /// pre-serialized bodies for whole-list requests, and falling back to invoke() for everything
+    /// else.
+    std::string invoke_cached(GET_SERVICE_NODES::request&& req, rpc_context context);
+
+    /// Queues a rebuild (as an OxenMQ job, so not on the block processing thread) of the cached
+    /// GET_SERVICE_NODES responses that were requested since the last block so that pollers of a
+    /// new block are served from the cache.  Called when a block is added; multiple calls before
+    /// the job runs are coalesced.
+    void queue_service_nodes_cache_rebuild();
 
 #if defined(OXEN_ENABLE_INTEGRATION_TEST_HOOKS)
     void on_relay_uptime_and_votes()
@@ -315,6 +380,10 @@ private:
 
     void fill_sn_response_entry(GET_SERVICE_NODES::response::entry& entry, const service_nodes::service_node_pubkey_info &sn_info, uint64_t current_height);
 
+    bool sn_response_cache_fresh(const detail::sn_response_cache_entry& entry, const std::string& top_hash) const;
+    void build_sn_response_cache_entry(detail::sn_response_cache_entry& entry);
+    void rebuild_service_nodes_cache();
+
     //utils
     uint64_t get_block_reward(const block& blk);
     std::optional<std::string> get_random_public_node();
@@ -333,6 +402,8 @@ private:
     std::unique_ptr<bootstrap_daemon> m_bootstrap_daemon;
     std::chrono::system_clock::time_point m_bootstrap_height_check_time;
     bool m_was_bootstrap_ever_used;
+    detail::sn_response_cache m_sn_response_cache;
+    std::atomic<bool> m_sn_response_cache_rebuild_pending{false};
   };
 
 } // namespace cryptonote::rpc
@@ -341,6 +341,8 @@ KV_SERIALIZE_MAP_CODE_BEGIN(GET_NET_STATS::response)
   KV_SERIALIZE(total_bytes_in)
   KV_SERIALIZE(total_packets_out)
   KV_SERIALIZE(total_bytes_out)
+  KV_SERIALIZE(total_writes_out)
+  KV_SERIALIZE(total_write_bytes_out)
 KV_SERIALIZE_MAP_CODE_END()
 
 
@@ -1389,4 +1391,36 @@ KV_SERIALIZE_MAP_CODE_BEGIN(FLUSH_CACHE::request)
   KV_SERIALIZE_OPT(bad_blocks, false)
 KV_SERIALIZE_MAP_CODE_END()
 
+
+KV_SERIALIZE_MAP_CODE_BEGIN(GET_PERF_STATS::request)
+  KV_SERIALIZE(category)
+KV_SERIALIZE_MAP_CODE_END()
+
+
+KV_SERIALIZE_MAP_CODE_BEGIN(GET_PERF_STATS::timer)
+  KV_SERIALIZE(name)
+  KV_SERIALIZE(category)
+  KV_SERIALIZE(count)
+  KV_SERIALIZE(total_ns)
+  KV_SERIALIZE(max_ns)
+  KV_SERIALIZE(histogram)
+KV_SERIALIZE_MAP_CODE_END()
+
+
+KV_SERIALIZE_MAP_CODE_BEGIN(GET_PERF_STATS::lock_stats)
+  KV_SERIALIZE(exclusive_acquired)
+  KV_SERIALIZE(exclusive_waited)
+  KV_SERIALIZE(exclusive_wait_ns)
+  KV_SERIALIZE(shared_acquired)
+  KV_SERIALIZE(shared_waited)
+  KV_SERIALIZE(shared_wait_ns)
+KV_SERIALIZE_MAP_CODE_END()
+
+
+KV_SERIALIZE_MAP_CODE_BEGIN(GET_PERF_STATS::response)
+  KV_SERIALIZE(status)
+  KV_SERIALIZE(timers)
+  KV_SERIALIZE(blockchain_lock)
+KV_SERIALIZE_MAP_CODE_END()
+
 }
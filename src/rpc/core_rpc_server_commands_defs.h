@@ -674,6 +674,8 @@ namespace rpc {
       uint64_t total_bytes_in;
       uint64_t total_packets_out;
       uint64_t total_bytes_out;
+      uint64_t total_writes_out;            // Number of gathered socket writes used to send total_write_bytes_out
+      uint64_t total_write_bytes_out;       // Bytes sent by those writes
 
       KV_MAP_SERIALIZABLE
     };
@@ -2570,6 +2572,55 @@ namespace rpc {
     struct response : STATUS { };
   };
 
+  OXEN_RPC_DOC_INTROSPECT
+  // Get the aggregated statistics of the daemon's internal performance timers (the PERF_TIMER
+  // instrumentation of block processing, the database, etc.) and of blockchain lock contention
+  // since startup.
+  struct GET_PERF_STATS : RPC_COMMAND
+  {
+    static constexpr auto names() { return NAMES("get_perf_stats"); }
+
+    struct request
+    {
+      std::string category; // If non-empty, only return timers whose category starts with this value (e.g. "perf.blockchain").
+
+      KV_MAP_SERIALIZABLE
+    };
+
+    struct timer
+    {
+      std::string name;               // Timer name.
+      std::string category;           // Log category of the timer, e.g. "perf.blockchain".
+      uint64_t count;                 // Number of completed timer runs.
+      uint64_t total_ns;              // Sum of all runs' durations, in nanoseconds.
+      uint64_t max_ns;                // Longest run, in nanoseconds.
+      std::vector<uint64_t> histogram; // Run counts per duration bucket: element 0 counts runs under 1us, element i counts runs of [2^(i-1), 2^i) us; the last element also counts anything longer.
+
+      KV_MAP_SERIALIZABLE
+    };
+
+    struct lock_stats
+    {
+      uint64_t exclusive_acquired;    // Number of times the lock was taken exclusively (for writing).
+      uint64_t exclusive_waited;      // How many of those had to wait for the lock.
+      uint64_t exclusive_wait_ns;     // Total time spent waiting for exclusive locks, in nanoseconds.
+      uint64_t shared_acquired;       // Number of times the lock was taken shared (for reading).
+      uint64_t shared_waited;         // How many of those had to wait for the lock.
+      uint64_t shared_wait_ns;        // Total time spent waiting for shared locks, in nanoseconds.
+
+      KV_MAP_SERIALIZABLE
+    };
+
+    struct response
+    {
+      std::string status;       // Generic RPC error code. "OK" is the success value.
+      std::vector<timer> timers; // Statistics of every timer that has run at least once.
+      lock_stats blockchain_lock; // Acquisition and contention counters of the blockchain lock since startup.
+
+      KV_MAP_SERIALIZABLE
+    };
+  };
+
   /// List of all supported rpc command structs to allow compile-time enumeration of all supported
   /// RPC types.  Every type added above that has an RPC endpoint needs to be added here, and needs
   /// a core_rpc_server::invoke() overload that takes a <TYPE>::request and returns a
@@ -2656,7 +2707,8 @@ namespace rpc {
     ONS_NAMES_TO_OWNERS,
     ONS_OWNERS_TO_NAMES,
     ONS_RESOLVE,
-    FLUSH_CACHE
+    FLUSH_CACHE,
+    GET_PERF_STATS
   >;
 
 } } // namespace cryptonote::rpc
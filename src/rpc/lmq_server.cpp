@@ -363,6 +363,8 @@ bool omq_rpc::block_added(const block& block, const std::vector<transaction>& tx
     omq.send(conn, "notify.block", height, std::string_view{block.hash.data, sizeof(block.hash.data)});
   });
 
+  rpc_.queue_service_nodes_cache_rebuild();
+
   return true;
 }
 
@@ -1078,6 +1078,14 @@ wallet2::wallet2(network_type nettype, uint64_t kdf_rounds, bool unattended):
   m_last_block_reward(0),
   m_encrypt_keys_after_refresh(std::nullopt),
   m_decrypt_keys_lockers(0),
+  m_cache_log_transfers_keep(0),
+  m_cache_log_history_height(std::numeric_limits<uint64_t>::max()),
+  m_cache_log_blockchain_keep(0),
+  m_cache_log_blockchain_offset(0),
+  m_cache_log_compact(true),
+  m_cache_log_base_iv{},
+  m_cache_log_base_size(0),
+  m_cache_log_size(0),
   m_unattended(unattended),
   m_devices_registered(false),
   m_device_last_key_image_sync(0),
@@ -1443,6 +1451,7 @@ void wallet2::add_subaddress_account(const std::string& label)
   uint32_t index_major = (uint32_t)get_num_subaddress_accounts();
   expand_subaddresses({index_major, 0});
   m_subaddress_labels[index_major][0] = label;
+  m_cache_log_changed.subaddress_labels.emplace(index_major, 0);
 }
 //----------------------------------------------------------------------------------------------------
 void wallet2::add_subaddress(uint32_t index_major, const std::string& label)
@@ -1451,6 +1460,7 @@ void wallet2::add_subaddress(uint32_t index_major, const std::string& label)
   uint32_t index_minor = (uint32_t)get_num_subaddresses(index_major);
   expand_subaddresses({index_major, index_minor});
   m_subaddress_labels[index_major][index_minor] = label;
+  m_cache_log_changed.subaddress_labels.emplace(index_major, index_minor);
 }
 //----------------------------------------------------------------------------------------------------
 bool wallet2::should_expand(const cryptonote::subaddress_index &index) const
@@ -1480,9 +1490,12 @@ void wallet2::expand_subaddresses(const cryptonote::subaddress_index& index)
       for (index2.minor = 0; index2.minor < end; ++index2.minor)
       {
          const crypto::public_key &D = pkeys[index2.minor];
-         m_subaddresses[D] = index2;
+         if (m_subaddresses.insert_or_assign(D, index2).second)
+           m_cache_log_changed.subaddresses.insert(D);
       }
     }
+    for (uint32_t major = m_subaddress_labels.size(); major <= index.major; ++major)
+      m_cache_log_changed.subaddress_labels.emplace(major, 0);
     m_subaddress_labels.resize(index.major + 1, {"Untitled account"});
     m_subaddress_labels[index.major].resize(index.minor + 1);
     get_account_tags();
@@ -1497,7 +1510,8 @@ void wallet2::expand_subaddresses(const cryptonote::subaddress_index& index)
     for (; index2.minor < end; ++index2.minor)
     {
        const crypto::public_key &D = pkeys[index2.minor - begin];
-       m_subaddresses[D] = index2;
+       if (m_subaddresses.insert_or_assign(D, index2).second)
+         m_cache_log_changed.subaddresses.insert(D);
     }
     m_subaddress_labels[index.major].resize(index.minor + 1);
   }
@@ -1518,6 +1532,7 @@ void wallet2::set_subaddress_label(const cryptonote::subaddress_index& index, co
   THROW_WALLET_EXCEPTION_IF(index.major >= m_subaddress_labels.size(), error::account_index_outofbound);
   THROW_WALLET_EXCEPTION_IF(index.minor >= m_subaddress_labels[index.major].size(), error::address_index_outofbound);
   m_subaddress_labels[index.major][index.minor] = label;
+  m_cache_log_changed.subaddress_labels.emplace(index.major, index.minor);
 }
 //----------------------------------------------------------------------------------------------------
 void wallet2::set_subaddress_lookahead(size_t major, size_t minor)
@@ -1545,6 +1560,7 @@ void wallet2::set_spent(size_t idx, uint64_t height)
   LOG_PRINT_L2("Setting SPENT at " << height << ": ki " << td.m_key_image << ", amount " << print_money(td.m_amount));
   td.m_spent = true;
   td.m_spent_height = height;
+  cache_log_transfer_changed(idx);
 }
 //----------------------------------------------------------------------------------------------------
 void wallet2::set_unspent(size_t idx)
@@ -1554,6 +1570,7 @@ void wallet2::set_unspent(size_t idx)
   LOG_PRINT_L2("Setting UNSPENT: ki " << td.m_key_image << ", amount " << print_money(td.m_amount));
   td.m_spent = false;
   td.m_spent_height = 0;
+  cache_log_transfer_changed(idx);
 }
 //----------------------------------------------------------------------------------------------------
 bool wallet2::is_spent(const transfer_details &td, bool strict) const
@@ -1580,6 +1597,7 @@ void wallet2::freeze(size_t idx)
   CHECK_AND_ASSERT_THROW_MES(idx < m_transfers.size(), "Invalid transfer_details index");
   transfer_details &td = m_transfers[idx];
   td.m_frozen = true;
+  cache_log_transfer_changed(idx);
 }
 //----------------------------------------------------------------------------------------------------
 void wallet2::thaw(size_t idx)
@@ -1587,6 +1605,7 @@ void wallet2::thaw(size_t idx)
   CHECK_AND_ASSERT_THROW_MES(idx < m_transfers.size(), "Invalid transfer_details index");
   transfer_details &td = m_transfers[idx];
   td.m_frozen = false;
+  cache_log_transfer_changed(idx);
 }
 //----------------------------------------------------------------------------------------------------
 bool wallet2::frozen(size_t idx) const
@@ -2109,6 +2128,7 @@ void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote
 
         // NOTE: Pre-existing transfer already exists for the output
         auto &transfer = m_transfers[kit->second];
+        cache_log_transfer_changed(kit->second);
         THROW_WALLET_EXCEPTION_IF(blink && transfer.m_unmined_blink,
                                   error::wallet_internal_error,
                                   "Sanity check failed: A blink tx replacing an pre-existing wallet tx should not be possible; when a "
@@ -2312,6 +2332,7 @@ void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote
           //   2) the wallet set the highest amount among them to transfer_details::m_amount, and
           //   3) the wallet somehow spent that output with an amount smaller than the above amount, causing inconsistency
           td.m_amount = amount;
+          cache_log_transfer_changed(it->second);
         }
       }
       else
@@ -2347,6 +2368,7 @@ void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote
             size_t idx = i->second;
             THROW_WALLET_EXCEPTION_IF(idx >= m_transfers.size(), error::wallet_internal_error, "Output tracker cache index out of range");
             m_transfers[idx].m_uses.push_back(std::make_pair(height, txid));
+            cache_log_transfer_changed(idx);
           }
         }
       }
@@ -2356,7 +2378,10 @@ void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote
           continue;
         for (uint64_t offset: offsets)
           if (offset == td.m_global_output_index)
+          {
             td.m_uses.push_back(std::make_pair(height, txid));
+            cache_log_transfer_changed(&td - m_transfers.data());
+          }
       }
     }
   }
@@ -2483,7 +2508,11 @@ void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote
           m_callback->on_unconfirmed_money_received(height, txid, tx, payment.m_amount, payment.m_subaddr_index);
       }
       else
+      {
         m_payments.emplace(payment_id, payment);
+        if (!payment.m_unmined_blink)
+          cache_log_history_changed(height);
+      }
       LOG_PRINT_L2("Payment found in " << (pool ? blink ? "blink pool" : "pool" : "block") << ": " << payment_id << " / " << payment.m_tx_hash << " / " << payment.m_amount);
     }
 
@@ -2504,6 +2533,7 @@ void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote
       {
         pd.m_block_height = height;
         pd.m_unmined_blink = false;
+        cache_log_history_changed(height);
       }
     }
 
@@ -2526,6 +2556,7 @@ void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote
     {
       m_key_images[it->m_key_image]    = real_transfers_index;
       m_pub_keys[it->get_public_key()] = real_transfers_index;
+      cache_log_transfer_changed(real_transfers_index);
     }
   }
 
@@ -2547,6 +2578,7 @@ void wallet2::process_unconfirmed(const crypto::hash &txid, const cryptonote::tr
     if (store_tx_info()) {
       try {
         m_confirmed_txs.insert(std::make_pair(txid, confirmed_transfer_details(unconf_it->second, height)));
+        cache_log_history_changed(height);
       }
       catch (...) {
         // can fail if the tx has unexpected input types
@@ -2554,12 +2586,14 @@ void wallet2::process_unconfirmed(const crypto::hash &txid, const cryptonote::tr
       }
     }
     m_unconfirmed_txs.erase(unconf_it);
+    m_cache_log_changed.unconfirmed_txs.insert(txid);
   }
 }
 //----------------------------------------------------------------------------------------------------
 void wallet2::process_outgoing(const crypto::hash &txid, const cryptonote::transaction &tx, uint64_t height, uint64_t ts, uint64_t spent, uint64_t received, uint32_t subaddr_account, const std::set<uint32_t>& subaddr_indices)
 {
   std::pair<std::unordered_map<crypto::hash, confirmed_transfer_details>::iterator, bool> entry = m_confirmed_txs.insert(std::make_pair(txid, confirmed_transfer_details()));
+  cache_log_history_changed(height);
   // fill with the info we know, some info might already be there
   if (entry.second)
   {
@@ -3134,11 +3168,13 @@ std::vector<wallet2::get_pool_state_tx> wallet2::get_pool_state(bool refreshed)
       {
         LOG_PRINT_L1("Pending txid " << txid << " not in pool, marking as not in pool");
         pit->second.m_state = wallet2::unconfirmed_transfer_details::pending_not_in_pool;
+        m_cache_log_changed.unconfirmed_txs.insert(txid);
       }
       else if (pit->second.m_state == wallet2::unconfirmed_transfer_details::pending_not_in_pool && refreshed)
       {
         LOG_PRINT_L1("Pending txid " << txid << " not in pool, marking as failed");
         pit->second.m_state = wallet2::unconfirmed_transfer_details::failed;
+        m_cache_log_changed.unconfirmed_txs.insert(txid);
 
         // the inputs aren't spent anymore, since the tx failed
         for (size_t vini = 0; vini < pit->second.m_tx.vin.size(); ++vini)
@@ -3289,10 +3325,12 @@ void wallet2::process_pool_state(const std::vector<get_pool_state_tx> &txs)
   {
     process_new_transaction(e.tx_hash, e.tx, std::vector<uint64_t>(), 0, 0, now, false, true, e.blink, e.double_spend_seen, {});
     m_scanned_pool_txs[0].insert(e.tx_hash);
+    m_cache_log_changed.scanned_pool_txs.insert(e.tx_hash);
     if (m_scanned_pool_txs[0].size() > 5000)
     {
       std::swap(m_scanned_pool_txs[0], m_scanned_pool_txs[1]);
       m_scanned_pool_txs[0].clear();
+      cache_log_compact();
     }
   }
 }
@@ -3374,6 +3412,7 @@ bool wallet2::add_address_book_row(const cryptonote::account_public_address &add
 
   auto old_size = m_address_book.size();
   m_address_book.push_back(a);
+  m_cache_log_changed.address_book.insert(old_size);
   if(m_address_book.size() == old_size+1)
     return true;
   return false;
@@ -3392,6 +3431,7 @@ bool wallet2::set_address_book_row(size_t row_id, const cryptonote::account_publ
   if (row_id >= size)
     return false;
   m_address_book[row_id] = a;
+  m_cache_log_changed.address_book.insert(row_id);
   return true;
 }
 
@@ -3400,6 +3440,8 @@ bool wallet2::delete_address_book_row(std::size_t row_id) {
     return false;
 
   m_address_book.erase(m_address_book.begin()+row_id);
+  for (size_t idx = row_id; idx < m_address_book.size(); ++idx)
+    m_cache_log_changed.address_book.insert(idx);
 
   return true;
 }
@@ -3549,6 +3591,7 @@ void wallet2::refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blo
           cryptonote::block b;
           generate_genesis(b);
           m_blockchain.clear();
+          cache_log_compact();
           m_blockchain.push_back(get_block_hash(b));
           short_chain_history.clear();
           get_short_chain_history(short_chain_history);
@@ -3762,10 +3805,14 @@ void wallet2::detach_blockchain(uint64_t height, std::map<std::pair<uint64_t, ui
     }
   }
 
-  for (transfer_details &td: m_transfers)
+  for (size_t i = 0; i < m_transfers.size(); ++i)
   {
-    while (!td.m_uses.empty() && td.m_uses.back().first >= height)
-      td.m_uses.pop_back();
+    auto &uses = m_transfers[i].m_uses;
+    if (uses.empty() || uses.back().first < height)
+      continue;
+    while (!uses.empty() && uses.back().first >= height)
+      uses.pop_back();
+    cache_log_transfer_changed(i);
   }
 
   if (output_tracker_cache)
@@ -3791,9 +3838,12 @@ void wallet2::detach_blockchain(uint64_t height, std::map<std::pair<uint64_t, ui
   }
   transfers_detached = std::distance(it, m_transfers.end());
   m_transfers.erase(it, m_transfers.end());
+  m_cache_log_transfers_keep = std::min(m_cache_log_transfers_keep, m_transfers.size());
 
   size_t blocks_detached = m_blockchain.size() - height;
   m_blockchain.crop(height);
+  m_cache_log_blockchain_keep = std::min<uint64_t>(m_cache_log_blockchain_keep, height);
+  cache_log_history_changed(height);
 
   for (auto it = m_payments.begin(); it != m_payments.end(); )
   {
@@ -3824,6 +3874,7 @@ bool wallet2::deinit()
 //----------------------------------------------------------------------------------------------------
 bool wallet2::clear()
 {
+  cache_log_compact();
   m_blockchain.clear();
   m_transfers.clear();
   m_key_images.clear();
@@ -3846,6 +3897,7 @@ bool wallet2::clear()
 //----------------------------------------------------------------------------------------------------
 void wallet2::clear_soft(bool keep_key_images)
 {
+  cache_log_compact();
   m_blockchain.clear();
   m_transfers.clear();
   if (!keep_key_images)
@@ -5226,6 +5278,7 @@ std::string wallet2::exchange_multisig_keys(const epee::wipeable_string &passwor
       }
     }
 
+    cache_log_compact();
     m_subaddresses.clear();
     m_subaddress_labels.clear();
     add_subaddress_account(tr("Primary account"));
@@ -5720,6 +5773,11 @@ void wallet2::load(const fs::path& wallet_, const epee::wipeable_string& passwor
         iss << cache_data;
         boost::archive::portable_binary_iarchive ar(iss);
         ar >> *this;
+        if (use_fs)
+        {
+          cache_log_reset(cache_file_data.iv, cache_file_buf.size(), 0);
+          load_cache_log(cache_data);
+        }
       }
       catch(...)
       {
@@ -5898,6 +5956,14 @@ void wallet2::store_to(const fs::path &path, const epee::wipeable_string &passwo
       fs::create_directories(parent_path);
   }
 
+  // routine stores only append what changed since the last one to the cache log
+  if (same_file && store_cache_log())
+  {
+    if (m_message_store.get_active())
+      m_message_store.write_to_file(get_multisig_wallet_state(), m_mms_file);
+    return;
+  }
+
   // get wallet cache data
   std::optional<wallet2::cache_file_data> cache_file_data = get_cache_file_data(password);
   THROW_WALLET_EXCEPTION_IF(!cache_file_data, error::wallet_internal_error, "failed to generate wallet cache data");
@@ -5907,6 +5973,7 @@ void wallet2::store_to(const fs::path &path, const epee::wipeable_string &passwo
   fs::path old_address_file = m_wallet_file;
   old_address_file += ".address.txt";
   const auto& old_mms_file = m_mms_file;
+  const auto old_cache_log_file = cache_log_file();
 
   // save keys to the new file
   // if we here, main wallet file is saved and we only need to save keys and address files
@@ -5934,6 +6001,10 @@ void wallet2::store_to(const fs::path &path, const epee::wipeable_string &passwo
     // remove old message store file
     if (fs::exists(old_mms_file, ec) && !fs::remove(old_mms_file, ec))
       LOG_ERROR("error removing file: " << old_mms_file << ": " << ec.message());
+    // remove old cache log file
+    if (fs::exists(old_cache_log_file, ec) && !fs::remove(old_cache_log_file, ec))
+      LOG_ERROR("error removing file: " << old_cache_log_file << ": " << ec.message());
+    cache_log_compact();
   } else {
     // save to new file
     fs::path new_file = m_wallet_file;
@@ -5957,6 +6028,11 @@ void wallet2::store_to(const fs::path &path, const epee::wipeable_string &passwo
 #endif
     fs::rename(new_file, m_wallet_file, e);
     THROW_WALLET_EXCEPTION_IF(e, error::file_save_error, m_wallet_file, e);
+
+    // the new cache includes everything in the cache log
+    if (fs::exists(old_cache_log_file, ec) && !fs::remove(old_cache_log_file, ec))
+      LOG_ERROR("error removing file: " << old_cache_log_file << ": " << ec.message());
+    cache_log_reset(cache_file_data->iv, cache_file_data->cache_data.size(), 0);
   }
 
   if (m_message_store.get_active())
@@ -5991,6 +6067,318 @@ std::optional<wallet2::cache_file_data> wallet2::get_cache_file_data(const epee:
   }
 }
 //----------------------------------------------------------------------------------------------------
+fs::path wallet2::cache_log_file() const
+{
+  auto file = m_wallet_file;
+  file += ".cachelog";
+  return file;
+}
+//----------------------------------------------------------------------------------------------------
+void wallet2::cache_log_reset(const crypto::chacha_iv &base_iv, uint64_t base_size, uint64_t log_size)
+{
+  m_cache_log_changed_transfers.clear();
+  m_cache_log_changed = {};
+  m_cache_log_transfers_keep = m_transfers.size();
+  m_cache_log_history_height = std::numeric_limits<uint64_t>::max();
+  m_cache_log_blockchain_keep = m_blockchain.size();
+  m_cache_log_blockchain_offset = m_blockchain.offset();
+  m_cache_log_compact = false;
+  m_cache_log_base_iv = base_iv;
+  m_cache_log_base_size = base_size;
+  m_cache_log_size = log_size;
+}
+//----------------------------------------------------------------------------------------------------
+template <class t_archive>
+void wallet2::serialize_cache_log_state(t_archive &a)
+{
+  // Everything the wallet cache holds other than the containers logged incrementally by
+  // cache_log_record.  These stay small (bounded by the pool or the number of accounts), so each
+  // record carries them whole.
+  a & m_unconfirmed_payments;
+  a & m_account_tags;
+  a & m_ring_history_saved;
+  a & m_last_block_reward;
+  a & m_device_last_key_image_sync;
+  a & m_immutable_height;
+}
+//----------------------------------------------------------------------------------------------------
+bool wallet2::store_cache_log()
+{
+  if (m_cache_log_compact || m_cache_log_base_size == 0)
+    return false;
+  // the hashchain was refilled below the offset the log was started at
+  if (m_blockchain.offset() < m_cache_log_blockchain_offset || m_blockchain.size() <= m_blockchain.offset())
+    return false;
+
+  std::string blob;
+  try
+  {
+    cache_log_record record{};
+    record.base_iv = m_cache_log_base_iv;
+
+    record.transfers_keep = std::min(m_cache_log_transfers_keep, m_transfers.size());
+    auto log_transfer = [&](size_t idx) {
+      const transfer_details &td = m_transfers[idx];
+      auto ki = m_key_images.find(td.m_key_image);
+      auto pk = m_pub_keys.find(td.get_public_key());
+      record.transfers.push_back({idx, td, ki != m_key_images.end() && ki->second == idx, pk != m_pub_keys.end() && pk->second == idx});
+    };
+    for (size_t idx : m_cache_log_changed_transfers)
+    {
+      if (idx >= record.transfers_keep)
+        break;
+      log_transfer(idx);
+    }
+    for (size_t idx = record.transfers_keep; idx < m_transfers.size(); ++idx)
+      log_transfer(idx);
+
+    record.history_height = m_cache_log_history_height;
+    for (const auto &p : m_payments)
+      if (p.second.m_block_height >= record.history_height || p.second.m_unmined_blink)
+        record.payments.push_back(p);
+    if (record.history_height != std::numeric_limits<uint64_t>::max())
+      for (const auto &c : m_confirmed_txs)
+        if (c.second.m_block_height >= record.history_height)
+          record.confirmed_txs.push_back(c);
+
+    record.blockchain_keep = std::min<uint64_t>(m_cache_log_blockchain_keep, m_blockchain.size());
+    record.blockchain_offset = m_blockchain.offset();
+    record.blockchain_first = std::max(record.blockchain_keep, record.blockchain_offset);
+    for (uint64_t height = record.blockchain_first; height < m_blockchain.size(); ++height)
+      record.blockchain.push_back(m_blockchain[height]);
+
+    auto log_map = [](const auto &container, const auto &changed, auto &delta) {
+      for (const auto &key : changed)
+      {
+        if (auto it = container.find(key); it != container.end())
+          delta.set.emplace_back(it->first, it->second);
+        else
+          delta.erased.push_back(key);
+      }
+    };
+    log_map(m_unconfirmed_txs, m_cache_log_changed.unconfirmed_txs, record.unconfirmed_txs);
+    log_map(m_tx_keys, m_cache_log_changed.tx_keys, record.tx_keys);
+    log_map(m_additional_tx_keys, m_cache_log_changed.tx_keys, record.additional_tx_keys);
+    log_map(m_tx_notes, m_cache_log_changed.tx_notes, record.tx_notes);
+    log_map(m_tx_device, m_cache_log_changed.tx_device, record.tx_device);
+    log_map(m_attributes, m_cache_log_changed.attributes, record.attributes);
+    log_map(m_subaddresses, m_cache_log_changed.subaddresses, record.subaddresses);
+    log_map(m_cold_key_images, m_cache_log_changed.cold_key_images, record.cold_key_images);
+    log_map(ons_records_cache, m_cache_log_changed.ons_records, record.ons_records);
+    record.scanned_pool_txs.assign(m_cache_log_changed.scanned_pool_txs.begin(), m_cache_log_changed.scanned_pool_txs.end());
+
+    for (const auto &labels : m_subaddress_labels)
+      record.subaddress_label_counts.push_back(labels.size());
+    for (const auto &[major, minor] : m_cache_log_changed.subaddress_labels)
+      if (major < m_subaddress_labels.size() && minor < m_subaddress_labels[major].size())
+        record.subaddress_labels.emplace_back(cryptonote::subaddress_index{major, minor}, m_subaddress_labels[major][minor]);
+    record.address_book_size = m_address_book.size();
+    for (size_t idx : m_cache_log_changed.address_book)
+      if (idx < m_address_book.size())
+        record.address_book.emplace_back(idx, m_address_book[idx]);
+
+    std::stringstream oss;
+    boost::archive::portable_binary_oarchive ar(oss);
+    ar << record;
+    serialize_cache_log_state(ar);
+    const std::string plain = oss.str();
+
+    wallet2::cache_file_data cache_file_data{};
+    cache_file_data.iv = crypto::rand<crypto::chacha_iv>();
+    cache_file_data.cache_data.resize(plain.size());
+    crypto::chacha20(plain.data(), plain.size(), m_cache_key, cache_file_data.iv, &cache_file_data.cache_data[0]);
+    blob = serialization::dump_binary(cache_file_data);
+  }
+  catch (const std::exception &e)
+  {
+    MWARNING("Failed to generate wallet cache log record, storing the whole cache: " << e.what());
+    return false;
+  }
+
+  // once the log gets big, rewriting the cache is cheaper than replaying the log on every load
+  if (m_cache_log_size + blob.size() > m_cache_log_base_size / 2)
+    return false;
+
+  // a fresh log truncates whatever a previous, interrupted store may have left behind
+  fs::ofstream ostr{cache_log_file(), std::ios_base::binary | (m_cache_log_size ? std::ios_base::app : std::ios_base::trunc)};
+  ostr.write(blob.data(), blob.size());
+  ostr.close();
+  if (!ostr)
+  {
+    MWARNING("Failed to append to wallet cache log " << cache_log_file() << ", storing the whole cache");
+    return false;
+  }
+
+  cache_log_reset(m_cache_log_base_iv, m_cache_log_base_size, m_cache_log_size + blob.size());
+  return true;
+}
+//----------------------------------------------------------------------------------------------------
+void wallet2::apply_cache_log_record(cache_log_record &record)
+{
+  THROW_WALLET_EXCEPTION_IF(record.transfers_keep > m_transfers.size(), error::wallet_internal_error,
+      "Invalid wallet cache log record: transfers");
+  THROW_WALLET_EXCEPTION_IF(record.blockchain_keep < m_blockchain.offset() || record.blockchain_keep > m_blockchain.size() ||
+      record.blockchain_first < record.blockchain_keep || record.blockchain_offset > record.blockchain_first + record.blockchain.size(),
+      error::wallet_internal_error, "Invalid wallet cache log record: hashchain");
+
+  auto unmap_transfer = [this](size_t idx) {
+    const transfer_details &td = m_transfers[idx];
+    if (auto it = m_key_images.find(td.m_key_image); it != m_key_images.end() && it->second == idx)
+      m_key_images.erase(it);
+    if (auto it = m_pub_keys.find(td.get_public_key()); it != m_pub_keys.end() && it->second == idx)
+      m_pub_keys.erase(it);
+  };
+  for (size_t idx = record.transfers_keep; idx < m_transfers.size(); ++idx)
+    unmap_transfer(idx);
+  m_transfers.erase(m_transfers.begin() + record.transfers_keep, m_transfers.end());
+  for (auto &t : record.transfers)
+  {
+    if (t.index < m_transfers.size())
+    {
+      unmap_transfer(t.index);
+      m_transfers[t.index] = std::move(t.td);
+    }
+    else
+    {
+      THROW_WALLET_EXCEPTION_IF(t.index != m_transfers.size(), error::wallet_internal_error,
+          "Invalid wallet cache log record: transfer index");
+      m_transfers.push_back(std::move(t.td));
+    }
+    const transfer_details &td = m_transfers[t.index];
+    if (t.key_image_mapped)
+      m_key_images[td.m_key_image] = t.index;
+    if (t.pub_key_mapped)
+      m_pub_keys[td.get_public_key()] = t.index;
+  }
+
+  for (auto it = m_payments.begin(); it != m_payments.end(); )
+  {
+    if (it->second.m_block_height >= record.history_height || it->second.m_unmined_blink)
+      it = m_payments.erase(it);
+    else
+      ++it;
+  }
+  if (record.history_height != std::numeric_limits<uint64_t>::max())
+  {
+    for (auto it = m_confirmed_txs.begin(); it != m_confirmed_txs.end(); )
+    {
+      if (it->second.m_block_height >= record.history_height)
+        it = m_confirmed_txs.erase(it);
+      else
+        ++it;
+    }
+  }
+  for (auto &p : record.payments)
+    m_payments.emplace(p.first, std::move(p.second));
+  for (auto &c : record.confirmed_txs)
+    m_confirmed_txs[c.first] = std::move(c.second);
+
+  m_blockchain.crop(record.blockchain_keep);
+  while (m_blockchain.size() < record.blockchain_first)
+    m_blockchain.push_back(crypto::null_hash);
+  for (const auto &hash : record.blockchain)
+    m_blockchain.push_back(hash);
+  m_blockchain.trim(record.blockchain_offset);
+  THROW_WALLET_EXCEPTION_IF(m_blockchain.offset() != record.blockchain_offset, error::wallet_internal_error,
+      "Invalid wallet cache log record: hashchain offset");
+
+  auto apply_map = [](auto &container, auto &delta) {
+    for (const auto &key : delta.erased)
+      container.erase(key);
+    for (auto &e : delta.set)
+      container.insert_or_assign(e.first, std::move(e.second));
+  };
+  apply_map(m_unconfirmed_txs, record.unconfirmed_txs);
+  apply_map(m_tx_keys, record.tx_keys);
+  apply_map(m_additional_tx_keys, record.additional_tx_keys);
+  apply_map(m_tx_notes, record.tx_notes);
+  apply_map(m_tx_device, record.tx_device);
+  apply_map(m_attributes, record.attributes);
+  apply_map(m_subaddresses, record.subaddresses);
+  apply_map(m_cold_key_images, record.cold_key_images);
+  apply_map(ons_records_cache, record.ons_records);
+  m_scanned_pool_txs[0].insert(record.scanned_pool_txs.begin(), record.scanned_pool_txs.end());
+
+  m_subaddress_labels.resize(record.subaddress_label_counts.size());
+  for (size_t major = 0; major < m_subaddress_labels.size(); ++major)
+    m_subaddress_labels[major].resize(record.subaddress_label_counts[major]);
+  for (auto &[index, label] : record.subaddress_labels)
+  {
+    THROW_WALLET_EXCEPTION_IF(index.major >= m_subaddress_labels.size() || index.minor >= m_subaddress_labels[index.major].size(),
+        error::wallet_internal_error, "Invalid wallet cache log record: subaddress label");
+    m_subaddress_labels[index.major][index.minor] = std::move(label);
+  }
+  m_address_book.resize(record.address_book_size);
+  for (auto &[idx, row] : record.address_book)
+  {
+    THROW_WALLET_EXCEPTION_IF(idx >= m_address_book.size(), error::wallet_internal_error,
+        "Invalid wallet cache log record: address book row");
+    m_address_book[idx] = std::move(row);
+  }
+}
+//----------------------------------------------------------------------------------------------------
+void wallet2::load_cache_log(const std::string &base_cache_data)
+{
+  std::error_code ec;
+  const auto log_file = cache_log_file();
+  if (!fs::exists(log_file, ec) || ec)
+    return;
+
+  // Records are read and applied one at a time straight from the file, so replaying doesn't need
+  // the whole log in memory on top of the wallet.
+  uint64_t log_size = 0;
+  size_t replayed = 0, records = 0;
+  try
+  {
+    log_size = fs::file_size(log_file);
+    fs::ifstream istr{log_file, std::ios_base::binary};
+    THROW_WALLET_EXCEPTION_IF(!istr, error::file_read_error, log_file);
+    serialization::binary_unarchiver iar{istr};
+    while (iar.remaining_bytes() > 0)
+    {
+      wallet2::cache_file_data cache_file_data;
+      try {
+        serialization::value(iar, cache_file_data);
+      } catch (const std::exception &e) {
+        MWARNING("Ignoring truncated record at the end of wallet cache log " << log_file);
+        break;
+      }
+      std::string cache_data;
+      cache_data.resize(cache_file_data.cache_data.size());
+      crypto::chacha20(cache_file_data.cache_data.data(), cache_file_data.cache_data.size(), m_cache_key, cache_file_data.iv, &cache_data[0]);
+      cache_file_data.cache_data.clear();
+
+      std::stringstream iss;
+      iss << cache_data;
+      boost::archive::portable_binary_iarchive ar(iss);
+      cache_log_record record;
+      ar >> record;
+      // left over from before the last full store: everything from here on is stale
+      if (memcmp(&record.base_iv, &m_cache_log_base_iv, sizeof(crypto::chacha_iv)))
+        break;
+      apply_cache_log_record(record);
+      serialize_cache_log_state(ar);
+      replayed = iar.streampos();
+      ++records;
+    }
+  }
+  catch (const std::exception &e)
+  {
+    MERROR("Failed to replay wallet cache log " << log_file << ", discarding it: " << e.what());
+    std::stringstream iss;
+    iss << base_cache_data;
+    boost::archive::portable_binary_iarchive ar(iss);
+    ar >> *this;
+    cache_log_compact();
+    return;
+  }
+
+  LOG_PRINT_L1("Replayed " << records << " wallet cache log records (" << replayed << " bytes)");
+  cache_log_reset(m_cache_log_base_iv, m_cache_log_base_size, replayed);
+  if (replayed != log_size)
+    cache_log_compact();
+}
+//----------------------------------------------------------------------------------------------------
 uint64_t wallet2::balance(uint32_t index_major, bool strict) const
 {
   uint64_t amount = 0;
@@ -6566,6 +6954,7 @@ void wallet2::get_unconfirmed_payments(std::list<std::pair<crypto::hash,wallet2:
 //----------------------------------------------------------------------------------------------------
 void wallet2::rescan_spent()
 {
+  cache_log_compact();
   // This is RPC call that can take a long time if there are many outputs,
   // so we call it several times, in stripes, so we don't time out spuriously
   std::vector<int> spent_status;
@@ -6894,7 +7283,9 @@ uint64_t wallet2::select_transfers(uint64_t needed_money, std::vector<size_t> un
 //----------------------------------------------------------------------------------------------------
 void wallet2::add_unconfirmed_tx(const cryptonote::transaction& tx, uint64_t amount_in, const std::vector<cryptonote::tx_destination_entry> &dests, const crypto::hash &payment_id, uint64_t change_amount, uint32_t subaddr_account, const std::set<uint32_t>& subaddr_indices)
 {
-  unconfirmed_transfer_details& utd = m_unconfirmed_txs[cryptonote::get_transaction_hash(tx)];
+  const crypto::hash txid = cryptonote::get_transaction_hash(tx);
+  unconfirmed_transfer_details& utd = m_unconfirmed_txs[txid];
+  m_cache_log_changed.unconfirmed_txs.insert(txid);
   utd.m_amount_in = amount_in;
   utd.m_amount_out = 0;
   for (const auto &d: dests)
@@ -7006,6 +7397,7 @@ void wallet2::commit_tx(pending_tx& ptx, bool blink)
   {
     m_tx_keys.insert(std::make_pair(txid, ptx.tx_key));
     m_additional_tx_keys.insert(std::make_pair(txid, ptx.additional_tx_keys));
+    m_cache_log_changed.tx_keys.insert(txid);
   }
 
   LOG_PRINT_L2("transaction " << txid << " generated ok and sent to daemon, key_images: [" << ptx.key_images << "]");
@@ -7198,6 +7590,7 @@ bool wallet2::sign_tx(unsigned_tx_set &exported_txs, std::vector<wallet2::pendin
       const crypto::hash txid = get_transaction_hash(ptx.tx);
       m_tx_keys.insert(std::make_pair(txid, tx_key));
       m_additional_tx_keys.insert(std::make_pair(txid, additional_tx_keys));
+      m_cache_log_changed.tx_keys.insert(txid);
     }
 
     std::ostringstream key_images;
@@ -7444,7 +7837,10 @@ bool wallet2::parse_tx_from_str(std::string_view s, std::vector<tools::wallet2::
 
   // remember key images for this tx, for when we get those txes from the blockchain
   for (const auto &e: signed_txs.tx_key_images)
+  {
     m_cold_key_images.insert(e);
+    m_cache_log_changed.cold_key_images.insert(e.first);
+  }
 
   ptx = signed_txs.ptx;
 
@@ -7458,7 +7854,11 @@ std::string wallet2::save_multisig_tx(multisig_tx_set txs)
   // txes generated, get rid of used k values
   for (size_t n = 0; n < txs.m_ptx.size(); ++n)
     for (size_t idx: txs.m_ptx[n].construction_data.selected_transfers)
+    {
       memwipe(m_transfers[idx].m_multisig_k.data(), m_transfers[idx].m_multisig_k.size() * sizeof(m_transfers[idx].m_multisig_k[0]));
+      // must reach the cache: reloading the old k values would mean signing with them again
+      cache_log_transfer_changed(idx);
+    }
 
   // zero out some data we don't want to share
   for (auto &ptx: txs.m_ptx)
@@ -7595,6 +7995,7 @@ bool wallet2::load_multisig_tx(cryptonote::blobdata s, multisig_tx_set &exported
       {
         m_tx_keys.insert(std::make_pair(txid, ptx.tx_key));
         m_additional_tx_keys.insert(std::make_pair(txid, ptx.additional_tx_keys));
+        m_cache_log_changed.tx_keys.insert(txid);
       }
     }
   }
@@ -7723,6 +8124,7 @@ bool wallet2::sign_multisig_tx(multisig_tx_set &exported_txs, std::vector<crypto
       {
         m_tx_keys.insert(std::make_pair(txid, ptx.tx_key));
         m_additional_tx_keys.insert(std::make_pair(txid, ptx.additional_tx_keys));
+        m_cache_log_changed.tx_keys.insert(txid);
       }
       txids.push_back(txid);
     }
@@ -7731,7 +8133,10 @@ bool wallet2::sign_multisig_tx(multisig_tx_set &exported_txs, std::vector<crypto
   // txes generated, get rid of used k values
   for (size_t n = 0; n < exported_txs.m_ptx.size(); ++n)
     for (size_t idx: exported_txs.m_ptx[n].construction_data.selected_transfers)
+    {
       memwipe(m_transfers[idx].m_multisig_k.data(), m_transfers[idx].m_multisig_k.size() * sizeof(m_transfers[idx].m_multisig_k[0]));
+      cache_log_transfer_changed(idx);
+    }
 
   exported_txs.m_signers.insert(get_multisig_signer_public_key());
 
@@ -10392,6 +10797,7 @@ bool wallet2::light_wallet_import_wallet_request(light_rpc::IMPORT_WALLET_REQUES
 
 void wallet2::light_wallet_get_unspent_outs()
 {
+  cache_log_compact();
   MDEBUG("Getting unspent outs");
 
   light_rpc::GET_UNSPENT_OUTS::request oreq{};
@@ -10560,6 +10966,7 @@ bool wallet2::light_wallet_get_address_info(light_rpc::GET_ADDRESS_INFO::respons
 
 void wallet2::light_wallet_get_address_txs()
 {
+  cache_log_compact();
   MDEBUG("Refreshing light wallet");
 
   light_rpc::GET_ADDRESS_TXS::request ireq{};
@@ -10692,6 +11099,7 @@ void wallet2::light_wallet_get_address_txs()
           utd.m_timestamp = t.timestamp;
           utd.m_state = wallet2::unconfirmed_transfer_details::pending;
           m_unconfirmed_txs.emplace(tx_hash,utd);
+          m_cache_log_changed.unconfirmed_txs.insert(tx_hash);
         }
       }
       else
@@ -12136,6 +12544,7 @@ void wallet2::set_tx_key(const crypto::hash &txid, const crypto::secret_key &tx_
   THROW_WALLET_EXCEPTION_IF(additional_tx_keys.size() != additional_tx_pub_keys.data.size(), error::wallet_internal_error, "The number of additional tx secret keys doesn't agree with the number of additional tx public keys in the blockchain" );
   m_tx_keys.insert(std::make_pair(txid, tx_key));
   m_additional_tx_keys.insert(std::make_pair(txid, additional_tx_keys));
+  m_cache_log_changed.tx_keys.insert(txid);
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -13033,12 +13442,14 @@ std::vector<rpc::GET_SERVICE_NODES::response::entry> wallet2::list_current_stake
 
 void wallet2::set_ons_cache_record(wallet2::ons_detail detail)
 {
+  m_cache_log_changed.ons_records.insert(detail.hashed_name);
   ons_records_cache[detail.hashed_name] = std::move(detail);
 }
 
 void wallet2::delete_ons_cache_record(const std::string& hashed_name)
 {
   ons_records_cache.erase(hashed_name);
+  m_cache_log_changed.ons_records.insert(hashed_name);
 }
 
 std::unordered_map<std::string, wallet2::ons_detail> wallet2::get_ons_cache()
@@ -13049,6 +13460,7 @@ std::unordered_map<std::string, wallet2::ons_detail> wallet2::get_ons_cache()
 void wallet2::set_tx_note(const crypto::hash &txid, const std::string &note)
 {
   m_tx_notes[txid] = note;
+  m_cache_log_changed.tx_notes.insert(txid);
 }
 
 std::string wallet2::get_tx_note(const crypto::hash &txid) const
@@ -13062,6 +13474,7 @@ std::string wallet2::get_tx_note(const crypto::hash &txid) const
 void wallet2::set_tx_device_aux(const crypto::hash &txid, const std::string &aux)
 {
   m_tx_device[txid] = aux;
+  m_cache_log_changed.tx_device.insert(txid);
 }
 
 std::string wallet2::get_tx_device_aux(const crypto::hash &txid) const
@@ -13075,6 +13488,7 @@ std::string wallet2::get_tx_device_aux(const crypto::hash &txid) const
 void wallet2::set_attribute(const std::string &key, const std::string &value)
 {
   m_attributes[key] = value;
+  m_cache_log_changed.attributes.insert(key);
 }
 
 bool wallet2::get_attribute(const std::string &key, std::string &value) const
@@ -13444,6 +13858,7 @@ uint64_t wallet2::import_key_images_from_file(const fs::path& filename, uint64_t
 uint64_t wallet2::import_key_images(const std::vector<std::pair<crypto::key_image, crypto::signature>> &signed_key_images, size_t offset, uint64_t &spent, uint64_t &unspent, bool check_spent)
 {
   PERF_TIMER(import_key_images_lots);
+  cache_log_compact();
   rpc::IS_KEY_IMAGE_SPENT::request req{};
   rpc::IS_KEY_IMAGE_SPENT::response daemon_resp{};
 
@@ -13712,6 +14127,7 @@ uint64_t wallet2::import_key_images(const std::vector<std::pair<crypto::key_imag
 
 bool wallet2::import_key_images(std::vector<crypto::key_image> key_images, size_t offset, std::optional<std::unordered_set<size_t>> selected_transfers)
 {
+  cache_log_compact();
   if (key_images.size() + offset > m_transfers.size())
   {
     LOG_PRINT_L1("More key images returned that we know outputs for");
@@ -13759,6 +14175,7 @@ wallet2::payment_container wallet2::export_payments() const
 }
 void wallet2::import_payments(const payment_container &payments)
 {
+  cache_log_compact();
   m_payments.clear();
   for (auto const &p : payments)
   {
@@ -13767,6 +14184,7 @@ void wallet2::import_payments(const payment_container &payments)
 }
 void wallet2::import_payments_out(const std::list<std::pair<crypto::hash,wallet2::confirmed_transfer_details>> &confirmed_payments)
 {
+  cache_log_compact();
   m_confirmed_txs.clear();
   for (auto const &p : confirmed_payments)
   {
@@ -13788,6 +14206,7 @@ std::tuple<size_t,crypto::hash,std::vector<crypto::hash>> wallet2::export_blockc
 
 void wallet2::import_blockchain(const std::tuple<size_t, crypto::hash, std::vector<crypto::hash>> &bc)
 {
+  cache_log_compact();
   m_blockchain.clear();
   if (std::get<0>(bc))
   {
@@ -13850,6 +14269,7 @@ std::string wallet2::export_outputs_to_str(bool all) const
 size_t wallet2::import_outputs(const std::pair<size_t, std::vector<tools::wallet2::transfer_details>> &outputs)
 {
   PERF_TIMER(import_outputs);
+  cache_log_compact();
 
   THROW_WALLET_EXCEPTION_IF(outputs.first > m_transfers.size(), error::wallet_internal_error,
       "Imported outputs omit more outputs that we know of");
@@ -14096,6 +14516,7 @@ crypto::key_image wallet2::get_multisig_composite_key_image(size_t n) const
 //----------------------------------------------------------------------------------------------------
 cryptonote::blobdata wallet2::export_multisig()
 {
+  cache_log_compact();
   std::vector<wallet::multisig_info> info;
 
   const crypto::public_key signer = get_multisig_signer_public_key();
@@ -14147,6 +14568,7 @@ cryptonote::blobdata wallet2::export_multisig()
 //----------------------------------------------------------------------------------------------------
 void wallet2::update_multisig_rescan_info(const std::vector<std::vector<rct::key>> &multisig_k, const std::vector<std::vector<wallet::multisig_info>> &info, size_t n)
 {
+  cache_log_compact();
   CHECK_AND_ASSERT_THROW_MES(n < m_transfers.size(), "Bad index in update_multisig_info");
   CHECK_AND_ASSERT_THROW_MES(multisig_k.size() >= m_transfers.size(), "Mismatched sizes of multisig_k and info");
 
@@ -14879,6 +15301,7 @@ bool parse_priority(const std::string& arg, uint32_t& priority)
 //----------------------------------------------------------------------------------------------------
 void wallet2::finish_rescan_bc_keep_key_images(uint64_t transfer_height, const crypto::hash &hash)
 {
+  cache_log_compact();
   // Compute hash of m_transfers, if differs there had to be BC reorg.
   crypto::hash new_transfers_hash{};
   hash_m_transfers((int64_t) transfer_height, new_transfers_hash);
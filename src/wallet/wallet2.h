@@ -84,6 +84,8 @@
 #define SUBADDRESS_LOOKAHEAD_MINOR 200
 
 class Serialization_portability_wallet_Test;
+class wallet_cache_log_store_and_replay_Test;
+class wallet_cache_log_side_containers_logged_as_deltas_Test;
 class wallet_accessor_test;
 
 OXEN_RPC_DOC_INTROSPECT
@@ -233,6 +235,8 @@ private:
   class wallet2
   {
     friend class ::Serialization_portability_wallet_Test;
+    friend class ::wallet_cache_log_store_and_replay_Test;
+    friend class ::wallet_cache_log_side_containers_logged_as_deltas_Test;
     friend class ::wallet_accessor_test;
     friend class wallet_keys_unlocker;
     friend class wallet_device_callback;
@@ -424,7 +428,7 @@ private:
         FIELD(cache_data)
       END_SERIALIZE()
     };
-    
+
     // GUI Address book
     struct address_book_row
     {
@@ -445,6 +449,61 @@ private:
       crypto::signature key_image_sig;
     };
 
+    struct ons_detail
+    {
+      ons::mapping_type type;
+      std::string name;
+      std::string hashed_name;
+    };
+
+    // Incremental cache log.  Routine stores append one of these (portable binary archived, then
+    // encrypted into a cache_file_data like the wallet cache itself) to the wallet's ".cachelog" file
+    // instead of rewriting the whole cache; load() replays them on top of the wallet cache.
+    struct cache_log_transfer
+    {
+      uint64_t index;
+      transfer_details td;
+      bool key_image_mapped; // m_key_images[td.m_key_image] == index
+      bool pub_key_mapped;   // m_pub_keys[td.get_public_key()] == index
+    };
+
+    // Entries of a keyed container changed since the last cache write
+    template <typename K, typename V>
+    struct cache_log_map_delta
+    {
+      std::vector<std::pair<K, V>> set; // inserted or modified
+      std::vector<K> erased;
+    };
+
+    struct cache_log_record
+    {
+      crypto::chacha_iv base_iv;          // iv of the wallet cache file this record applies to
+      uint64_t transfers_keep;            // m_transfers is truncated to this size before applying `transfers`
+      std::vector<cache_log_transfer> transfers; // changed transfers, then new ones in index order
+      uint64_t history_height;            // payments and outgoing txes at or above this height (and unmined
+                                          // blink payments) are replaced by `payments`/`confirmed_txs`
+      std::vector<std::pair<crypto::hash, payment_details>> payments;
+      std::vector<std::pair<crypto::hash, confirmed_transfer_details>> confirmed_txs;
+      uint64_t blockchain_keep;           // m_blockchain is cropped to this size, then `blockchain` hashes are
+      uint64_t blockchain_first;          // appended starting at this height, then it is trimmed to
+      uint64_t blockchain_offset;         // this offset
+      std::vector<crypto::hash> blockchain;
+      cache_log_map_delta<crypto::hash, unconfirmed_transfer_details> unconfirmed_txs;
+      cache_log_map_delta<crypto::hash, crypto::secret_key> tx_keys;
+      cache_log_map_delta<crypto::hash, std::vector<crypto::secret_key>> additional_tx_keys;
+      cache_log_map_delta<crypto::hash, std::string> tx_notes;
+      cache_log_map_delta<crypto::hash, std::string> tx_device;
+      cache_log_map_delta<std::string, std::string> attributes;
+      cache_log_map_delta<crypto::public_key, cryptonote::subaddress_index> subaddresses;
+      cache_log_map_delta<crypto::public_key, crypto::key_image> cold_key_images;
+      cache_log_map_delta<std::string, ons_detail> ons_records;
+      std::vector<crypto::hash> scanned_pool_txs; // added to m_scanned_pool_txs[0]
+      std::vector<uint64_t> subaddress_label_counts; // m_subaddress_labels[major] is resized to these, then
+      std::vector<std::pair<cryptonote::subaddress_index, std::string>> subaddress_labels; // these labels are set
+      uint64_t address_book_size;         // m_address_book is resized to this, then
+      std::vector<std::pair<uint64_t, address_book_row>> address_book; // these rows are set
+    };
+
     typedef std::tuple<uint64_t, crypto::public_key, rct::key> get_outs_entry;
 
     struct parsed_block
@@ -821,12 +880,6 @@ private:
     auto ons_names_to_owners(cryptonote::rpc::ONS_NAMES_TO_OWNERS::request const &request) const { return m_node_rpc_proxy.ons_names_to_owners(request); }
     auto resolve(cryptonote::rpc::ONS_RESOLVE::request const &request) const { return m_node_rpc_proxy.ons_resolve(request); }
 
-    struct ons_detail
-    {
-      ons::mapping_type type;
-      std::string name;
-      std::string hashed_name;
-    };
     std::unordered_map<std::string, ons_detail> ons_records_cache;
 
     void set_ons_cache_record(wallet2::ons_detail detail);
@@ -1570,6 +1623,17 @@ private:
 
     bool should_expand(const cryptonote::subaddress_index &index) const;
 
+    fs::path cache_log_file() const;
+    void cache_log_transfer_changed(size_t idx) { m_cache_log_changed_transfers.insert(idx); }
+    void cache_log_history_changed(uint64_t height) { m_cache_log_history_height = std::min(m_cache_log_history_height, height); }
+    void cache_log_compact() { m_cache_log_compact = true; } // bulk changes (rescans, imports, ...) aren't logged
+    void cache_log_reset(const crypto::chacha_iv &base_iv, uint64_t base_size, uint64_t log_size);
+    bool store_cache_log();
+    void load_cache_log(const std::string &base_cache_data);
+    void apply_cache_log_record(cache_log_record &record);
+    template <class t_archive>
+    void serialize_cache_log_state(t_archive &a);
+
     cryptonote::account_base m_account;
     fs::path m_wallet_file;
     fs::path m_keys_file;
@@ -1690,6 +1754,25 @@ private:
     std::mutex m_decrypt_keys_mutex;
     unsigned int m_decrypt_keys_lockers;
 
+    // Incremental cache log state: what changed since the last cache write, for store_to().
+    std::set<size_t> m_cache_log_changed_transfers; // existing transfers modified
+    struct
+    {
+      std::unordered_set<crypto::hash> unconfirmed_txs, tx_keys, tx_notes, tx_device, scanned_pool_txs;
+      std::unordered_set<crypto::public_key> subaddresses, cold_key_images;
+      std::unordered_set<std::string> attributes, ons_records;
+      std::set<std::pair<uint32_t, uint32_t>> subaddress_labels; // (major, minor)
+      std::set<size_t> address_book;
+    } m_cache_log_changed;                    // side container keys set or erased
+    size_t m_cache_log_transfers_keep;        // lowest m_transfers size
+    uint64_t m_cache_log_history_height;      // lowest height of a payment/outgoing tx change
+    uint64_t m_cache_log_blockchain_keep;     // lowest m_blockchain size
+    uint64_t m_cache_log_blockchain_offset;   // m_blockchain offset at the last cache write
+    bool m_cache_log_compact;                 // the next store must rewrite the whole cache
+    crypto::chacha_iv m_cache_log_base_iv;    // iv of the wallet cache file the log applies to
+    uint64_t m_cache_log_base_size;           // size of that wallet cache file
+    uint64_t m_cache_log_size;                // current size of the log file
+
     bool m_unattended;
     bool m_devices_registered;
 
@@ -1723,6 +1806,8 @@ BOOST_CLASS_VERSION(tools::wallet2::confirmed_transfer_details, 8)
 BOOST_CLASS_VERSION(tools::wallet2::address_book_row, 18)
 BOOST_CLASS_VERSION(tools::wallet2::reserve_proof_entry, 0)
 BOOST_CLASS_VERSION(tools::wallet2::ons_detail, 1)
+BOOST_CLASS_VERSION(tools::wallet2::cache_log_transfer, 0)
+BOOST_CLASS_VERSION(tools::wallet2::cache_log_record, 1)
 
 namespace boost::serialization
 {
@@ -1942,4 +2027,51 @@ namespace boost::serialization
       a & x.key_image_sig;
     }
 
+    template <class Archive>
+    void serialize(Archive &a, tools::wallet2::cache_log_transfer &x, const unsigned int ver)
+    {
+      a & x.index;
+      a & x.td;
+      a & x.key_image_mapped;
+      a & x.pub_key_mapped;
+    }
+
+    template <class Archive, typename K, typename V>
+    void serialize(Archive &a, tools::wallet2::cache_log_map_delta<K, V> &x, const unsigned int ver)
+    {
+      a & x.set;
+      a & x.erased;
+    }
+
+    template <class Archive>
+    void serialize(Archive &a, tools::wallet2::cache_log_record &x, const unsigned int ver)
+    {
+      if (ver < 1)
+        throw std::runtime_error("unsupported wallet cache log record version");
+      a & reinterpret_cast<char (&)[sizeof(crypto::chacha_iv)]>(x.base_iv);
+      a & x.transfers_keep;
+      a & x.transfers;
+      a & x.history_height;
+      a & x.payments;
+      a & x.confirmed_txs;
+      a & x.blockchain_keep;
+      a & x.blockchain_first;
+      a & x.blockchain_offset;
+      a & x.blockchain;
+      a & x.unconfirmed_txs;
+      a & x.tx_keys;
+      a & x.additional_tx_keys;
+      a & x.tx_notes;
+      a & x.tx_device;
+      a & x.attributes;
+      a & x.subaddresses;
+      a & x.cold_key_images;
+      a & x.ons_records;
+      a & x.scanned_pool_txs;
+      a & x.subaddress_label_counts;
+      a & x.subaddress_labels;
+      a & x.address_book_size;
+      a & x.address_book;
+    }
+
 }
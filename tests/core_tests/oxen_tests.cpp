@@ -1388,15 +1388,18 @@ bool oxen_name_system_get_mappings::generate(std::vector<test_event_entry> &even
 
   ons_keys_t bob_key = make_ons_keys(bob);
   std::string session_name1 = "MyName";
-  crypto::hash session_tx_hash;
+  std::string session_name2 = "MyOtherName";
+  crypto::hash session_tx_hash, session_tx_hash2;
   {
     cryptonote::transaction tx1 = gen.create_and_add_oxen_name_system_tx(bob, gen.hardfork(), ons::mapping_type::session, session_name1, bob_key.session_value);
+    cryptonote::transaction tx2 = gen.create_and_add_oxen_name_system_tx(bob, gen.hardfork(), ons::mapping_type::session, session_name2, bob_key.session_value);
     session_tx_hash = cryptonote::get_transaction_hash(tx1);
-    gen.create_and_add_next_block({tx1});
+    session_tx_hash2 = cryptonote::get_transaction_hash(tx2);
+    gen.create_and_add_next_block({tx1, tx2});
   }
   uint64_t session_height = gen.height();
 
-  oxen_register_callback(events, "check_ons_entries", [bob_key, session_height, session_name1, session_tx_hash](cryptonote::core &c, size_t ev_index)
+  oxen_register_callback(events, "check_ons_entries", [bob_key, session_height, session_name1, session_name2, session_tx_hash, session_tx_hash2](cryptonote::core &c, size_t ev_index)
   {
     DEFINE_TESTS_ERROR_CONTEXT("check_ons_entries");
     ons::name_system_db &ons_db = c.get_blockchain_storage().name_system_db();
@@ -1404,6 +1407,25 @@ bool oxen_name_system_get_mappings::generate(std::vector<test_event_entry> &even
     std::vector<ons::mapping_record> records = ons_db.get_mappings({ons::mapping_type::session}, session_name_hash);
     CHECK_EQ(records.size(), 1);
     CHECK_TEST_CONDITION(verify_ons_mapping_record(perr_context, records[0], ons::mapping_type::session, session_name1, bob_key.session_value, session_height, std::nullopt, session_tx_hash, bob_key.owner, {} /*backup_owner*/));
+
+    // Batched lookup, including a name that doesn't exist and a duplicate
+    std::string session_name_hash2 = ons::name_to_base64_hash(tools::lowercase_ascii_string(session_name2));
+    std::string missing_name_hash = ons::name_to_base64_hash("doesnotexist");
+    records = ons_db.get_mappings_by_name_hashes({ons::mapping_type::session, ons::mapping_type::lokinet}, {session_name_hash, missing_name_hash, session_name_hash2, session_name_hash});
+    CHECK_EQ(records.size(), 2);
+    if (records[0].name_hash != session_name_hash) std::swap(records[0], records[1]);
+    CHECK_TEST_CONDITION(verify_ons_mapping_record(perr_context, records[0], ons::mapping_type::session, session_name1, bob_key.session_value, session_height, std::nullopt, session_tx_hash, bob_key.owner, {} /*backup_owner*/));
+    CHECK_TEST_CONDITION(verify_ons_mapping_record(perr_context, records[1], ons::mapping_type::session, session_name2, bob_key.session_value, session_height, std::nullopt, session_tx_hash2, bob_key.owner, {} /*backup_owner*/));
+
+    // Resolving twice should give the same answer (the second time from the cache)
+    uint64_t height = c.get_current_blockchain_height();
+    for (int i = 0; i < 2; i++)
+    {
+      auto value = ons_db.resolve(ons::mapping_type::session, session_name_hash, height);
+      CHECK_TEST_CONDITION(value);
+      CHECK_TEST_CONDITION(value->to_view() == records[0].encrypted_value.to_view());
+      CHECK_TEST_CONDITION(!ons_db.resolve(ons::mapping_type::session, missing_name_hash, height));
+    }
     return true;
   });
 
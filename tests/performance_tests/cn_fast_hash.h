@@ -55,3 +55,31 @@ public:
 private:
   std::array<uint8_t, bytes> m_data;
 };
+
+template<size_t bytes, size_t count>
+class test_cn_fast_hash_many
+{
+public:
+  static const size_t loop_count = bytes < 256 ? 100000 / count : bytes < 4096 ? 10000 / count : 1000 / count;
+
+  bool init()
+  {
+    crypto::rand(m_data.size(), m_data.data());
+    for (size_t i = 0; i < count; ++i)
+      m_inputs[i] = m_data.data() + i * bytes;
+    m_sizes.fill(bytes);
+    return true;
+  }
+
+  bool test()
+  {
+    crypto::cn_fast_hash_many(m_inputs.data(), m_sizes.data(), m_hashes.data(), count);
+    return true;
+  }
+
+private:
+  std::array<uint8_t, bytes * count> m_data;
+  std::array<const void*, count> m_inputs;
+  std::array<size_t, count> m_sizes;
+  std::array<crypto::hash, count> m_hashes;
+};
@@ -58,6 +58,9 @@
 #include "crypto_ops.h"
 #include "multiexp.h"
 #include "sig_clsag.h"
+#include "threadpool.h"
+#include "portable_storage.h"
+#include "tx_pool.h"
 
 namespace po = boost::program_options;
 
@@ -198,6 +201,9 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE0(filter, p, test_cn_slow_hash);
   TEST_PERFORMANCE1(filter, p, test_cn_fast_hash, 32);
   TEST_PERFORMANCE1(filter, p, test_cn_fast_hash, 16384);
+  TEST_PERFORMANCE2(filter, p, test_cn_fast_hash_many, 64, 64); // tree hash level
+  TEST_PERFORMANCE2(filter, p, test_cn_fast_hash_many, 2048, 16);
+  TEST_PERFORMANCE2(filter, p, test_cn_fast_hash_many, 16384, 8);
 
   TEST_PERFORMANCE3(filter, p, test_sig_clsag, 4, 2, 2); // CLSAG verification
   TEST_PERFORMANCE3(filter, p, test_sig_clsag, 8, 2, 2);
@@ -212,6 +218,18 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE2(filter, p, test_equality, verify32, false);
   TEST_PERFORMANCE2(filter, p, test_equality, verify32, false);
 
+  TEST_PERFORMANCE2(filter, p, test_threadpool, 100, false);
+  TEST_PERFORMANCE2(filter, p, test_threadpool, 100, true);
+  TEST_PERFORMANCE2(filter, p, test_threadpool, 10000, false);
+  TEST_PERFORMANCE2(filter, p, test_threadpool, 10000, true);
+
+  TEST_PERFORMANCE3(filter, p, test_portable_storage_load, 100, 10, false);
+  TEST_PERFORMANCE3(filter, p, test_portable_storage_load, 100, 10, true);
+
+  TEST_PERFORMANCE1(filter, p, test_tx_pool_remove, 1000);
+  TEST_PERFORMANCE1(filter, p, test_tx_pool_remove, 10000);
+  TEST_PERFORMANCE1(filter, p, test_tx_pool_remove, 100000);
+
   TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 1); // 1 bulletproof with 1 amount
   TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 1);
 
@@ -231,6 +249,9 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE6(filter, p, test_aggregated_bulletproof, true, 1, 8, 1, 1, 4); // 32 proofs, with 1, 2, 3, 4 amounts, 8 of each
   TEST_PERFORMANCE6(filter, p, test_aggregated_bulletproof, false, 2, 1, 1, 0, 64);
   TEST_PERFORMANCE6(filter, p, test_aggregated_bulletproof, true, 2, 1, 1, 0, 64); // 64 proof, each with 2 amounts
+  TEST_PERFORMANCE6(filter, p, test_aggregated_bulletproof, true, 2, 1, 1, 0, 1); // 1 proof with 2 amounts, batch code path
+  TEST_PERFORMANCE6(filter, p, test_aggregated_bulletproof, true, 2, 1, 1, 0, 16); // 16 proofs, each with 2 amounts
+  TEST_PERFORMANCE6(filter, p, test_aggregated_bulletproof, true, 16, 1, 1, 0, 16); // 16 proofs, each with 16 amounts
 
   TEST_PERFORMANCE1(filter, p, test_crypto_ops, op_sc_add);
   TEST_PERFORMANCE1(filter, p, test_crypto_ops, op_sc_sub);
@@ -432,6 +453,19 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE3(filter, p, test_multiexp, multiexp_pippenger_cached, 4096, 8);
   TEST_PERFORMANCE3(filter, p, test_multiexp, multiexp_pippenger_cached, 4096, 9);
 
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 2);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 4);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 8);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 16);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 32);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 64);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 128);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 256);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 512);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 1024);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 2048);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_fixed, 4096);
+
   TEST_PERFORMANCE3(filter, p, test_multiexp, multiexp_pippenger, 2, 1);
   TEST_PERFORMANCE3(filter, p, test_multiexp, multiexp_pippenger, 2, 2);
   TEST_PERFORMANCE3(filter, p, test_multiexp, multiexp_pippenger, 2, 3);
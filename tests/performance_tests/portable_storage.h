@@ -0,0 +1,68 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+#include "epee/storages/portable_storage_template_helper.h"
+
+// Decodes a sync-sized NOTIFY_RESPONSE_GET_BLOCKS payload (`blocks` blocks of `txs` ~2kB txes
+// each), either moving the blobs out of the parsed storage as the levin handlers do, or copying.
+template<size_t blocks, size_t txs, bool consume>
+class test_portable_storage_load
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool init()
+  {
+    cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request req;
+    req.current_blockchain_height = 1000000;
+    for (size_t i = 0; i < blocks; ++i)
+    {
+      auto& entry = req.blocks.emplace_back();
+      entry.block = std::string(400, static_cast<char>(i));
+      for (size_t j = 0; j < txs; ++j)
+        entry.txs.push_back(std::string(2000 + j, static_cast<char>(j)));
+    }
+    return epee::serialization::store_t_to_binary(req, m_blob);
+  }
+
+  bool test()
+  {
+    epee::serialization::portable_storage ps;
+    ps.set_consume_on_load(consume);
+    if (!ps.load_from_binary(m_blob))
+      return false;
+    cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request req;
+    return req.load(ps) && req.blocks.size() == blocks;
+  }
+
+private:
+  std::string m_blob;
+};
@@ -0,0 +1,65 @@
+// Copyright (c) 2019-2020, The Loki Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include "common/threadpool.h"
+
+// Measures the scheduling overhead of the thread pool for `items` trivial work items, either
+// submitted one at a time or as a single submit_range() call.
+template<size_t items, bool ranged>
+class test_threadpool
+{
+public:
+  static const size_t loop_count = items < 1000 ? 10000 : 1000;
+
+  bool init()
+  {
+    m_tpool.reset(tools::threadpool::getNewForUnitTests());
+    return true;
+  }
+
+  bool test()
+  {
+    tools::threadpool::waiter waiter;
+    m_counter = 0;
+    if (ranged)
+      m_tpool->submit_range(&waiter, 0, items, [this](size_t) { ++m_counter; });
+    else
+      for (size_t i = 0; i < items; ++i)
+        m_tpool->submit(&waiter, [this] { ++m_counter; });
+    waiter.wait(m_tpool.get());
+    return m_counter == items;
+  }
+
+private:
+  std::unique_ptr<tools::threadpool> m_tpool;
+  std::atomic<size_t> m_counter;
+};
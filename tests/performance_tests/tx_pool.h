@@ -0,0 +1,98 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "blockchain_db/testdb.h"
+#include "blockchain_utilities/blockchain_objects.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_core/cryptonote_core.h"
+#include "cryptonote_core/uptime_proof.h"
+
+// Measures removing txes (as happens when a block containing them is added) from a pool holding
+// `pool_size` txes; with the txid index this should not grow with the pool size.
+template<size_t pool_size>
+class test_tx_pool_remove
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool init()
+  {
+    m_objects = std::make_unique<blockchain_objects_t>();
+    auto* db = new cryptonote::TxpoolTestDB();
+    const cryptonote::test_options options{{{7, 0, 0, 0}}, 5000};
+    if (!m_objects->m_blockchain.init(db, nullptr /*ons_db*/, cryptonote::FAKECHAIN, true, &options))
+      return false;
+
+    m_txids.reserve(pool_size);
+    for (size_t i = 0; i < pool_size; ++i)
+    {
+      // The pool never verifies anything here, so a single-input v1 tx carrying a unique key image
+      // is all we need.
+      cryptonote::transaction tx;
+      tx.version = cryptonote::txversion::v1;
+      cryptonote::txin_to_key in{};
+      in.amount = 1000 + i;
+      in.key_offsets = {0};
+      in.k_image = crypto::rand<crypto::key_image>();
+      tx.vin.push_back(in);
+      tx.signatures = {{crypto::signature{}}};
+
+      cryptonote::blobdata blob = cryptonote::tx_to_blob(tx);
+      cryptonote::txpool_tx_meta_t meta{};
+      meta.weight = blob.size();
+      meta.fee = in.amount;
+      meta.receive_time = time(nullptr) - i;
+      const crypto::hash txid = cryptonote::get_transaction_hash(tx);
+      db->add_txpool_tx(txid, blob, meta);
+      m_txids.push_back(txid);
+    }
+    return m_objects->m_mempool.init(0) && m_objects->m_mempool.get_transactions_count() == pool_size;
+  }
+
+  bool test()
+  {
+    if (m_next >= m_txids.size())
+      return false; // pool exhausted: use a larger pool_size or a smaller --loop-multiplier
+
+    cryptonote::transaction tx;
+    cryptonote::blobdata blob;
+    size_t weight;
+    uint64_t fee;
+    bool relayed, do_not_relay, double_spend_seen;
+    return m_objects->m_mempool.take_tx(m_txids[m_next++], tx, blob, weight, fee, relayed, do_not_relay, double_spend_seen);
+  }
+
+private:
+  std::unique_ptr<blockchain_objects_t> m_objects;
+  std::vector<crypto::hash> m_txids;
+  size_t m_next = 0;
+};
@@ -38,6 +38,7 @@
 #include "epee/string_tools.h"
 #include "blockchain_db/blockchain_db.h"
 #include "blockchain_db/lmdb/db_lmdb.h"
+#include "blockchain_db/lmdb/chain_reader.h"
 #include "cryptonote_basic/cryptonote_format_utils.h"
 #include "common/fs.h"
 #include "common/hex.h"
@@ -335,4 +336,228 @@ TYPED_TEST(BlockchainDBTest, RetrieveBlockData)
   ASSERT_HASH_EQ(get_block_hash(this->m_blocks[1].first), hashes[1]);
 }
 
+TYPED_TEST(BlockchainDBTest, BlobViews)
+{
+  fs::path tempPath = random_tmp_file();
+  std::string dirPath = tempPath.string();
+
+  this->set_prefix(dirPath);
+
+  ASSERT_NO_THROW(this->m_db->open(dirPath, cryptonote::FAKECHAIN));
+  this->get_filenames();
+
+  db_wtxn_guard guard(this->m_db);
+
+  ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[0], t_sizes[0], t_sizes[0], t_diffs[0], t_coins[0], this->m_txs[0]));
+  ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[1], t_sizes[1], t_sizes[1], t_diffs[1], t_coins[1], this->m_txs[1]));
+
+  for (uint64_t height = 0; height < 2; ++height)
+  {
+    std::string_view view;
+    ASSERT_NO_THROW(view = this->m_db->get_block_blob_view_from_height(height));
+    ASSERT_EQ(this->m_db->get_block_blob_from_height(height), view);
+  }
+
+  for (const auto& [bl, blob] : this->m_blocks)
+  {
+    if (bl.tx_hashes.empty())
+      continue;
+    std::vector<std::string_view> views;
+    std::vector<blobdata> blobs;
+    ASSERT_TRUE(this->m_db->get_pruned_tx_blob_views_from(bl.tx_hashes.front(), bl.tx_hashes.size(), views));
+    ASSERT_TRUE(this->m_db->get_pruned_tx_blobs_from(bl.tx_hashes.front(), bl.tx_hashes.size(), blobs));
+    ASSERT_EQ(blobs.size(), views.size());
+    for (size_t i = 0; i < views.size(); ++i)
+      ASSERT_EQ(blobs[i], views[i]);
+
+    for (const auto& tx_hash : bl.tx_hashes)
+    {
+      std::string_view pruned, prunable;
+      blobdata full;
+      ASSERT_TRUE(this->m_db->get_tx_blob_views(tx_hash, pruned, prunable));
+      ASSERT_TRUE(this->m_db->get_tx_blob(tx_hash, full));
+      ASSERT_EQ(full, std::string{pruned} + std::string{prunable});
+    }
+  }
+
+  guard.stop();
+
+  // Views without a txn to keep them alive are refused
+  ASSERT_THROW(this->m_db->get_block_blob_view_from_height(0), DB_ERROR);
+}
+
+TYPED_TEST(BlockchainDBTest, BlobScans)
+{
+  fs::path tempPath = random_tmp_file();
+  std::string dirPath = tempPath.string();
+
+  this->set_prefix(dirPath);
+
+  ASSERT_NO_THROW(this->m_db->open(dirPath, cryptonote::FAKECHAIN));
+  this->get_filenames();
+
+  {
+    db_wtxn_guard guard(this->m_db);
+    ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[0], t_sizes[0], t_sizes[0], t_diffs[0], t_coins[0], this->m_txs[0]));
+    ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[1], t_sizes[1], t_sizes[1], t_diffs[1], t_coins[1], this->m_txs[1]));
+  }
+
+  std::vector<uint64_t> heights;
+  ASSERT_TRUE(this->m_db->for_blocks_range_blobs(0, 1, [&](uint64_t height, std::string_view blob) {
+    heights.push_back(height);
+    EXPECT_EQ(this->m_blocks[height].second, blob);
+    return true;
+  }));
+  ASSERT_EQ((std::vector<uint64_t>{0, 1}), heights);
+
+  // h2 is inclusive, and stopping early is reported
+  heights.clear();
+  ASSERT_FALSE(this->m_db->for_blocks_range_blobs(1, 5, [&](uint64_t height, std::string_view) {
+    heights.push_back(height);
+    return false;
+  }));
+  ASSERT_EQ(std::vector<uint64_t>{1}, heights);
+
+  size_t num_txs = 0, expected_txs = 0;
+  for (const auto& [bl, blob] : this->m_blocks)
+    expected_txs += 1 + bl.tx_hashes.size();
+  ASSERT_TRUE(this->m_db->for_all_transaction_blobs([&](const crypto::hash& hash, std::string_view pruned, std::string_view prunable) {
+    ++num_txs;
+    blobdata full;
+    EXPECT_TRUE(this->m_db->get_tx_blob(hash, full));
+    EXPECT_EQ(full, std::string{pruned} + std::string{prunable});
+    return true;
+  }, false));
+  ASSERT_EQ(expected_txs, num_txs);
+
+  size_t num_outputs = 0, expected_outputs = 0;
+  for (size_t i = 0; i < this->m_blocks.size(); ++i)
+  {
+    expected_outputs += this->m_blocks[i].first.miner_tx.vout.size();
+    for (const auto& [tx, blob] : this->m_txs[i])
+      expected_outputs += tx.vout.size();
+  }
+  ASSERT_TRUE(this->m_db->for_all_output_data([&](uint64_t amount, uint64_t amount_index, uint64_t, const output_data_t& data) {
+    ++num_outputs;
+    EXPECT_EQ(this->m_db->get_output_key(amount, amount_index, false).pubkey, data.pubkey);
+    return true;
+  }));
+  ASSERT_EQ(expected_outputs, num_outputs);
+}
+
+TEST(chain_reader, attach_requires_existing_db)
+{
+  fs::path path = random_tmp_file();
+  ASSERT_THROW(std::make_unique<chain_reader>(path, cryptonote::FAKECHAIN), DB_OPEN_FAILURE);
+  // ... and attaching must never create one
+  ASSERT_FALSE(fs::exists(path));
+}
+
+TYPED_TEST(BlockchainDBTest, BlockInfoCache)
+{
+  fs::path tempPath = random_tmp_file();
+  std::string dirPath = tempPath.string();
+
+  this->set_prefix(dirPath);
+
+  ASSERT_NO_THROW(this->m_db->open(dirPath, cryptonote::FAKECHAIN));
+  this->get_filenames();
+
+  {
+    db_wtxn_guard guard(this->m_db);
+    ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[0], t_sizes[0], t_sizes[0], t_diffs[0], t_coins[0], this->m_txs[0]));
+    ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[1], t_sizes[1], t_sizes[1], t_diffs[1], t_coins[1], this->m_txs[1]));
+  }
+
+  // Repeated lookups are served from the cached block info and must agree with what was added
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (uint64_t height = 0; height < 2; ++height)
+    {
+      ASSERT_EQ(this->m_blocks[height].first.timestamp, this->m_db->get_block_timestamp(height));
+      ASSERT_EQ(t_sizes[height], this->m_db->get_block_weight(height));
+      ASSERT_EQ(t_sizes[height], this->m_db->get_block_long_term_weight(height));
+      ASSERT_EQ(t_diffs[height], this->m_db->get_block_cumulative_difficulty(height));
+      ASSERT_EQ(t_coins[height], this->m_db->get_block_already_generated_coins(height));
+      ASSERT_HASH_EQ(get_block_hash(this->m_blocks[height].first), this->m_db->get_block_hash_from_height(height));
+    }
+    ASSERT_EQ((std::vector<uint64_t>{t_sizes[0], t_sizes[1]}), this->m_db->get_block_weights(0, 5));
+    ASSERT_EQ(2, this->m_db->get_hashes_range(0, 1).size());
+  }
+
+  // Popping the top block has to drop it from the cache
+  block popped;
+  std::vector<transaction> popped_txs;
+  ASSERT_NO_THROW(this->m_db->pop_block(popped, popped_txs));
+  ASSERT_EQ(1, this->m_db->height());
+  ASSERT_THROW(this->m_db->get_block_timestamp(1), BLOCK_DNE);
+  ASSERT_EQ(std::vector<uint64_t>{t_sizes[0]}, this->m_db->get_block_weights(0, 5));
+
+  // ... and an aborted re-add must not leave anything behind either
+  {
+    db_wtxn_guard guard(this->m_db);
+    ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[1], t_sizes[1], t_sizes[1], t_diffs[1], t_coins[1], this->m_txs[1]));
+    ASSERT_EQ(this->m_blocks[1].first.timestamp, this->m_db->get_block_timestamp(1));
+    guard.abort();
+  }
+  ASSERT_EQ(1, this->m_db->height());
+  ASSERT_THROW(this->m_db->get_block_timestamp(1), BLOCK_DNE);
+  ASSERT_HASH_EQ(get_block_hash(this->m_blocks[0].first), this->m_db->get_block_hash_from_height(0));
+}
+
+TYPED_TEST(BlockchainDBTest, ServiceNodeStates)
+{
+  using kind = service_node_state_kind;
+  fs::path tempPath = random_tmp_file();
+  std::string dirPath = tempPath.string();
+
+  this->set_prefix(dirPath);
+
+  ASSERT_NO_THROW(this->m_db->open(dirPath, cryptonote::FAKECHAIN));
+  this->get_filenames();
+
+  {
+    db_wtxn_guard guard(this->m_db);
+    for (uint64_t h : {10, 11, 12, 15})
+      this->m_db->set_service_node_state(kind::short_term, h, "st" + std::to_string(h));
+    this->m_db->set_service_node_state(kind::long_term, 10000, "lt");
+    this->m_db->set_service_node_state(kind::quorums, 11, "q");
+  }
+
+  auto collect = [this](kind k, uint64_t from, bool reverse, size_t limit = 100) {
+    std::vector<std::pair<uint64_t, std::string>> result;
+    this->m_db->for_each_service_node_state(k, from, reverse, [&](uint64_t height, std::string_view data) {
+      result.emplace_back(height, data);
+      return result.size() < limit;
+    });
+    return result;
+  };
+  using records = std::vector<std::pair<uint64_t, std::string>>;
+
+  // Kinds don't see each other's records, in either direction
+  ASSERT_EQ((records{{10, "st10"}, {11, "st11"}, {12, "st12"}, {15, "st15"}}), collect(kind::short_term, 0, false));
+  ASSERT_EQ((records{{15, "st15"}, {12, "st12"}}), collect(kind::short_term, UINT64_MAX, true, 2));
+  ASSERT_EQ((records{{12, "st12"}, {11, "st11"}, {10, "st10"}}), collect(kind::short_term, 14, true));
+  ASSERT_EQ((records{{11, "st11"}, {12, "st12"}, {15, "st15"}}), collect(kind::short_term, 11, false));
+  ASSERT_EQ((records{{10000, "lt"}}), collect(kind::long_term, UINT64_MAX, true));
+  ASSERT_EQ((records{{11, "q"}}), collect(kind::quorums, 0, false));
+  ASSERT_TRUE(collect(kind::quorums, 12, false).empty());
+
+  {
+    db_wtxn_guard guard(this->m_db);
+    this->m_db->set_service_node_state(kind::short_term, 12, "replaced");
+    this->m_db->remove_service_node_states(kind::short_term, 0, 11);
+    this->m_db->remove_service_node_states(kind::short_term, 13, UINT64_MAX);
+  }
+  ASSERT_EQ((records{{11, "st11"}, {12, "replaced"}}), collect(kind::short_term, 0, false));
+  ASSERT_EQ((records{{10000, "lt"}}), collect(kind::long_term, 0, false));
+
+  {
+    db_wtxn_guard guard(this->m_db);
+    this->m_db->clear_service_node_data();
+  }
+  for (auto k : {kind::short_term, kind::long_term, kind::quorums})
+    ASSERT_TRUE(collect(k, 0, false).empty());
+}
+
 }  // anonymous namespace
@@ -28,9 +28,11 @@
 // 
 // Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
 
+#include <atomic>
 #include <chrono>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 
 #include "gtest/gtest.h"
 
@@ -81,6 +83,30 @@ namespace
   };
 
   typedef epee::net_utils::boosted_tcp_server<test_protocol_handler> test_tcp_server;
+
+  // Queues a burst of messages as soon as a connection comes up.  The burst is much larger than the
+  // socket buffers and the client doesn't read until it is all queued, so most of the messages wait
+  // in the send queue (and get gathered into shared writes) behind a blocked write.
+  struct burst_protocol_handler : test_protocol_handler
+  {
+    static constexpr size_t message_count = 900; // stays below ABSTRACT_SERVER_SEND_QUE_MAX_COUNT
+    static constexpr size_t message_size = 50000;
+    static inline std::atomic<bool> queued{false};
+
+    burst_protocol_handler(epee::net_utils::i_service_endpoint* psnd_hndlr, config_type& config, connection_context& conn_context)
+      : test_protocol_handler{psnd_hndlr, config, conn_context}, m_send_handler{psnd_hndlr}
+    {
+    }
+
+    void after_init_connection()
+    {
+      for (size_t i = 0; i < message_count; ++i)
+        m_send_handler->do_send(epee::shared_sv{std::string(message_size, static_cast<char>(i))});
+      queued = true;
+    }
+
+    epee::net_utils::i_service_endpoint* m_send_handler;
+  };
 }
 
 TEST(boosted_tcp_server, worker_threads_are_exception_resistant)
@@ -130,3 +156,60 @@ TEST(boosted_tcp_server, worker_threads_are_exception_resistant)
   ASSERT_TRUE(srv.server_stop());
   ASSERT_TRUE(srv.deinit_server());
 }
+
+namespace
+{
+  void check_queued_sends_gathered(epee::net_utils::t_connection_type connection_type)
+  {
+    burst_protocol_handler::queued = false;
+    epee::net_utils::boosted_tcp_server<burst_protocol_handler> srv(connection_type);
+    ASSERT_TRUE(srv.init_server(test_server_port, test_server_host));
+    ASSERT_TRUE(srv.run_server(2, false));
+
+    const auto stats_before = epee::net_utils::connection_basic::get_write_stats();
+
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::socket sock(io_service);
+    sock.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(test_server_host), test_server_port));
+    for (int i = 0; i < 500 && !burst_protocol_handler::queued; ++i)
+      std::this_thread::sleep_for(10ms);
+    ASSERT_TRUE(burst_protocol_handler::queued);
+
+    std::string received(burst_protocol_handler::message_count * burst_protocol_handler::message_size, '\0');
+    boost::system::error_code ec;
+    boost::asio::read(sock, boost::asio::buffer(received), ec);
+    ASSERT_FALSE(ec);
+    for (size_t i = 0; i < burst_protocol_handler::message_count; ++i)
+      ASSERT_EQ(std::string(burst_protocol_handler::message_size, static_cast<char>(i)),
+          received.substr(i * burst_protocol_handler::message_size, burst_protocol_handler::message_size));
+
+    // The write stats are updated after the data is on the wire; give the last completion handler a moment.
+    auto stats = epee::net_utils::connection_basic::get_write_stats();
+    for (int i = 0; i < 100 && stats.buffers - stats_before.buffers < burst_protocol_handler::message_count; ++i)
+    {
+      std::this_thread::sleep_for(10ms);
+      stats = epee::net_utils::connection_basic::get_write_stats();
+    }
+    EXPECT_EQ(burst_protocol_handler::message_count, stats.buffers - stats_before.buffers);
+    EXPECT_EQ(received.size(), stats.bytes - stats_before.bytes);
+    EXPECT_LT(stats.writes - stats_before.writes, burst_protocol_handler::message_count / 2);
+
+    sock.close();
+    srv.send_stop_signal();
+    ASSERT_TRUE(srv.server_stop());
+  }
+}
+
+TEST(boosted_tcp_server, queued_sends_are_gathered)
+{
+  check_queued_sends_gathered(epee::net_utils::e_connection_type_RPC);
+}
+
+TEST(boosted_tcp_server, throttled_queued_sends_are_gathered)
+{
+  // p2p connections are speed limited; the throttle counts whole gathered writes, so they gather too
+  const auto old_limit = epee::net_utils::connection_basic::get_rate_up_limit();
+  epee::net_utils::connection_basic::set_rate_up_limit(1024 * 1024);
+  check_queued_sends_gathered(epee::net_utils::e_connection_type_P2P);
+  epee::net_utils::connection_basic::set_rate_up_limit(old_limit);
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "blockchain_db/testdb.h"
+#include "blockchain_utilities/blockchain_objects.h"
+#include "blockchain_utilities/indexed_bootstrap_file.h"
+#include "common/oxen.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_core/cryptonote_core.h"
+#include "cryptonote_core/uptime_proof.h"
+
+namespace
+{
+
+struct stored_block
+{
+  cryptonote::blobdata blob;
+  uint64_t weight;
+  cryptonote::difficulty_type cumulative_difficulty;
+  uint64_t coins_generated;
+};
+
+class TestDB: public cryptonote::BaseTestDB
+{
+public:
+  TestDB() { m_open = true; }
+
+  virtual void add_block( const cryptonote::block& blk
+                        , size_t block_weight
+                        , uint64_t long_term_block_weight
+                        , const cryptonote::difficulty_type& cumulative_difficulty
+                        , const uint64_t& coins_generated
+                        , uint64_t num_rct_outs
+                        , const crypto::hash& blk_hash
+                        ) override {
+    blocks.push_back({cryptonote::block_to_blob(blk), block_weight, cumulative_difficulty, coins_generated});
+    hashes.push_back(blk_hash);
+  }
+  virtual uint64_t height() const override { return blocks.size(); }
+  virtual crypto::hash get_block_hash_from_height(const uint64_t &height) const override { return hashes.at(height); }
+  virtual crypto::hash top_block_hash(uint64_t *block_height = NULL) const override {
+    if (block_height)
+      *block_height = hashes.size() - 1;
+    return hashes.back();
+  }
+  virtual cryptonote::blobdata get_block_blob_from_height(uint64_t height) const override { return blocks.at(height).blob; }
+  virtual size_t get_block_weight(const uint64_t& height) const override { return blocks.at(height).weight; }
+  virtual cryptonote::difficulty_type get_block_cumulative_difficulty(const uint64_t& height) const override { return blocks.at(height).cumulative_difficulty; }
+  virtual uint64_t get_block_already_generated_coins(const uint64_t& height) const override { return blocks.at(height).coins_generated; }
+  virtual bool get_tx_blob(const crypto::hash& h, cryptonote::blobdata &tx) const override {
+    auto it = txs.find(h);
+    if (it == txs.end())
+      return false;
+    tx = it->second;
+    return true;
+  }
+
+  std::vector<stored_block> blocks;
+  std::vector<crypto::hash> hashes;
+  std::unordered_map<crypto::hash, cryptonote::blobdata> txs;
+};
+
+}
+
+TEST(indexed_bootstrap_file, round_trip)
+{
+  blockchain_objects_t bc_objects;
+  auto *db = new TestDB();
+  const cryptonote::test_options test_options{{{7, 0, 0, 0}}, 5000};
+  ASSERT_TRUE(bc_objects.m_blockchain.init(db, nullptr /*ons_db*/, cryptonote::FAKECHAIN, true, &test_options));
+  ASSERT_EQ(db->height(), 1);
+
+  // Blocks carrying a varying number of (unique, unverified) txes each
+  for (uint64_t height = 1; height < 20; height++)
+  {
+    cryptonote::block b{};
+    b.major_version = 7;
+    b.prev_id = db->hashes.back();
+    b.timestamp = height;
+    for (uint64_t i = 0; i < height % 4; i++)
+    {
+      cryptonote::transaction tx;
+      tx.version = cryptonote::txversion::v1;
+      cryptonote::txin_to_key in{};
+      in.amount = height * 100 + i;
+      in.key_offsets = {0};
+      in.k_image = crypto::rand<crypto::key_image>();
+      tx.vin.push_back(in);
+      tx.signatures = {{crypto::signature{}}};
+      const crypto::hash txid = cryptonote::get_transaction_hash(tx);
+      db->txs[txid] = cryptonote::tx_to_blob(tx);
+      b.tx_hashes.push_back(txid);
+    }
+    db->blocks.push_back({cryptonote::block_to_blob(b), 1000 + height, 50 * height, 1000000 * height});
+    db->hashes.push_back(cryptonote::get_block_hash(b));
+  }
+
+  const auto dir = fs::temp_directory_path() / ("oxen-indexed-bootstrap-" + std::to_string(crypto::rand<uint64_t>()));
+  ASSERT_TRUE(fs::create_directories(dir));
+  OXEN_DEFER { std::error_code ec; fs::remove_all(dir, ec); };
+  fs::path file = dir / BLOCKCHAIN_RAW_INDEXED;
+
+  {
+    IndexedBootstrapFile exporter;
+    ASSERT_TRUE(exporter.store_blockchain_raw(&bc_objects.m_blockchain, nullptr, file));
+  }
+  ASSERT_TRUE(IndexedBootstrapFile::is_indexed_file(file));
+
+  {
+    IndexedBootstrapFile reader;
+    ASSERT_TRUE(reader.open_reader(file));
+    ASSERT_EQ(reader.block_first(), 0);
+    ASSERT_EQ(reader.block_end(), db->height());
+    EXPECT_GT(reader.span_bytes(1, db->height()), reader.span_bytes(1, 2));
+
+    for (uint64_t height = 0; height < db->height(); height++)
+    {
+      indexed_block_record record;
+      ASSERT_TRUE(reader.read_block(height, record)) << "height " << height;
+      const auto &expected = db->blocks[height];
+      EXPECT_EQ(record.block, expected.blob);
+      EXPECT_EQ(record.block_weight, expected.weight);
+      EXPECT_EQ(record.cumulative_difficulty, expected.cumulative_difficulty);
+      EXPECT_EQ(record.coins_generated, expected.coins_generated);
+
+      cryptonote::block b;
+      ASSERT_TRUE(cryptonote::parse_and_validate_block_from_blob(record.block, b));
+      ASSERT_EQ(record.txs.size(), b.tx_hashes.size());
+      for (size_t i = 0; i < record.txs.size(); i++)
+        EXPECT_EQ(record.txs[i], db->txs[b.tx_hashes[i]]);
+    }
+  }
+
+  // A file cut short (e.g. an interrupted copy) must be refused rather than read past its end
+  fs::resize_file(file, fs::file_size(file) - 1);
+  IndexedBootstrapFile reader;
+  EXPECT_FALSE(reader.open_reader(file));
+}
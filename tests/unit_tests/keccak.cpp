@@ -26,6 +26,9 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 extern "C" {
@@ -161,3 +164,31 @@ TEST(keccak, alignment)
     ASSERT_TRUE(!memcmp(md, amd, 32));
   }
 }
+
+TEST(keccak, many)
+{
+  // lengths around the block boundaries, in an order that makes the lanes finish out of step
+  static const size_t lengths[] = {0, 1, 135, 136, 137, 6000, 32, 64, 271, 272, 273, 1000, 64, 64, 5, 408, 0, 2000, 136};
+  const size_t n = sizeof(lengths) / sizeof(lengths[0]);
+
+  std::string data;
+  data.resize(6000 + n);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = i * 17;
+
+  for (size_t count = 0; count <= n; ++count)
+  {
+    std::vector<const uint8_t*> in(count);
+    std::vector<uint8_t> md(count * 32);
+    for (size_t i = 0; i < count; ++i)
+      in[i] = (const uint8_t*)data.data() + i;
+    keccak_many(in.data(), lengths, md.data(), count, 32);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      uint8_t md0[32];
+      keccak(in[i], lengths[i], md0, 32);
+      ASSERT_EQ(memcmp(md0, md.data() + i * 32, 32), 0) << "message " << i << " of " << count;
+    }
+  }
+}
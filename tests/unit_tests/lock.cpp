@@ -0,0 +1,142 @@
+// Copyright (c) 2019-2020, The Loki Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <atomic>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include "gtest/gtest.h"
+#include "common/lock.h"
+
+TEST(recursive_shared_mutex, exclusive_recursion)
+{
+  tools::recursive_shared_mutex m;
+  std::unique_lock l1{m};
+  std::unique_lock l2{m};
+  std::shared_lock l3{m};
+  ASSERT_TRUE(m.owns_exclusive());
+  l3.unlock();
+  l2.unlock();
+  ASSERT_TRUE(m.owns_exclusive());
+  l1.unlock();
+  ASSERT_FALSE(m.owns_exclusive());
+  ASSERT_EQ(m.contention().exclusive_acquired, 1);
+}
+
+TEST(recursive_shared_mutex, shared_recursion)
+{
+  tools::recursive_shared_mutex m;
+  std::shared_lock l1{m};
+  std::shared_lock l2{m};
+  ASSERT_FALSE(m.owns_exclusive());
+  ASSERT_EQ(m.contention().shared_acquired, 1);
+}
+
+TEST(recursive_shared_mutex, no_upgrade)
+{
+  tools::recursive_shared_mutex m;
+  std::shared_lock l1{m};
+  ASSERT_THROW(m.lock(), std::logic_error);
+  ASSERT_FALSE(m.try_lock());
+  l1.unlock();
+  ASSERT_TRUE(m.try_lock());
+  m.unlock();
+}
+
+TEST(recursive_shared_mutex, concurrent_readers)
+{
+  tools::recursive_shared_mutex m;
+  std::shared_lock l1{m};
+  bool other_got_shared = false, other_got_exclusive = true;
+  std::thread t{[&] {
+    other_got_shared = m.try_lock_shared();
+    if (other_got_shared)
+      m.unlock_shared();
+    other_got_exclusive = m.try_lock();
+    if (other_got_exclusive)
+      m.unlock();
+  }};
+  t.join();
+  ASSERT_TRUE(other_got_shared);
+  ASSERT_FALSE(other_got_exclusive);
+}
+
+TEST(recursive_shared_mutex, contention_counted)
+{
+  tools::recursive_shared_mutex m;
+  std::atomic<bool> started{false};
+  std::unique_lock l1{m};
+  std::thread t{[&] {
+    started = true;
+    std::shared_lock l{m};
+  }};
+  while (!started)
+    std::this_thread::yield();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  l1.unlock();
+  t.join();
+  auto stats = m.contention();
+  ASSERT_EQ(stats.shared_acquired, 1);
+  ASSERT_EQ(stats.shared_waited, 1);
+  ASSERT_GT(stats.shared_wait_time.count(), 0);
+}
+
+TEST(recursive_shared_mutex, writer_preferred)
+{
+  tools::recursive_shared_mutex m;
+  std::shared_lock l1{m};
+  std::atomic<bool> writer_started{false}, writer_done{false};
+  std::thread writer{[&] {
+    writer_started = true;
+    std::unique_lock l{m};
+    writer_done = true;
+  }};
+  while (!writer_started)
+    std::this_thread::yield();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_FALSE(writer_done);
+
+  // A new reader has to wait for the waiting writer...
+  bool other_got_shared = true;
+  std::thread reader{[&] {
+    other_got_shared = m.try_lock_shared();
+    if (other_got_shared)
+      m.unlock_shared();
+  }};
+  reader.join();
+  ASSERT_FALSE(other_got_shared);
+
+  // ...but an existing reader can still nest its shared lock
+  {
+    std::shared_lock l2{m};
+  }
+  l1.unlock();
+  writer.join();
+  ASSERT_TRUE(writer_done);
+  ASSERT_EQ(m.contention().exclusive_waited, 1);
+}
@@ -266,6 +266,37 @@ TEST(multiexp, pippenger_cached)
   }
 }
 
+TEST(multiexp, pippenger_fixed)
+{
+  static constexpr size_t N = 256;
+  std::vector<rct::MultiexpData> P(N);
+  for (size_t n = 0; n < N; ++n)
+  {
+    P[n].scalar = rct::zero();
+    ASSERT_TRUE(ge_frombytes_vartime(&P[n].point, rct::scalarmultBase(rct::skGen()).bytes) == 0);
+  }
+  std::shared_ptr<rct::pippenger_fixed_cached_data> cache = rct::pippenger_fixed_init_cache(P);
+  for (size_t n = 0; n < N/16; ++n)
+  {
+    std::vector<rct::MultiexpData> data;
+    size_t sz = 1 + crypto::rand<size_t>() % (N-1);
+    for (size_t s = 0; s < sz; ++s)
+    {
+      data.push_back({rct::skGen(), P[s].point});
+    }
+    data[0].scalar = rct::zero();
+    data.back().scalar = TESTSMALLSCALAR;
+    ASSERT_TRUE(basic(data) == pippenger_fixed(data, cache));
+    // extra points which are not in the cache
+    size_t extra = crypto::rand<size_t>() % 128;
+    for (size_t s = 0; s < extra; ++s)
+    {
+      data.push_back({rct::skGen(), get_p3(rct::scalarmultBase(rct::skGen()))});
+    }
+    ASSERT_TRUE(basic(data) == pippenger_fixed(data, cache, sz));
+  }
+}
+
 TEST(multiexp, scalarmult_triple)
 {
   std::vector<rct::MultiexpData> data;
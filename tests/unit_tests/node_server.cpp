@@ -30,11 +30,15 @@
 
 #include "gtest/gtest.h"
 #include "cryptonote_core/cryptonote_core.h"
+#include "cryptonote_core/uptime_proof.h"
 #include "p2p/net_node.h"
 #include "p2p/net_node.inl"
 #include "cryptonote_protocol/cryptonote_protocol_handler.h"
 #include "cryptonote_protocol/cryptonote_protocol_handler.inl"
 #include "cryptonote_core/blockchain.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "blockchain_utilities/blockchain_objects.h"
+#include "blockchain_db/testdb.h"
 
 #define MAKE_IPV4_ADDRESS(a,b,c,d) epee::net_utils::ipv4_network_address{MAKE_IP(a,b,c,d),0}
 #define MAKE_IPV4_ADDRESS_PORT(a,b,c,d,e) epee::net_utils::ipv4_network_address{MAKE_IP(a,b,c,d),e}
@@ -57,12 +61,13 @@ public:
   bool have_block(const crypto::hash& id) const {return true;}
   void get_blockchain_top(uint64_t& height, crypto::hash& top_id)const{height=0;top_id=crypto::null_hash;}
   std::vector<cryptonote::core::tx_verification_batch_info> parse_incoming_txs(const std::vector<cryptonote::blobdata>& tx_blobs, const cryptonote::tx_pool_options &opts) { return {}; }
+  std::vector<std::vector<cryptonote::core::tx_verification_batch_info>> parse_incoming_block_txs(const std::vector<cryptonote::block_complete_entry>& blocks) { return {}; }
   bool handle_parsed_txs(std::vector<cryptonote::core::tx_verification_batch_info> &parsed_txs, const cryptonote::tx_pool_options &opts, uint64_t *blink_rollback_height = nullptr) { if (blink_rollback_height) *blink_rollback_height = 0; return true; }
   std::vector<cryptonote::core::tx_verification_batch_info> handle_incoming_txs(const std::vector<cryptonote::blobdata>& tx_blobs, const cryptonote::tx_pool_options &opts) { return {}; }
   bool handle_incoming_tx(const cryptonote::blobdata& tx_blob, cryptonote::tx_verification_context& tvc, const cryptonote::tx_pool_options &opts) { return true; }
   std::pair<std::vector<std::shared_ptr<cryptonote::blink_tx>>, std::unordered_set<crypto::hash>> parse_incoming_blinks(const std::vector<cryptonote::serializable_blink_metadata> &blinks) { return {}; }
   int add_blinks(const std::vector<std::shared_ptr<cryptonote::blink_tx>> &blinks) { return 0; }
-  bool handle_incoming_block(const cryptonote::blobdata& block_blob, const cryptonote::block *block, cryptonote::block_verification_context& bvc, cryptonote::checkpoint_t const *checkpoint, bool update_miner_blocktemplate = true) { return true; }
+  bool handle_incoming_block(const cryptonote::blobdata& block_blob, const cryptonote::block *block, cryptonote::block_verification_context& bvc, cryptonote::checkpoint_t const *checkpoint, bool update_miner_blocktemplate = true) { added_blocks.push_back(block_blob); bvc.m_added_to_main_chain = true; return true; }
   bool handle_uptime_proof(const cryptonote::NOTIFY_UPTIME_PROOF::request &proof, bool &my_uptime_proof_confirmation) { return false; }
   bool handle_btencoded_uptime_proof(const cryptonote::NOTIFY_BTENCODED_UPTIME_PROOF::request &proof, bool &my_uptime_proof_confirmation) { return false; }
   void pause_mine(){}
@@ -70,7 +75,7 @@ public:
   bool on_idle(){return true;}
   bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, cryptonote::NOTIFY_RESPONSE_CHAIN_ENTRY::request& resp){return true;}
   bool handle_get_blocks(cryptonote::NOTIFY_REQUEST_GET_BLOCKS::request& arg, cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request& rsp, cryptonote::cryptonote_connection_context& context){return true;}
-  cryptonote::Blockchain &get_blockchain_storage() { throw std::runtime_error("Called invalid member function: please never call get_blockchain_storage on the TESTING class test_core."); }
+  cryptonote::Blockchain &get_blockchain_storage() { if (!blockchain) throw std::runtime_error("Called invalid member function: please never call get_blockchain_storage on the TESTING class test_core without a blockchain."); return *blockchain; }
   bool get_test_drop_download() const {return true;}
   bool get_test_drop_download_height() const {return true;}
   bool prepare_handle_incoming_blocks(const std::vector<cryptonote::block_complete_entry>  &blocks_entry, std::vector<cryptonote::block> &blocks) { return true; }
@@ -111,14 +116,35 @@ public:
       void unlock() {}
       bool try_lock() { return true; }
       std::shared_ptr<cryptonote::blink_tx> get_blink(crypto::hash &) { return nullptr; }
-      bool get_transaction(const crypto::hash& id, cryptonote::blobdata& tx_blob) const { return false; }
-      bool have_tx(const crypto::hash &txid) const { return false; }
+      bool get_transaction(const crypto::hash& id, cryptonote::blobdata& tx_blob) const {
+        auto it = txs.find(id);
+        if (it == txs.end())
+          return false;
+        tx_blob = it->second;
+        return true;
+      }
+      bool have_tx(const crypto::hash &txid) const { return txs.count(txid); }
+      std::vector<crypto::hash> find_short_tx_ids(const crypto::hash &salt, const std::vector<uint64_t> &short_ids) const {
+        std::vector<crypto::hash> result;
+        for (uint64_t id : short_ids)
+        {
+          auto it = short_id_index.find(id);
+          result.push_back(it == short_id_index.end() ? crypto::null_hash : it->second);
+        }
+        return result;
+      }
       std::map<uint64_t, crypto::hash> get_blink_checksums() const { return {}; }
       std::vector<crypto::hash> get_mined_blinks(const std::set<uint64_t> &) const { return {}; }
       void keep_missing_blinks(std::vector<crypto::hash> &tx_hashes) const {}
+
+      std::unordered_map<crypto::hash, cryptonote::blobdata> txs;
+      std::unordered_map<uint64_t, crypto::hash> short_id_index; // short id (salted with the chain tip) -> txid
   };
   fake_pool &get_pool() { return m_pool; }
 
+  cryptonote::Blockchain *blockchain = nullptr;
+  std::vector<cryptonote::blobdata> added_blocks;
+
 private:
   fake_pool m_pool;
 };
@@ -336,5 +362,232 @@ TEST(node_server, bind_same_p2p_port)
   EXPECT_TRUE(init(new_node(), port_another));
 }
 
+namespace
+{
+
+// Gives `context` a new connection id and the given peer address
+void connect(cryptonote::cryptonote_connection_context &context, const epee::net_utils::network_address &address)
+{
+  static_cast<epee::net_utils::connection_context_base&>(context) = epee::net_utils::connection_context_base{boost::uuids::random_generator()(), address, false};
+}
+
+// Records what the protocol handler sends, and offers it one peer with compact block support and
+// one without to relay blocks to.
+struct recording_p2p : nodetool::p2p_endpoint_stub<cryptonote::cryptonote_connection_context>
+{
+  std::vector<std::pair<int, std::string>> notified; // Sent back to the peer that sent us something
+  std::map<int, std::pair<std::string, std::vector<boost::uuids::uuid>>> relayed;
+  size_t dropped = 0;
+  cryptonote::cryptonote_connection_context compact_peer, fluffy_peer;
+
+  recording_p2p()
+  {
+    connect(compact_peer, MAKE_IPV4_ADDRESS(1,1,1,1));
+    connect(fluffy_peer, MAKE_IPV4_ADDRESS(2,2,2,2));
+  }
+
+  bool invoke_notify_to_peer(int command, const epee::span<const uint8_t> req_buff, const epee::net_utils::connection_context_base& context) override
+  {
+    notified.emplace_back(command, std::string{req_buff.begin(), req_buff.end()});
+    return true;
+  }
+  bool relay_notify_to_list(int command, const epee::span<const uint8_t> data_buff, std::vector<std::pair<epee::net_utils::zone, boost::uuids::uuid>> connections) override
+  {
+    auto &entry = relayed[command];
+    entry.first.assign(data_buff.begin(), data_buff.end());
+    for (auto &connection : connections)
+      entry.second.push_back(connection.second);
+    return true;
+  }
+  bool drop_connection(const epee::net_utils::connection_context_base& context) override
+  {
+    dropped++;
+    return true;
+  }
+  void for_each_connection(std::function<bool(cryptonote::cryptonote_connection_context&, nodetool::peerid_type, uint32_t)> f) override
+  {
+    f(compact_peer, 1, P2P_SUPPORT_FLAGS) && f(fluffy_peer, 2, P2P_SUPPORT_FLAG_FLUFFY_BLOCKS);
+  }
+};
+
+template <typename T>
+T load_request(const std::string &blob)
+{
+  T request{};
+  EXPECT_TRUE(epee::serialization::load_t_from_binary(request, blob));
+  return request;
+}
+
+struct compact_block_test : public ::testing::Test
+{
+  blockchain_objects_t bc_objects;
+  test_core core;
+  recording_p2p p2p;
+  cryptonote::t_cryptonote_protocol_handler<test_core> protocol{core, true /*offline, i.e. synchronized*/};
+  cryptonote::cryptonote_connection_context context;
+  crypto::hash tip;
+
+  void SetUp() override
+  {
+    const cryptonote::test_options test_options{{{7, 0, 0, 0}}, 5000};
+    ASSERT_TRUE(bc_objects.m_blockchain.init(new cryptonote::TxpoolTestDB(), nullptr /*ons_db*/, cryptonote::FAKECHAIN, true, &test_options));
+    core.blockchain = &bc_objects.m_blockchain;
+    tip = bc_objects.m_blockchain.get_tail_id();
+    protocol.set_p2p_endpoint(&p2p);
+    connect(context, MAKE_IPV4_ADDRESS(3,3,3,3));
+    context.m_state = cryptonote::cryptonote_connection_context::state_normal;
+  }
+
+  // A tx with a unique key image; the test core takes anything, so that's all we need
+  std::pair<crypto::hash, cryptonote::blobdata> make_tx()
+  {
+    cryptonote::transaction tx;
+    tx.version = cryptonote::txversion::v1;
+    cryptonote::txin_to_key in{};
+    in.amount = 1000;
+    in.key_offsets = {0};
+    in.k_image = crypto::rand<crypto::key_image>();
+    tx.vin.push_back(in);
+    tx.signatures = {{crypto::signature{}}};
+    return {cryptonote::get_transaction_hash(tx), cryptonote::tx_to_blob(tx)};
+  }
+
+  std::pair<crypto::hash, cryptonote::blobdata> add_pool_tx()
+  {
+    auto tx = make_tx();
+    auto &pool = core.get_pool();
+    pool.txs.insert(tx);
+    pool.short_id_index[cryptonote::get_short_tx_id(tip, tx.first)] = tx.first;
+    return tx;
+  }
+
+  cryptonote::block make_block(const std::vector<crypto::hash> &tx_hashes)
+  {
+    cryptonote::block b{};
+    b.major_version = cryptonote::network_version_7;
+    b.minor_version = cryptonote::network_version_7;
+    b.prev_id = tip;
+    b.miner_tx.version = cryptonote::txversion::v1;
+    b.miner_tx.vin.push_back(cryptonote::txin_gen{1});
+    b.tx_hashes = tx_hashes;
+    return b;
+  }
+
+  // Relays `b` to us the way relay_block does, prefilling the given txes
+  int notify_compact(cryptonote::block b, const std::map<size_t, cryptonote::blobdata> &prefill = {})
+  {
+    cryptonote::NOTIFY_NEW_COMPACT_BLOCK::request arg{};
+    arg.block_hash = cryptonote::get_block_hash(b);
+    arg.current_blockchain_height = 2;
+    for (const auto &tx_hash : b.tx_hashes)
+      arg.short_tx_ids.push_back(cryptonote::get_short_tx_id(b.prev_id, tx_hash));
+    for (const auto &[i, blob] : prefill)
+    {
+      arg.prefilled_indices.push_back(i);
+      arg.prefilled_txs.push_back(blob);
+    }
+    b.tx_hashes.clear();
+    arg.block = cryptonote::t_serializable_object_to_blob(b);
+
+    std::string blob, out;
+    epee::serialization::store_t_to_binary(arg, blob);
+    bool handled = false;
+    return protocol.handle_invoke_map(true /*is_notify*/, cryptonote::NOTIFY_NEW_COMPACT_BLOCK::ID, epee::strspan<uint8_t>(blob), out, context, handled);
+  }
+};
+
+}
+
+TEST_F(compact_block_test, reconstructs_from_pool)
+{
+  auto tx0 = add_pool_tx(), tx1 = add_pool_tx();
+  const auto b = make_block({tx0.first, tx1.first});
+  notify_compact(b);
+
+  EXPECT_EQ(p2p.dropped, 0);
+  EXPECT_TRUE(p2p.notified.empty());
+  ASSERT_EQ(core.added_blocks.size(), 1);
+  EXPECT_EQ(core.added_blocks[0], cryptonote::t_serializable_object_to_blob(b));
+}
+
+TEST_F(compact_block_test, relays_fluffy_to_peers_without_the_flag)
+{
+  auto tx0 = add_pool_tx();
+  const auto b = make_block({tx0.first});
+  notify_compact(b);
+  ASSERT_EQ(core.added_blocks.size(), 1);
+
+  ASSERT_EQ(p2p.relayed.size(), 2);
+  auto &compact = p2p.relayed[cryptonote::NOTIFY_NEW_COMPACT_BLOCK::ID];
+  EXPECT_EQ(compact.second, std::vector<boost::uuids::uuid>{p2p.compact_peer.m_connection_id});
+  auto compact_arg = load_request<cryptonote::NOTIFY_NEW_COMPACT_BLOCK::request>(compact.first);
+  EXPECT_EQ(compact_arg.block_hash, cryptonote::get_block_hash(b));
+  EXPECT_EQ(compact_arg.short_tx_ids, std::vector<uint64_t>{cryptonote::get_short_tx_id(tip, tx0.first)});
+  EXPECT_TRUE(compact_arg.prefilled_txs.empty()); // We had it in our pool, so the peer likely does too
+
+  auto &fluffy = p2p.relayed[cryptonote::NOTIFY_NEW_FLUFFY_BLOCK::ID];
+  EXPECT_EQ(fluffy.second, std::vector<boost::uuids::uuid>{p2p.fluffy_peer.m_connection_id});
+  auto fluffy_arg = load_request<cryptonote::NOTIFY_NEW_FLUFFY_BLOCK::request>(fluffy.first);
+  EXPECT_EQ(fluffy_arg.b.block, cryptonote::t_serializable_object_to_blob(b));
+}
+
+TEST_F(compact_block_test, uses_prefilled_txes)
+{
+  auto tx0 = add_pool_tx();
+  auto tx1 = make_tx();
+  const auto b = make_block({tx0.first, tx1.first});
+  notify_compact(b, {{1, tx1.second}});
+
+  EXPECT_EQ(p2p.dropped, 0);
+  EXPECT_TRUE(p2p.notified.empty());
+  ASSERT_EQ(core.added_blocks.size(), 1);
+  EXPECT_EQ(core.added_blocks[0], cryptonote::t_serializable_object_to_blob(b));
+
+  // The next hop probably doesn't have it either, so it gets prefilled onwards
+  auto compact_arg = load_request<cryptonote::NOTIFY_NEW_COMPACT_BLOCK::request>(p2p.relayed[cryptonote::NOTIFY_NEW_COMPACT_BLOCK::ID].first);
+  EXPECT_EQ(compact_arg.prefilled_indices, std::vector<uint64_t>{1});
+  EXPECT_EQ(compact_arg.prefilled_txs, std::vector<cryptonote::blobdata>{tx1.second});
+}
+
+TEST_F(compact_block_test, requests_missing_txes_by_index)
+{
+  auto tx0 = add_pool_tx();
+  auto tx1 = make_tx(), tx2 = make_tx();
+  const auto b = make_block({tx1.first, tx0.first, tx2.first});
+  notify_compact(b);
+
+  // One round trip: the unresolved txes are asked for straight away
+  EXPECT_EQ(p2p.dropped, 0);
+  EXPECT_TRUE(core.added_blocks.empty());
+  ASSERT_EQ(p2p.notified.size(), 1);
+  ASSERT_EQ(p2p.notified[0].first, cryptonote::NOTIFY_REQUEST_FLUFFY_MISSING_TX::ID);
+  auto request = load_request<cryptonote::NOTIFY_REQUEST_FLUFFY_MISSING_TX::request>(p2p.notified[0].second);
+  EXPECT_EQ(request.block_hash, cryptonote::get_block_hash(b));
+  EXPECT_EQ(request.missing_tx_indices, (std::vector<uint64_t>{0, 2}));
+  EXPECT_TRUE(context.m_requested_objects.empty());
+}
+
+TEST_F(compact_block_test, falls_back_to_fluffy_on_short_id_collision)
+{
+  // The block's tx is not in our pool, but another one with the same short id is
+  auto tx0 = add_pool_tx();
+  auto tx1 = make_tx();
+  auto &pool = core.get_pool();
+  pool.short_id_index.clear();
+  pool.short_id_index[cryptonote::get_short_tx_id(tip, tx1.first)] = tx0.first;
+
+  const auto b = make_block({tx1.first});
+  notify_compact(b);
+
+  // Not the peer's fault: get the whole block instead, without dropping it
+  EXPECT_EQ(p2p.dropped, 0);
+  EXPECT_TRUE(core.added_blocks.empty());
+  ASSERT_EQ(p2p.notified.size(), 1);
+  ASSERT_EQ(p2p.notified[0].first, cryptonote::NOTIFY_REQUEST_FLUFFY_MISSING_TX::ID);
+  auto request = load_request<cryptonote::NOTIFY_REQUEST_FLUFFY_MISSING_TX::request>(p2p.notified[0].second);
+  EXPECT_EQ(request.block_hash, cryptonote::get_block_hash(b));
+  EXPECT_TRUE(request.missing_tx_indices.empty());
+}
+
 namespace nodetool { template class node_server<cryptonote::t_cryptonote_protocol_handler<test_core>>; }
 namespace cryptonote { template class t_cryptonote_protocol_handler<test_core>; }
@@ -93,43 +93,36 @@ bool get_output_distribution(uint64_t amount, uint64_t from, uint64_t to, uint64
   return r && blockchain->get_output_distribution(amount, from, to, start_height, distribution, base);
 }
 
-crypto::hash get_block_hash(uint64_t height)
-{
-  crypto::hash hash = crypto::null_hash;
-  *((uint64_t*)&hash) = height;
-  return hash;
-}
-
 TEST(output_distribution, extend)
 {
   std::optional<cryptonote::rpc::output_distribution_data> res;
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 29, ::get_block_hash, false, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 29, false);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 2);
   ASSERT_EQ(res->distribution, std::vector<uint64_t>({5, 0}));
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 29, ::get_block_hash, true, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 29, true);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 2);
   ASSERT_EQ(res->distribution, std::vector<uint64_t>({55, 55}));
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 30, ::get_block_hash, false, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 30, false);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 3);
   ASSERT_EQ(res->distribution, std::vector<uint64_t>({5, 0, 2}));
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 30, ::get_block_hash, true, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 30, true);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 3);
   ASSERT_EQ(res->distribution, std::vector<uint64_t>({55, 55, 57}));
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 31, ::get_block_hash, false, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 31, false);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 4);
   ASSERT_EQ(res->distribution, std::vector<uint64_t>({5, 0, 2, 3}));
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 31, ::get_block_hash, true, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 28, 31, true);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 4);
   ASSERT_EQ(res->distribution, std::vector<uint64_t>({55, 55, 57, 60}));
@@ -139,7 +132,7 @@ TEST(output_distribution, one)
 {
   std::optional<cryptonote::rpc::output_distribution_data> res;
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 0, 0, ::get_block_hash, false, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 0, 0, false);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 1);
   ASSERT_EQ(res->distribution.back(), 0);
@@ -149,7 +142,7 @@ TEST(output_distribution, full_cumulative)
 {
   std::optional<cryptonote::rpc::output_distribution_data> res;
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 0, 31, ::get_block_hash, true, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 0, 31, true);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 32);
   ASSERT_EQ(res->distribution.back(), 60);
@@ -159,7 +152,7 @@ TEST(output_distribution, full_noncumulative)
 {
   std::optional<cryptonote::rpc::output_distribution_data> res;
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 0, 31, ::get_block_hash, false, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 0, 31, false);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 32);
   for (size_t i = 0; i < 32; ++i)
@@ -170,7 +163,7 @@ TEST(output_distribution, part_cumulative)
 {
   std::optional<cryptonote::rpc::output_distribution_data> res;
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 4, 8, ::get_block_hash, true, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 4, 8, true);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 5);
   ASSERT_EQ(res->distribution, std::vector<uint64_t>({0, 1, 6, 7, 11}));
@@ -180,8 +173,41 @@ TEST(output_distribution, part_noncumulative)
 {
   std::optional<cryptonote::rpc::output_distribution_data> res;
 
-  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 4, 8, ::get_block_hash, false, test_distribution_size);
+  res = cryptonote::rpc::detail::get_output_distribution(::get_output_distribution, 0, 4, 8, false);
   ASSERT_TRUE(res != std::nullopt);
   ASSERT_EQ(res->distribution.size(), 5);
   ASSERT_EQ(res->distribution, std::vector<uint64_t>({0, 1, 5, 1, 4}));
 }
+
+TEST(output_distribution, cached_height_changes)
+{
+  blockchain_objects_t bc = {};
+  struct get_test_options {
+    const std::vector<cryptonote::hard_fork> hard_forks{{1,0,0,0}};
+    const cryptonote::test_options test_options = {
+      hard_forks
+    };
+  } opts;
+  auto *db = new TestDB(20);
+  cryptonote::Blockchain &blockchain = bc.m_blockchain;
+  ASSERT_TRUE(blockchain.init(db, nullptr /*ons_db*/, cryptonote::FAKECHAIN, true, &opts.test_options, 0, NULL));
+
+  uint64_t start_height, base;
+  std::vector<uint64_t> distribution;
+  ASSERT_TRUE(blockchain.get_output_distribution(0, 4, 8, start_height, distribution, base));
+  ASSERT_EQ(distribution, std::vector<uint64_t>({0, 1, 6, 7, 11}));
+  ASSERT_EQ(base, 0);
+
+  // Chain grows: the cached prefix sums get extended
+  db->blockchain_height = 32;
+  ASSERT_TRUE(blockchain.get_output_distribution(0, 28, 31, start_height, distribution, base));
+  ASSERT_EQ(distribution, std::vector<uint64_t>({55, 55, 57, 60}));
+  ASSERT_EQ(base, 50);
+
+  // Chain shrinks: heights above the top are gone, lower ones are still answered
+  db->blockchain_height = 10;
+  ASSERT_FALSE(blockchain.get_output_distribution(0, 28, 31, start_height, distribution, base));
+  ASSERT_TRUE(blockchain.get_output_distribution(0, 7, 9, start_height, distribution, base));
+  ASSERT_EQ(distribution, std::vector<uint64_t>({7, 11, 11}));
+  ASSERT_EQ(base, 6);
+}
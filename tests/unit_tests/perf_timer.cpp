@@ -0,0 +1,108 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+#include "common/perf_timer.h"
+
+#include <optional>
+#include <thread>
+
+#undef OXEN_DEFAULT_LOG_CATEGORY
+#define OXEN_DEFAULT_LOG_CATEGORY "test.perf_timer"
+
+namespace {
+
+std::optional<tools::performance_timer_stats> find_stats(const char *name)
+{
+  for (auto& s : tools::get_performance_timer_stats())
+    if (s.name == name && s.category == "perf." OXEN_DEFAULT_LOG_CATEGORY)
+      return s;
+  return std::nullopt;
+}
+
+void timed_scope()
+{
+  PERF_TIMER(timed_scope);
+}
+
+}
+
+TEST(perf_timer, register_is_idempotent)
+{
+  size_t a = tools::register_performance_timer("same_name", "perf.test");
+  size_t b = tools::register_performance_timer("same_name", "perf.test");
+  size_t c = tools::register_performance_timer("same_name", "perf.other");
+  ASSERT_EQ(a, b);
+  ASSERT_NE(a, c);
+}
+
+TEST(perf_timer, aggregates_across_threads)
+{
+  for (int i = 0; i < 10; i++)
+    timed_scope();
+  std::thread t1{[] { for (int i = 0; i < 20; i++) timed_scope(); }};
+  t1.join();
+  std::thread t2{[] { for (int i = 0; i < 30; i++) timed_scope(); }};
+  t2.join();
+
+  // The runs of both exited threads are kept, along with this (still running) thread's
+  auto stats = find_stats("timed_scope");
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->count, 60);
+  uint64_t histogram_total = 0;
+  for (auto n : stats->histogram)
+    histogram_total += n;
+  EXPECT_EQ(histogram_total, 60);
+  EXPECT_LE(stats->max_ns, stats->total_ns);
+}
+
+TEST(perf_timer, histogram_buckets)
+{
+  size_t id = tools::register_performance_timer("histogram_buckets", "perf." OXEN_DEFAULT_LOG_CATEGORY);
+  tools::record_performance_timer(id, 999);          // < 1us
+  tools::record_performance_timer(id, 1000);         // [1, 2)us
+  tools::record_performance_timer(id, 3500);         // [2, 4)us
+  tools::record_performance_timer(id, 1'000'000);    // [512, 1024)us
+  tools::record_performance_timer(id, UINT64_MAX);   // overflows into the last bucket
+
+  auto stats = find_stats("histogram_buckets");
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->count, 5);
+  EXPECT_EQ(stats->max_ns, UINT64_MAX);
+  EXPECT_EQ(stats->histogram[0], 1);
+  EXPECT_EQ(stats->histogram[1], 1);
+  EXPECT_EQ(stats->histogram[2], 1);
+  EXPECT_EQ(stats->histogram[10], 1);
+  EXPECT_EQ(stats->histogram[tools::PERFORMANCE_TIMER_BUCKETS - 1], 1);
+}
+
+TEST(perf_timer, unused_timers_are_omitted)
+{
+  tools::register_performance_timer("never_run", "perf." OXEN_DEFAULT_LOG_CATEGORY);
+  ASSERT_FALSE(find_stats("never_run"));
+}
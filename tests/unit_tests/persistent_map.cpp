@@ -0,0 +1,134 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+#include "common/persistent_map.h"
+
+#include <map>
+#include <string>
+
+using pmap = tools::persistent_map<int, std::string, std::hash<int>, 16>;
+
+TEST(persistent_map, basic)
+{
+  pmap m;
+  ASSERT_TRUE(m.empty());
+  ASSERT_TRUE(m.emplace(1, "one").second);
+  ASSERT_FALSE(m.emplace(1, "uno").second);
+  m[2] = "two";
+  m[17] = "seventeen"; // same shard as 1
+  ASSERT_EQ(m.size(), 3);
+  ASSERT_EQ(m.at(1), "one");
+  ASSERT_EQ(m.find(17)->second, "seventeen");
+  ASSERT_EQ(m.count(3), 0);
+  ASSERT_THROW(m.at(3), std::out_of_range);
+  ASSERT_THROW(m.get_mutable(3), std::out_of_range);
+  m.get_mutable(2) = "deux";
+  ASSERT_EQ(m.at(2), "deux");
+  ASSERT_EQ(m.erase(1), 1);
+  ASSERT_EQ(m.erase(1), 0);
+  ASSERT_EQ(m.size(), 2);
+  ASSERT_EQ(m.at(17), "seventeen");
+}
+
+TEST(persistent_map, copies_are_independent)
+{
+  pmap a;
+  for (int i = 0; i < 100; i++)
+    a[i] = std::to_string(i);
+
+  pmap b = a;
+  ASSERT_EQ(b.shared_shards(a), 16);
+
+  b.get_mutable(5) = "five";
+  b.erase(6);
+  b[1000] = "thousand";
+  ASSERT_EQ(a.at(5), "5");
+  ASSERT_EQ(a.count(6), 1);
+  ASSERT_EQ(a.count(1000), 0);
+  ASSERT_EQ(a.size(), 100);
+  ASSERT_EQ(b.at(5), "five");
+  ASSERT_EQ(b.count(6), 0);
+  ASSERT_EQ(b.size(), 100);
+  // Only the shards holding 5, 6 and 1000 should have been copied
+  ASSERT_EQ(b.shared_shards(a), 13);
+}
+
+TEST(persistent_map, iteration)
+{
+  pmap m;
+  std::map<int, std::string> expected;
+  for (int i = 0; i < 50; i += 3)
+    expected[i] = m[i] = std::to_string(i);
+
+  std::map<int, std::string> seen{m.begin(), m.end()};
+  ASSERT_EQ(seen, expected);
+  ASSERT_EQ(std::distance(m.begin(), m.end()), m.size());
+
+  pmap copy = m;
+  for (auto it = m.begin(); it != m.end(); )
+  {
+    if (it->first % 2 == 0)
+      it = m.erase(it);
+    else
+      ++it;
+  }
+  for (auto& [k, v] : m)
+    ASSERT_EQ(k % 2, 1);
+  ASSERT_EQ(m.size(), 8);
+  ASSERT_EQ(copy.size(), 17);
+
+  m.clear();
+  ASSERT_TRUE(m.empty());
+  ASSERT_EQ(m.begin(), m.end());
+}
+
+TEST(persistent_map, diff)
+{
+  pmap a;
+  for (int i = 0; i < 40; i++)
+    a[i] = std::to_string(i);
+
+  pmap b = a;
+  b.get_mutable(3) = "three";
+  b.erase(20);
+  b[100] = "hundred";
+  b[7] = "7"; // same value: not reported
+
+  std::map<int, std::string> changed;
+  std::vector<int> removed;
+  b.diff(a, [&](auto& kv) { changed.insert(kv); }, [&](int k) { removed.push_back(k); });
+  ASSERT_EQ(changed, (std::map<int, std::string>{{3, "three"}, {100, "hundred"}}));
+  ASSERT_EQ(removed, std::vector<int>{20});
+
+  changed.clear();
+  removed.clear();
+  a.diff(pmap{}, [&](auto& kv) { changed.insert(kv); }, [&](int k) { removed.push_back(k); });
+  ASSERT_EQ(changed.size(), 40);
+  ASSERT_TRUE(removed.empty());
+}
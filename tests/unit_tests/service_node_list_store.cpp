@@ -0,0 +1,318 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define IN_UNIT_TESTS
+
+#include <map>
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "cryptonote_core/blockchain.h"
+#include "cryptonote_core/cryptonote_core.h"
+#include "cryptonote_core/service_node_list.h"
+#include "cryptonote_core/uptime_proof.h"
+#include "blockchain_utilities/blockchain_objects.h"
+#include "blockchain_db/testdb.h"
+#include "serialization/binary_utils.h"
+
+namespace
+{
+
+using sn_list_t = service_nodes::service_node_list;
+using kind = cryptonote::service_node_state_kind;
+
+// Archived states are kept at multiples of 10000 blocks
+constexpr uint64_t ARCHIVE_HEIGHT = 10000;
+
+// TxpoolTestDB's chain plus in-memory service node tables, both the per-height records and the old
+// whole-history blobs.
+class StateTestDB : public cryptonote::TxpoolTestDB {
+public:
+  void set_service_node_data(const std::string& data, bool long_term) override { blobs[long_term] = data; }
+  bool get_service_node_data(std::string& data, bool long_term) const override {
+    auto it = blobs.find(long_term);
+    if (it == blobs.end())
+      return false;
+    data = it->second;
+    return true;
+  }
+  void clear_service_node_data() override {
+    blobs.clear();
+    states.clear();
+  }
+  void set_service_node_state(kind k, uint64_t height, std::string_view data) override { states[k][height] = data; }
+  void for_each_service_node_state(kind k, uint64_t from_height, bool reverse, std::function<bool(uint64_t, std::string_view)> f) const override {
+    auto it = states.find(k);
+    if (it == states.end())
+      return;
+    auto &records = it->second;
+    if (reverse)
+    {
+      for (auto rit = std::make_reverse_iterator(records.upper_bound(from_height)); rit != records.rend(); rit++)
+        if (!f(rit->first, rit->second))
+          return;
+    }
+    else
+    {
+      for (auto fit = records.lower_bound(from_height); fit != records.end(); fit++)
+        if (!f(fit->first, fit->second))
+          return;
+    }
+  }
+  void remove_service_node_states(kind k, uint64_t begin, uint64_t end) override {
+    auto &records = states[k];
+    records.erase(records.lower_bound(begin), records.lower_bound(end));
+  }
+
+  size_t count(kind k) const {
+    auto it = states.find(k);
+    return it == states.end() ? 0 : it->second.size();
+  }
+
+  std::map<bool, std::string> blobs;
+  std::map<kind, std::map<uint64_t, std::string>> states;
+};
+
+void expect_same_state(const sn_list_t::state_t &expected, const sn_list_t::state_t &actual)
+{
+  EXPECT_EQ(actual.height, expected.height);
+  EXPECT_EQ(actual.block_hash, expected.block_hash) << "at height " << expected.height;
+  EXPECT_EQ(actual.only_loaded_quorums, expected.only_loaded_quorums) << "at height " << expected.height;
+  ASSERT_EQ(actual.service_nodes_infos.size(), expected.service_nodes_infos.size()) << "at height " << expected.height;
+  for (const auto &[pubkey, info] : expected.service_nodes_infos)
+  {
+    auto it = actual.service_nodes_infos.find(pubkey);
+    ASSERT_NE(it, actual.service_nodes_infos.end()) << "at height " << expected.height;
+    EXPECT_EQ(it->second->registration_height, info->registration_height);
+    EXPECT_EQ(it->second->last_reward_block_height, info->last_reward_block_height);
+    EXPECT_EQ(it->second->staking_requirement, info->staking_requirement);
+  }
+}
+
+void expect_same_states(const sn_list_t::state_set &expected, const sn_list_t::state_set &actual)
+{
+  ASSERT_EQ(actual.size(), expected.size());
+  for (auto eit = expected.begin(), ait = actual.begin(); eit != expected.end(); eit++, ait++)
+    expect_same_state(*eit, *ait);
+}
+
+struct service_node_list_store_test : public ::testing::Test
+{
+  blockchain_objects_t bc_objects;
+  StateTestDB *db = new StateTestDB();
+  sn_list_t &sn_list = bc_objects.m_service_node_list;
+
+  void SetUp() override
+  {
+    const cryptonote::test_options test_options{{{7, 0, 0, 0}, {cryptonote::network_version_9_service_nodes, 0, 1, 0}}, 5000};
+    ASSERT_TRUE(bc_objects.m_blockchain.init(db, nullptr /*ons_db*/, cryptonote::FAKECHAIN, true, &test_options));
+
+    // Start out with a state at an archive height, which (like process_block would) we also
+    // archive, and a few nodes in it.
+    set_chain(1);
+    auto &state = sn_list.m_state;
+    state.height = ARCHIVE_HEIGHT;
+    state.block_hash = db->blocks[state.height];
+    for (int i = 0; i < 5; i++)
+      register_node(state);
+    sn_list.m_transient.state_archive.insert(state);
+  }
+
+  // (Re)generates the block hashes from `from_height` up to a bit above the states we use
+  void set_chain(uint64_t from_height)
+  {
+    db->blocks.resize(ARCHIVE_HEIGHT + 100);
+    for (uint64_t height = from_height; height < db->blocks.size(); height++)
+      db->blocks[height] = crypto::rand<crypto::hash>();
+  }
+
+  void register_node(sn_list_t::state_t &state)
+  {
+    auto info = std::make_shared<service_nodes::service_node_info>();
+    info->registration_height = state.height;
+    info->staking_requirement = 100 + state.height;
+    state.service_nodes_infos.emplace(crypto::rand<crypto::public_key>(), std::move(info));
+  }
+
+  // Moves on to the next block the way block_added does (the current state goes into the
+  // history, the new one starts as a copy of it), then registers a node, rewards one and
+  // deregisters another.
+  void add_block()
+  {
+    auto &state = sn_list.m_state;
+    sn_list.m_transient.state_history.insert(sn_list.m_transient.state_history.end(), state);
+    state.height++;
+    state.block_hash = db->blocks[state.height];
+
+    const auto [winner, winner_info] = *state.service_nodes_infos.begin();
+    auto rewarded = std::make_shared<service_nodes::service_node_info>(*winner_info);
+    rewarded->last_reward_block_height = state.height;
+    state.service_nodes_infos[winner] = std::move(rewarded);
+    if (state.height % 3 == 0)
+    {
+      const crypto::public_key deregistered = std::next(state.service_nodes_infos.begin())->first;
+      state.service_nodes_infos.erase(deregistered);
+    }
+    register_node(state);
+  }
+
+  // Culls the history below `height`, as process_block would
+  void cull(uint64_t height)
+  {
+    auto &history = sn_list.m_transient.state_history;
+    history.erase(history.begin(), history.lower_bound(height));
+  }
+
+  // Stores the list, then loads it back and checks that it comes back unchanged
+  void store_and_reload()
+  {
+    ASSERT_TRUE(sn_list.store());
+    const auto state = sn_list.m_state;
+    const auto history = sn_list.m_transient.state_history;
+    const auto archive = sn_list.m_transient.state_archive;
+
+    ASSERT_TRUE(sn_list.load(db->height()));
+    expect_same_state(state, sn_list.m_state);
+    expect_same_states(history, sn_list.m_transient.state_history);
+    expect_same_states(archive, sn_list.m_transient.state_archive);
+  }
+};
+
+}
+
+TEST_F(service_node_list_store_test, store_and_load)
+{
+  // The archived state itself gets culled from the short term history before the first store
+  for (int i = 0; i < 30; i++)
+    add_block();
+  cull(ARCHIVE_HEIGHT + 5);
+  store_and_reload();
+
+  // One checkpoint (the oldest kept state), then a delta per block
+  EXPECT_EQ(sn_list.m_transient.stored_checkpoints, std::vector<uint64_t>{ARCHIVE_HEIGHT + 5});
+  EXPECT_EQ(db->count(kind::short_term), 26);
+  EXPECT_EQ(db->count(kind::long_term), 1);
+
+  // Later stores only add deltas for the new blocks
+  for (int i = 0; i < 10; i++)
+    add_block();
+  store_and_reload();
+  EXPECT_EQ(sn_list.m_transient.stored_checkpoints, std::vector<uint64_t>{ARCHIVE_HEIGHT + 5});
+  EXPECT_EQ(db->count(kind::short_term), 36);
+}
+
+TEST_F(service_node_list_store_test, reorg)
+{
+  for (int i = 0; i < 30; i++)
+    add_block();
+  cull(ARCHIVE_HEIGHT + 5);
+  ASSERT_TRUE(sn_list.store());
+
+  // Pop 10 blocks and replace them with 5 others: the records of the popped blocks get replaced
+  // or dropped, and the new ones are deltas against the state we reverted to.
+  sn_list.blockchain_detached(ARCHIVE_HEIGHT + 21, false /*by_pop_blocks*/);
+  ASSERT_EQ(sn_list.m_state.height, ARCHIVE_HEIGHT + 20);
+  set_chain(ARCHIVE_HEIGHT + 21);
+  for (int i = 0; i < 5; i++)
+    add_block();
+  store_and_reload();
+  EXPECT_EQ(sn_list.m_state.height, ARCHIVE_HEIGHT + 25);
+  EXPECT_EQ(sn_list.m_state.block_hash, db->blocks[ARCHIVE_HEIGHT + 25]);
+  EXPECT_EQ(sn_list.m_transient.stored_checkpoints, std::vector<uint64_t>{ARCHIVE_HEIGHT + 5});
+  EXPECT_EQ(db->count(kind::short_term), 21);
+}
+
+TEST_F(service_node_list_store_test, archive_revert)
+{
+  for (int i = 0; i < 30; i++)
+    add_block();
+  cull(ARCHIVE_HEIGHT + 5);
+  ASSERT_TRUE(sn_list.store());
+
+  // Detaching below the oldest kept state reverts to the archived one, which has no short term
+  // record: everything must get rewritten from a checkpoint of it.
+  sn_list.blockchain_detached(ARCHIVE_HEIGHT + 3, false /*by_pop_blocks*/);
+  ASSERT_EQ(sn_list.m_state.height, ARCHIVE_HEIGHT);
+  ASSERT_TRUE(sn_list.m_transient.state_history.empty());
+  set_chain(ARCHIVE_HEIGHT + 1);
+  for (int i = 0; i < 10; i++)
+    add_block();
+  store_and_reload();
+  EXPECT_EQ(sn_list.m_state.height, ARCHIVE_HEIGHT + 10);
+  EXPECT_EQ(sn_list.m_transient.stored_checkpoints, std::vector<uint64_t>{ARCHIVE_HEIGHT});
+  EXPECT_EQ(db->count(kind::short_term), 11);
+
+  // ...and later stores go back to writing deltas on top of that
+  for (int i = 0; i < 5; i++)
+    add_block();
+  store_and_reload();
+  EXPECT_EQ(sn_list.m_transient.stored_checkpoints, std::vector<uint64_t>{ARCHIVE_HEIGHT});
+  EXPECT_EQ(db->count(kind::short_term), 16);
+}
+
+TEST_F(service_node_list_store_test, legacy_blob_conversion)
+{
+  for (int i = 0; i < 30; i++)
+    add_block();
+  cull(ARCHIVE_HEIGHT + 5);
+
+  // Write the states the way older versions did: the archive and the short term history (with
+  // the current state last) each in one blob.
+  auto legacy = [](const sn_list_t::state_t &state) {
+    sn_list_t::state_serialized result{};
+    result.version = sn_list_t::state_serialized::version_t::version_1_serialize_hash;
+    result.height = state.height;
+    result.quorums.height = state.height;
+    for (const auto &kv_pair : state.service_nodes_infos)
+      result.infos.emplace_back(kv_pair);
+    result.block_hash = state.block_hash;
+    return result;
+  };
+  sn_list_t::data_for_serialization long_term{}, short_term{};
+  for (const auto &state : sn_list.m_transient.state_archive)
+    long_term.states.push_back(legacy(state));
+  for (const auto &state : sn_list.m_transient.state_history)
+    short_term.states.push_back(legacy(state));
+  short_term.states.push_back(legacy(sn_list.m_state));
+  db->set_service_node_data(serialization::dump_binary(long_term), true /*long_term*/);
+  db->set_service_node_data(serialization::dump_binary(short_term), false /*long_term*/);
+
+  const auto state = sn_list.m_state;
+  const auto history = sn_list.m_transient.state_history;
+  const auto archive = sn_list.m_transient.state_archive;
+  ASSERT_TRUE(sn_list.load(db->height()));
+  expect_same_state(state, sn_list.m_state);
+  expect_same_states(history, sn_list.m_transient.state_history);
+  expect_same_states(archive, sn_list.m_transient.state_archive);
+
+  // The first store converts the blobs to per-height records (and drops the blobs)
+  store_and_reload();
+  EXPECT_TRUE(db->blobs.empty());
+  EXPECT_EQ(db->count(kind::short_term), 26);
+  EXPECT_EQ(db->count(kind::long_term), 1);
+}
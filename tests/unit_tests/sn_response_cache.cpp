@@ -0,0 +1,156 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "rpc/core_rpc_server.h"
+
+using cryptonote::rpc::detail::sn_response_cache;
+using cryptonote::rpc::detail::sn_response_cache_entry;
+
+namespace
+{
+
+// Stands in for the rpc server: entries are fresh while built at the current "top block", and a
+// build records the block and which request it was built from.
+struct test_chain
+{
+  std::string top = "a";
+  std::atomic<int> builds{0};
+
+  sn_response_cache::fresh_fn fresh() {
+    return [this](const sn_response_cache_entry& e) { return !e.body.empty() && e.block_hash == top; };
+  }
+  sn_response_cache::build_fn build() {
+    return [this](sn_response_cache_entry& e) {
+      ++builds;
+      e.block_hash = top;
+      e.body = e.req.poll_block_hash + "@" + top;
+    };
+  }
+  std::string get(sn_response_cache& cache, const std::string& key) {
+    cryptonote::rpc::GET_SERVICE_NODES::request req{};
+    req.poll_block_hash = key; // Just something to tell the built bodies apart
+    return cache.get(key, req, fresh(), build());
+  }
+};
+
+}
+
+TEST(sn_response_cache, builds_once_per_block)
+{
+  sn_response_cache cache{4};
+  test_chain chain;
+
+  EXPECT_EQ(chain.get(cache, "x"), "x@a");
+  EXPECT_EQ(chain.get(cache, "x"), "x@a");
+  EXPECT_EQ(chain.builds, 1);
+
+  chain.top = "b";
+  EXPECT_EQ(chain.get(cache, "x"), "x@b");
+  EXPECT_EQ(chain.builds, 2);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(sn_response_cache, evicts_least_recently_used)
+{
+  sn_response_cache cache{2};
+  test_chain chain;
+
+  chain.get(cache, "x");
+  chain.get(cache, "y");
+  chain.get(cache, "x");
+  // Over the limit: "y" is the least recently used, not "x" (the oldest insert)
+  chain.get(cache, "z");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(chain.builds, 3);
+
+  chain.get(cache, "x");
+  chain.get(cache, "z");
+  EXPECT_EQ(chain.builds, 3);
+  chain.get(cache, "y");
+  EXPECT_EQ(chain.builds, 4);
+  EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(sn_response_cache, refresh_rebuilds_requested_only)
+{
+  sn_response_cache cache{4};
+  test_chain chain;
+
+  chain.get(cache, "x");
+  chain.get(cache, "y");
+  chain.top = "b";
+  cache.refresh(chain.fresh(), chain.build());
+  EXPECT_EQ(chain.builds, 4);
+  EXPECT_EQ(cache.size(), 2);
+
+  // Only "x" gets asked for at "b", so the next block drops "y" instead of rebuilding it
+  EXPECT_EQ(chain.get(cache, "x"), "x@b");
+  chain.top = "c";
+  cache.refresh(chain.fresh(), chain.build());
+  EXPECT_EQ(chain.builds, 5);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(chain.get(cache, "x"), "x@c");
+  EXPECT_EQ(chain.builds, 5);
+}
+
+TEST(sn_response_cache, slow_build_only_blocks_its_own_entry)
+{
+  sn_response_cache cache{4};
+  test_chain chain;
+  std::promise<void> started, release;
+  auto release_future = release.get_future().share();
+
+  auto slow_build = [&](sn_response_cache_entry& e) {
+    started.set_value();
+    release_future.wait();
+    chain.build()(e);
+  };
+  cryptonote::rpc::GET_SERVICE_NODES::request req{};
+  auto slow = std::async(std::launch::async, [&] { return cache.get("x", req, chain.fresh(), slow_build); });
+  started.get_future().wait();
+
+  // Another entry can be served while "x" is being built...
+  auto other = std::async(std::launch::async, [&] { return chain.get(cache, "y"); });
+  ASSERT_EQ(other.wait_for(std::chrono::seconds{5}), std::future_status::ready);
+  EXPECT_EQ(other.get(), "y@a");
+
+  // ...while a concurrent request for "x" waits for that build rather than doing its own
+  auto same = std::async(std::launch::async, [&] { return chain.get(cache, "x"); });
+  EXPECT_EQ(same.wait_for(std::chrono::milliseconds{50}), std::future_status::timeout);
+  release.set_value();
+  EXPECT_EQ(slow.get(), "@a");
+  EXPECT_EQ(same.get(), "@a");
+  EXPECT_EQ(chain.builds, 2);
+}
@@ -53,3 +53,93 @@ TEST(protocol_pack, protocol_pack_command)
     ASSERT_TRUE(r.total_height == 3);
   }
 }
+
+TEST(protocol_pack, protocol_pack_blocks)
+{
+  cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request r;
+  r.current_blockchain_height = 1234;
+  r.missed_ids.resize(2, crypto::hash{});
+  for (int i = 0; i < 20; i++)
+  {
+    auto& entry = r.blocks.emplace_back();
+    entry.block = std::string(300 + i, 'a' + i);
+    for (int j = 0; j < i % 4; j++)
+      entry.txs.push_back(std::string(1000 + j, '0' + j));
+  }
+
+  std::string buff;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(r, buff));
+
+  // load_t_from_binary moves the blobs out of the parsed storage
+  cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request r2;
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(r2, buff));
+  ASSERT_EQ(r.current_blockchain_height, r2.current_blockchain_height);
+  ASSERT_EQ(r.missed_ids.size(), r2.missed_ids.size());
+  ASSERT_EQ(r.blocks.size(), r2.blocks.size());
+  for (size_t i = 0; i < r.blocks.size(); i++)
+  {
+    ASSERT_EQ(r.blocks[i].block, r2.blocks[i].block);
+    ASSERT_EQ(r.blocks[i].txs, r2.blocks[i].txs);
+  }
+
+  // Without consume_on_load the same storage can be loaded more than once
+  epee::serialization::portable_storage ps;
+  ASSERT_TRUE(ps.load_from_binary(buff));
+  cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request r3, r4;
+  ASSERT_TRUE(r3.load(ps));
+  ASSERT_TRUE(r4.load(ps));
+  ASSERT_EQ(r.blocks.back().txs, r3.blocks.back().txs);
+  ASSERT_EQ(r.blocks.back().txs, r4.blocks.back().txs);
+}
+
+TEST(protocol_pack, unordered_section_keys)
+{
+  epee::serialization::portable_storage ps;
+  ASSERT_TRUE(ps.set_value("b", uint64_t{2}, nullptr));
+  ASSERT_TRUE(ps.set_value("a", uint64_t{1}, nullptr));
+  ASSERT_TRUE(ps.set_value("c", uint64_t{3}, nullptr));
+  ASSERT_TRUE(ps.set_value("a", uint64_t{4}, nullptr));
+
+  std::string buff;
+  ASSERT_TRUE(ps.store_to_binary(buff));
+  epee::serialization::portable_storage ps2;
+  ASSERT_TRUE(ps2.load_from_binary(buff));
+  uint64_t v;
+  ASSERT_TRUE(ps2.get_value("a", v, nullptr));
+  ASSERT_EQ(4, v);
+  ASSERT_TRUE(ps2.get_value("b", v, nullptr));
+  ASSERT_EQ(2, v);
+  ASSERT_TRUE(ps2.get_value("c", v, nullptr));
+  ASSERT_EQ(3, v);
+  ASSERT_FALSE(ps2.get_value("d", v, nullptr));
+}
+
+TEST(protocol_pack, unsorted_binary_section)
+{
+  epee::serialization::portable_storage ps;
+  ASSERT_TRUE(ps.set_value("k1", uint64_t{1}, nullptr));
+  ASSERT_TRUE(ps.set_value("k2", uint64_t{2}, nullptr));
+  ASSERT_TRUE(ps.set_value("k3", uint64_t{3}, nullptr));
+  std::string buff;
+  ASSERT_TRUE(ps.store_to_binary(buff));
+
+  // Rename entries in the serialized data so that they arrive out of order (k9, k2, ...) and with a
+  // duplicate name (..., k2, k2): the first of a duplicated name wins, like when inserting.
+  auto rename = [&](std::string_view from, std::string_view to) {
+    auto pos = buff.find(from);
+    ASSERT_NE(pos, std::string::npos);
+    buff.replace(pos, from.size(), to);
+  };
+  rename("k1", "k9");
+  rename("k3", "k2");
+
+  epee::serialization::portable_storage ps2;
+  ASSERT_TRUE(ps2.load_from_binary(buff));
+  uint64_t v;
+  ASSERT_TRUE(ps2.get_value("k2", v, nullptr));
+  ASSERT_EQ(2, v);
+  ASSERT_TRUE(ps2.get_value("k9", v, nullptr));
+  ASSERT_EQ(1, v);
+  ASSERT_FALSE(ps2.get_value("k1", v, nullptr));
+  ASSERT_FALSE(ps2.get_value("k3", v, nullptr));
+}
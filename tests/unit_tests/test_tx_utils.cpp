@@ -34,12 +34,47 @@
 
 #include "common/util.h"
 #include "cryptonote_basic/cryptonote_basic.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
 #include "cryptonote_basic/tx_extra.h"
 #include "cryptonote_core/cryptonote_tx_utils.h"
 
 namespace
 {
   uint64_t const TEST_FEE = 5000000000; // 5 * 10^9
+
+  cryptonote::tx_out make_out()
+  {
+    cryptonote::tx_out out{};
+    out.target = cryptonote::txout_to_key{crypto::rand<crypto::public_key>()};
+    return out;
+  }
+
+  // A 2-in, 2-out tx with a (meaningless) full ringct signature, so that it has a prunable part
+  cryptonote::transaction make_rct_tx()
+  {
+    cryptonote::transaction tx;
+    tx.version = cryptonote::txversion::v2_ringct;
+    for (int i = 0; i < 2; i++)
+    {
+      cryptonote::txin_to_key in{};
+      in.key_offsets = {1, 2};
+      in.k_image = crypto::rand<crypto::key_image>();
+      tx.vin.push_back(in);
+      tx.vout.push_back(make_out());
+    }
+    auto &rct = tx.rct_signatures;
+    rct.type = rct::RCTType::Full;
+    rct.txnFee = TEST_FEE;
+    rct.ecdhInfo.resize(2);
+    rct.outPk.resize(2);
+    for (auto &pk : rct.outPk)
+      pk.mask = rct::skGen();
+    rct.p.rangeSigs.resize(2);
+    rct.p.MGs.resize(1);
+    rct.p.MGs[0].ss.assign(2, rct::keyV(3, rct::skGen()));
+    rct.p.MGs[0].cc = rct::skGen();
+    return tx;
+  }
 }
 
 TEST(parse_tx_extra, handles_empty_extra)
@@ -276,3 +311,87 @@ TEST(sort_tx_extra, invalid_suffix)
   std::vector<uint8_t> extra(&extra_arr[0], &extra_arr[0] + sizeof(extra_arr));
   ASSERT_FALSE(cryptonote::sort_tx_extra(extra, sorted));
 }
+
+TEST(get_transaction_hashes, match_one_at_a_time)
+{
+  std::vector<cryptonote::transaction> txs;
+
+  auto &v1 = txs.emplace_back();
+  v1.version = cryptonote::txversion::v1;
+  cryptonote::txin_to_key in{};
+  in.key_offsets = {0};
+  in.k_image = crypto::rand<crypto::key_image>();
+  v1.vin.push_back(in);
+  v1.vout.push_back(make_out());
+  v1.signatures = {{crypto::signature{}}};
+
+  txs.push_back(make_rct_tx());
+  txs.push_back(make_rct_tx());
+
+  auto &no_prunable = txs.emplace_back();
+  no_prunable.version = cryptonote::txversion::v4_tx_types;
+  no_prunable.vin.push_back(cryptonote::txin_gen{123});
+  no_prunable.vout.push_back(make_out());
+  no_prunable.output_unlock_times.push_back(0);
+
+  auto &not_transfer = txs.emplace_back();
+  not_transfer.version = cryptonote::txversion::v4_tx_types;
+  not_transfer.type = cryptonote::txtype::state_change;
+
+  std::vector<cryptonote::blobdata> blobs;
+  for (const auto &tx : txs)
+    blobs.push_back(cryptonote::tx_to_blob(tx));
+
+  std::vector<cryptonote::transaction> parsed(blobs.size());
+  std::vector<const cryptonote::transaction*> ptrs;
+  std::vector<std::string_view> views;
+  for (size_t i = 0; i < blobs.size(); i++)
+  {
+    ASSERT_TRUE(cryptonote::parse_and_validate_tx_from_blob(blobs[i], parsed[i]));
+    ptrs.push_back(&parsed[i]);
+    views.push_back(blobs[i]);
+  }
+  std::vector<crypto::hash> hashes, prefix_hashes;
+  ASSERT_TRUE(cryptonote::get_transaction_hashes(ptrs, views, hashes));
+  cryptonote::get_transaction_prefix_hashes(ptrs, views, prefix_hashes);
+  ASSERT_EQ(hashes.size(), txs.size());
+  ASSERT_EQ(prefix_hashes.size(), txs.size());
+  for (size_t i = 0; i < txs.size(); i++)
+  {
+    cryptonote::transaction fresh;
+    ASSERT_TRUE(cryptonote::parse_and_validate_tx_from_blob(blobs[i], fresh));
+    EXPECT_EQ(hashes[i], cryptonote::get_transaction_hash(fresh)) << "tx " << i;
+    EXPECT_EQ(prefix_hashes[i], cryptonote::get_transaction_prefix_hash(fresh)) << "tx " << i;
+    EXPECT_TRUE(parsed[i].is_hash_valid());
+    EXPECT_EQ(parsed[i].hash, hashes[i]);
+  }
+  EXPECT_NE(hashes[1], hashes[2]);
+}
+
+TEST(get_block_hashes, match_one_at_a_time)
+{
+  std::vector<cryptonote::block> blocks(5);
+  for (size_t i = 0; i < blocks.size(); i++)
+  {
+    auto &b = blocks[i];
+    b.major_version = cryptonote::network_version_7;
+    b.timestamp = 1000 + i;
+    b.prev_id = crypto::rand<crypto::hash>();
+    b.miner_tx.version = cryptonote::txversion::v2_ringct;
+    b.miner_tx.vin.push_back(cryptonote::txin_gen{i});
+    b.miner_tx.vout.push_back(make_out());
+    for (size_t j = 0; j < i; j++)
+      b.tx_hashes.push_back(crypto::rand<crypto::hash>());
+  }
+
+  std::vector<crypto::hash> hashes;
+  ASSERT_TRUE(cryptonote::get_block_hashes(blocks, hashes));
+  ASSERT_EQ(hashes.size(), blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++)
+  {
+    cryptonote::block fresh;
+    ASSERT_TRUE(cryptonote::parse_and_validate_block_from_blob(cryptonote::block_to_blob(blocks[i]), fresh));
+    EXPECT_EQ(hashes[i], cryptonote::get_block_hash(fresh)) << "block " << i;
+    EXPECT_TRUE(blocks[i].is_hash_valid());
+  }
+}
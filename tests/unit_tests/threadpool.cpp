@@ -144,3 +144,41 @@ TEST(threadpool, leaf_reentrancy)
   waiter.wait(tpool.get());
   ASSERT_EQ(counter, 500000);
 }
+
+TEST(threadpool, submit_range)
+{
+  std::shared_ptr<tools::threadpool> tpool(tools::threadpool::getNewForUnitTests(4));
+  tools::threadpool::waiter waiter;
+
+  std::vector<std::atomic<int>> hits(10000);
+  tpool->submit_range(&waiter, 0, hits.size(), [&](size_t i){ ++hits[i]; });
+  waiter.wait(tpool.get());
+  for (const auto &h : hits)
+    ASSERT_EQ(h, 1);
+
+  // Explicit chunk size that doesn't divide the range evenly
+  std::atomic<size_t> sum(0);
+  tpool->submit_range(&waiter, 5, 1005, [&](size_t i){ sum += i; }, 7);
+  waiter.wait(tpool.get());
+  ASSERT_EQ(sum, (5 + 1004) * 1000 / 2);
+
+  // Empty range does nothing
+  tpool->submit_range(&waiter, 3, 3, [&](size_t){ ASSERT_TRUE(false); });
+  waiter.wait(tpool.get());
+}
+
+TEST(threadpool, stats)
+{
+  std::shared_ptr<tools::threadpool> tpool(tools::threadpool::getNewForUnitTests(2));
+  tools::threadpool::waiter waiter;
+
+  std::atomic<unsigned int> counter(0);
+  for (size_t n = 0; n < 100; ++n)
+    tpool->submit(&waiter, [&counter](){ ++counter; });
+  waiter.wait(tpool.get());
+  ASSERT_EQ(counter, 100);
+
+  auto stats = tpool->get_stats();
+  ASSERT_EQ(stats.queue_depth, 0);
+  ASSERT_EQ(stats.submitted + stats.inline_runs, 100);
+}
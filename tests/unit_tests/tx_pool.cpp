@@ -0,0 +1,314 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define IN_UNIT_TESTS
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <unordered_set>
+#include <vector>
+#include "gtest/gtest.h"
+#include "cryptonote_core/blockchain.h"
+#include "cryptonote_core/tx_pool.h"
+#include "cryptonote_core/cryptonote_core.h"
+#include "cryptonote_core/uptime_proof.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "blockchain_utilities/blockchain_objects.h"
+#include "blockchain_db/testdb.h"
+
+namespace
+{
+
+using TestDB = cryptonote::TxpoolTestDB;
+
+constexpr uint8_t HF_VERSION = 7;
+
+// A single-input v1 tx with a unique key image; it never verifies, but txes from blocks are kept
+// in the pool regardless so that's all we need.
+cryptonote::transaction make_tx(uint64_t fee)
+{
+  cryptonote::transaction tx;
+  tx.version = cryptonote::txversion::v1;
+  cryptonote::txin_to_key in{};
+  in.amount = fee;
+  in.key_offsets = {0};
+  in.k_image = crypto::rand<crypto::key_image>();
+  tx.vin.push_back(in);
+  tx.signatures = {{crypto::signature{}}};
+  tx.invalidate_hashes();
+  return tx;
+}
+
+// Adds a tx the way the blockchain returns txes of popped blocks to the pool
+bool add_from_block(cryptonote::tx_memory_pool &pool, cryptonote::transaction tx)
+{
+  cryptonote::tx_verification_context tvc{};
+  return pool.add_tx(tx, tvc, cryptonote::tx_pool_options::from_block(), HF_VERSION) && tvc.m_added_to_pool;
+}
+
+bool take_tx(cryptonote::tx_memory_pool &pool, const crypto::hash &txid)
+{
+  cryptonote::transaction tx;
+  cryptonote::blobdata blob;
+  size_t weight;
+  uint64_t fee;
+  bool relayed, do_not_relay, double_spend_seen;
+  return pool.take_tx(txid, tx, blob, weight, fee, relayed, do_not_relay, double_spend_seen);
+}
+
+struct tx_pool_test : public ::testing::Test
+{
+  blockchain_objects_t bc_objects;
+  TestDB *db = new TestDB();
+  cryptonote::tx_memory_pool &pool = bc_objects.m_mempool;
+
+  void SetUp() override
+  {
+    const cryptonote::test_options test_options{{{HF_VERSION, 0, 0, 0}}, 5000};
+    ASSERT_TRUE(bc_objects.m_blockchain.init(db, nullptr /*ons_db*/, cryptonote::FAKECHAIN, true, &test_options));
+    ASSERT_TRUE(pool.init(0));
+  }
+
+  // Checks that the pool's in-memory metadata and sorted container match the database exactly
+  void check_mirror()
+  {
+    ASSERT_EQ(pool.m_pool_tx_info.size(), db->txpool.size());
+    ASSERT_EQ(pool.m_txs_by_fee_and_receive_time.size(), db->txpool.size());
+    for (const auto& [txid, entry] : db->txpool)
+    {
+      auto it = pool.m_pool_tx_info.find(txid);
+      ASSERT_NE(it, pool.m_pool_tx_info.end());
+      EXPECT_EQ(std::memcmp(&it->second.meta, &entry.first, sizeof(entry.first)), 0) << "metadata mismatch for " << txid;
+      EXPECT_EQ(it->second.sorted_it->second, txid);
+    }
+  }
+};
+
+}
+
+TEST_F(tx_pool_test, metadata_mirror_in_sync)
+{
+  std::vector<cryptonote::transaction> txs;
+  for (uint64_t i = 0; i < 10; i++)
+    txs.push_back(make_tx(1000 + i));
+
+  for (auto &tx : txs)
+    ASSERT_TRUE(add_from_block(pool, tx));
+  check_mirror();
+
+  // Metadata updates (here: relaying) go to both copies
+  std::vector<std::pair<crypto::hash, cryptonote::blobdata>> relayed;
+  for (size_t i = 0; i < 5; i++)
+    relayed.emplace_back(cryptonote::get_transaction_hash(txs[i]), cryptonote::tx_to_blob(txs[i]));
+  pool.set_relayed(relayed);
+  check_mirror();
+
+  // A block mines some of them...
+  for (size_t i = 0; i < 4; i++)
+    ASSERT_TRUE(take_tx(pool, cryptonote::get_transaction_hash(txs[i])));
+  check_mirror();
+  ASSERT_EQ(pool.get_transactions_count(), 6);
+
+  // ...and then gets popped by a reorg, returning them to the pool
+  for (size_t i = 0; i < 4; i++)
+    ASSERT_TRUE(add_from_block(pool, txs[i]));
+  ASSERT_TRUE(pool.on_blockchain_dec());
+  check_mirror();
+  ASSERT_EQ(pool.get_transactions_count(), 10);
+
+  // Reloading from the database gives the same state
+  ASSERT_TRUE(pool.init(0));
+  check_mirror();
+}
+
+TEST_F(tx_pool_test, lookup_and_remove_by_txid)
+{
+  std::vector<cryptonote::transaction> txs;
+  std::vector<crypto::hash> txids;
+  for (uint64_t i = 0; i < 50; i++)
+  {
+    txs.push_back(make_tx(1000 + i));
+    txids.push_back(cryptonote::get_transaction_hash(txs.back()));
+    ASSERT_TRUE(add_from_block(pool, txs.back()));
+  }
+
+  for (size_t i = 0; i < txids.size(); i++)
+  {
+    auto it = pool.find_tx_in_sorted_container(txids[i]);
+    ASSERT_NE(it, pool.m_txs_by_fee_and_receive_time.end());
+    EXPECT_EQ(it->second, txids[i]);
+    cryptonote::blobdata blob;
+    ASSERT_TRUE(pool.get_transaction(txids[i], blob));
+    EXPECT_EQ(blob, cryptonote::tx_to_blob(txs[i]));
+  }
+  EXPECT_EQ(pool.find_tx_in_sorted_container(crypto::rand<crypto::hash>()), pool.m_txs_by_fee_and_receive_time.end());
+
+  // Removing in an order unrelated to the fee ordering leaves exactly the others findable
+  std::vector<size_t> order(txids.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::mt19937{42});
+  std::vector<bool> removed(txids.size(), false);
+  for (size_t n = 0; n < order.size(); n++)
+  {
+    const size_t i = order[n];
+    ASSERT_TRUE(take_tx(pool, txids[i]));
+    removed[i] = true;
+    EXPECT_FALSE(take_tx(pool, txids[i]));
+    if (n % 10 == 0)
+    {
+      for (size_t j = 0; j < txids.size(); j++)
+        EXPECT_EQ(pool.find_tx_in_sorted_container(txids[j]) != pool.m_txs_by_fee_and_receive_time.end(), !removed[j]) << "tx " << j;
+      check_mirror();
+    }
+  }
+  EXPECT_TRUE(pool.m_txs_by_fee_and_receive_time.empty());
+  EXPECT_EQ(pool.get_transactions_count(), 0);
+}
+
+TEST_F(tx_pool_test, incremental_block_template_matches_rebuild)
+{
+  const size_t median_weight = CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE_V5;
+  const crypto::hash top = bc_objects.m_blockchain.get_tail_id();
+  cryptonote::block bl{};
+  bl.prev_id = top;
+
+  // Our fake txes can't pass input checks, so pretend they already did
+  auto add = [&](uint64_t fee) {
+    auto tx = make_tx(fee);
+    const crypto::hash txid = cryptonote::get_transaction_hash(tx);
+    pool.m_input_cache[txid] = {true, cryptonote::tx_verification_context{}, 0, top};
+    EXPECT_TRUE(add_from_block(pool, tx));
+    return txid;
+  };
+  auto fill = [&](size_t &weight, uint64_t &fee, uint64_t &reward) {
+    EXPECT_TRUE(pool.fill_block_template(bl, median_weight, 0, weight, fee, reward, HF_VERSION, 1));
+    return std::unordered_set<crypto::hash>(bl.tx_hashes.begin(), bl.tx_hashes.end());
+  };
+
+  for (uint64_t i = 0; i < 5; i++)
+    add(1000 + i);
+  size_t weight;
+  uint64_t fee, reward;
+  ASSERT_EQ(fill(weight, fee, reward).size(), 5);
+  ASSERT_TRUE(pool.m_block_template.valid);
+  ASSERT_FALSE(pool.m_block_template.saturated);
+
+  std::vector<crypto::hash> added;
+  for (uint64_t i = 0; i < 5; i++)
+    added.push_back(add(2000 + i));
+  // Leaves the pool before the template gets refreshed, so it must simply be skipped
+  ASSERT_TRUE(take_tx(pool, added.back()));
+  ASSERT_TRUE(pool.m_block_template.valid);
+
+  const auto incremental = fill(weight, fee, reward);
+  EXPECT_EQ(incremental.size(), 9);
+  EXPECT_FALSE(incremental.count(added.back()));
+
+  size_t full_weight;
+  uint64_t full_fee, full_reward;
+  pool.m_block_template = {};
+  EXPECT_EQ(fill(full_weight, full_fee, full_reward), incremental);
+  EXPECT_EQ(full_weight, weight);
+  EXPECT_EQ(full_fee, fee);
+  EXPECT_EQ(full_reward, reward);
+
+  // A template tx getting flagged as a double spend means the next refresh has to recheck
+  // everything rather than keep what it has
+  ASSERT_TRUE(pool.m_block_template.valid);
+  auto conflict = make_tx(3000);
+  ASSERT_TRUE(pool.m_block_template.selected.count(added.front()));
+  cryptonote::transaction selected_tx;
+  ASSERT_TRUE(cryptonote::parse_and_validate_tx_from_blob(db->txpool[added.front()].second, selected_tx));
+  var::get<cryptonote::txin_to_key>(conflict.vin[0]).k_image = var::get<cryptonote::txin_to_key>(selected_tx.vin[0]).k_image;
+  pool.mark_double_spend(conflict);
+  EXPECT_TRUE(pool.m_pool_tx_info[added.front()].meta.double_spend_seen);
+  EXPECT_FALSE(pool.m_block_template.valid);
+}
+
+TEST(short_tx_id, salted)
+{
+  const crypto::hash salt = crypto::rand<crypto::hash>(), txid = crypto::rand<crypto::hash>();
+  EXPECT_EQ(cryptonote::get_short_tx_id(salt, txid), cryptonote::get_short_tx_id(salt, txid));
+  EXPECT_NE(cryptonote::get_short_tx_id(salt, txid), cryptonote::get_short_tx_id(crypto::rand<crypto::hash>(), txid));
+  EXPECT_NE(cryptonote::get_short_tx_id(salt, txid), cryptonote::get_short_tx_id(salt, crypto::rand<crypto::hash>()));
+}
+
+TEST_F(tx_pool_test, short_tx_id_index)
+{
+  crypto::hash top = bc_objects.m_blockchain.get_tail_id();
+  ASSERT_EQ(pool.m_short_tx_id_salt, top);
+
+  std::vector<crypto::hash> txids;
+  for (uint64_t i = 0; i < 3; i++)
+  {
+    auto tx = make_tx(1000 + i);
+    ASSERT_TRUE(add_from_block(pool, tx));
+    txids.push_back(cryptonote::get_transaction_hash(tx));
+  }
+  auto short_ids = [&](const crypto::hash& salt) {
+    std::vector<uint64_t> ids;
+    for (const auto& txid : txids)
+      ids.push_back(cryptonote::get_short_tx_id(salt, txid));
+    return ids;
+  };
+
+  auto ids = short_ids(top);
+  ids.push_back(cryptonote::get_short_tx_id(top, crypto::rand<crypto::hash>()));
+  EXPECT_EQ(pool.find_short_tx_ids(top, ids), (std::vector<crypto::hash>{txids[0], txids[1], txids[2], crypto::null_hash}));
+  EXPECT_EQ(pool.m_short_tx_ids.size(), 3);
+
+  // A salt other than our chain tip (e.g. from a peer's block on another parent) resolves nothing
+  // and leaves the index alone
+  const crypto::hash other = crypto::rand<crypto::hash>();
+  EXPECT_EQ(pool.find_short_tx_ids(other, short_ids(other)), std::vector<crypto::hash>(3, crypto::null_hash));
+  EXPECT_EQ(pool.m_short_tx_id_salt, top);
+
+  // Removed txes leave the index
+  ASSERT_TRUE(take_tx(pool, txids[0]));
+  EXPECT_EQ(pool.m_short_tx_ids.size(), 2);
+  EXPECT_EQ(pool.find_short_tx_ids(top, short_ids(top)), (std::vector<crypto::hash>{crypto::null_hash, txids[1], txids[2]}));
+  txids.erase(txids.begin());
+
+  // A new chain tip rebuilds it with the new salt
+  db->blocks.push_back(crypto::rand<crypto::hash>());
+  ASSERT_TRUE(pool.on_blockchain_dec());
+  top = db->blocks.back();
+  EXPECT_EQ(pool.m_short_tx_id_salt, top);
+  EXPECT_EQ(pool.find_short_tx_ids(top, short_ids(top)), txids);
+
+  // An id shared by two pool txes can't be resolved, but doesn't affect the others
+  pool.m_short_tx_ids.emplace(cryptonote::get_short_tx_id(top, txids[0]), crypto::rand<crypto::hash>());
+  EXPECT_EQ(pool.find_short_tx_ids(top, short_ids(top)), (std::vector<crypto::hash>{crypto::null_hash, txids[1]}));
+
+  // Reloading starts over from the pool txes
+  ASSERT_TRUE(pool.init(0));
+  EXPECT_EQ(pool.m_short_tx_ids.size(), 2);
+  EXPECT_EQ(pool.find_short_tx_ids(top, short_ids(top)), txids);
+}
@@ -0,0 +1,215 @@
+// Copyright (c) 2021, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <fstream>
+#include <memory>
+#include "gtest/gtest.h"
+
+#include "common/oxen.h"
+#include "crypto/crypto.h"
+#include "ringct/rctOps.h"
+#include "wallet/wallet2.h"
+
+namespace
+{
+
+// An output with a unique key image and public key, carrying multisig k values
+wallet::transfer_details make_transfer(uint64_t height)
+{
+  wallet::transfer_details td{};
+  td.m_block_height = height;
+  cryptonote::txout_to_key to;
+  to.key = crypto::rand<crypto::public_key>();
+  cryptonote::tx_out out;
+  out.amount = 1000;
+  out.target = to;
+  td.m_tx.vout.push_back(out);
+  td.m_txid = crypto::rand<crypto::hash>();
+  td.m_internal_output_index = 0;
+  td.m_key_image = crypto::rand<crypto::key_image>();
+  td.m_key_image_known = true;
+  td.m_amount = 1000;
+  td.m_multisig_k = {rct::skGen(), rct::skGen()};
+  return td;
+}
+
+}
+
+TEST(wallet_cache_log, store_and_replay)
+{
+  const auto dir = fs::temp_directory_path() / ("oxen-wallet-cache-log-" + std::to_string(crypto::rand<uint64_t>()));
+  ASSERT_TRUE(fs::create_directories(dir));
+  OXEN_DEFER { std::error_code ec; fs::remove_all(dir, ec); };
+  const auto wallet_file = dir / "wallet";
+  auto log_file = wallet_file;
+  log_file += ".cachelog";
+
+  std::vector<wallet::transfer_details> expected;
+  {
+    tools::wallet2 w{cryptonote::TESTNET};
+    w.generate(wallet_file, "pass");
+
+    auto add_transfer = [&w] {
+      w.m_transfers.push_back(make_transfer(w.m_transfers.size()));
+      const size_t idx = w.m_transfers.size() - 1;
+      w.m_key_images[w.m_transfers[idx].m_key_image] = idx;
+      w.m_pub_keys[w.m_transfers[idx].get_public_key()] = idx;
+    };
+    for (size_t i = 0; i < 300; i++)
+      add_transfer();
+
+    // A full store for the log to start from
+    w.cache_log_compact();
+    w.store();
+    ASSERT_FALSE(fs::exists(log_file));
+
+    // Wiping used multisig k values has to reach the cache: signing again with the old ones after a
+    // reload would reuse the nonces.
+    tools::wallet2::multisig_tx_set txs;
+    txs.m_ptx.emplace_back().construction_data.selected_transfers = {1, 150};
+    w.save_multisig_tx(txs);
+    ASSERT_EQ(w.m_transfers[1].m_multisig_k[0], rct::zero());
+    ASSERT_EQ(w.m_transfers[150].m_multisig_k[1], rct::zero());
+    w.store();
+    ASSERT_TRUE(fs::exists(log_file));
+    const auto one_record = fs::file_size(log_file);
+
+    // A second record, with both a changed and a new transfer
+    w.set_spent(2, 10);
+    add_transfer();
+    w.store();
+    ASSERT_GT(fs::file_size(log_file), one_record);
+
+    expected = w.m_transfers;
+  }
+
+  auto check = [&](const tools::wallet2 &w) {
+    ASSERT_EQ(w.m_transfers.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+      EXPECT_EQ(w.m_transfers[i].m_multisig_k, expected[i].m_multisig_k) << "transfer " << i;
+      EXPECT_EQ(w.m_transfers[i].m_key_image, expected[i].m_key_image) << "transfer " << i;
+      EXPECT_EQ(w.m_transfers[i].m_spent, expected[i].m_spent) << "transfer " << i;
+    }
+    EXPECT_EQ(w.m_key_images.size(), expected.size());
+    EXPECT_EQ(w.m_pub_keys.size(), expected.size());
+  };
+
+  {
+    tools::wallet2 w{cryptonote::TESTNET};
+    w.load(wallet_file, "pass");
+    check(w);
+    EXPECT_TRUE(w.m_transfers[2].m_spent);
+    EXPECT_EQ(w.m_transfers[1].m_multisig_k[0], rct::zero());
+    EXPECT_FALSE(w.m_cache_log_compact);
+  }
+
+  // A record cut short (e.g. by a crash while appending it) is ignored, and makes the next store
+  // rewrite the whole cache.
+  {
+    std::ofstream out{log_file, std::ios::binary | std::ios::app};
+    out.write("\x01\x02\x03", 3);
+  }
+  {
+    tools::wallet2 w{cryptonote::TESTNET};
+    w.load(wallet_file, "pass");
+    check(w);
+    EXPECT_TRUE(w.m_cache_log_compact);
+  }
+}
+
+TEST(wallet_cache_log, side_containers_logged_as_deltas)
+{
+  const auto dir = fs::temp_directory_path() / ("oxen-wallet-cache-log-" + std::to_string(crypto::rand<uint64_t>()));
+  ASSERT_TRUE(fs::create_directories(dir));
+  OXEN_DEFER { std::error_code ec; fs::remove_all(dir, ec); };
+  const auto wallet_file = dir / "wallet";
+  auto log_file = wallet_file;
+  log_file += ".cachelog";
+
+  const auto book_address = cryptonote::account_public_address{crypto::rand<crypto::public_key>(), crypto::rand<crypto::public_key>()};
+  const auto noted_txid = crypto::rand<crypto::hash>();
+  const auto new_txid = crypto::rand<crypto::hash>();
+  {
+    // The default lookahead: a subaddress table of 50 accounts of 200 subaddresses each
+    tools::wallet2 w{cryptonote::TESTNET};
+    w.generate(wallet_file, "pass");
+    w.add_subaddress_account("savings");
+    ASSERT_GE(w.m_subaddresses.size(), 10000u);
+    for (size_t i = 0; i < 1000; i++)
+    {
+      const auto txid = crypto::rand<crypto::hash>();
+      w.m_tx_keys[txid] = rct::rct2sk(rct::skGen());
+      w.m_additional_tx_keys[txid] = {rct::rct2sk(rct::skGen()), rct::rct2sk(rct::skGen())};
+      w.set_tx_note(txid, "note " + std::to_string(i));
+    }
+    w.set_tx_note(noted_txid, "old note");
+    ASSERT_TRUE(w.add_address_book_row(book_address, nullptr, "first", false));
+    ASSERT_TRUE(w.add_address_book_row(book_address, nullptr, "second", false));
+    w.set_ons_cache_record({ons::mapping_type::session, "name", "hashed"});
+
+    w.cache_log_compact();
+    w.store();
+    ASSERT_FALSE(fs::exists(log_file));
+    const auto cache_size = fs::file_size(wallet_file);
+
+    // A handful of small changes, including erasures, should log a handful of entries
+    w.add_subaddress(0, "shop");
+    w.set_subaddress_label({1, 0}, "spending");
+    w.set_tx_note(noted_txid, "new note");
+    w.m_tx_keys[new_txid] = rct::rct2sk(rct::skGen());
+    w.m_additional_tx_keys[new_txid] = {};
+    w.m_cache_log_changed.tx_keys.insert(new_txid);
+    w.set_attribute("attr", "value");
+    ASSERT_TRUE(w.delete_address_book_row(0));
+    w.delete_ons_cache_record("hashed");
+    w.store();
+    ASSERT_TRUE(fs::exists(log_file));
+    EXPECT_LT(fs::file_size(log_file), 4096u);
+    EXPECT_GT(cache_size, 100 * fs::file_size(log_file));
+  }
+
+  tools::wallet2 w{cryptonote::TESTNET};
+  w.load(wallet_file, "pass");
+  EXPECT_FALSE(w.m_cache_log_compact);
+  EXPECT_GE(w.m_subaddresses.size(), 10000u);
+  ASSERT_EQ(w.get_num_subaddress_accounts(), 2u);
+  EXPECT_EQ(w.get_num_subaddresses(0), 2u);
+  EXPECT_EQ(w.get_subaddress_label({0, 1}), "shop");
+  EXPECT_EQ(w.get_subaddress_label({1, 0}), "spending");
+  EXPECT_EQ(w.get_tx_note(noted_txid), "new note");
+  EXPECT_EQ(w.m_tx_keys.size(), 1001u);
+  EXPECT_EQ(w.m_tx_keys.count(new_txid), 1u);
+  EXPECT_EQ(w.m_additional_tx_keys.count(new_txid), 1u);
+  std::string value;
+  EXPECT_TRUE(w.get_attribute("attr", value));
+  EXPECT_EQ(value, "value");
+  ASSERT_EQ(w.get_address_book().size(), 1u);
+  EXPECT_EQ(w.get_address_book()[0].m_description, "second");
+  EXPECT_TRUE(w.get_ons_cache().empty());
+}